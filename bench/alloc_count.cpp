@@ -0,0 +1,40 @@
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "bench.h"
+
+// Replaces the global allocation functions for the whole bench binary. The
+// counter is per thread so that counting costs one increment and multi-
+// threaded cases do not contend on it. Array and nothrow forms fall back to
+// these through the standard library; the aligned forms, which
+// std::pmr::new_delete_resource calls, do not and are replaced as well.
+namespace {
+
+thread_local std::size_t allocations = 0;
+
+}  // namespace
+
+std::size_t bench::Allocations() { return allocations; }
+
+void* operator new(std::size_t size) {
+  ++allocations;
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+  throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  ++allocations;
+  std::size_t align = static_cast<std::size_t>(alignment);
+  std::size_t rounded = (size + align - 1) / align * align;
+  if (void* ptr = std::aligned_alloc(align, rounded == 0 ? align : rounded)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
@@ -0,0 +1,201 @@
+#ifndef BENCH_BENCH_H_
+#define BENCH_BENCH_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__unix__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+// Minimal self-contained benchmark harness. Every case runs in its own
+// process so that RSS readings are not polluted by earlier cases.
+namespace bench {
+
+struct Options {
+  std::size_t max_elements = 1000000;
+  std::string filter;
+};
+
+using CaseFn = void (*)(const Options&);
+
+struct Case {
+  const char* name;
+  CaseFn fn;
+};
+
+inline std::vector<Case>& Registry() {
+  static std::vector<Case> cases;
+  return cases;
+}
+
+inline bool Register(const char* name, CaseFn fn) {
+  Registry().push_back(Case{name, fn});
+  return true;
+}
+
+class Timer {
+ public:
+  Timer() : start_(std::chrono::steady_clock::now()) {}
+  double Seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start_)
+        .count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Resident set size of the current process in KiB, 0 when unavailable.
+inline std::size_t RssKb() {
+  std::size_t pages = 0;
+  std::size_t resident = 0;
+  std::FILE* statm = std::fopen("/proc/self/statm", "r");
+  if (statm == nullptr) return 0;
+  if (std::fscanf(statm, "%zu %zu", &pages, &resident) != 2) resident = 0;
+  std::fclose(statm);
+#if defined(__unix__)
+  return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE)) / 1024;
+#else
+  return resident * 4;
+#endif
+}
+
+// Hardware cache-miss counter for the calling thread. Reads -1 when the
+// kernel does not allow perf events (containers, perf_event_paranoid).
+class CacheMisses {
+ public:
+  CacheMisses() {
+#if defined(__linux__)
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+  ~CacheMisses() {
+#if defined(__linux__)
+    if (fd_ >= 0) close(fd_);
+#endif
+  }
+  CacheMisses(const CacheMisses&) = delete;
+  CacheMisses& operator=(const CacheMisses&) = delete;
+
+  void Start() {
+#if defined(__linux__)
+    if (fd_ < 0) return;
+    ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  }
+  long long Stop() {
+    long long count = -1;
+#if defined(__linux__)
+    if (fd_ < 0) return -1;
+    ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd_, &count, sizeof(count)) != sizeof(count)) count = -1;
+#endif
+    return count;
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+// Heap allocations made so far by the calling thread, counted by the
+// replacement operator new in alloc_count.cpp. Take the difference of two
+// readings around the code being measured.
+std::size_t Allocations();
+
+inline std::string PerOp(const char* unit, double total, std::size_t ops) {
+  char buffer[48];
+  if (total < 0) return std::string(unit) + "=n/a";
+  std::snprintf(buffer, sizeof(buffer), "%s=%.2f", unit,
+                total / static_cast<double>(ops));
+  return buffer;
+}
+
+inline void RunIsolated(const std::function<void()>& fn) {
+#if defined(__unix__)
+  std::fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    fn();
+    std::fflush(stdout);
+    _exit(0);
+  }
+  if (pid > 0) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return;
+  }
+#endif
+  fn();
+}
+
+// Powers of ten from `from` up to the configured maximum.
+inline std::vector<std::size_t> Sizes(const Options& options,
+                                      std::size_t from) {
+  std::vector<std::size_t> sizes;
+  for (std::size_t n = from; n <= options.max_elements; n *= 10) {
+    sizes.push_back(n);
+  }
+  return sizes;
+}
+
+inline std::vector<int> ShuffledKeys(std::size_t n, unsigned seed = 42) {
+  std::vector<int> keys(n);
+  for (std::size_t i = 0; i < n; ++i) keys[i] = static_cast<int>(i);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(seed));
+  return keys;
+}
+
+inline void Header(const char* title) {
+  std::printf("\n== %s ==\n", title);
+  std::printf("%-40s %12s %12s   %s\n", "case", "n", "ns/op", "note");
+}
+
+inline void Row(const std::string& label, std::size_t n, double seconds,
+                std::size_t ops, const std::string& note = "") {
+  double ns = ops == 0 ? 0.0 : seconds * 1e9 / static_cast<double>(ops);
+  std::printf("%-40s %12zu %12.1f   %s\n", label.c_str(), n, ns,
+              note.c_str());
+}
+
+inline std::string Mib(std::size_t kb) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.1fMiB", kb / 1024.0);
+  return buffer;
+}
+
+}  // namespace bench
+
+#define BENCH_CASE(name)                                               \
+  static void name(const bench::Options& options);                     \
+  [[maybe_unused]] static const bool name##_registered =               \
+      bench::Register(#name, name);                                    \
+  static void name([[maybe_unused]] const bench::Options& options)
+
+#endif  // BENCH_BENCH_H_
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "bench.h"
+#include "concurrent_map.h"
+#include "custom_map.h"
+
+namespace {
+
+constexpr std::size_t kOpsPerKey = 20;
+constexpr std::size_t kMaxOps = 4000000;
+constexpr std::size_t kBatch = 64;
+constexpr unsigned kThreadCounts[] = {1, 2, 4, 8, 16, 32, 64};
+constexpr unsigned kReadPercents[] = {90, 50};
+
+// What ConcurrentMap replaces: one Map behind one mutex.
+class LockedMap {
+ public:
+  explicit LockedMap(std::size_t) {}
+  bool insert_or_assign(int key, long long value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return map.insert_or_assign(key, value).second;
+  }
+  bool contains(int key) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return map.contains(key);
+  }
+
+ private:
+  mutable std::mutex mutex;
+  Map<int, long long> map;
+};
+
+using HashShards = ConcurrentMap<int, long long>;
+using TreeShards =
+    ConcurrentMap<int, long long, std::hash<int>, Map<int, long long>>;
+
+// The threads share kOpsPerKey operations per key (at most kMaxOps) on
+// random keys in [0, n): reads with the given probability,
+// insert_or_assign otherwise.
+// With batches, reads are gathered kBatch at a time into find_many.
+template <typename MapType>
+void Mix(const std::string& name, std::size_t n, unsigned threads,
+         unsigned readPercent, bool batches) {
+  MapType map(0);
+  for (int key : bench::ShuffledKeys(n)) map.insert_or_assign(key, key);
+  std::size_t perThread = std::min(n * kOpsPerKey, kMaxOps) / threads;
+  std::vector<std::thread> workers;
+  bench::Timer timer;
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.emplace_back([&map, n, perThread, readPercent, batches, t] {
+      std::mt19937 rng(t + 1);
+      std::uniform_int_distribution<int> pick(0, static_cast<int>(n) - 1);
+      std::vector<int> reads;
+      std::size_t found = 0;
+      for (std::size_t i = 0; i < perThread; ++i) {
+        int key = pick(rng);
+        if (rng() % 100 >= readPercent) {
+          map.insert_or_assign(key, static_cast<long long>(i));
+        } else if (!batches) {
+          found += map.contains(key) ? 1 : 0;
+        } else {
+          reads.push_back(key);
+          if (reads.size() == kBatch) {
+            if constexpr (!std::is_same<MapType, LockedMap>::value) {
+              auto values = map.find_many(reads.begin(), reads.end());
+              found += values.size();
+            }
+            reads.clear();
+          }
+        }
+      }
+      bench::DoNotOptimize(found);
+    });
+  }
+  for (std::thread& worker : workers) worker.join();
+  double seconds = timer.Seconds();
+  std::string label = name + " " + std::to_string(readPercent) + "/" +
+                      std::to_string(100 - readPercent) + " x" +
+                      std::to_string(threads);
+  char note[32];
+  std::snprintf(note, sizeof(note), "%.1f Mops/s",
+                static_cast<double>(perThread * threads) / seconds / 1e6);
+  bench::Row(label, n, seconds, perThread * threads, note);
+}
+
+}  // namespace
+
+// ns/op is wall time over all operations of all threads, so it falls as
+// threads are added for as long as they run in parallel. Scaling needs as
+// many cores as threads; `make tsan` runs this case under ThreadSanitizer.
+BENCH_CASE(concurrent_map) {
+  bench::Header("Map shared by threads: read/write mixes (reads/writes)");
+  std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+  for (std::size_t n : bench::Sizes(options, 10000)) {
+    for (unsigned readPercent : kReadPercents) {
+      for (unsigned threads : kThreadCounts) {
+        bench::RunIsolated([=] {
+          Mix<LockedMap>("Map + mutex", n, threads, readPercent, false);
+        });
+        bench::RunIsolated([=] {
+          Mix<HashShards>("ConcurrentMap", n, threads, readPercent, false);
+        });
+        bench::RunIsolated([=] {
+          Mix<TreeShards>("ConcurrentMap<Map>", n, threads, readPercent,
+                          false);
+        });
+        bench::RunIsolated([=] {
+          Mix<HashShards>("ConcurrentMap find_many", n, threads,
+                          readPercent, true);
+        });
+      }
+    }
+  }
+}
@@ -0,0 +1,117 @@
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bench.h"
+#include "custom_hash_map.h"
+#include "custom_map.h"
+
+namespace {
+
+using SwissMap = HashMap<int, int>;
+using StdMap = std::unordered_map<int, int>;
+using TreeMap = Map<int, int>;
+
+// Sizes the table for `count` elements at `load` without growing on the
+// way; Map has no buckets and ignores both.
+void Presize(SwissMap& map, std::size_t count, double load) {
+  map.rehash(static_cast<std::size_t>(count / load));
+}
+void Presize(StdMap& map, std::size_t count, double load) {
+  map.max_load_factor(1.0f);
+  map.rehash(static_cast<std::size_t>(count / load));
+}
+void Presize(TreeMap&, std::size_t, double) {}
+
+std::string LoadNote(const SwissMap& map) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "load=%.2f", map.load_factor());
+  return buffer;
+}
+std::string LoadNote(const StdMap& map) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "load=%.2f", map.load_factor());
+  return buffer;
+}
+std::string LoadNote(const TreeMap&) { return ""; }
+
+// std::unordered_map has no contains before C++20 and Map has no find, so
+// each map gets its own spelling of the three operations.
+void Insert(SwissMap& map, int key) { map.insert(key, key); }
+void Insert(StdMap& map, int key) { map.emplace(key, key); }
+void Insert(TreeMap& map, int key) { map.insert(key, key); }
+bool Contains(const SwissMap& map, int key) { return map.contains(key); }
+bool Contains(const StdMap& map, int key) { return map.count(key) != 0; }
+bool Contains(const TreeMap& map, int key) { return map.contains(key); }
+void Erase(SwissMap& map, int key) { map.erase(map.find(key)); }
+void Erase(StdMap& map, int key) { map.erase(key); }
+void Erase(TreeMap& map, int key) { map.erase(map.lower_bound(key)); }
+
+// Inserts `keys`, looks up a mix of present keys and keys in [n, 2n) that
+// are not, then erases every other key.
+template <typename MapType>
+void InsertLookupErase(const std::string& label, const std::vector<int>& keys,
+                       double load, std::size_t lookups) {
+  MapType map;
+  Presize(map, keys.size(), load);
+  bench::Timer insertTimer;
+  for (int key : keys) Insert(map, key);
+  double insertSeconds = insertTimer.Seconds();
+  std::string note = LoadNote(map);
+
+  std::mt19937 rng(9);
+  std::uniform_int_distribution<int> pick(
+      0, static_cast<int>(keys.size() * 2 - 1));
+  std::size_t hits = 0;
+  bench::Timer lookupTimer;
+  for (std::size_t q = 0; q < lookups; ++q) hits += Contains(map, pick(rng));
+  double lookupSeconds = lookupTimer.Seconds();
+  bench::DoNotOptimize(hits);
+
+  bench::Timer eraseTimer;
+  for (std::size_t i = 0; i < keys.size(); i += 2) {
+    Erase(map, keys[i]);
+  }
+  double eraseSeconds = eraseTimer.Seconds();
+
+  bench::Row(label + " insert", keys.size(), insertSeconds, keys.size(),
+             note);
+  bench::Row(label + " lookup 50% hit", keys.size(), lookupSeconds, lookups);
+  bench::Row(label + " erase", keys.size(), eraseSeconds,
+             (keys.size() + 1) / 2);
+}
+
+}  // namespace
+
+BENCH_CASE(hash_map) {
+  bench::Header("HashMap<int, int> vs std::unordered_map vs Map");
+  const double loads[] = {0.25, 0.5, 0.85};
+  for (std::size_t n : bench::Sizes(options, 1000)) {
+    // Element counts that put HashMap's 2^k - 1 slots at each load factor.
+    SwissMap sizing;
+    sizing.rehash(n);
+    std::size_t slots = sizing.bucket_count();
+    std::size_t lookups = 1000000;
+    for (double load : loads) {
+      std::vector<int> keys =
+          bench::ShuffledKeys(static_cast<std::size_t>(slots * load));
+      char tag[16];
+      std::snprintf(tag, sizeof(tag), " lf=%.2f", load);
+      bench::RunIsolated([&] {
+        InsertLookupErase<SwissMap>(std::string("hash-map") + tag, keys, load,
+                                    lookups);
+      });
+      bench::RunIsolated([&] {
+        InsertLookupErase<StdMap>(std::string("unordered_map") + tag, keys,
+                                  load, lookups);
+      });
+      bench::RunIsolated([&] {
+        InsertLookupErase<TreeMap>(std::string("map") + tag, keys, load,
+                                   lookups);
+      });
+    }
+  }
+}
@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "bench.h"
+#include "custom_hash_set.h"
+#include "custom_set.h"
+
+namespace {
+
+// CustomSet is fed in batches through its range insert (append, sort and
+// merge once per batch); one insert per element would shift the array
+// every time.
+constexpr std::size_t kBatch = 1 << 20;
+
+// n values drawn from n / 10 distinct random ints, so nine inserts in ten
+// hit an element that is already there.
+std::vector<int> DuplicateHeavy(std::size_t n) {
+  std::mt19937 rng(21);
+  std::vector<int> pool(std::max<std::size_t>(n / 10, 1));
+  for (int& value : pool) value = static_cast<int>(rng());
+  std::uniform_int_distribution<std::size_t> pick(0, pool.size() - 1);
+  std::vector<int> values(n);
+  for (int& value : values) value = pool[pick(rng)];
+  return values;
+}
+
+template <typename Set>
+void Report(const std::string& label, const Set& set, std::size_t n,
+            double seconds, std::size_t rssBefore) {
+  std::size_t rss = bench::RssKb() - rssBefore;
+  bench::Row(label, n, seconds, n,
+             bench::Mib(rss) + " unique=" + std::to_string(set.size()));
+}
+
+template <typename Set>
+void Ingest(const std::string& label, const std::vector<int>& values) {
+  std::size_t rssBefore = bench::RssKb();
+  Set set;
+  bench::Timer timer;
+  for (int value : values) set.insert(value);
+  Report(label, set, values.size(), timer.Seconds(), rssBefore);
+}
+
+void IngestBatched(const std::string& label, const std::vector<int>& values) {
+  std::size_t rssBefore = bench::RssKb();
+  CustomSet<int> set;
+  bench::Timer timer;
+  for (std::size_t i = 0; i < values.size(); i += kBatch) {
+    std::size_t last = std::min(values.size(), i + kBatch);
+    set.insert(values.begin() + i, values.begin() + last);
+  }
+  Report(label, set, values.size(), timer.Seconds(), rssBefore);
+}
+
+}  // namespace
+
+// Run with --max=100000000 for the 100M-insert case.
+BENCH_CASE(hash_set) {
+  bench::Header("Dedup ingest, 10% unique: HashSet vs unordered_set vs set");
+  for (std::size_t n : bench::Sizes(options, 1000000)) {
+    std::vector<int> values = DuplicateHeavy(n);
+    bench::RunIsolated(
+        [&] { Ingest<HashSet<int>>("hash-set insert", values); });
+    bench::RunIsolated([&] {
+      Ingest<std::unordered_set<int>>("unordered_set insert", values);
+    });
+    bench::RunIsolated(
+        [&] { IngestBatched("custom-set batched range insert", values); });
+  }
+}
@@ -0,0 +1,25 @@
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "bench.h"
+
+// Usage: s21_containers_bench [filter] [--max=N]
+int main(int argc, char** argv) {
+  bench::Options options;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], "--max=", 6) == 0) {
+      options.max_elements = std::strtoull(argv[i] + 6, nullptr, 10);
+    } else {
+      options.filter = argv[i];
+    }
+  }
+
+  for (const bench::Case& c : bench::Registry()) {
+    if (std::string(c.name).find(options.filter) == std::string::npos) {
+      continue;
+    }
+    bench::RunIsolated([&c, &options] { c.fn(options); });
+  }
+  return 0;
+}
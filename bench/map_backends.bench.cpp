@@ -0,0 +1,58 @@
+#include <cstddef>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "custom_map.h"
+
+namespace {
+
+using Entry = std::pair<const int, int>;
+using RBTreeMap = Map<int, int>;
+using BTreeMap = Map<int, int, NodePool<Entry>, BTreeBackend<>>;
+
+template <typename MapType>
+void InsertLookupScan(const std::string& label, const std::vector<int>& keys,
+                      std::size_t lookups) {
+  std::size_t rssBefore = bench::RssKb();
+  MapType map;
+  bench::Timer insertTimer;
+  for (int key : keys) map.insert(key, key);
+  double insertSeconds = insertTimer.Seconds();
+  std::size_t rss = bench::RssKb() - rssBefore;
+
+  std::mt19937 rng(9);
+  std::uniform_int_distribution<std::size_t> pick(0, keys.size() - 1);
+  long long sum = 0;
+  bench::Timer lookupTimer;
+  for (std::size_t q = 0; q < lookups; ++q) sum += map.at(keys[pick(rng)]);
+  double lookupSeconds = lookupTimer.Seconds();
+
+  bench::Timer scanTimer;
+  for (auto it = map.begin(); it != map.end(); ++it) sum += it->second;
+  double scanSeconds = scanTimer.Seconds();
+  bench::DoNotOptimize(sum);
+
+  bench::Row(label + " insert", keys.size(), insertSeconds, keys.size(),
+             bench::Mib(rss));
+  bench::Row(label + " lookup", keys.size(), lookupSeconds, lookups);
+  bench::Row(label + " in-order scan", keys.size(), scanSeconds,
+             keys.size());
+}
+
+}  // namespace
+
+// Run with --max=100000000 to reach 100M elements.
+BENCH_CASE(map_backends) {
+  bench::Header("Map<int, int>: red-black tree vs B-tree backend");
+  for (std::size_t n : bench::Sizes(options, 1000)) {
+    std::vector<int> keys = bench::ShuffledKeys(n);
+    std::size_t lookups = 1000000;
+    bench::RunIsolated(
+        [&] { InsertLookupScan<RBTreeMap>("rb-tree", keys, lookups); });
+    bench::RunIsolated(
+        [&] { InsertLookupScan<BTreeMap>("b-tree", keys, lookups); });
+  }
+}
@@ -0,0 +1,54 @@
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "custom_map.h"
+
+namespace {
+
+using Snapshot = std::vector<std::pair<int, int>>;
+
+void LoadByInsert(const Snapshot& snapshot) {
+  bench::Timer timer;
+  Map<int, int> map;
+  for (const auto& item : snapshot) map.insert(item.first, item.second);
+  bench::Row("repeated insert", snapshot.size(), timer.Seconds(),
+             snapshot.size());
+}
+
+void LoadByEndHint(const Snapshot& snapshot) {
+  bench::Timer timer;
+  Map<int, int> map;
+  for (const auto& item : snapshot) map.insert(map.end(), item);
+  bench::Row("insert with end() hint", snapshot.size(), timer.Seconds(),
+             snapshot.size());
+}
+
+void LoadByRange(const Snapshot& snapshot) {
+  bench::Timer timer;
+  Map<int, int> map(snapshot.begin(), snapshot.end());
+  double buildSeconds = timer.Seconds();
+  bench::Timer scanTimer;
+  long long sum = 0;
+  for (auto it = map.begin(); it != map.end(); ++it) sum += it->second;
+  bench::DoNotOptimize(sum);
+  bench::Row("range constructor (bulk load)", snapshot.size(), buildSeconds,
+             snapshot.size());
+  bench::Row("  in-order scan after bulk load", snapshot.size(),
+             scanTimer.Seconds(), snapshot.size());
+}
+
+}  // namespace
+
+BENCH_CASE(map_build_from_sorted) {
+  bench::Header("Map<int, int> startup from a sorted snapshot");
+  for (std::size_t n : bench::Sizes(options, 100000)) {
+    Snapshot snapshot(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      snapshot[i] = std::make_pair(static_cast<int>(i), static_cast<int>(i));
+    }
+    bench::RunIsolated([&snapshot] { LoadByInsert(snapshot); });
+    bench::RunIsolated([&snapshot] { LoadByEndHint(snapshot); });
+    bench::RunIsolated([&snapshot] { LoadByRange(snapshot); });
+  }
+}
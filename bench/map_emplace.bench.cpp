@@ -0,0 +1,87 @@
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "custom_map.h"
+
+namespace {
+
+// A large mapped value: copying it allocates and copies 1 KiB, moving it
+// only steals the buffer. The counters show which of the two each insert
+// path pays for.
+struct Payload {
+  static inline std::size_t copies = 0;
+  static inline std::size_t moves = 0;
+
+  Payload() = default;
+  explicit Payload(int seed) : samples(256, seed) {}
+  Payload(const Payload& other) : samples(other.samples) { ++copies; }
+  Payload(Payload&& other) noexcept : samples(std::move(other.samples)) {
+    ++moves;
+  }
+  Payload& operator=(const Payload& other) {
+    ++copies;
+    samples = other.samples;
+    return *this;
+  }
+  Payload& operator=(Payload&& other) noexcept {
+    ++moves;
+    samples = std::move(other.samples);
+    return *this;
+  }
+
+  std::vector<int> samples;
+};
+
+using PayloadMap = Map<int, Payload>;
+
+// The ways a caller can hand a fresh payload to the map.
+void ConstRefInsert(PayloadMap& map, int key) {
+  Payload payload(key);
+  map.insert(key, payload);
+}
+void RvalueInsert(PayloadMap& map, int key) {
+  map.insert(PayloadMap::value_type(key, Payload(key)));
+}
+void Emplace(PayloadMap& map, int key) { map.emplace(key, Payload(key)); }
+void TryEmplace(PayloadMap& map, int key) { map.try_emplace(key, key); }
+void Subscript(PayloadMap& map, int key) { map[key] = Payload(key); }
+
+// Every key is inserted twice, so half of the calls find it already there.
+template <typename InsertFn>
+void Inserts(const std::string& label, const std::vector<int>& keys,
+             InsertFn insert) {
+  PayloadMap map;
+  Payload::copies = Payload::moves = 0;
+  bench::Timer timer;
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int key : keys) insert(map, key);
+  }
+  double seconds = timer.Seconds();
+  bench::DoNotOptimize(map.size());
+  std::size_t ops = keys.size() * 2;
+  bench::Row(label, keys.size(), seconds, ops,
+             bench::PerOp("copies/op", static_cast<double>(Payload::copies),
+                          ops) +
+                 " " +
+                 bench::PerOp("moves/op", static_cast<double>(Payload::moves),
+                              ops));
+}
+
+}  // namespace
+
+BENCH_CASE(map_emplace) {
+  bench::Header("Map<int, 1 KiB payload> inserts, half of them duplicates");
+  for (std::size_t n : bench::Sizes(options, 100000)) {
+    std::vector<int> keys = bench::ShuffledKeys(n);
+    bench::RunIsolated(
+        [&] { Inserts("insert(key, const value&)", keys, ConstRefInsert); });
+    bench::RunIsolated(
+        [&] { Inserts("insert(value_type&&)", keys, RvalueInsert); });
+    bench::RunIsolated([&] { Inserts("emplace", keys, Emplace); });
+    bench::RunIsolated([&] { Inserts("try_emplace", keys, TryEmplace); });
+    bench::RunIsolated([&] { Inserts("operator[] =", keys, Subscript); });
+  }
+}
@@ -0,0 +1,91 @@
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "custom_map.h"
+
+namespace {
+
+using Entry = std::pair<const int, std::string>;
+using PoolMap = Map<int, std::string>;
+using HeapMap = Map<int, std::string, std::allocator<Entry>>;
+
+// Long enough to live on the heap, so copying a value costs an allocation.
+std::string Payload(int key) {
+  return "payload-of-entry-" + std::to_string(key);
+}
+
+// The source shard holds the odd keys, the target the even ones.
+template <typename MapType>
+void Fill(MapType& source, MapType& target, const std::vector<int>& keys) {
+  for (int key : keys) {
+    (key % 2 != 0 ? source : target).insert(key, Payload(key));
+  }
+}
+
+// How every source entry gets into the target.
+template <typename MapType>
+void CopyAndErase(MapType& source, MapType& target) {
+  while (!source.empty()) {
+    auto it = source.begin();
+    target.insert(it->first, it->second);
+    source.erase(it);
+  }
+}
+template <typename MapType>
+void ExtractAndInsert(MapType& source, MapType& target) {
+  while (!source.empty()) target.insert(source.extract(source.begin()));
+}
+template <typename MapType>
+void Merge(MapType& source, MapType& target) {
+  target.merge(source);
+}
+
+template <typename MapType, typename MigrateFn>
+void Migrate(const std::string& label, const std::vector<int>& keys,
+             MigrateFn migrate) {
+  MapType source;
+  MapType target;
+  Fill(source, target, keys);
+  std::size_t moved = source.size();
+  std::size_t allocationsBefore = bench::Allocations();
+  bench::Timer timer;
+  migrate(source, target);
+  double seconds = timer.Seconds();
+  std::size_t allocations = bench::Allocations() - allocationsBefore;
+  bench::DoNotOptimize(target.size());
+  bench::Row(label, moved, seconds, moved,
+             bench::PerOp("allocs/op", static_cast<double>(allocations),
+                          moved));
+}
+
+}  // namespace
+
+// Run with --max=20000000 to migrate 10M entries.
+BENCH_CASE(map_extract) {
+  bench::Header("Migrating the entries of one Map<int, std::string> to another");
+  for (std::size_t n : bench::Sizes(options, 200000)) {
+    std::vector<int> keys = bench::ShuffledKeys(n);
+    bench::RunIsolated([&] {
+      Migrate<PoolMap>("pool: copy + erase", keys, CopyAndErase<PoolMap>);
+    });
+    bench::RunIsolated([&] {
+      Migrate<PoolMap>("pool: extract + insert", keys,
+                       ExtractAndInsert<PoolMap>);
+    });
+    bench::RunIsolated(
+        [&] { Migrate<PoolMap>("pool: merge", keys, Merge<PoolMap>); });
+    bench::RunIsolated([&] {
+      Migrate<HeapMap>("heap: copy + erase", keys, CopyAndErase<HeapMap>);
+    });
+    bench::RunIsolated([&] {
+      Migrate<HeapMap>("heap: extract + insert", keys,
+                       ExtractAndInsert<HeapMap>);
+    });
+    bench::RunIsolated(
+        [&] { Migrate<HeapMap>("heap: merge", keys, Merge<HeapMap>); });
+  }
+}
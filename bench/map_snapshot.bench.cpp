@@ -0,0 +1,108 @@
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "custom_map.h"
+
+namespace {
+
+using Entry = std::pair<const int, long long>;
+using HeapMap = Map<int, long long, std::allocator<Entry>>;
+using PersistentMap =
+    Map<int, long long, std::allocator<Entry>, PersistentRBTreeBackend>;
+
+constexpr std::size_t kWritesPerSnapshot = 1000;
+constexpr std::size_t kLiveSnapshots = 4;
+
+template <typename MapType>
+void Fill(MapType& map, std::size_t n) {
+  for (int key : bench::ShuffledKeys(n)) map.insert(key, key);
+}
+
+void SnapshotCost(std::size_t n) {
+  PersistentMap map;
+  Fill(map, n);
+  constexpr std::size_t kSnapshots = 100000;
+  bench::Timer timer;
+  for (std::size_t i = 0; i < kSnapshots; ++i) {
+    auto snapshot = map.snapshot();
+    bench::DoNotOptimize(snapshot.size());
+  }
+  bench::Row("snapshot()", n, timer.Seconds(), kSnapshots);
+
+  HeapMap heap;
+  Fill(heap, n);
+  bench::Timer copyTimer;
+  HeapMap copy(heap);
+  bench::Row("deep copy (red-black map)", n, copyTimer.Seconds(), 1);
+  bench::DoNotOptimize(copy.size());
+}
+
+// n updates of random existing keys. With snapshots, one is taken every
+// kWritesPerSnapshot writes and the last kLiveSnapshots are kept alive, as
+// readers would; `take` builds one from the map.
+template <typename MapType, typename Take>
+void Writes(const std::string& label, std::size_t n, bool snapshots,
+            Take take) {
+  MapType map;
+  Fill(map, n);
+  std::size_t baseRss = bench::RssKb();
+  using Snapshot = decltype(take(map));
+  std::vector<Snapshot> live;
+  std::mt19937 rng(9);
+  std::uniform_int_distribution<int> pick(0, static_cast<int>(n) - 1);
+  std::size_t allocations = bench::Allocations();
+  bench::Timer timer;
+  for (std::size_t i = 0; i < n; ++i) {
+    map.insert_or_assign(pick(rng), static_cast<long long>(i));
+    if (snapshots && i % kWritesPerSnapshot == 0) {
+      if (live.size() == kLiveSnapshots) live.erase(live.begin());
+      live.push_back(take(map));
+    }
+  }
+  double seconds = timer.Seconds();
+  allocations = bench::Allocations() - allocations;
+  std::size_t extraKb = bench::RssKb() - baseRss;
+  bench::Row(label, n, seconds, n,
+             bench::PerOp("allocs/write", static_cast<double>(allocations),
+                          n) +
+                 " +" + bench::Mib(extraKb));
+  bench::DoNotOptimize(map.size());
+}
+
+}  // namespace
+
+// ns/op is per snapshot for the first two rows and per write after them.
+// The note gives heap allocations per write and how much the resident set
+// grew during the writes.
+BENCH_CASE(map_snapshot) {
+  bench::Header("Snapshots of a Map<int, long long> under updates");
+  for (std::size_t n : bench::Sizes(options, 10000)) {
+    bench::RunIsolated([n] { SnapshotCost(n); });
+    bench::RunIsolated([n] {
+      Writes<HeapMap>("red-black: writes", n, false,
+                      [](HeapMap&) { return 0; });
+    });
+    bench::RunIsolated([n] {
+      Writes<PersistentMap>("persistent: writes", n, false,
+                            [](PersistentMap& map) { return map.snapshot(); });
+    });
+    bench::RunIsolated([n] {
+      Writes<PersistentMap>("persistent: writes + snapshots", n, true,
+                            [](PersistentMap& map) { return map.snapshot(); });
+    });
+    // A deep copy per snapshot is O(n), so this stops at 100k elements.
+    if (n <= 100000) {
+      bench::RunIsolated([n] {
+        Writes<HeapMap>("red-black: writes + deep copies", n, true,
+                        [](HeapMap& map) {
+                          return std::make_unique<HeapMap>(map);
+                        });
+      });
+    }
+  }
+}
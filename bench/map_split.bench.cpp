@@ -0,0 +1,84 @@
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "bench.h"
+#include "custom_map.h"
+
+namespace {
+
+using Entry = std::pair<const long long, long long>;
+using PoolMap = Map<long long, long long>;
+using HeapMap = Map<long long, long long, std::allocator<Entry>>;
+using SizedHeapMap =
+    Map<long long, long long, std::allocator<Entry>, RBTreeBackend<true>>;
+
+// Timestamps one apart; the cut keeps the oldest 90% in place, as when a
+// time-partitioned index seals its current partition.
+template <typename MapType>
+void Fill(MapType& map, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    map.insert(static_cast<long long>(i), static_cast<long long>(i));
+  }
+}
+
+long long Cut(std::size_t n) { return static_cast<long long>(n / 10 * 9); }
+
+// What split_at replaces: copy the tail into a new map and erase it.
+template <typename MapType>
+void Reinsert(const std::string& label, std::size_t n) {
+  MapType map;
+  Fill(map, n);
+  bench::Timer timer;
+  MapType tail;
+  for (auto it = map.lower_bound(Cut(n)); it != map.end();) {
+    tail.insert(it->first, it->second);
+    map.erase(it++);
+  }
+  double splitSeconds = timer.Seconds();
+  bench::Timer concatTimer;
+  for (auto it = tail.begin(); it != tail.end(); ++it) {
+    map.insert(it->first, it->second);
+  }
+  tail.clear();
+  double concatSeconds = concatTimer.Seconds();
+  bench::DoNotOptimize(map.size());
+  bench::Row(label + ": split", n, splitSeconds, 1);
+  bench::Row(label + ": concat", n, concatSeconds, 1);
+}
+
+template <typename MapType>
+void SplitConcat(const std::string& label, std::size_t n) {
+  MapType map;
+  Fill(map, n);
+  bench::Timer timer;
+  MapType tail = map.split_at(Cut(n));
+  double splitSeconds = timer.Seconds();
+  bench::DoNotOptimize(tail.size());
+  bench::Timer concatTimer;
+  map.concat(tail);
+  double concatSeconds = concatTimer.Seconds();
+  bench::DoNotOptimize(map.size());
+  bench::Row(label + ": split_at", n, splitSeconds, 1,
+             bench::Mib(bench::RssKb()));
+  bench::Row(label + ": concat", n, concatSeconds, 1);
+}
+
+}  // namespace
+
+// ns/op is the time of one whole split or concatenation. Run with
+// --max=100000000 to reach 100M entries (about 6 GiB with std::allocator).
+BENCH_CASE(map_split) {
+  bench::Header("Cutting a Map<long long, long long> at 90% and rejoining");
+  for (std::size_t n : bench::Sizes(options, 1000000)) {
+    if (n <= 10000000) {
+      bench::RunIsolated(
+          [n] { Reinsert<HeapMap>("heap: reinsert + erase", n); });
+    }
+    bench::RunIsolated(
+        [n] { SplitConcat<SizedHeapMap>("heap, subtree sizes", n); });
+    bench::RunIsolated([n] { SplitConcat<HeapMap>("heap", n); });
+    bench::RunIsolated([n] { SplitConcat<PoolMap>("pool", n); });
+  }
+}
@@ -0,0 +1,50 @@
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "custom_map.h"
+
+namespace {
+
+using Entry = std::pair<const std::string, int>;
+// The node layout Map used before keys were read from value_type.first.
+using StoredKeyTree = RBTree<std::string, Entry>;
+using FirstKeyTree = Map<std::string, int>::tree_type;
+
+// Long enough to live on the heap rather than in the small-string buffer.
+std::string SessionKey(int id) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "session:user:%012d", id);
+  return buffer;
+}
+
+template <typename Tree>
+void Fill(const char* label, const std::vector<int>& ids) {
+  std::size_t rssBefore = bench::RssKb();
+  Tree tree;
+  bench::Timer timer;
+  for (int id : ids) {
+    std::string key = SessionKey(id);
+    tree.insert(key, Entry(key, id));
+  }
+  double seconds = timer.Seconds();
+  std::size_t rss = bench::RssKb() - rssBefore;
+  char note[64];
+  std::snprintf(note, sizeof(note), "%s, node=%zuB", bench::Mib(rss).c_str(),
+                sizeof(typename Tree::Node));
+  bench::Row(label, ids.size(), seconds, ids.size(), note);
+}
+
+}  // namespace
+
+// Run with --max=10000000 for the 10M-entry footprint.
+BENCH_CASE(map_string_keys) {
+  bench::Header("Map<std::string, int>: key stored in node vs read from pair");
+  for (std::size_t n : bench::Sizes(options, 100000)) {
+    std::vector<int> ids = bench::ShuffledKeys(n);
+    bench::RunIsolated([&ids] { Fill<StoredKeyTree>("key + pair", ids); });
+    bench::RunIsolated([&ids] { Fill<FirstKeyTree>("pair only", ids); });
+  }
+}
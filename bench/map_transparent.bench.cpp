@@ -0,0 +1,90 @@
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "custom_map.h"
+
+namespace {
+
+using Entry = std::pair<const std::string, int>;
+using PlainMap = Map<std::string, int>;
+using TransparentMap =
+    Map<std::string, int, NodePool<Entry>, RBTreeBackend<>, std::less<>>;
+
+// Long enough to live on the heap rather than in the small-string buffer,
+// so every std::string built for a lookup costs an allocation.
+std::string SessionKey(int id) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "session:user:%012d", id);
+  return buffer;
+}
+
+// With std::less<std::string> a std::string_view has to become a
+// std::string first; with std::less<> it is compared as it is. A const char*
+// avoids the allocation too, but every comparison then measures its length.
+bool Lookup(const PlainMap& map, std::string_view key) {
+  return map.contains(std::string(key));
+}
+bool Lookup(const TransparentMap& map, std::string_view key) {
+  return map.contains(key);
+}
+bool Lookup(const PlainMap& map, const char* key) { return map.contains(key); }
+bool Lookup(const TransparentMap& map, const char* key) {
+  return map.contains(key);
+}
+
+// Looks up `lookups` random keys, half of them absent, each passed as Query.
+template <typename MapType, typename Query>
+void Lookups(const std::string& label, std::size_t n, std::size_t lookups) {
+  MapType map;
+  for (int id : bench::ShuffledKeys(n)) map.insert(SessionKey(id), id);
+  std::vector<std::string> queries;
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int> pick(0, static_cast<int>(n * 2 - 1));
+  for (std::size_t q = 0; q < 4096; ++q) {
+    queries.push_back(SessionKey(pick(rng)));
+  }
+
+  std::size_t hits = 0;
+  std::size_t allocationsBefore = bench::Allocations();
+  bench::Timer timer;
+  for (std::size_t q = 0; q < lookups; ++q) {
+    const std::string& query = queries[q % queries.size()];
+    hits += Lookup(map, Query(query.c_str()));
+  }
+  double seconds = timer.Seconds();
+  std::size_t allocations = bench::Allocations() - allocationsBefore;
+  bench::DoNotOptimize(hits);
+  bench::Row(label, n, seconds, lookups,
+             bench::PerOp("allocs/op", static_cast<double>(allocations),
+                          lookups));
+}
+
+}  // namespace
+
+BENCH_CASE(map_transparent) {
+  bench::Header("Map<std::string, int> lookups: less<string> vs less<>");
+  for (std::size_t n : bench::Sizes(options, 1000)) {
+    std::size_t lookups = 1000000;
+    bench::RunIsolated([&] {
+      Lookups<PlainMap, std::string_view>("less<string> string_view", n,
+                                          lookups);
+    });
+    bench::RunIsolated([&] {
+      Lookups<TransparentMap, std::string_view>("less<> string_view", n,
+                                                lookups);
+    });
+    bench::RunIsolated([&] {
+      Lookups<PlainMap, const char*>("less<string> const char*", n, lookups);
+    });
+    bench::RunIsolated([&] {
+      Lookups<TransparentMap, const char*>("less<> const char*", n, lookups);
+    });
+  }
+}
@@ -0,0 +1,80 @@
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "custom_multiset.h"
+
+namespace {
+
+constexpr int kRangeWidth = 100;
+
+// What lower_bound used to do: walk from begin() until the key is reached.
+MultiSet<int>::iterator WalkLowerBound(MultiSet<int>& set, int key) {
+  auto it = set.begin();
+  while (it != set.end() && *it < key) ++it;
+  return it;
+}
+
+std::size_t CountInRange(MultiSet<int>::iterator first,
+                         MultiSet<int>::iterator last) {
+  std::size_t count = 0;
+  for (; first != last; ++first) ++count;
+  return count;
+}
+
+void RangeQueries(std::size_t n, bool walk, std::size_t queries) {
+  std::vector<int> sorted(n);
+  for (std::size_t i = 0; i < n; ++i) sorted[i] = static_cast<int>(i);
+  MultiSet<int> set(sorted.begin(), sorted.end());
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int> pick(0, static_cast<int>(n) - 1);
+
+  bench::Timer timer;
+  std::size_t found = 0;
+  for (std::size_t q = 0; q < queries; ++q) {
+    int low = pick(rng);
+    if (walk) {
+      auto first = WalkLowerBound(set, low);
+      found += CountInRange(first, WalkLowerBound(set, low + kRangeWidth));
+    } else {
+      found += CountInRange(set.lower_bound(low),
+                            set.lower_bound(low + kRangeWidth));
+    }
+  }
+  double rangeSeconds = timer.Seconds();
+  bench::DoNotOptimize(found);
+
+  if (walk) {
+    bench::Row("range [k, k+100) by linear walk", n, rangeSeconds, queries);
+    return;
+  }
+  bench::Timer equalTimer;
+  for (std::size_t q = 0; q < queries; ++q) {
+    auto range = set.equal_range(pick(rng));
+    found += range.first != range.second;
+  }
+  double equalSeconds = equalTimer.Seconds();
+  bench::Timer countTimer;
+  for (std::size_t q = 0; q < queries; ++q) found += set.count(pick(rng));
+  double countSeconds = countTimer.Seconds();
+  bench::DoNotOptimize(found);
+
+  bench::Row("range [k, k+100) by lower_bound", n, rangeSeconds, queries);
+  bench::Row("  equal_range", n, equalSeconds, queries);
+  bench::Row("  count", n, countSeconds, queries);
+}
+
+}  // namespace
+
+// Run with --max=10000000 to reach the 10M-element set.
+BENCH_CASE(multiset_bounds) {
+  bench::Header("MultiSet<int> range queries: linear walk vs tree descent");
+  for (std::size_t n : bench::Sizes(options, 10000)) {
+    // A walk is O(n) per query, so it gets a fixed budget of steps.
+    std::size_t walkQueries = n >= 10000000 ? 2 : 20000000 / n;
+    bench::RunIsolated(
+        [n, walkQueries] { RangeQueries(n, true, walkQueries); });
+    bench::RunIsolated([n] { RangeQueries(n, false, 1000000); });
+  }
+}
@@ -0,0 +1,71 @@
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "custom_multiset.h"
+
+namespace {
+
+using NodePerElement = MultiSet<int>;
+using NodePerKey = MultiSet<int, NodePool<int>, RBTreeBackend<false, true>>;
+
+// Zipf-distributed keys: key k is drawn with weight 1 / (k + 1)^skew.
+std::vector<int> SkewedKeys(std::size_t n, std::size_t distinct, double skew) {
+  std::vector<double> weights(distinct);
+  for (std::size_t k = 0; k < distinct; ++k) {
+    weights[k] = 1.0 / std::pow(static_cast<double>(k + 1), skew);
+  }
+  std::discrete_distribution<int> pick(weights.begin(), weights.end());
+  std::mt19937 rng(3);
+  std::vector<int> keys(n);
+  for (int& key : keys) key = pick(rng);
+  return keys;
+}
+
+template <typename Set>
+void InsertAll(const std::string& label, const std::vector<int>& keys) {
+  std::size_t rssBefore = bench::RssKb();
+  Set set;
+  bench::Timer insertTimer;
+  for (int key : keys) set.insert(key);
+  double insertSeconds = insertTimer.Seconds();
+  std::size_t rss = bench::RssKb() - rssBefore;
+
+  bench::Timer countTimer;
+  std::size_t total = 0;
+  for (int key = 0; key < 1000; ++key) total += set.count(key);
+  double countSeconds = countTimer.Seconds();
+  bench::DoNotOptimize(total);
+
+  bench::Row(label + " insert", keys.size(), insertSeconds, keys.size(),
+             bench::Mib(rss));
+  bench::Row(label + " count", keys.size(), countSeconds, 1000);
+}
+
+}  // namespace
+
+BENCH_CASE(multiset_duplicates) {
+  bench::Header("MultiSet<int> with skewed keys: node per element vs per key");
+  struct Shape {
+    const char* name;
+    std::size_t distinct;
+    double skew;
+  };
+  const Shape shapes[] = {{"zipf 1.1/1K", 1000, 1.1},
+                          {"zipf 0.8/100K", 100000, 0.8}};
+  for (std::size_t n : bench::Sizes(options, 100000)) {
+    for (const Shape& shape : shapes) {
+      std::vector<int> keys = SkewedKeys(n, shape.distinct, shape.skew);
+      std::string prefix = std::string(shape.name) + ": ";
+      bench::RunIsolated([&] {
+        InsertAll<NodePerElement>(prefix + "equal", keys);
+      });
+      bench::RunIsolated([&] {
+        InsertAll<NodePerKey>(prefix + "counted", keys);
+      });
+    }
+  }
+}
@@ -0,0 +1,101 @@
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "custom_multiset.h"
+
+namespace {
+
+using PlainSet = MultiSet<int>;
+using RankedSet = MultiSet<int, NodePool<int>, RBTreeBackend<true>>;
+
+template <typename Set>
+double Fill(Set& set, const std::vector<int>& keys) {
+  bench::Timer timer;
+  for (int key : keys) set.insert(key);
+  return timer.Seconds();
+}
+
+// The k-th element and the rank of a key, found by walking the iterators.
+int ScanSelect(PlainSet& set, std::size_t index) {
+  auto it = set.begin();
+  for (; index > 0; --index) ++it;
+  return *it;
+}
+
+std::size_t ScanRank(PlainSet& set, int key) {
+  std::size_t rank = 0;
+  for (auto it = set.begin(); it != set.end() && *it < key; ++it) ++rank;
+  return rank;
+}
+
+void LinearScan(const std::vector<int>& keys, std::size_t queries) {
+  PlainSet set;
+  double fillSeconds = Fill(set, keys);
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<std::size_t> pick(0, keys.size() - 1);
+
+  bench::Timer selectTimer;
+  long long sum = 0;
+  for (std::size_t q = 0; q < queries; ++q) sum += ScanSelect(set, pick(rng));
+  double selectSeconds = selectTimer.Seconds();
+
+  bench::Timer rankTimer;
+  for (std::size_t q = 0; q < queries; ++q) {
+    sum += static_cast<long long>(ScanRank(set, keys[pick(rng)]));
+  }
+  double rankSeconds = rankTimer.Seconds();
+  bench::DoNotOptimize(sum);
+
+  bench::Row("plain tree insert", keys.size(), fillSeconds, keys.size(),
+             bench::Mib(bench::RssKb()));
+  bench::Row("  select by iterator scan", keys.size(), selectSeconds,
+             queries);
+  bench::Row("  rank by iterator scan", keys.size(), rankSeconds, queries);
+}
+
+void OrderStatistics(const std::vector<int>& keys, std::size_t queries) {
+  RankedSet set;
+  double fillSeconds = Fill(set, keys);
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<std::size_t> pick(0, keys.size() - 1);
+
+  bench::Timer selectTimer;
+  long long sum = 0;
+  for (std::size_t q = 0; q < queries; ++q) sum += *set.select(pick(rng));
+  double selectSeconds = selectTimer.Seconds();
+
+  bench::Timer rankTimer;
+  for (std::size_t q = 0; q < queries; ++q) {
+    sum += static_cast<long long>(set.rank(keys[pick(rng)]));
+  }
+  double rankSeconds = rankTimer.Seconds();
+
+  bench::Timer rangeTimer;
+  for (std::size_t q = 0; q < queries; ++q) {
+    int low = keys[pick(rng)];
+    sum += static_cast<long long>(set.count_in_range(low, low + 1000));
+  }
+  double rangeSeconds = rangeTimer.Seconds();
+  bench::DoNotOptimize(sum);
+
+  bench::Row("order-statistics tree insert", keys.size(), fillSeconds,
+             keys.size(), bench::Mib(bench::RssKb()));
+  bench::Row("  select", keys.size(), selectSeconds, queries);
+  bench::Row("  rank", keys.size(), rankSeconds, queries);
+  bench::Row("  count_in_range", keys.size(), rangeSeconds, queries);
+}
+
+}  // namespace
+
+BENCH_CASE(order_statistics) {
+  bench::Header("MultiSet<int> select/rank: iterator scan vs subtree sizes");
+  for (std::size_t n : bench::Sizes(options, 10000)) {
+    std::vector<int> keys = bench::ShuffledKeys(n);
+    // A scan costs O(n) per query, so it gets a fixed budget of steps.
+    std::size_t scanQueries = n >= 10000000 ? 10 : 10000000 / n;
+    bench::RunIsolated([&] { LinearScan(keys, scanQueries); });
+    bench::RunIsolated([&] { OrderStatistics(keys, 100000); });
+  }
+}
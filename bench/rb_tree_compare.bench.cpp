@@ -0,0 +1,94 @@
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "bench.h"
+#include "rb_tree.h"
+
+namespace {
+
+std::size_t comparisons = 0;
+
+// Only "less": find and contains have to ask twice at a node to tell a
+// match from a key further right.
+struct LessOnly {
+  bool operator()(const std::string& lhs, const std::string& rhs) const {
+    ++comparisons;
+    return lhs < rhs;
+  }
+};
+
+// The same order with a three-way member, so every node costs one call.
+struct ThreeWay {
+  bool operator()(const std::string& lhs, const std::string& rhs) const {
+    ++comparisons;
+    return lhs < rhs;
+  }
+  int compare(const std::string& lhs, const std::string& rhs) const {
+    ++comparisons;
+    return lhs.compare(rhs);
+  }
+};
+
+template <typename Compare>
+using StringTree = RBTree<std::string, int, NodePool<int>, false,
+                          RBTreeKeys::kUnique, RBTreeStoredKey, Compare>;
+
+// Keys share a long prefix, so every comparison scans it before the digits
+// decide.
+std::string SessionKey(int id) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "session:user:%012d", id);
+  return buffer;
+}
+
+// Looks up `lookups` random keys, half of them absent.
+template <typename Compare>
+void Lookups(const char* label, std::size_t n, std::size_t lookups) {
+  StringTree<Compare> tree;
+  for (int id : bench::ShuffledKeys(n)) tree.insert(SessionKey(id), id);
+  std::vector<std::string> queries;
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int> pick(0, static_cast<int>(n * 2 - 1));
+  for (std::size_t q = 0; q < 4096; ++q) {
+    queries.push_back(SessionKey(pick(rng)));
+  }
+
+  std::size_t hits = 0;
+  comparisons = 0;
+  bench::Timer timer;
+  for (std::size_t q = 0; q < lookups; ++q) {
+    hits += tree.contains(queries[q % queries.size()]);
+  }
+  double seconds = timer.Seconds();
+  bench::DoNotOptimize(hits);
+  std::string note = std::is_same<Compare, std::less<std::string>>::value
+                         ? "cmp/op=not counted"
+                         : bench::PerOp("cmp/op",
+                                        static_cast<double>(comparisons),
+                                        lookups);
+  bench::Row(label, n, seconds, lookups, note);
+}
+
+}  // namespace
+
+BENCH_CASE(rb_tree_compare) {
+  bench::Header("RBTree<std::string> contains: two-way vs three-way descent");
+  for (std::size_t n : bench::Sizes(options, 1000)) {
+    std::size_t lookups = 1000000;
+    bench::RunIsolated([&] {
+      Lookups<LessOnly>("less only, two calls per node", n, lookups);
+    });
+    bench::RunIsolated([&] {
+      Lookups<ThreeWay>("compare member, one per node", n, lookups);
+    });
+    bench::RunIsolated([&] {
+      Lookups<std::less<std::string>>("std::less, std::string::compare", n,
+                                      lookups);
+    });
+  }
+}
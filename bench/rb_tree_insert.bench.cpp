@@ -0,0 +1,70 @@
+#include <string>
+
+#include "bench.h"
+#include "rb_tree.h"
+
+namespace {
+
+std::size_t comparisons = 0;
+
+struct CountedKey {
+  int value;
+};
+
+bool operator<(const CountedKey& lhs, const CountedKey& rhs) {
+  ++comparisons;
+  return lhs.value < rhs.value;
+}
+
+enum class Strategy { kFindInsertFind, kSingleDescent, kEndHint };
+
+void Measure(const char* label, Strategy strategy,
+             const std::vector<int>& keys) {
+  RBTree<CountedKey, int> tree;
+  bench::CacheMisses misses;
+  comparisons = 0;
+  misses.Start();
+  bench::Timer timer;
+  for (int key : keys) {
+    CountedKey k{key};
+    switch (strategy) {
+      case Strategy::kFindInsertFind:
+        // The shape Map::insert used to have: three walks per insert.
+        if (tree.find(k) == nullptr) {
+          tree.insert(k, key);
+          bench::DoNotOptimize(tree.find(k));
+        }
+        break;
+      case Strategy::kSingleDescent:
+        bench::DoNotOptimize(tree.insert(k, key).first);
+        break;
+      case Strategy::kEndHint:
+        bench::DoNotOptimize(tree.insertWithHint(nullptr, k, key).first);
+        break;
+    }
+  }
+  double seconds = timer.Seconds();
+  long long missCount = misses.Stop();
+  std::size_t n = keys.size();
+  bench::Row(label, n, seconds, n,
+             bench::PerOp("cmp/op", static_cast<double>(comparisons), n) +
+                 " " +
+                 bench::PerOp("miss/op", static_cast<double>(missCount), n));
+}
+
+}  // namespace
+
+BENCH_CASE(rb_tree_insert_descent) {
+  bench::Header("RBTree insert: find+insert+find vs single descent vs hint");
+  for (std::size_t n : bench::Sizes(options, 10000)) {
+    std::vector<int> shuffled = bench::ShuffledKeys(n);
+    std::vector<int> sorted(n);
+    for (std::size_t i = 0; i < n; ++i) sorted[i] = static_cast<int>(i);
+
+    Measure("random find+insert+find", Strategy::kFindInsertFind, shuffled);
+    Measure("random single descent", Strategy::kSingleDescent, shuffled);
+    Measure("sorted find+insert+find", Strategy::kFindInsertFind, sorted);
+    Measure("sorted single descent", Strategy::kSingleDescent, sorted);
+    Measure("sorted end() hint", Strategy::kEndHint, sorted);
+  }
+}
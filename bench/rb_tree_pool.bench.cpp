@@ -0,0 +1,51 @@
+#include <memory>
+#include <string>
+
+#include "bench.h"
+#include "node_pool.h"
+#include "rb_tree.h"
+
+namespace {
+
+template <typename Allocator>
+void InsertEraseCycle(const char* label, std::size_t n) {
+  std::vector<int> keys = bench::ShuffledKeys(n);
+  std::size_t rssBefore = bench::RssKb();
+  RBTree<int, int, Allocator> tree;
+
+  bench::Timer insertTimer;
+  for (int key : keys) tree.insert(key, key);
+  double insertSeconds = insertTimer.Seconds();
+  std::size_t rss = bench::RssKb() - rssBefore;
+
+  bench::Timer eraseTimer;
+  for (std::size_t i = 0; i < n / 2; ++i) tree.remove(keys[i]);
+  double eraseSeconds = eraseTimer.Seconds();
+
+  bench::Timer reinsertTimer;
+  for (std::size_t i = 0; i < n / 2; ++i) tree.insert(keys[i], keys[i]);
+  double reinsertSeconds = reinsertTimer.Seconds();
+
+  bench::Timer clearTimer;
+  tree.clear();
+  double clearSeconds = clearTimer.Seconds();
+
+  std::string name(label);
+  bench::Row(name + " insert", n, insertSeconds, n, bench::Mib(rss));
+  bench::Row(name + " erase", n, eraseSeconds, n / 2);
+  bench::Row(name + " reinsert", n, reinsertSeconds, n / 2);
+  bench::Row(name + " clear", n, clearSeconds, n);
+}
+
+}  // namespace
+
+BENCH_CASE(rb_tree_node_pool) {
+  bench::Header("RBTree<int, int>: heap-per-node vs NodePool");
+  for (std::size_t n : bench::Sizes(options, 10000)) {
+    bench::RunIsolated([n] {
+      InsertEraseCycle<std::allocator<int>>("std::allocator", n);
+    });
+    bench::RunIsolated(
+        [n] { InsertEraseCycle<NodePool<int>>("NodePool", n); });
+  }
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arena_resource.h"
+#include "bench.h"
+#include "pmr_containers.h"
+
+namespace {
+
+constexpr std::size_t kElementBudget = 4000000;
+
+// The containers of one request on the heap, and on a memory resource.
+struct Heap {
+  using Vector = CustomVector<int>;
+  using List = CustomList<int>;
+  using Tree =
+      Map<int, long long, std::allocator<std::pair<const int, long long>>>;
+  using Hash = HashMap<int, long long>;
+  using Set = CustomSet<int>;
+};
+struct Pmr {
+  using Vector = pmr::CustomVector<int>;
+  using List = pmr::CustomList<int>;
+  using Tree = pmr::Map<int, long long>;
+  using Hash = pmr::HashMap<int, long long>;
+  using Set = pmr::CustomSet<int>;
+};
+
+// One request: builds a vector, a list, a map, a hash map and a set of n
+// elements each, reads them once and drops them. Alloc is empty for the
+// heap and the resource for the others.
+template <typename Kind, typename... Alloc>
+long long Request(const std::vector<int>& keys, const Alloc&... alloc) {
+  typename Kind::Vector vector(alloc...);
+  typename Kind::List list(alloc...);
+  typename Kind::Tree tree(alloc...);
+  typename Kind::Hash hash(alloc...);
+  typename Kind::Set set(alloc...);
+  for (int key : keys) {
+    vector.push_back(key);
+    list.push_back(key);
+    tree.insert(key, key);
+    hash.insert(key, key);
+  }
+  set.insert(keys.begin(), keys.end());
+  long long sum = 0;
+  for (std::size_t i = 0; i < vector.size(); ++i) sum += vector[i];
+  sum += list.back() + tree.at(keys[0]) + hash.at(keys[0]);
+  return sum + static_cast<long long>(set.size());
+}
+
+// Runs `requests` requests through `serve` and reports the time and heap
+// allocations per request.
+template <typename Serve>
+void Requests(const std::string& label, std::size_t n, std::size_t requests,
+              Serve serve) {
+  std::vector<int> keys = bench::ShuffledKeys(n);
+  long long sum = 0;
+  std::size_t allocations = bench::Allocations();
+  bench::Timer timer;
+  for (std::size_t r = 0; r < requests; ++r) sum += serve(keys);
+  double seconds = timer.Seconds();
+  allocations = bench::Allocations() - allocations;
+  bench::Row(label, n, seconds, requests,
+             bench::PerOp("allocs/request", static_cast<double>(allocations),
+                          requests));
+  bench::DoNotOptimize(sum);
+}
+
+}  // namespace
+
+// n is the number of elements in each container of a request and ns/op is
+// per request. The arena is created once and reset after every request,
+// so once it has grown to a request's size it stops allocating;
+// std::pmr::monotonic_buffer_resource is created and dropped per request.
+// On std::allocator CustomVector<int> grows with realloc, which the
+// allocation count does not see.
+BENCH_CASE(request_arena) {
+  bench::Header("Request-scoped containers: heap vs memory resources");
+  for (std::size_t n : bench::Sizes(options, 10)) {
+    std::size_t requests = std::clamp<std::size_t>(kElementBudget / n, 1,
+                                                   100000);
+    bench::RunIsolated([=] {
+      Requests("std::allocator", n, requests,
+               [](const std::vector<int>& keys) {
+                 return Request<Heap>(keys);
+               });
+    });
+    bench::RunIsolated([=] {
+      Requests("pmr new_delete_resource", n, requests,
+               [](const std::vector<int>& keys) {
+                 return Request<Pmr>(keys, std::pmr::new_delete_resource());
+               });
+    });
+    bench::RunIsolated([=] {
+      Requests("pmr monotonic_buffer_resource", n, requests,
+               [](const std::vector<int>& keys) {
+                 std::pmr::monotonic_buffer_resource resource;
+                 return Request<Pmr>(keys, &resource);
+               });
+    });
+    bench::RunIsolated([=] {
+      ArenaResource arena;
+      Requests("pmr ArenaResource", n, requests,
+               [&arena](const std::vector<int>& keys) {
+                 long long sum = Request<Pmr>(keys, &arena);
+                 arena.reset();
+                 return sum;
+               });
+    });
+  }
+}
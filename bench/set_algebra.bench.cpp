@@ -0,0 +1,113 @@
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "custom_map.h"
+#include "custom_set.h"
+
+namespace {
+
+using PoolMap = Map<int, int>;
+using BTreeMap = Map<int, int, NodePool<std::pair<const int, int>>,
+                     BTreeBackend<>>;
+
+constexpr std::size_t kRatios[] = {1, 10, 100, 1000, 10000};
+
+// The large side holds the even numbers below 2n, the small side n / ratio
+// keys drawn from the same range, so about half of them are shared.
+std::vector<int> SmallKeys(std::size_t n, std::size_t ratio) {
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> pick(0, static_cast<int>(2 * n) - 1);
+  std::vector<int> keys(n / ratio);
+  for (int& key : keys) key = pick(rng);
+  return keys;
+}
+
+template <typename MapType>
+void Fill(MapType& map, const std::vector<int>& keys) {
+  for (int key : keys) map.insert(key, key);
+}
+
+// Union adds the small map to the large one, intersection keeps the part
+// of the small map found in the large one; each against the loop of
+// single-element calls that does the same.
+template <typename MapType>
+void MapRows(const std::string& name, std::size_t n, std::size_t ratio) {
+  MapType large;
+  for (std::size_t i = 0; i < n; ++i) {
+    large.insert(static_cast<int>(2 * i), 0);
+  }
+  MapType small;
+  Fill(small, SmallKeys(n, ratio));
+  std::string prefix = name + " 1:" + std::to_string(ratio) + " ";
+  std::size_t ops = n + small.size();
+
+  MapType target(large);
+  bench::Timer loopUnion;
+  for (auto it = small.begin(); it != small.end(); ++it) {
+    target.insert(it->first, it->second);
+  }
+  bench::Row(prefix + "union: insert loop", n, loopUnion.Seconds(), ops);
+  bench::DoNotOptimize(target.size());
+  MapType joined(large);
+  bench::Timer union_;
+  joined.union_with(small);
+  bench::Row(prefix + "union_with", n, union_.Seconds(), ops);
+  bench::DoNotOptimize(joined.size());
+
+  bench::Timer loopIntersection;
+  MapType common;
+  for (auto it = small.begin(); it != small.end(); ++it) {
+    if (large.contains(it->first)) common.insert(it->first, it->second);
+  }
+  bench::Row(prefix + "intersect: lookup loop", n,
+             loopIntersection.Seconds(), ops);
+  bench::DoNotOptimize(common.size());
+  MapType kept(small);
+  bench::Timer intersection;
+  kept.intersect_with(large);
+  bench::Row(prefix + "intersect_with", n, intersection.Seconds(), ops);
+  bench::DoNotOptimize(kept.size());
+}
+
+void SetRows(std::size_t n, std::size_t ratio) {
+  std::vector<int> evens(n);
+  for (std::size_t i = 0; i < n; ++i) evens[i] = static_cast<int>(2 * i);
+  CustomSet<int> large(evens.begin(), evens.end());
+  std::vector<int> keys = SmallKeys(n, ratio);
+  CustomSet<int> small(keys.begin(), keys.end());
+  std::string prefix = "CustomSet 1:" + std::to_string(ratio) + " ";
+  std::size_t ops = n + small.size();
+
+  CustomSet<int> target(large);
+  bench::Timer merge;
+  target.merge(small);
+  bench::Row(prefix + "union: merge", n, merge.Seconds(), ops);
+  target = large;
+  bench::Timer union_;
+  target.union_with(small);
+  bench::Row(prefix + "union_with", n, union_.Seconds(), ops);
+  bench::DoNotOptimize(target.size());
+
+  target = small;
+  bench::Timer intersection;
+  target.intersect_with(large);
+  bench::Row(prefix + "intersect_with", n, intersection.Seconds(), ops);
+  bench::DoNotOptimize(target.size());
+}
+
+}  // namespace
+
+// ns/op is per element of the two inputs together.
+BENCH_CASE(set_algebra) {
+  bench::Header("Set algebra on ordered containers across size ratios");
+  for (std::size_t n : bench::Sizes(options, 1000000)) {
+    for (std::size_t ratio : kRatios) {
+      bench::RunIsolated([=] { MapRows<PoolMap>("Map", n, ratio); });
+      bench::RunIsolated([=] { MapRows<BTreeMap>("Map<B-tree>", n, ratio); });
+      bench::RunIsolated([=] { SetRows(n, ratio); });
+    }
+  }
+}
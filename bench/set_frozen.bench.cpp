@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "custom_set.h"
+
+namespace {
+
+constexpr std::size_t kQueries = 2000000;
+
+std::vector<int> Probes(std::size_t n) {
+  std::mt19937 rng(17);
+  std::uniform_int_distribution<int> pick(0, static_cast<int>(n) * 2 - 1);
+  std::vector<int> probes(kQueries);
+  for (int& probe : probes) probe = pick(rng);
+  return probes;
+}
+
+void Lookups(std::size_t n) {
+  std::vector<int> sorted(n);
+  for (std::size_t i = 0; i < n; ++i) sorted[i] = static_cast<int>(2 * i);
+  std::vector<int> probes = Probes(2 * n);
+
+  bench::Timer branchyTimer;
+  std::size_t hits = 0;
+  for (int probe : probes) {
+    hits += std::binary_search(sorted.begin(), sorted.end(), probe);
+  }
+  double branchySeconds = branchyTimer.Seconds();
+
+  CustomSet<int> set(sorted.begin(), sorted.end());
+  bench::Timer branchlessTimer;
+  for (int probe : probes) hits += set.contains(probe);
+  double branchlessSeconds = branchlessTimer.Seconds();
+
+  set.freeze();
+  bench::Timer frozenTimer;
+  for (int probe : probes) hits += set.contains(probe);
+  double frozenSeconds = frozenTimer.Seconds();
+  bench::DoNotOptimize(hits);
+
+  bench::Row("std::binary_search", n, branchySeconds, kQueries,
+             bench::Mib(n * sizeof(int) / 1024));
+  bench::Row("CustomSet branchless", n, branchlessSeconds, kQueries);
+  bench::Row("CustomSet frozen (Eytzinger)", n, frozenSeconds, kQueries);
+}
+
+}  // namespace
+
+// 1K ints fit in L1, 1M in L2/L3, 10M and 100M are far beyond the LLC.
+// Run with --max=100000000 to reach the largest size.
+BENCH_CASE(set_frozen) {
+  bench::Header("CustomSet<int>::contains: sorted array vs Eytzinger layout");
+  for (std::size_t n : bench::Sizes(options, 1000)) {
+    bench::RunIsolated([n] { Lookups(n); });
+  }
+}
@@ -0,0 +1,61 @@
+#include <cstddef>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "custom_multiset.h"
+#include "custom_set.h"
+
+namespace {
+
+constexpr std::size_t kQueries = 1000000;
+
+// Read-heavy workload: one bulk build, then a mix of hits, misses and
+// lower_bound queries.
+template <typename Set>
+void BuildAndQuery(const std::string& label, const std::vector<int>& keys) {
+  std::size_t rssBefore = bench::RssKb();
+  bench::Timer buildTimer;
+  Set set(keys.begin(), keys.end());
+  double buildSeconds = buildTimer.Seconds();
+  std::size_t rss = bench::RssKb() - rssBefore;
+
+  std::mt19937 rng(13);
+  // Keys are 0..n-1, so half of the probes miss.
+  std::uniform_int_distribution<int> pick(
+      0, static_cast<int>(keys.size()) * 2 - 1);
+  std::size_t hits = 0;
+  bench::Timer findTimer;
+  for (std::size_t q = 0; q < kQueries; ++q) {
+    hits += set.find(pick(rng)) != set.end();
+  }
+  double findSeconds = findTimer.Seconds();
+  bench::Timer boundTimer;
+  for (std::size_t q = 0; q < kQueries; ++q) {
+    hits += set.lower_bound(pick(rng)) != set.end();
+  }
+  double boundSeconds = boundTimer.Seconds();
+  bench::DoNotOptimize(hits);
+
+  bench::Row(label + " build", keys.size(), buildSeconds, keys.size(),
+             bench::Mib(rss));
+  bench::Row(label + " find", keys.size(), findSeconds, kQueries);
+  bench::Row(label + " lower_bound", keys.size(), boundSeconds, kQueries);
+}
+
+}  // namespace
+
+BENCH_CASE(set_lookup) {
+  bench::Header("Read-heavy int sets: CustomSet vs MultiSet vs std::set");
+  for (std::size_t n : bench::Sizes(options, 1000)) {
+    std::vector<int> keys = bench::ShuffledKeys(n);
+    bench::RunIsolated(
+        [&] { BuildAndQuery<CustomSet<int>>("CustomSet", keys); });
+    bench::RunIsolated(
+        [&] { BuildAndQuery<MultiSet<int>>("MultiSet", keys); });
+    bench::RunIsolated(
+        [&] { BuildAndQuery<std::set<int>>("std::set", keys); });
+  }
+}
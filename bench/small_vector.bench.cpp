@@ -0,0 +1,116 @@
+#include <cstddef>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "bench.h"
+#include "custom_vector.h"
+#include "small_vector.h"
+
+namespace {
+
+using Small = SmallVector<int, 8>;
+
+// Lengths drawn uniformly from 1 to maxLength.
+std::vector<int> Lengths(std::size_t n, int maxLength) {
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> length(1, maxLength);
+  std::vector<int> lengths(n);
+  for (int& value : lengths) value = length(rng);
+  return lengths;
+}
+
+// Every capacity change of a vector off its inline buffer is one call to
+// malloc, realloc or operator new. CustomVector<int> grows with realloc,
+// which bench::Allocations() does not see, so the vectors count their own.
+template <typename Vec>
+bool OnHeap(const Vec& vec) {
+  if constexpr (std::is_same<Vec, Small>::value) {
+    return !vec.is_inline();
+  } else {
+    return true;
+  }
+}
+
+template <typename Vec>
+void Fill(Vec& vec, int length, std::size_t& allocations) {
+  for (int i = 0; i < length; ++i) {
+    std::size_t capacity = vec.capacity();
+    vec.push_back(i);
+    if (vec.capacity() != capacity && OnHeap(vec)) ++allocations;
+  }
+}
+
+// Builds a vector per length, reads it and drops it.
+template <typename Vec>
+void Transient(const std::string& label, const std::vector<int>& lengths) {
+  std::size_t allocations = 0;
+  long long sum = 0;
+  bench::Timer timer;
+  for (int length : lengths) {
+    Vec vec;
+    Fill(vec, length, allocations);
+    sum += vec[vec.size() - 1];
+  }
+  double seconds = timer.Seconds();
+  bench::Row(label, lengths.size(), seconds, lengths.size(),
+             bench::PerOp("allocs/vector", static_cast<double>(allocations),
+                          lengths.size()));
+  bench::DoNotOptimize(sum);
+}
+
+// Builds a vector per length and keeps them all, as the values of a table
+// would be; the note adds the memory they hold.
+template <typename Vec>
+void Retained(const std::string& label, const std::vector<int>& lengths) {
+  std::size_t allocations = 0;
+  std::size_t rssBefore = bench::RssKb();
+  bench::Timer timer;
+  std::vector<Vec> table(lengths.size());
+  for (std::size_t i = 0; i < lengths.size(); ++i) {
+    Fill(table[i], lengths[i], allocations);
+  }
+  double seconds = timer.Seconds();
+  std::size_t rss = bench::RssKb() - rssBefore;
+  bench::Row(label, lengths.size(), seconds, lengths.size(),
+             bench::PerOp("allocs/vector", static_cast<double>(allocations),
+                          lengths.size()) +
+                 " rss=" + bench::Mib(rss));
+  bench::DoNotOptimize(table.back().size());
+}
+
+void Mix(const std::string& name, std::size_t n, int maxLength) {
+  std::vector<int> lengths = Lengths(n, maxLength);
+  bench::RunIsolated([&] {
+    Transient<CustomVector<int>>("CustomVector<int> " + name, lengths);
+  });
+  bench::RunIsolated([&] {
+    Transient<std::vector<int>>("std::vector<int> " + name, lengths);
+  });
+  bench::RunIsolated(
+      [&] { Transient<Small>("SmallVector<int, 8> " + name, lengths); });
+  bench::RunIsolated([&] {
+    Retained<CustomVector<int>>("kept CustomVector<int> " + name, lengths);
+  });
+  bench::RunIsolated([&] {
+    Retained<std::vector<int>>("kept std::vector<int> " + name, lengths);
+  });
+  bench::RunIsolated(
+      [&] { Retained<Small>("kept SmallVector<int, 8> " + name, lengths); });
+}
+
+}  // namespace
+
+// n is the number of vectors and ns/op is per vector, push_backs included.
+// Lengths 1-8 all fit SmallVector<int, 8> inline; with 1-16 about half of
+// the vectors spill. SmallVector<int, 8> is 64 bytes, a CustomVector's 32
+// plus the buffer, which the kept rows pay for every vector even when it
+// spills.
+BENCH_CASE(small_vector) {
+  bench::Header("Short vectors: CustomVector vs std::vector vs SmallVector");
+  for (std::size_t n : bench::Sizes(options, 10000)) {
+    Mix("len 1-8", n, 8);
+    Mix("len 1-16", n, 16);
+  }
+}
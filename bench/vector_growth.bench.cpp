@@ -0,0 +1,106 @@
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "custom_vector.h"
+
+namespace {
+
+// An element with a real constructor: a heap-allocated name and a few
+// fields. The counter takes every constructor call, so that work on
+// capacity nobody asked to fill shows up next to the elements that were.
+struct Record {
+  static inline std::size_t constructed = 0;
+
+  Record() { ++constructed; }
+  explicit Record(int id)
+      : id(id), name("record number " + std::to_string(id)) {
+    ++constructed;
+  }
+  Record(const Record& other) : id(other.id), name(other.name) {
+    ++constructed;
+  }
+  Record(Record&& other) noexcept
+      : id(other.id), name(std::move(other.name)) {
+    ++constructed;
+  }
+  Record& operator=(const Record&) = default;
+  Record& operator=(Record&&) noexcept = default;
+
+  int id = 0;
+  std::string name;
+  double score = 0;
+};
+
+std::string Constructions(std::size_t n) {
+  return bench::PerOp("ctors/elem", static_cast<double>(Record::constructed),
+                      n);
+}
+
+template <typename Vec>
+void Reserve(const std::string& label, std::size_t n) {
+  Record::constructed = 0;
+  bench::Timer timer;
+  Vec vec;
+  vec.reserve(n);
+  double seconds = timer.Seconds();
+  bench::Row(label, n, seconds, 1,
+             "ctors=" + std::to_string(Record::constructed));
+  bench::DoNotOptimize(vec.capacity());
+}
+
+template <typename Vec>
+void PushBack(const std::string& label, std::size_t n, bool reserve) {
+  Record::constructed = 0;
+  bench::Timer timer;
+  Vec vec;
+  if (reserve) vec.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    vec.push_back(Record(static_cast<int>(i)));
+  }
+  double seconds = timer.Seconds();
+  bench::Row(label, n, seconds, n, Constructions(n));
+  bench::DoNotOptimize(vec.size());
+}
+
+template <typename Vec>
+void PushBackInts(const std::string& label, std::size_t n) {
+  bench::Timer timer;
+  Vec vec;
+  for (std::size_t i = 0; i < n; ++i) vec.push_back(static_cast<int>(i));
+  bench::Row(label, n, timer.Seconds(), n);
+  bench::DoNotOptimize(vec.size());
+}
+
+}  // namespace
+
+// The reserve rows time a single reserve(n) call, so ns/op is for the
+// whole call. The push_back rows count each element's temporary, its move
+// into the vector and the moves of later growth.
+BENCH_CASE(vector_growth) {
+  bench::Header("CustomVector<Record>: reserve and push_back");
+  for (std::size_t n : bench::Sizes(options, 1000)) {
+    bench::RunIsolated(
+        [n] { Reserve<CustomVector<Record>>("CustomVector reserve", n); });
+    bench::RunIsolated(
+        [n] { Reserve<std::vector<Record>>("std::vector reserve", n); });
+    bench::RunIsolated([n] {
+      PushBack<CustomVector<Record>>("CustomVector push_back", n, false);
+    });
+    bench::RunIsolated([n] {
+      PushBack<CustomVector<Record>>("CustomVector reserve + push_back", n,
+                                     true);
+    });
+    bench::RunIsolated([n] {
+      PushBack<std::vector<Record>>("std::vector push_back", n, false);
+    });
+    bench::RunIsolated([n] {
+      PushBackInts<CustomVector<int>>("CustomVector<int> push_back", n);
+    });
+    bench::RunIsolated([n] {
+      PushBackInts<std::vector<int>>("std::vector<int> push_back", n);
+    });
+  }
+}
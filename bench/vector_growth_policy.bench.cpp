@@ -0,0 +1,125 @@
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "custom_vector.h"
+#include "vector_growth.h"
+
+namespace {
+
+// 16 bytes with a move constructor of its own: not trivially relocatable,
+// so every reallocation moves the elements one by one into a new block.
+struct Moved {
+  Moved(long long a, long long b) : a(a), b(b) {}
+  Moved(Moved&& other) noexcept : a(other.a), b(other.b) {}
+  Moved(const Moved&) = default;
+  Moved& operator=(const Moved&) = default;
+
+  long long a;
+  long long b;
+};
+
+constexpr std::size_t kChunkBytes = 1 << 20;
+// Chunk growth of elements that cannot go through realloc moves the whole
+// vector every chunk, O(n^2) in all; past this many reallocations the row
+// is skipped.
+constexpr std::size_t kMaxChunkReallocations = 100;
+
+template <typename T>
+T Make(std::size_t i);
+
+template <>
+int Make<int>(std::size_t i) {
+  return static_cast<int>(i);
+}
+
+template <>
+Moved Make<Moved>(std::size_t i) {
+  return Moved(static_cast<long long>(i), 0);
+}
+
+std::string Percent(double part, double whole) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.1f%%", 100.0 * part / whole);
+  return buffer;
+}
+
+// Pushes n elements and reports the time per element, the reallocations
+// and the bytes they copied per element, the unused share of the final
+// buffer, the largest unused part of any buffer and the RSS the vector
+// holds.
+template <typename T, typename Growth>
+void Push(const std::string& label, std::size_t n) {
+  using Vec = CustomVector<T, std::allocator<T>, GrowthStats<Growth>>;
+  std::size_t rssBefore = bench::RssKb();
+  bench::Timer timer;
+  Vec vec;
+  for (std::size_t i = 0; i < n; ++i) vec.push_back(Make<T>(i));
+  double seconds = timer.Seconds();
+  std::size_t rss = bench::RssKb() - rssBefore;
+  const GrowthStats<Growth>& stats = vec.growth_policy();
+  bench::Row(label, n, seconds, n,
+             "reallocs=" + std::to_string(stats.reallocations()) + " " +
+                 bench::PerOp("copied/elem",
+                              static_cast<double>(stats.bytes_copied()),
+                              n) +
+                 " slack=" +
+                 Percent(static_cast<double>(vec.capacity() - n),
+                         static_cast<double>(n)) +
+                 " peak=" + bench::Mib(stats.peak_slack_bytes() / 1024) +
+                 " rss=" + bench::Mib(rss));
+  bench::DoNotOptimize(vec[n - 1]);
+}
+
+template <typename T>
+void PushStd(const std::string& label, std::size_t n) {
+  std::size_t rssBefore = bench::RssKb();
+  bench::Timer timer;
+  std::vector<T> vec;
+  for (std::size_t i = 0; i < n; ++i) vec.push_back(Make<T>(i));
+  double seconds = timer.Seconds();
+  std::size_t rss = bench::RssKb() - rssBefore;
+  bench::Row(label, n, seconds, n,
+             "slack=" +
+                 Percent(static_cast<double>(vec.capacity() - n),
+                         static_cast<double>(n)) +
+                 " rss=" + bench::Mib(rss));
+  bench::DoNotOptimize(vec[n - 1]);
+}
+
+template <typename T>
+void Policies(const std::string& name, std::size_t n) {
+  std::string custom = "CustomVector<" + name + "> ";
+  bench::RunIsolated(
+      [&] { Push<T, DoublingGrowth>(custom + "doubling", n); });
+  bench::RunIsolated([&] { Push<T, HalfAgainGrowth>(custom + "1.5x", n); });
+  bench::RunIsolated(
+      [&] { Push<T, SizeClassGrowth>(custom + "size classes", n); });
+  if (IsTriviallyRelocatable<T>::value ||
+      n / (kChunkBytes / sizeof(T)) <= kMaxChunkReallocations) {
+    bench::RunIsolated([&] {
+      Push<T, ChunkGrowth<kChunkBytes>>(custom + "1MiB chunks", n);
+    });
+  }
+  bench::RunIsolated([&] { PushStd<T>("std::vector<" + name + ">", n); });
+}
+
+}  // namespace
+
+// ns/op is per push_back. copied/elem counts the bytes reallocations moved
+// per element, zero where realloc extended the block in place; int takes
+// the realloc path, Moved is moved element by element. slack is the
+// unused share of the final buffer and peak the most unused capacity any
+// reallocation left. Capacity realloc never touches stays out of rss. For
+// 1B elements pass --max=1000000000 (about 4GiB of int, and 16GiB of
+// Moved).
+BENCH_CASE(vector_growth_policy) {
+  bench::Header("CustomVector growth policies: memory overhead vs speed");
+  for (std::size_t n : bench::Sizes(options, 1000)) {
+    Policies<int>("int", n);
+    Policies<Moved>("Moved", n);
+  }
+}
@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "bench.h"
+#include "custom_vector.h"
+
+namespace {
+
+// A 64-byte plain record: trivially copyable, so CustomVector relocates it
+// with memcpy and memmove.
+struct Pod64 {
+  int fields[16];
+};
+
+constexpr std::size_t kShiftBudget = 20000000;
+
+template <typename T>
+T Make(std::size_t i);
+
+template <>
+int Make<int>(std::size_t i) {
+  return static_cast<int>(i);
+}
+
+template <>
+Pod64 Make<Pod64>(std::size_t i) {
+  Pod64 pod{};
+  pod.fields[0] = static_cast<int>(i);
+  return pod;
+}
+
+// Long enough to live on the heap, so a move steals the buffer.
+template <>
+std::string Make<std::string>(std::size_t i) {
+  return "element number " + std::to_string(i) + " of the benchmark";
+}
+
+template <typename Vec>
+const void* First(const Vec& vec) {
+  return &vec[0];
+}
+
+// The note counts the growths that realloc managed without moving the
+// buffer.
+template <typename Vec, typename T>
+void PushBack(const std::string& label, std::size_t n) {
+  bench::Timer timer;
+  Vec vec;
+  std::size_t growths = 0;
+  std::size_t inPlace = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    std::size_t capacity = vec.capacity();
+    const void* before = vec.size() > 0 ? First(vec) : nullptr;
+    vec.push_back(Make<T>(i));
+    if (vec.capacity() != capacity && before != nullptr) {
+      ++growths;
+      inPlace += First(vec) == before ? 1 : 0;
+    }
+  }
+  double seconds = timer.Seconds();
+  bench::Row(label, n, seconds, n,
+             "in place " + std::to_string(inPlace) + "/" +
+                 std::to_string(growths));
+  bench::DoNotOptimize(vec.size());
+}
+
+// Inserts at random positions, then erases the same number, so every call
+// shifts half the vector on average. The number of calls falls as n grows
+// to keep the total bytes moved bounded.
+template <typename Vec, typename T>
+void InsertErase(const std::string& label, std::size_t n) {
+  Vec vec;
+  for (std::size_t i = 0; i < n; ++i) vec.push_back(Make<T>(i));
+  std::size_t ops = std::clamp<std::size_t>(kShiftBudget / n, 10, 10000);
+  std::mt19937 rng(7);
+  std::vector<std::size_t> positions(ops);
+  for (std::size_t& position : positions) position = rng() % n;
+  T value = Make<T>(n);
+  bench::Timer timer;
+  for (std::size_t position : positions) {
+    if constexpr (std::is_same<Vec, CustomVector<T>>::value) {
+      vec.insert(position, value);
+    } else {
+      vec.insert(vec.begin() + position, value);
+    }
+  }
+  for (std::size_t position : positions) {
+    if constexpr (std::is_same<Vec, CustomVector<T>>::value) {
+      vec.erase(position);
+    } else {
+      vec.erase(vec.begin() + position);
+    }
+  }
+  bench::Row(label, n, timer.Seconds(), 2 * ops);
+  bench::DoNotOptimize(vec.size());
+}
+
+template <typename Vec, typename T>
+void ShrinkToFit(const std::string& label, std::size_t n) {
+  Vec vec;
+  vec.reserve(2 * n);
+  for (std::size_t i = 0; i < n; ++i) vec.push_back(Make<T>(i));
+  bench::Timer timer;
+  vec.shrink_to_fit();
+  bench::Row(label, n, timer.Seconds(), n);
+  bench::DoNotOptimize(vec.capacity());
+}
+
+template <typename T>
+void Type(const std::string& name, std::size_t n) {
+  using Custom = CustomVector<T>;
+  using Std = std::vector<T>;
+  bench::RunIsolated([&] {
+    PushBack<Custom, T>("CustomVector<" + name + "> push_back", n);
+  });
+  bench::RunIsolated([&] {
+    PushBack<Std, T>("std::vector<" + name + "> push_back", n);
+  });
+  bench::RunIsolated([&] {
+    InsertErase<Custom, T>("CustomVector<" + name + "> insert/erase", n);
+  });
+  bench::RunIsolated([&] {
+    InsertErase<Std, T>("std::vector<" + name + "> insert/erase", n);
+  });
+  bench::RunIsolated([&] {
+    ShrinkToFit<Custom, T>("CustomVector<" + name + "> shrink_to_fit", n);
+  });
+}
+
+}  // namespace
+
+// ns/op is per element for push_back and shrink_to_fit, and per call for
+// insert/erase, whose calls each shift about n/2 elements. int and Pod64
+// are trivially relocatable; std::string is not and takes the element-wise
+// paths.
+BENCH_CASE(vector_relocate) {
+  bench::Header("CustomVector relocation: int, 64-byte POD, std::string");
+  for (std::size_t n : bench::Sizes(options, 1000)) {
+    Type<int>("int", n);
+    Type<Pod64>("Pod64", n);
+    Type<std::string>("string", n);
+  }
+}
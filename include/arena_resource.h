@@ -0,0 +1,178 @@
+#ifndef INCLUDE_ARENA_RESOURCE_H_
+#define INCLUDE_ARENA_RESOURCE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+// Monotonic memory resource for request-scoped containers: allocation bumps
+// a pointer through chunks taken from an upstream resource, deallocation
+// does nothing, and everything is handed back at once by release() or when
+// the arena is destroyed. Each new chunk is twice the size of the last, so
+// n bytes cost O(log n) upstream calls.
+//
+// reset() drops every allocation but keeps the largest chunk, so an arena
+// reused request after request settles on a chunk that fits a whole request
+// and stops calling upstream at all. Memory freed by a container during the
+// request is not reused until then: containers that keep growing and
+// shrinking are better served by NodePool or the default allocator.
+//
+// Like std::pmr::monotonic_buffer_resource, an arena is not thread-safe;
+// share one between the containers of a request, not between threads.
+class ArenaResource : public std::pmr::memory_resource {
+ public:
+  using size_type = std::size_t;
+
+  explicit ArenaResource(
+      std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+  ArenaResource(size_type initialBytes, std::pmr::memory_resource* upstream =
+                                            std::pmr::new_delete_resource());
+  ArenaResource(const ArenaResource&) = delete;
+  ArenaResource& operator=(const ArenaResource&) = delete;
+  ~ArenaResource() override;
+
+  // Returns every chunk to upstream.
+  void release() noexcept;
+  // Rewinds to an empty arena that keeps its largest chunk.
+  void reset() noexcept;
+
+  std::pmr::memory_resource* upstream_resource() const noexcept;
+  size_type chunk_count() const noexcept;
+  // Bytes taken from upstream, and bytes handed out since the last release
+  // or reset, alignment padding included.
+  size_type reserved_bytes() const noexcept;
+  size_type used_bytes() const noexcept;
+
+ protected:
+  void* do_allocate(size_type bytes, size_type alignment) override;
+  void do_deallocate(void* ptr, size_type bytes,
+                     size_type alignment) override;
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override;
+
+ private:
+  // Starts every chunk; the usable bytes follow it.
+  struct Chunk {
+    Chunk* next;
+    size_type bytes;
+  };
+
+  static constexpr size_type kHeaderBytes =
+      (sizeof(Chunk) + alignof(std::max_align_t) - 1) /
+      alignof(std::max_align_t) * alignof(std::max_align_t);
+  static constexpr size_type kFirstChunkBytes = 4096;
+
+  std::pmr::memory_resource* upstream;
+  Chunk* chunks;
+  std::uintptr_t cursor;
+  std::uintptr_t cursorEnd;
+  size_type nextChunkBytes;
+  size_type chunkCount;
+  size_type reservedBytes;
+  size_type usedBytes;
+
+  void grow(size_type bytes, size_type alignment);
+  void startChunk(Chunk* chunk) noexcept;
+};
+
+inline ArenaResource::ArenaResource(std::pmr::memory_resource* upstream)
+    : ArenaResource(kFirstChunkBytes, upstream) {}
+inline ArenaResource::ArenaResource(size_type initialBytes,
+                                    std::pmr::memory_resource* upstream)
+    : upstream(upstream),
+      chunks(nullptr),
+      cursor(0),
+      cursorEnd(0),
+      nextChunkBytes(initialBytes > 0 ? initialBytes : kFirstChunkBytes),
+      chunkCount(0),
+      reservedBytes(0),
+      usedBytes(0) {}
+inline ArenaResource::~ArenaResource() { release(); }
+
+inline void ArenaResource::release() noexcept {
+  while (chunks != nullptr) {
+    Chunk* next = chunks->next;
+    upstream->deallocate(chunks, kHeaderBytes + chunks->bytes,
+                         alignof(std::max_align_t));
+    chunks = next;
+  }
+  cursor = 0;
+  cursorEnd = 0;
+  chunkCount = 0;
+  reservedBytes = 0;
+  usedBytes = 0;
+}
+
+// Chunks double in size, so the newest one is the largest.
+inline void ArenaResource::reset() noexcept {
+  if (chunks == nullptr) return;
+  Chunk* largest = chunks;
+  chunks = chunks->next;
+  release();
+  largest->next = nullptr;
+  chunks = largest;
+  chunkCount = 1;
+  reservedBytes = kHeaderBytes + largest->bytes;
+  startChunk(largest);
+}
+
+inline std::pmr::memory_resource* ArenaResource::upstream_resource()
+    const noexcept {
+  return upstream;
+}
+inline ArenaResource::size_type ArenaResource::chunk_count() const noexcept {
+  return chunkCount;
+}
+inline ArenaResource::size_type ArenaResource::reserved_bytes()
+    const noexcept {
+  return reservedBytes;
+}
+inline ArenaResource::size_type ArenaResource::used_bytes() const noexcept {
+  return usedBytes;
+}
+
+inline void* ArenaResource::do_allocate(size_type bytes,
+                                        size_type alignment) {
+  std::uintptr_t start = (cursor + alignment - 1) & ~(alignment - 1);
+  if (cursor == 0 || start > cursorEnd || cursorEnd - start < bytes) {
+    grow(bytes, alignment);
+    start = (cursor + alignment - 1) & ~(alignment - 1);
+  }
+  usedBytes += start + bytes - cursor;
+  cursor = start + bytes;
+  return reinterpret_cast<void*>(start);
+}
+
+inline void ArenaResource::do_deallocate(void*, size_type, size_type) {}
+
+inline bool ArenaResource::do_is_equal(
+    const std::pmr::memory_resource& other) const noexcept {
+  return this == &other;
+}
+
+// The new chunk holds the request even at the worst alignment offset.
+inline void ArenaResource::grow(size_type bytes, size_type alignment) {
+  size_type needed = bytes + alignment;
+  if (needed < bytes) throw std::bad_alloc();
+  size_type chunkBytes = nextChunkBytes;
+  while (chunkBytes < needed) {
+    chunkBytes = chunkBytes > needed / 2 ? needed : chunkBytes * 2;
+  }
+  Chunk* chunk = static_cast<Chunk*>(upstream->allocate(
+      kHeaderBytes + chunkBytes, alignof(std::max_align_t)));
+  chunk->next = chunks;
+  chunk->bytes = chunkBytes;
+  chunks = chunk;
+  ++chunkCount;
+  reservedBytes += kHeaderBytes + chunkBytes;
+  nextChunkBytes = chunkBytes * 2;
+  startChunk(chunk);
+}
+
+inline void ArenaResource::startChunk(Chunk* chunk) noexcept {
+  cursor = reinterpret_cast<std::uintptr_t>(chunk) + kHeaderBytes;
+  cursorEnd = cursor + chunk->bytes;
+}
+
+#endif  // INCLUDE_ARENA_RESOURCE_H_
@@ -0,0 +1,1271 @@
+#ifndef SRC_B_TREE_H
+#define SRC_B_TREE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "node_pool.h"
+#include "rb_tree.h"
+
+// Uninitialized room for Slots objects of type T. The tree constructs and
+// destroys the objects itself as elements move between nodes.
+template <typename T, std::size_t Slots>
+struct BTreeSlots {
+  void* slot(std::size_t i) { return storage + i * sizeof(T); }
+  T& operator[](std::size_t i) {
+    return *std::launder(reinterpret_cast<T*>(slot(i)));
+  }
+  const T& operator[](std::size_t i) const {
+    return *std::launder(reinterpret_cast<const T*>(storage + i * sizeof(T)));
+  }
+
+  alignas(T) unsigned char storage[sizeof(T) * Slots];
+};
+
+// Key array, present only when the keys are kept apart from the values.
+template <typename KeyType, std::size_t Slots, bool Separate>
+struct BTreeNodeKeys {};
+template <typename KeyType, std::size_t Slots>
+struct BTreeNodeKeys<KeyType, Slots, true> {
+  BTreeSlots<KeyType, Slots> keys;
+};
+
+template <typename KeyType, typename ValueType, std::size_t Slots,
+          bool SeparateKeys>
+struct BTreeNode : BTreeNodeKeys<KeyType, Slots, SeparateKeys> {
+  BTreeNode() : parent(nullptr), position(0), count(0), leaf(true) {}
+
+  BTreeNode* parent;
+  std::uint16_t position;  // index among the parent's children
+  std::uint16_t count;
+  bool leaf;
+  BTreeSlots<ValueType, Slots> values;
+};
+
+template <typename KeyType, typename ValueType, std::size_t Slots,
+          bool SeparateKeys>
+struct BTreeInternalNode
+    : BTreeNode<KeyType, ValueType, Slots, SeparateKeys> {
+  BTreeInternalNode() { this->leaf = false; }
+
+  BTreeNode<KeyType, ValueType, Slots, SeparateKeys>* children[Slots + 1];
+};
+
+// BTree's counterpart of RBTreeNodeHandle. A B-tree has no node per
+// element to hand over, so the handle holds the element itself, moved out
+// of its slot, and needs keys that are read from the value.
+template <typename KeyType, typename ValueType, typename KeyOfValue>
+class BTreeNodeHandle {
+ public:
+  using key_type = KeyType;
+  using value_type = ValueType;
+
+  BTreeNodeHandle() = default;
+  BTreeNodeHandle(BTreeNodeHandle&& other) noexcept
+      : element(std::move(other.element)) {
+    other.element.reset();
+  }
+  BTreeNodeHandle& operator=(BTreeNodeHandle&& other) noexcept {
+    if (this != &other) {
+      element.reset();
+      if (other.element.has_value()) {
+        element.emplace(std::move(*other.element));
+        other.element.reset();
+      }
+    }
+    return *this;
+  }
+
+  bool empty() const { return !element.has_value(); }
+  explicit operator bool() const { return element.has_value(); }
+  value_type& value() const { return *element; }
+  const key_type& key() const { return KeyOfValue::get(*element); }
+
+ private:
+  template <typename, typename, typename, bool, typename, std::size_t,
+            typename>
+  friend class BTree;
+
+  mutable std::optional<ValueType> element;
+};
+
+// B-tree with the same interface as RBTree, so Map and MultiSet can use it
+// through BTreeBackend. Elements are stored in sorted arrays inside the
+// nodes and a search touches one node per level. Since the tree is only
+// log_B(n) levels deep, that means far fewer cache misses than one per
+// level of a binary tree.
+//
+// Fan-out is NodeBytes divided by the size of what a search compares, so
+// the searched array of a node spans NodeBytes / 64 cache lines. Small
+// trivially copyable keys are kept in their own array next to the values
+// and searched there. Other keys are read from the values via KeyOfValue,
+// which is one of the RBTree key extractors.
+//
+// Unlike RBTree nodes, elements move between nodes when the tree changes,
+// so any insert or erase invalidates every Position.
+//
+// Compare orders the keys as in RBTree, including transparent lookups.
+template <typename KeyType, typename ValueType,
+          typename Allocator = NodePool<ValueType>, bool UniqueKeys = true,
+          typename KeyOfValue = RBTreeStoredKey, std::size_t NodeBytes = 256,
+          typename Compare = std::less<KeyType>>
+class BTree {
+  static constexpr bool kSeparateKeys =
+      KeyOfValue::kStoresKey ||
+      (!std::is_same<KeyOfValue, RBTreeIdentityKey>::value &&
+       std::is_trivially_copyable<KeyType>::value);
+  using Searched = std::conditional_t<kSeparateKeys, KeyType, ValueType>;
+
+ public:
+  static constexpr std::size_t kSlots =
+      std::max<std::size_t>(4, std::min<std::size_t>(
+                                   1024, NodeBytes / sizeof(Searched)));
+
+  using Node = BTreeNode<KeyType, ValueType, kSlots, kSeparateKeys>;
+  using InternalNode =
+      BTreeInternalNode<KeyType, ValueType, kSlots, kSeparateKeys>;
+  // An element is a slot in a node; the default Position is end().
+  struct Position {
+    Node* node = nullptr;
+    std::size_t slot = 0;
+
+    bool operator==(const Position& other) const {
+      return node == other.node && slot == other.slot;
+    }
+    bool operator!=(const Position& other) const { return !(*this == other); }
+  };
+  using InsertResult = std::pair<Position, bool>;
+  using NodeHandle = BTreeNodeHandle<KeyType, ValueType, KeyOfValue>;
+  using key_type = KeyType;
+  using value_type = ValueType;
+  using allocator_type = Allocator;
+  using key_compare = Compare;
+
+  BTree();
+  explicit BTree(const Allocator& alloc);
+  BTree(const BTree& other);
+  BTree(BTree&& other) noexcept;
+  ~BTree();
+
+  BTree& operator=(const BTree& other);
+  BTree& operator=(BTree&& other) noexcept;
+
+  // Same contract as RBTree: a hint is the element the new key should
+  // precede (end() to append) and saves the descent from the root when it
+  // is right. Without UniqueKeys a new key goes after its equals.
+  InsertResult insert(const KeyType& key, const ValueType& value);
+  InsertResult insertWithHint(Position hint, const KeyType& key,
+                              const ValueType& value);
+  // RBTree's emplace family: the value is built in its slot from args. As
+  // slots hold elements directly, emplaceValue builds the value on the
+  // stack to learn its key and moves it in.
+  template <typename... Args>
+  InsertResult emplace(const KeyType& key, Args&&... args);
+  template <typename... Args>
+  InsertResult emplaceWithHint(Position hint, const KeyType& key,
+                               Args&&... args);
+  template <typename... Args>
+  InsertResult emplaceValue(Args&&... args);
+  template <typename... Args>
+  InsertResult emplaceValueWithHint(Position hint, Args&&... args);
+  // Replaces the contents with the sorted range [first, last) by appending
+  // each element to the rightmost leaf.
+  template <typename ForwardIt, typename GetKey>
+  void buildFromSorted(ForwardIt first, ForwardIt last, GetKey keyOf);
+  // remove erases one element equal to `key` and throws if there is none.
+  // removeNode erases the element at `position`.
+  void remove(const KeyType& key);
+  void removeNode(Position position);
+  // RBTree's node handle interface. The element moves into the handle and
+  // back into a slot, so no allocation is needed beyond the tree's own
+  // splits; mergeFrom moves elements the same way.
+  NodeHandle extractNode(Position position);
+  InsertResult insertNode(NodeHandle& handle);
+  InsertResult insertNodeWithHint(Position hint, NodeHandle& handle);
+  void mergeFrom(BTree& other);
+  // RBTree::combine. The result is appended to a new tree in one ordered
+  // walk, moving this tree's elements and copying those of `other`; the
+  // same lookups replace the walk when the sizes are far apart.
+  void combine(const BTree& other, RBTreeSetOp op);
+  void clear();
+  int size() const;
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  bool contains(const K& key) const;
+  bool contains(const KeyType& key) const { return contains<KeyType>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  Position find(const K& key) const;
+  Position find(const KeyType& key) const { return find<KeyType>(key); }
+  Position minimum() const;
+  Position maximum() const;
+  static Position findNext(Position position);
+  static Position findPrev(Position position);
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  Position lowerBound(const K& key) const;
+  Position lowerBound(const KeyType& key) const {
+    return lowerBound<KeyType>(key);
+  }
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  Position upperBound(const K& key) const;
+  Position upperBound(const KeyType& key) const {
+    return upperBound<KeyType>(key);
+  }
+  bool isEmpty() const { return treeSize == 0; }
+  static std::size_t occurrences(Position) { return 1; }
+  static ValueType& valueOf(Position position) {
+    return position.node->values[position.slot];
+  }
+  Compare keyComp() const { return compare; }
+
+ private:
+  using LeafAllocator =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+  using LeafTraits = std::allocator_traits<LeafAllocator>;
+  using InternalAllocator = typename std::allocator_traits<
+      Allocator>::template rebind_alloc<InternalNode>;
+  using InternalTraits = std::allocator_traits<InternalAllocator>;
+
+  static constexpr std::size_t kMinSlots = (kSlots - 1) / 2;
+
+  LeafAllocator leafAllocator;
+  InternalAllocator internalAllocator;
+  Compare compare;
+  Node* root;
+  int treeSize;
+
+  // An empty tree with copies of `other`'s allocators and compare, whose
+  // nodes `other` can take over by move assignment.
+  struct EmptyLike {};
+  BTree(EmptyLike, const BTree& other);
+
+  Node* createNode(bool leaf);
+  void destroyNode(Node* node);
+  void destroySubtree(Node* node);
+  Node* copySubtree(const Node* node);
+
+  static const KeyType& keyAt(const Node* node, std::size_t slot);
+  static Node* child(const Node* node, std::size_t i);
+  static void setChild(Node* node, std::size_t i, Node* newChild);
+  static Node* firstLeaf(Node* node);
+  static Node* lastLeaf(Node* node);
+  template <bool Upper, typename K>
+  std::size_t searchNode(const Node* node, const K& key) const;
+  template <bool Upper, typename K>
+  Position bound(const K& key) const;
+
+  // Builds the key (when kept apart) and then the value from args.
+  template <typename... Args>
+  static void constructSlot(Node* node, std::size_t slot, const KeyType& key,
+                            Args&&... args);
+  static void destroySlot(Node* node, std::size_t slot);
+  static void moveSlot(Node* to, std::size_t toSlot, Node* from,
+                       std::size_t fromSlot);
+  static void shiftRight(Node* node, std::size_t first, std::size_t last);
+  static void shiftLeft(Node* node, std::size_t first, std::size_t last);
+
+  Node* split(Node* node);
+  template <typename... Args>
+  Position insertInLeaf(Node* leaf, std::size_t slot, const KeyType& key,
+                        Args&&... args);
+  void rebalance(Node* node);
+  static void rotateRight(Node* left, Node* node);
+  static void rotateLeft(Node* node, Node* right);
+  void merge(Node* left, Node* right);
+};
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::BTree()
+    : leafAllocator(),
+      internalAllocator(),
+      compare(),
+      root(nullptr),
+      treeSize(0) {}
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::BTree(const Allocator& alloc)
+    : leafAllocator(alloc),
+      internalAllocator(alloc),
+      compare(),
+      root(nullptr),
+      treeSize(0) {}
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::BTree(EmptyLike, const BTree& other)
+    : leafAllocator(other.leafAllocator),
+      internalAllocator(other.internalAllocator),
+      compare(other.compare),
+      root(nullptr),
+      treeSize(0) {}
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::BTree(const BTree& other)
+    : leafAllocator(LeafTraits::select_on_container_copy_construction(
+          other.leafAllocator)),
+      internalAllocator(InternalTraits::select_on_container_copy_construction(
+          other.internalAllocator)),
+      compare(other.compare),
+      root(nullptr),
+      treeSize(other.treeSize) {
+  root = copySubtree(other.root);
+}
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::BTree(BTree&& other) noexcept
+    : leafAllocator(std::move(other.leafAllocator)),
+      internalAllocator(std::move(other.internalAllocator)),
+      compare(other.compare),
+      root(other.root),
+      treeSize(other.treeSize) {
+  other.root = nullptr;
+  other.treeSize = 0;
+}
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::~BTree() {
+  clear();
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>&
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::operator=(const BTree& other) {
+  if (this != &other) {
+    clear();
+    compare = other.compare;
+    if constexpr (LeafTraits::propagate_on_container_copy_assignment::value) {
+      leafAllocator = other.leafAllocator;
+      internalAllocator = other.internalAllocator;
+    }
+    root = copySubtree(other.root);
+    treeSize = other.treeSize;
+  }
+  return *this;
+}
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>&
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::operator=(BTree&& other) noexcept {
+  if (this != &other) {
+    clear();
+    compare = other.compare;
+    if constexpr (LeafTraits::propagate_on_container_move_assignment::value) {
+      leafAllocator = std::move(other.leafAllocator);
+      internalAllocator = std::move(other.internalAllocator);
+    } else if (!(leafAllocator == other.leafAllocator &&
+                 internalAllocator == other.internalAllocator)) {
+      root = copySubtree(other.root);
+      treeSize = other.treeSize;
+      other.clear();
+      return *this;
+    }
+    root = other.root;
+    treeSize = other.treeSize;
+    other.root = nullptr;
+    other.treeSize = 0;
+  }
+  return *this;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::clear() {
+  destroySubtree(root);
+  root = nullptr;
+  treeSize = 0;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+int BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+          NodeBytes, Compare>::size() const {
+  return treeSize;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::InsertResult
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::insert(const KeyType& key, const ValueType& value) {
+  return emplace(key, value);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::InsertResult
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::insertWithHint(Position hint, const KeyType& key,
+                                          const ValueType& value) {
+  return emplaceWithHint(hint, key, value);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+template <typename... Args>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::InsertResult
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::emplace(const KeyType& key, Args&&... args) {
+  if (root == nullptr) {
+    root = createNode(true);
+  }
+  Node* node = root;
+  while (true) {
+    std::size_t slot = searchNode<!UniqueKeys>(node, key);
+    if (UniqueKeys && slot < node->count && !compare(key, keyAt(node, slot))) {
+      return std::make_pair(Position{node, slot}, false);
+    }
+    if (node->leaf) {
+      return std::make_pair(
+          insertInLeaf(node, slot, key, std::forward<Args>(args)...), true);
+    }
+    node = child(node, slot);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+template <typename... Args>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::InsertResult
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::emplaceWithHint(Position hint, const KeyType& key,
+                                           Args&&... args) {
+  if (root == nullptr) {
+    return emplace(key, std::forward<Args>(args)...);
+  }
+  Position prev = hint.node == nullptr ? maximum() : findPrev(hint);
+  bool afterPrev = prev.node == nullptr ||
+                   (UniqueKeys ? compare(keyAt(prev.node, prev.slot), key)
+                               : !compare(key, keyAt(prev.node, prev.slot)));
+  bool beforeHint = hint.node == nullptr ||
+                    (UniqueKeys ? compare(key, keyAt(hint.node, hint.slot))
+                                : !compare(keyAt(hint.node, hint.slot), key));
+  if (!afterPrev || !beforeHint) {
+    return emplace(key, std::forward<Args>(args)...);
+  }
+  // The gap before an element of an inner node is the end of the rightmost
+  // leaf of the subtree to its left.
+  Node* leaf = lastLeaf(root);
+  std::size_t slot = leaf->count;
+  if (hint.node != nullptr && hint.node->leaf) {
+    leaf = hint.node;
+    slot = hint.slot;
+  } else if (hint.node != nullptr) {
+    leaf = lastLeaf(child(hint.node, hint.slot));
+    slot = leaf->count;
+  }
+  return std::make_pair(
+      insertInLeaf(leaf, slot, key, std::forward<Args>(args)...), true);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+template <typename... Args>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::InsertResult
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::emplaceValue(Args&&... args) {
+  ValueType value(std::forward<Args>(args)...);
+  return emplace(KeyOfValue::get(value), std::move(value));
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+template <typename... Args>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::InsertResult
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::emplaceValueWithHint(Position hint,
+                                                Args&&... args) {
+  ValueType value(std::forward<Args>(args)...);
+  return emplaceWithHint(hint, KeyOfValue::get(value), std::move(value));
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+template <typename ForwardIt, typename GetKey>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::buildFromSorted(ForwardIt first, ForwardIt last,
+                                                GetKey keyOf) {
+  clear();
+  for (; first != last; ++first) {
+    insertWithHint(Position(), keyOf(*first), *first);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::NodeHandle
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::extractNode(Position position) {
+  static_assert(!KeyOfValue::kStoresKey,
+                "a handle holds only the value, so the key must be in it");
+  NodeHandle handle;
+  handle.element.emplace(std::move(valueOf(position)));
+  removeNode(position);
+  return handle;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::InsertResult
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::insertNode(NodeHandle& handle) {
+  if (handle.empty()) {
+    return std::make_pair(Position(), false);
+  }
+  InsertResult result = emplace(handle.key(), std::move(*handle.element));
+  if (result.second) {
+    handle.element.reset();
+  }
+  return result;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::InsertResult
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::insertNodeWithHint(Position hint,
+                                              NodeHandle& handle) {
+  if (handle.empty()) {
+    return std::make_pair(Position(), false);
+  }
+  InsertResult result =
+      emplaceWithHint(hint, handle.key(), std::move(*handle.element));
+  if (result.second) {
+    handle.element.reset();
+  }
+  return result;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::mergeFrom(BTree& other) {
+  if (this == &other) return;
+  if constexpr (!UniqueKeys) {
+    for (Position position = other.minimum(); position != Position();
+         position = findNext(position)) {
+      emplace(keyAt(position.node, position.slot),
+              std::move(valueOf(position)));
+    }
+    other.clear();
+  } else {
+    // Erasing from `other` invalidates its positions, so the walk resumes
+    // after the key just moved, read back from this tree.
+    Position position = other.minimum();
+    while (position != Position()) {
+      auto [placed, inserted] = emplace(keyAt(position.node, position.slot),
+                                        std::move(valueOf(position)));
+      if (!inserted) {
+        position = findNext(position);
+        continue;
+      }
+      other.removeNode(position);
+      position = other.upperBound(keyAt(placed.node, placed.slot));
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::combine(const BTree& other,
+                                          RBTreeSetOp op) {
+  bool takesOthers =
+      op == RBTreeSetOp::kUnion || op == RBTreeSetOp::kSymmetricDifference;
+  if (this == &other) {
+    if (op == RBTreeSetOp::kDifference ||
+        op == RBTreeSetOp::kSymmetricDifference) {
+      clear();
+    }
+    return;
+  }
+  std::size_t own = treeSize;
+  std::size_t others = other.treeSize;
+  if (UniqueKeys && op != RBTreeSetOp::kIntersection &&
+      RBTreeSearchEach(others, own)) {
+    for (Position theirs = other.minimum(); theirs != Position();
+         theirs = findNext(theirs)) {
+      const KeyType& key = keyAt(theirs.node, theirs.slot);
+      if (op == RBTreeSetOp::kUnion) {
+        emplace(key, valueOf(theirs));
+        continue;
+      }
+      Position found = find(key);
+      if (found == Position()) {
+        if (op != RBTreeSetOp::kDifference) emplace(key, valueOf(theirs));
+      } else {
+        removeNode(found);
+      }
+    }
+    return;
+  }
+  bool skipThroughOther = !takesOthers && RBTreeSearchEach(own, others);
+
+  // Equal keys pair up one to one, which gives the counts of RBTreeSetOp.
+  // The result shares this tree's allocators, so taking it over below only
+  // hands over the root.
+  BTree result(EmptyLike(), *this);
+  Position mine = minimum();
+  Position theirs = other.minimum();
+  while (mine != Position() || (takesOthers && theirs != Position())) {
+    int order = -1;
+    if (mine == Position()) {
+      order = 1;
+    } else if (theirs != Position()) {
+      order = RBTreeThreeWay(compare, keyAt(mine.node, mine.slot),
+                             keyAt(theirs.node, theirs.slot));
+    }
+    if (order > 0) {
+      if (takesOthers) {
+        result.emplaceWithHint(Position(), keyAt(theirs.node, theirs.slot),
+                               valueOf(theirs));
+        theirs = findNext(theirs);
+      } else if (skipThroughOther) {
+        theirs = other.lowerBound(keyAt(mine.node, mine.slot));
+      } else {
+        theirs = findNext(theirs);
+      }
+      continue;
+    }
+    bool keep = order == 0 ? op == RBTreeSetOp::kUnion ||
+                                 op == RBTreeSetOp::kIntersection
+                           : op != RBTreeSetOp::kIntersection;
+    if (keep) {
+      result.emplaceWithHint(Position(), keyAt(mine.node, mine.slot),
+                             std::move(valueOf(mine)));
+    }
+    if (order == 0) theirs = findNext(theirs);
+    mine = findNext(mine);
+  }
+  *this = std::move(result);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::remove(const KeyType& key) {
+  Position position = find(key);
+  if (position.node == nullptr) {
+    throw std::invalid_argument("Key not found.");
+  }
+  removeNode(position);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::removeNode(Position position) {
+  Node* node = position.node;
+  destroySlot(node, position.slot);
+  if (node->leaf) {
+    shiftLeft(node, position.slot + 1, node->count);
+  } else {
+    // Fill the hole with the predecessor, which always sits in a leaf.
+    Node* leaf = lastLeaf(child(node, position.slot));
+    moveSlot(node, position.slot, leaf, leaf->count - 1);
+    node = leaf;
+  }
+  --node->count;
+  --treeSize;
+  rebalance(node);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+template <typename K, typename>
+bool BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::contains(const K& key) const {
+  return find<K>(key).node != nullptr;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+template <typename K, typename>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Position
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::find(const K& key) const {
+  if constexpr (UniqueKeys) {
+    Node* node = root;
+    while (node != nullptr) {
+      std::size_t slot = searchNode<false>(node, key);
+      if (slot < node->count && !compare(key, keyAt(node, slot))) {
+        return Position{node, slot};
+      }
+      node = node->leaf ? nullptr : child(node, slot);
+    }
+    return Position();
+  }
+  Position position = lowerBound<K>(key);
+  if (position.node == nullptr ||
+      compare(key, keyAt(position.node, position.slot))) {
+    return Position();
+  }
+  return position;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Position
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::minimum() const {
+  if (treeSize == 0) return Position();
+  return Position{firstLeaf(root), 0};
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Position
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::maximum() const {
+  if (treeSize == 0) return Position();
+  Node* leaf = lastLeaf(root);
+  return Position{leaf, leaf->count - 1u};
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Position
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::findNext(Position position) {
+  Node* node = position.node;
+  if (node == nullptr) return Position();
+  if (!node->leaf) {
+    return Position{firstLeaf(child(node, position.slot + 1)), 0};
+  }
+  if (position.slot + 1 < node->count) {
+    return Position{node, position.slot + 1};
+  }
+  while (node->parent != nullptr) {
+    std::size_t index = node->position;
+    node = node->parent;
+    if (index < node->count) return Position{node, index};
+  }
+  return Position();
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Position
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::findPrev(Position position) {
+  Node* node = position.node;
+  if (node == nullptr) return Position();
+  if (!node->leaf) {
+    Node* leaf = lastLeaf(child(node, position.slot));
+    return Position{leaf, leaf->count - 1u};
+  }
+  if (position.slot > 0) {
+    return Position{node, position.slot - 1};
+  }
+  while (node->parent != nullptr) {
+    std::size_t index = node->position;
+    node = node->parent;
+    if (index > 0) return Position{node, index - 1};
+  }
+  return Position();
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+template <typename K, typename>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Position
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::lowerBound(const K& key) const {
+  return bound<false>(key);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+template <typename K, typename>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Position
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::upperBound(const K& key) const {
+  return bound<true>(key);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+template <bool Upper, typename K>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Position
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::bound(const K& key) const {
+  Position result;
+  Node* node = root;
+  while (node != nullptr) {
+    std::size_t slot = searchNode<Upper>(node, key);
+    if (slot < node->count) result = Position{node, slot};
+    node = node->leaf ? nullptr : child(node, slot);
+  }
+  return result;
+}
+
+// First slot whose key is not less than `key`, or with Upper greater than
+// it. The halving step has no data-dependent branch, so the compiler can
+// turn it into a conditional move and the search never mispredicts.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+template <bool Upper, typename K>
+std::size_t BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                  NodeBytes, Compare>::searchNode(const Node* node,
+                                                  const K& key) const {
+  auto before = [this, node, &key](std::size_t slot) {
+    return Upper ? !compare(key, keyAt(node, slot))
+                 : compare(keyAt(node, slot), key);
+  };
+  if (node->count == 0) return 0;
+  std::size_t low = 0;
+  std::size_t length = node->count;
+  while (length > 1) {
+    std::size_t half = length / 2;
+    low = before(low + half) ? low + half : low;
+    length -= half;
+  }
+  return low + (before(low) ? 1 : 0);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+const KeyType& BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                     NodeBytes, Compare>::keyAt(const Node* node,
+                                                std::size_t slot) {
+  if constexpr (kSeparateKeys) {
+    return node->keys[slot];
+  } else {
+    return KeyOfValue::get(node->values[slot]);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Node*
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::child(const Node* node, std::size_t i) {
+  return static_cast<const InternalNode*>(node)->children[i];
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::setChild(Node* node, std::size_t i,
+                                         Node* newChild) {
+  static_cast<InternalNode*>(node)->children[i] = newChild;
+  newChild->parent = node;
+  newChild->position = static_cast<std::uint16_t>(i);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Node*
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::firstLeaf(Node* node) {
+  while (!node->leaf) node = child(node, 0);
+  return node;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Node*
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::lastLeaf(Node* node) {
+  while (!node->leaf) node = child(node, node->count);
+  return node;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Node*
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::createNode(bool leaf) {
+  if (leaf) {
+    Node* node = LeafTraits::allocate(leafAllocator, 1);
+    LeafTraits::construct(leafAllocator, node);
+    return node;
+  }
+  InternalNode* node = InternalTraits::allocate(internalAllocator, 1);
+  InternalTraits::construct(internalAllocator, node);
+  return node;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::destroyNode(Node* node) {
+  if (node->leaf) {
+    LeafTraits::destroy(leafAllocator, node);
+    LeafTraits::deallocate(leafAllocator, node, 1);
+    return;
+  }
+  InternalNode* internal = static_cast<InternalNode*>(node);
+  InternalTraits::destroy(internalAllocator, internal);
+  InternalTraits::deallocate(internalAllocator, internal, 1);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::destroySubtree(Node* node) {
+  if (node == nullptr) return;
+  if (!node->leaf) {
+    for (std::size_t i = 0; i <= node->count; ++i) {
+      destroySubtree(child(node, i));
+    }
+  }
+  for (std::size_t i = 0; i < node->count; ++i) destroySlot(node, i);
+  destroyNode(node);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Node*
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::copySubtree(const Node* node) {
+  if (node == nullptr) return nullptr;
+  Node* copy = createNode(node->leaf);
+  for (std::size_t i = 0; i < node->count; ++i) {
+    constructSlot(copy, i, keyAt(node, i), node->values[i]);
+    ++copy->count;
+  }
+  if (!node->leaf) {
+    for (std::size_t i = 0; i <= node->count; ++i) {
+      setChild(copy, i, copySubtree(child(node, i)));
+    }
+  }
+  return copy;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+template <typename... Args>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::constructSlot(Node* node, std::size_t slot,
+                                              const KeyType& key,
+                                              Args&&... args) {
+  if constexpr (kSeparateKeys) {
+    ::new (node->keys.slot(slot)) KeyType(key);
+    try {
+      ::new (node->values.slot(slot)) ValueType(std::forward<Args>(args)...);
+    } catch (...) {
+      node->keys[slot].~KeyType();
+      throw;
+    }
+  } else {
+    (void)key;
+    ::new (node->values.slot(slot)) ValueType(std::forward<Args>(args)...);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::destroySlot(Node* node, std::size_t slot) {
+  node->values[slot].~ValueType();
+  if constexpr (kSeparateKeys) {
+    node->keys[slot].~KeyType();
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::moveSlot(Node* to, std::size_t toSlot,
+                                         Node* from, std::size_t fromSlot) {
+  ::new (to->values.slot(toSlot)) ValueType(std::move(from->values[fromSlot]));
+  from->values[fromSlot].~ValueType();
+  if constexpr (kSeparateKeys) {
+    ::new (to->keys.slot(toSlot)) KeyType(std::move(from->keys[fromSlot]));
+    from->keys[fromSlot].~KeyType();
+  }
+}
+
+// Moves the elements in [first, last) one slot up; slot `first` is left
+// empty.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::shiftRight(Node* node, std::size_t first,
+                                           std::size_t last) {
+  for (std::size_t i = last; i > first; --i) moveSlot(node, i, node, i - 1);
+}
+
+// Moves the elements in [first, last) one slot down into the empty slot
+// first - 1.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::shiftLeft(Node* node, std::size_t first,
+                                          std::size_t last) {
+  for (std::size_t i = first; i < last; ++i) moveSlot(node, i - 1, node, i);
+}
+
+// Splits a full node around its middle element, which moves up into the
+// parent; a full parent is split first. Returns the new right half.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Node*
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::split(Node* node) {
+  constexpr std::size_t kMiddle = kSlots / 2;
+  Node* parent = node->parent;
+  if (parent == nullptr) {
+    parent = createNode(false);
+    setChild(parent, 0, node);
+    root = parent;
+  } else if (parent->count == kSlots) {
+    split(parent);
+    parent = node->parent;
+  }
+  Node* right = createNode(node->leaf);
+  for (std::size_t i = kMiddle + 1; i < kSlots; ++i) {
+    moveSlot(right, i - kMiddle - 1, node, i);
+  }
+  if (!node->leaf) {
+    for (std::size_t i = kMiddle + 1; i <= kSlots; ++i) {
+      setChild(right, i - kMiddle - 1, child(node, i));
+    }
+  }
+  right->count = kSlots - kMiddle - 1;
+
+  std::size_t at = node->position;
+  shiftRight(parent, at, parent->count);
+  for (std::size_t i = parent->count + 1u; i > at + 1; --i) {
+    setChild(parent, i, child(parent, i - 1));
+  }
+  moveSlot(parent, at, node, kMiddle);
+  setChild(parent, at + 1, right);
+  ++parent->count;
+  node->count = kMiddle;
+  return right;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+template <typename... Args>
+typename BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+               NodeBytes, Compare>::Position
+BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+      NodeBytes, Compare>::insertInLeaf(Node* leaf, std::size_t slot,
+                                        const KeyType& key, Args&&... args) {
+  if (leaf->count == kSlots) {
+    Node* right = split(leaf);
+    if (slot > leaf->count) {
+      slot -= leaf->count + 1u;
+      leaf = right;
+    }
+  }
+  shiftRight(leaf, slot, leaf->count);
+  try {
+    constructSlot(leaf, slot, key, std::forward<Args>(args)...);
+  } catch (...) {
+    shiftLeft(leaf, slot + 1, leaf->count + 1u);
+    throw;
+  }
+  ++leaf->count;
+  ++treeSize;
+  return Position{leaf, slot};
+}
+
+// Restores the minimum fill after an erase by borrowing from a sibling or
+// merging with it, which may leave the parent short in turn.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::rebalance(Node* node) {
+  while (node != root && node->count < kMinSlots) {
+    Node* parent = node->parent;
+    std::size_t at = node->position;
+    Node* left = at > 0 ? child(parent, at - 1) : nullptr;
+    Node* right = at < parent->count ? child(parent, at + 1) : nullptr;
+    if (left != nullptr && left->count > kMinSlots) {
+      rotateRight(left, node);
+      return;
+    }
+    if (right != nullptr && right->count > kMinSlots) {
+      rotateLeft(node, right);
+      return;
+    }
+    if (left != nullptr) {
+      merge(left, node);
+    } else {
+      merge(node, right);
+    }
+    node = parent;
+  }
+  if (root->count == 0) {
+    Node* old = root;
+    root = root->leaf ? nullptr : child(root, 0);
+    if (root != nullptr) root->parent = nullptr;
+    destroyNode(old);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::rotateRight(Node* left, Node* node) {
+  Node* parent = node->parent;
+  std::size_t separator = node->position - 1u;
+  shiftRight(node, 0, node->count);
+  moveSlot(node, 0, parent, separator);
+  moveSlot(parent, separator, left, left->count - 1u);
+  if (!node->leaf) {
+    for (std::size_t i = node->count + 1u; i > 0; --i) {
+      setChild(node, i, child(node, i - 1));
+    }
+    setChild(node, 0, child(left, left->count));
+  }
+  --left->count;
+  ++node->count;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::rotateLeft(Node* node, Node* right) {
+  Node* parent = node->parent;
+  std::size_t separator = node->position;
+  moveSlot(node, node->count, parent, separator);
+  moveSlot(parent, separator, right, 0);
+  shiftLeft(right, 1, right->count);
+  if (!node->leaf) {
+    setChild(node, node->count + 1u, child(right, 0));
+    for (std::size_t i = 0; i < right->count; ++i) {
+      setChild(right, i, child(right, i + 1));
+    }
+  }
+  ++node->count;
+  --right->count;
+}
+
+// Appends the separator and all of `right` to `left`, then frees `right`.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, std::size_t NodeBytes,
+          typename Compare>
+void BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+           NodeBytes, Compare>::merge(Node* left, Node* right) {
+  Node* parent = left->parent;
+  std::size_t separator = left->position;
+  moveSlot(left, left->count, parent, separator);
+  for (std::size_t i = 0; i < right->count; ++i) {
+    moveSlot(left, left->count + 1u + i, right, i);
+  }
+  if (!left->leaf) {
+    for (std::size_t i = 0; i <= right->count; ++i) {
+      setChild(left, left->count + 1u + i, child(right, i));
+    }
+  }
+  left->count += right->count + 1;
+  shiftLeft(parent, separator + 1, parent->count);
+  for (std::size_t i = separator + 1; i < parent->count; ++i) {
+    setChild(parent, i, child(parent, i + 1));
+  }
+  --parent->count;
+  right->count = 0;
+  destroyNode(right);
+}
+
+// Backend tag for Map and MultiSet that builds them on a BTree. Positions,
+// and so iterators, are invalidated by every insert and erase. select and
+// rank are not available.
+template <std::size_t NodeBytes = 256>
+struct BTreeBackend {
+  template <typename KeyType, typename ValueType, typename Allocator,
+            bool UniqueKeys, typename KeyOfValue,
+            typename Compare = std::less<KeyType>>
+  using tree = BTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                     NodeBytes, Compare>;
+};
+
+#endif  // SRC_B_TREE_H
@@ -0,0 +1,304 @@
+#ifndef SRC_INCLUDE_CONCURRENT_MAP_H_
+#define SRC_INCLUDE_CONCURRENT_MAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+
+#include "custom_hash_map.h"
+#include "custom_vector.h"
+#include "hash_group.h"
+
+// Map for many threads at once: keys are spread over a power-of-two number
+// of shards, each an independent Shard behind its own reader-writer lock,
+// so threads working on different shards do not wait for each other and
+// lookups in the same shard run side by side.
+//
+// Shard is HashMap (the default) or a Map on the red-black or B-tree
+// backend. Lookups call its find under a shared lock, so its lookups must
+// not modify it; the persistent backend, whose find copies nodes, does not
+// qualify. A shard is picked from the top bits of the mixed Hash, which
+// leaves the low bits HashMap uses for its own probing independent of it.
+//
+// No references into the map are handed out, since another thread may
+// erase the element as soon as the lock is released. Lookups return copies
+// of the mapped value and changes in place go through update. size() adds
+// up the shards one lock at a time, so under concurrent writes it is only
+// a recent count.
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename Shard = HashMap<Key, Value, Hash>>
+class ConcurrentMap {
+ public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = std::pair<const Key, Value>;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using shard_type = Shard;
+
+  // shardCount is rounded up to a power of two; 0 picks four shards per
+  // hardware thread.
+  explicit ConcurrentMap(size_type shardCount = 0);
+  ConcurrentMap(const ConcurrentMap&) = delete;
+  ConcurrentMap& operator=(const ConcurrentMap&) = delete;
+
+  // Return whether the key was new.
+  bool insert(const key_type& key, const mapped_type& value);
+  bool insert_or_assign(const key_type& key, const mapped_type& value);
+  // Returns whether the key was there.
+  bool erase(const key_type& key);
+  // Calls f(mapped_type&) under the shard's exclusive lock; false if the
+  // key is absent.
+  template <typename F>
+  bool update(const key_type& key, F f);
+
+  std::optional<mapped_type> find(const key_type& key) const;
+  bool contains(const key_type& key) const;
+
+  // Batches: the keys are grouped by shard first, so each shard's lock is
+  // taken once per call however many of the keys it holds. Results are in
+  // the order of the input. insert_many takes a range of key-value pairs
+  // and reports which were inserted; find_many takes a range of keys.
+  template <typename ForwardIt>
+  CustomVector<bool> insert_many(ForwardIt first, ForwardIt last);
+  template <typename ForwardIt>
+  CustomVector<std::optional<mapped_type>> find_many(ForwardIt first,
+                                                     ForwardIt last) const;
+
+  // Calls f(const value_type&) for every element, one shard at a time
+  // under its shared lock.
+  template <typename F>
+  void for_each(F f) const;
+
+  size_type size() const;
+  bool empty() const;
+  void clear();
+  size_type shard_count() const;
+
+ private:
+  static constexpr std::size_t kCacheLine = 64;
+
+  // A cache line of its own per shard, so that taking one lock does not
+  // steal the line holding its neighbour's.
+  struct alignas(kCacheLine) Slot {
+    mutable std::shared_mutex mutex;
+    mutable Shard map;
+  };
+
+  // One key of a batch: where its result goes and where its element is.
+  template <typename ForwardIt>
+  struct BatchEntry {
+    size_type index;
+    ForwardIt item;
+  };
+
+  size_type shardOf(const key_type& key) const;
+  // Sorts the batch by shard with a counting sort. Entries for shard s end
+  // up in [starts[s], starts[s + 1]).
+  template <typename ForwardIt, typename GetKey>
+  void groupByShard(ForwardIt first, ForwardIt last, GetKey keyOf,
+                    CustomVector<BatchEntry<ForwardIt>>& entries,
+                    CustomVector<size_type>& starts) const;
+
+  Hash hash;
+  int shardBits;
+  std::unique_ptr<Slot[]> shards;
+};
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+ConcurrentMap<Key, Value, Hash, Shard>::ConcurrentMap(size_type shardCount)
+    : hash(), shardBits(0) {
+  if (shardCount == 0) {
+    shardCount = 4 * static_cast<size_type>(
+                         std::max(1u, std::thread::hardware_concurrency()));
+  }
+  while ((size_type{1} << shardBits) < shardCount) ++shardBits;
+  shards.reset(new Slot[size_type{1} << shardBits]);
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+typename ConcurrentMap<Key, Value, Hash, Shard>::size_type
+ConcurrentMap<Key, Value, Hash, Shard>::shardOf(const key_type& key) const {
+  if (shardBits == 0) return 0;
+  std::uint64_t mixed = HashMix(static_cast<std::uint64_t>(hash(key)));
+  return static_cast<size_type>(mixed >> (64 - shardBits));
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+bool ConcurrentMap<Key, Value, Hash, Shard>::insert(const key_type& key,
+                                                    const mapped_type& value) {
+  Slot& slot = shards[shardOf(key)];
+  std::unique_lock<std::shared_mutex> lock(slot.mutex);
+  return slot.map.insert(key, value).second;
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+bool ConcurrentMap<Key, Value, Hash, Shard>::insert_or_assign(
+    const key_type& key, const mapped_type& value) {
+  Slot& slot = shards[shardOf(key)];
+  std::unique_lock<std::shared_mutex> lock(slot.mutex);
+  return slot.map.insert_or_assign(key, value).second;
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+bool ConcurrentMap<Key, Value, Hash, Shard>::erase(const key_type& key) {
+  Slot& slot = shards[shardOf(key)];
+  std::unique_lock<std::shared_mutex> lock(slot.mutex);
+  auto found = slot.map.find(key);
+  if (found == slot.map.end()) return false;
+  slot.map.erase(found);
+  return true;
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+template <typename F>
+bool ConcurrentMap<Key, Value, Hash, Shard>::update(const key_type& key,
+                                                    F f) {
+  Slot& slot = shards[shardOf(key)];
+  std::unique_lock<std::shared_mutex> lock(slot.mutex);
+  auto found = slot.map.find(key);
+  if (found == slot.map.end()) return false;
+  f(found->second);
+  return true;
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+std::optional<typename ConcurrentMap<Key, Value, Hash, Shard>::mapped_type>
+ConcurrentMap<Key, Value, Hash, Shard>::find(const key_type& key) const {
+  const Slot& slot = shards[shardOf(key)];
+  std::shared_lock<std::shared_mutex> lock(slot.mutex);
+  auto found = slot.map.find(key);
+  if (found == slot.map.end()) return std::nullopt;
+  return found->second;
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+bool ConcurrentMap<Key, Value, Hash, Shard>::contains(
+    const key_type& key) const {
+  const Slot& slot = shards[shardOf(key)];
+  std::shared_lock<std::shared_mutex> lock(slot.mutex);
+  return slot.map.contains(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+template <typename ForwardIt, typename GetKey>
+void ConcurrentMap<Key, Value, Hash, Shard>::groupByShard(
+    ForwardIt first, ForwardIt last, GetKey keyOf,
+    CustomVector<BatchEntry<ForwardIt>>& entries,
+    CustomVector<size_type>& starts) const {
+  size_type count = shard_count();
+  CustomVector<size_type> shardOfItem;
+  starts.resize(count + 1, 0);
+  for (ForwardIt it = first; it != last; ++it) {
+    size_type shard = shardOf(keyOf(*it));
+    shardOfItem.push_back(shard);
+    ++starts[shard + 1];
+  }
+  for (size_type s = 0; s < count; ++s) starts[s + 1] += starts[s];
+  entries.resize(shardOfItem.size(), BatchEntry<ForwardIt>{0, first});
+  CustomVector<size_type> next(starts);
+  size_type index = 0;
+  for (ForwardIt it = first; it != last; ++it, ++index) {
+    entries[next[shardOfItem[index]]++] = BatchEntry<ForwardIt>{index, it};
+  }
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+template <typename ForwardIt>
+CustomVector<bool> ConcurrentMap<Key, Value, Hash, Shard>::insert_many(
+    ForwardIt first, ForwardIt last) {
+  CustomVector<BatchEntry<ForwardIt>> entries;
+  CustomVector<size_type> starts;
+  groupByShard(first, last,
+               [](const auto& item) -> const key_type& { return item.first; },
+               entries, starts);
+  CustomVector<bool> results;
+  results.resize(entries.size(), false);
+  for (size_type s = 0; s < shard_count(); ++s) {
+    if (starts[s] == starts[s + 1]) continue;
+    Slot& slot = shards[s];
+    std::unique_lock<std::shared_mutex> lock(slot.mutex);
+    for (size_type i = starts[s]; i < starts[s + 1]; ++i) {
+      const auto& item = *entries[i].item;
+      results[entries[i].index] =
+          slot.map.insert(item.first, item.second).second;
+    }
+  }
+  return results;
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+template <typename ForwardIt>
+CustomVector<std::optional<
+    typename ConcurrentMap<Key, Value, Hash, Shard>::mapped_type>>
+ConcurrentMap<Key, Value, Hash, Shard>::find_many(ForwardIt first,
+                                                  ForwardIt last) const {
+  CustomVector<BatchEntry<ForwardIt>> entries;
+  CustomVector<size_type> starts;
+  groupByShard(first, last,
+               [](const key_type& key) -> const key_type& { return key; },
+               entries, starts);
+  CustomVector<std::optional<mapped_type>> results;
+  results.resize(entries.size(), std::nullopt);
+  for (size_type s = 0; s < shard_count(); ++s) {
+    if (starts[s] == starts[s + 1]) continue;
+    const Slot& slot = shards[s];
+    std::shared_lock<std::shared_mutex> lock(slot.mutex);
+    for (size_type i = starts[s]; i < starts[s + 1]; ++i) {
+      auto found = slot.map.find(*entries[i].item);
+      if (found != slot.map.end()) results[entries[i].index] = found->second;
+    }
+  }
+  return results;
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+template <typename F>
+void ConcurrentMap<Key, Value, Hash, Shard>::for_each(F f) const {
+  for (size_type s = 0; s < shard_count(); ++s) {
+    const Slot& slot = shards[s];
+    std::shared_lock<std::shared_mutex> lock(slot.mutex);
+    for (auto it = slot.map.begin(); it != slot.map.end(); ++it) {
+      f(static_cast<const value_type&>(*it));
+    }
+  }
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+typename ConcurrentMap<Key, Value, Hash, Shard>::size_type
+ConcurrentMap<Key, Value, Hash, Shard>::size() const {
+  size_type total = 0;
+  for (size_type s = 0; s < shard_count(); ++s) {
+    std::shared_lock<std::shared_mutex> lock(shards[s].mutex);
+    total += shards[s].map.size();
+  }
+  return total;
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+bool ConcurrentMap<Key, Value, Hash, Shard>::empty() const {
+  return size() == 0;
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+void ConcurrentMap<Key, Value, Hash, Shard>::clear() {
+  for (size_type s = 0; s < shard_count(); ++s) {
+    std::unique_lock<std::shared_mutex> lock(shards[s].mutex);
+    shards[s].map.clear();
+  }
+}
+
+template <typename Key, typename Value, typename Hash, typename Shard>
+typename ConcurrentMap<Key, Value, Hash, Shard>::size_type
+ConcurrentMap<Key, Value, Hash, Shard>::shard_count() const {
+  return size_type{1} << shardBits;
+}
+
+#endif  // SRC_INCLUDE_CONCURRENT_MAP_H_
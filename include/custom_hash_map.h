@@ -0,0 +1,667 @@
+#ifndef SRC_INCLUDE_CUSTOM_HASH_MAP_H_
+#define SRC_INCLUDE_CUSTOM_HASH_MAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include "custom_vector.h"
+#include "hash_group.h"
+
+// Forward iterator over the full slots of a HashMap. It walks the control
+// bytes in slot order and stops at the sentinel, where it becomes end().
+template <typename Key, typename T>
+class HashMapIterator {
+ public:
+  using HashMapIter = HashMapIterator;
+  using value_type = std::pair<const Key, T>;
+
+  HashMapIterator();
+  HashMapIterator(std::int8_t* ctrlPos, value_type* slotPos);
+
+  Key getKey() const;
+  value_type* getSlot() const;
+
+  value_type& operator*() const;
+  value_type* operator->() const;
+  HashMapIterator& operator++();
+  HashMapIterator operator++(int);
+  bool operator==(const HashMapIter& other) const;
+  bool operator!=(const HashMapIter& other) const;
+
+ private:
+  void skipEmpty();
+
+  std::int8_t* ctrl;
+  value_type* slot;
+};
+
+// Unordered map with open addressing in the SwissTable layout: one control
+// byte per slot, probed a HashGroup at a time, so a lookup usually touches
+// one group of control bytes and one slot. The capacity is always 2^k - 1
+// and the table grows once it is 7/8 full. Any insertion may rehash and
+// invalidate iterators; erase only invalidates the erased one.
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, Value>>>
+class HashMap {
+ public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = std::pair<const Key, Value>;
+  using map = HashMap;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using allocator_type = Allocator;
+  using iterator = HashMapIterator<Key, Value>;
+
+  explicit HashMap();
+  explicit HashMap(const Allocator& alloc);
+  explicit HashMap(std::initializer_list<value_type> const& items);
+  template <typename InputIt>
+  HashMap(InputIt first, InputIt last);
+  explicit HashMap(const map& m);
+  explicit HashMap(map&& m);
+  ~HashMap();
+
+  HashMap& operator=(map&& m);
+
+  std::pair<iterator, bool> insert(const value_type& value);
+  std::pair<iterator, bool> insert(const key_type& key,
+                                   const mapped_type& value);
+  std::pair<iterator, bool> insert_or_assign(const key_type& key,
+                                             const mapped_type& value);
+  void erase(iterator pos);
+  Value& operator[](const key_type& key);
+  Value& at(const key_type& key);
+  iterator find(const key_type& key);
+  iterator begin();
+  iterator end();
+  size_type size() const;
+  size_type max_size() const;
+  bool empty() const;
+  void clear();
+  bool contains(const key_type& key) const;
+
+  void swap(map& other);
+  void merge(map& other);
+  template <typename... Args>
+  CustomVector<std::pair<iterator, bool>> insert_many(Args&&... args);
+
+  // Hash policy. reserve(n) makes room for n elements without rehashing;
+  // rehash(n) rebuilds the table with at least n slots (and enough for the
+  // current elements), which also drops the markers left by erase.
+  void reserve(size_type count);
+  void rehash(size_type count);
+  size_type bucket_count() const;
+  float load_factor() const;
+  float max_load_factor() const;
+
+ private:
+  using Group = HashGroup;
+  using CtrlAllocator = typename std::allocator_traits<
+      Allocator>::template rebind_alloc<std::int8_t>;
+  using SlotTraits = std::allocator_traits<Allocator>;
+  using CtrlTraits = std::allocator_traits<CtrlAllocator>;
+
+  static constexpr size_type kWidth = Group::kWidth;
+
+  static size_type normalizeCapacity(size_type count);
+  static size_type growthLimit(size_type capacity);
+  // Smallest capacity whose growth limit is at least `count`.
+  static size_type capacityFor(size_type count);
+  static std::int8_t h2(size_type keyHash);
+
+  size_type hashOf(const key_type& key) const;
+  // Index of the slot holding `key`, or `capacity` if there is none.
+  size_type findIndex(const key_type& key, size_type keyHash) const;
+  size_type findFirstNonFull(size_type keyHash) const;
+  template <typename... Args>
+  std::pair<iterator, bool> insertUnique(const key_type& key,
+                                         Args&&... args);
+  void setCtrl(size_type index, std::int8_t value);
+  void resize(size_type newCapacity);
+  void destroySlots();
+  void deallocate();
+  iterator iteratorAt(size_type index);
+
+  std::int8_t* ctrl;
+  value_type* slots;
+  size_type capacity;
+  size_type elementsCount;
+  size_type growthLeft;
+  Hash hash;
+  KeyEqual equal;
+  Allocator allocator;
+};
+
+template <typename Key, typename T>
+HashMapIterator<Key, T>::HashMapIterator() : ctrl(nullptr), slot(nullptr) {}
+template <typename Key, typename T>
+HashMapIterator<Key, T>::HashMapIterator(std::int8_t* ctrlPos,
+                                         value_type* slotPos)
+    : ctrl(ctrlPos), slot(slotPos) {
+  skipEmpty();
+}
+template <typename Key, typename T>
+void HashMapIterator<Key, T>::skipEmpty() {
+  if (ctrl == nullptr) return;
+  while (HashCtrl::isEmptyOrDeleted(*ctrl)) {
+    ++ctrl;
+    ++slot;
+  }
+  if (*ctrl == HashCtrl::kSentinel) {
+    ctrl = nullptr;
+    slot = nullptr;
+  }
+}
+template <typename Key, typename T>
+std::pair<const Key, T>& HashMapIterator<Key, T>::operator*() const {
+  return *slot;
+}
+template <typename Key, typename T>
+std::pair<const Key, T>* HashMapIterator<Key, T>::operator->() const {
+  return slot;
+}
+template <typename Key, typename T>
+HashMapIterator<Key, T>& HashMapIterator<Key, T>::operator++() {
+  ++ctrl;
+  ++slot;
+  skipEmpty();
+  return *this;
+}
+template <typename Key, typename T>
+HashMapIterator<Key, T> HashMapIterator<Key, T>::operator++(int) {
+  HashMapIter temp = *this;
+  ++(*this);
+  return temp;
+}
+template <typename Key, typename T>
+bool HashMapIterator<Key, T>::operator==(const HashMapIter& other) const {
+  return slot == other.slot;
+}
+template <typename Key, typename T>
+bool HashMapIterator<Key, T>::operator!=(const HashMapIter& other) const {
+  return slot != other.slot;
+}
+template <typename Key, typename T>
+Key HashMapIterator<Key, T>::getKey() const {
+  if (slot == nullptr) {
+    throw std::runtime_error("Iterator does not point to a valid slot");
+  }
+  return slot->first;
+}
+template <typename Key, typename T>
+std::pair<const Key, T>* HashMapIterator<Key, T>::getSlot() const {
+  return slot;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::HashMap()
+    : HashMap(Allocator()) {}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::HashMap(
+    const Allocator& alloc)
+    : ctrl(nullptr),
+      slots(nullptr),
+      capacity(0),
+      elementsCount(0),
+      growthLeft(0),
+      hash(),
+      equal(),
+      allocator(alloc) {}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::HashMap(
+    std::initializer_list<value_type> const& items)
+    : HashMap() {
+  reserve(items.size());
+  for (const auto& item : items) {
+    insert(item);
+  }
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <typename InputIt>
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::HashMap(InputIt first,
+                                                        InputIt last)
+    : HashMap() {
+  for (; first != last; ++first) {
+    insert(*first);
+  }
+}
+// The copy has the same capacity and hash function, so every element goes
+// to the same slot and the control bytes are copied as they are.
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::HashMap(const map& m)
+    : ctrl(nullptr),
+      slots(nullptr),
+      capacity(0),
+      elementsCount(0),
+      growthLeft(0),
+      hash(m.hash),
+      equal(m.equal),
+      allocator(
+          SlotTraits::select_on_container_copy_construction(m.allocator)) {
+  if (m.capacity == 0) return;
+  CtrlAllocator ctrlAllocator(allocator);
+  ctrl = CtrlTraits::allocate(ctrlAllocator, m.capacity + kWidth);
+  slots = SlotTraits::allocate(allocator, m.capacity);
+  capacity = m.capacity;
+  std::memset(ctrl, HashCtrl::kEmpty, capacity + kWidth);
+  ctrl[capacity] = HashCtrl::kSentinel;
+  for (size_type i = 0; i < capacity; ++i) {
+    if (HashCtrl::isFull(m.ctrl[i])) {
+      SlotTraits::construct(allocator, slots + i, m.slots[i]);
+      ++elementsCount;
+    }
+  }
+  std::memcpy(ctrl, m.ctrl, capacity + kWidth);
+  growthLeft = m.growthLeft;
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::HashMap(map&& m)
+    : ctrl(m.ctrl),
+      slots(m.slots),
+      capacity(m.capacity),
+      elementsCount(m.elementsCount),
+      growthLeft(m.growthLeft),
+      hash(std::move(m.hash)),
+      equal(std::move(m.equal)),
+      allocator(std::move(m.allocator)) {
+  m.ctrl = nullptr;
+  m.slots = nullptr;
+  m.capacity = 0;
+  m.elementsCount = 0;
+  m.growthLeft = 0;
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::~HashMap() {
+  destroySlots();
+  deallocate();
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+HashMap<Key, Value, Hash, KeyEqual, Allocator>&
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::operator=(map&& m) {
+  if (this != &m) {
+    map moved(std::move(m));
+    swap(moved);
+  }
+  return *this;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::size_type
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::normalizeCapacity(
+    size_type count) {
+  size_type capacity = kWidth - 1;
+  while (capacity < count) capacity = capacity * 2 + 1;
+  return capacity;
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::size_type
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::growthLimit(
+    size_type capacity) {
+  // 7/8 of seven slots would fill them all, and probing relies on at least
+  // one empty byte to stop.
+  return capacity == 7 ? 6 : capacity - capacity / 8;
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::size_type
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::capacityFor(size_type count) {
+  if (count == 7) return 8;
+  return count == 0 ? 0 : count + (count - 1) / 7;
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+std::int8_t HashMap<Key, Value, Hash, KeyEqual, Allocator>::h2(
+    size_type keyHash) {
+  return static_cast<std::int8_t>(keyHash & 0x7f);
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::size_type
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::hashOf(
+    const key_type& key) const {
+  return static_cast<size_type>(HashMix(hash(key)));
+}
+
+// Groups are visited in triangular order (offsets 0, W, 3W, 6W, ...),
+// which reaches every group because the slot count is a power of two. A
+// group with an empty byte ends the search: an insertion of the key would
+// have stopped there.
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::size_type
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::findIndex(
+    const key_type& key, size_type keyHash) const {
+  if (capacity == 0) return 0;
+  size_type offset = (keyHash >> 7) & capacity;
+  for (size_type step = kWidth;; step += kWidth) {
+    Group group(ctrl + offset);
+    for (size_type i : group.match(h2(keyHash))) {
+      size_type index = (offset + i) & capacity;
+      if (equal(slots[index].first, key)) return index;
+    }
+    if (group.matchEmpty()) return capacity;
+    offset = (offset + step) & capacity;
+  }
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::size_type
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::findFirstNonFull(
+    size_type keyHash) const {
+  size_type offset = (keyHash >> 7) & capacity;
+  for (size_type step = kWidth;; step += kWidth) {
+    auto free = Group(ctrl + offset).matchEmptyOrDeleted();
+    if (free) return (offset + free.lowest()) & capacity;
+    offset = (offset + step) & capacity;
+  }
+}
+// The first kWidth - 1 control bytes are mirrored after the sentinel so
+// that a group loaded near the end of the table wraps around.
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashMap<Key, Value, Hash, KeyEqual, Allocator>::setCtrl(
+    size_type index, std::int8_t value) {
+  ctrl[index] = value;
+  ctrl[((index - (kWidth - 1)) & capacity) + (kWidth - 1)] = value;
+}
+// A deleted slot is reused without growing; otherwise a full table is
+// rebuilt at the same size when erase markers take up at least 3/32 of it,
+// and doubled when they do not.
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <typename... Args>
+std::pair<typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::insertUnique(
+    const key_type& key, Args&&... args) {
+  size_type keyHash = hashOf(key);
+  size_type index = findIndex(key, keyHash);
+  if (index < capacity) {
+    return std::make_pair(iteratorAt(index), false);
+  }
+  if (capacity != 0) index = findFirstNonFull(keyHash);
+  if (capacity == 0 ||
+      (growthLeft == 0 && ctrl[index] != HashCtrl::kDeleted)) {
+    bool manyDeleted = elementsCount * 32 <= capacity * 25;
+    resize(capacity != 0 && manyDeleted ? capacity : capacity * 2 + 1);
+    index = findFirstNonFull(keyHash);
+  }
+  SlotTraits::construct(allocator, slots + index,
+                        std::forward<Args>(args)...);
+  growthLeft -= ctrl[index] == HashCtrl::kEmpty;
+  setCtrl(index, h2(keyHash));
+  ++elementsCount;
+  return std::make_pair(iteratorAt(index), true);
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashMap<Key, Value, Hash, KeyEqual, Allocator>::resize(
+    size_type newCapacity) {
+  std::int8_t* oldCtrl = ctrl;
+  value_type* oldSlots = slots;
+  size_type oldCapacity = capacity;
+
+  CtrlAllocator ctrlAllocator(allocator);
+  newCapacity = normalizeCapacity(newCapacity);
+  ctrl = CtrlTraits::allocate(ctrlAllocator, newCapacity + kWidth);
+  slots = SlotTraits::allocate(allocator, newCapacity);
+  capacity = newCapacity;
+  std::memset(ctrl, HashCtrl::kEmpty, capacity + kWidth);
+  ctrl[capacity] = HashCtrl::kSentinel;
+  growthLeft = growthLimit(capacity) - elementsCount;
+
+  for (size_type i = 0; i < oldCapacity; ++i) {
+    if (!HashCtrl::isFull(oldCtrl[i])) continue;
+    size_type keyHash = hashOf(oldSlots[i].first);
+    size_type index = findFirstNonFull(keyHash);
+    SlotTraits::construct(allocator, slots + index, std::move(oldSlots[i]));
+    SlotTraits::destroy(allocator, oldSlots + i);
+    setCtrl(index, h2(keyHash));
+  }
+  if (oldCapacity != 0) {
+    CtrlTraits::deallocate(ctrlAllocator, oldCtrl, oldCapacity + kWidth);
+    SlotTraits::deallocate(allocator, oldSlots, oldCapacity);
+  }
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashMap<Key, Value, Hash, KeyEqual, Allocator>::destroySlots() {
+  for (size_type i = 0; i < capacity; ++i) {
+    if (HashCtrl::isFull(ctrl[i])) {
+      SlotTraits::destroy(allocator, slots + i);
+    }
+  }
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashMap<Key, Value, Hash, KeyEqual, Allocator>::deallocate() {
+  if (capacity == 0) return;
+  CtrlAllocator ctrlAllocator(allocator);
+  CtrlTraits::deallocate(ctrlAllocator, ctrl, capacity + kWidth);
+  SlotTraits::deallocate(allocator, slots, capacity);
+  ctrl = nullptr;
+  slots = nullptr;
+  capacity = 0;
+  growthLeft = 0;
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::iterator
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::iteratorAt(size_type index) {
+  return iterator(ctrl + index, slots + index);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+std::pair<typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::insert(
+    const value_type& value) {
+  return insertUnique(value.first, value);
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+std::pair<typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::insert(
+    const key_type& key, const mapped_type& value) {
+  return insertUnique(key, key, value);
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+std::pair<typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::insert_or_assign(
+    const key_type& key, const mapped_type& value) {
+  auto result = insertUnique(key, key, value);
+  if (!result.second) {
+    result.first->second = value;
+  }
+  return result;
+}
+// The slot becomes empty again when no probe could have passed over it:
+// the empty bytes nearest to it on both sides are less than a group apart,
+// so every group holding the slot also held an empty byte. Otherwise it is
+// marked deleted to keep later probe sequences going.
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashMap<Key, Value, Hash, KeyEqual, Allocator>::erase(iterator pos) {
+  if (pos == end()) {
+    throw std::runtime_error("Iterator does not point to a valid slot");
+  }
+  size_type index = static_cast<size_type>(pos.getSlot() - slots);
+  SlotTraits::destroy(allocator, slots + index);
+  --elementsCount;
+
+  size_type before = (index - kWidth) & capacity;
+  auto emptyAfter = Group(ctrl + index).matchEmpty();
+  auto emptyBefore = Group(ctrl + before).matchEmpty();
+  bool neverFull = emptyBefore && emptyAfter &&
+                   emptyAfter.trailingZeros() + emptyBefore.leadingZeros() <
+                       kWidth;
+  setCtrl(index, neverFull ? HashCtrl::kEmpty : HashCtrl::kDeleted);
+  growthLeft += neverFull;
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+Value& HashMap<Key, Value, Hash, KeyEqual, Allocator>::operator[](
+    const key_type& key) {
+  return insertUnique(key, std::piecewise_construct, std::forward_as_tuple(key),
+                      std::forward_as_tuple())
+      .first->second;
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+Value& HashMap<Key, Value, Hash, KeyEqual, Allocator>::at(
+    const key_type& key) {
+  iterator found = find(key);
+  if (found == end()) {
+    throw std::out_of_range("Key not found");
+  }
+  return found->second;
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::iterator
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::find(const key_type& key) {
+  size_type index = findIndex(key, hashOf(key));
+  return index < capacity ? iteratorAt(index) : end();
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::iterator
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::begin() {
+  return capacity == 0 ? end() : iteratorAt(0);
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::iterator
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::end() {
+  return iterator();
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+std::size_t HashMap<Key, Value, Hash, KeyEqual, Allocator>::size() const {
+  return elementsCount;
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::size_type
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::max_size() const {
+  return std::numeric_limits<size_type>::max();
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+bool HashMap<Key, Value, Hash, KeyEqual, Allocator>::empty() const {
+  return elementsCount == 0;
+}
+// Keeps the allocation; only the slots and the control bytes are reset.
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashMap<Key, Value, Hash, KeyEqual, Allocator>::clear() {
+  if (capacity == 0) return;
+  destroySlots();
+  std::memset(ctrl, HashCtrl::kEmpty, capacity + kWidth);
+  ctrl[capacity] = HashCtrl::kSentinel;
+  elementsCount = 0;
+  growthLeft = growthLimit(capacity);
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+bool HashMap<Key, Value, Hash, KeyEqual, Allocator>::contains(
+    const key_type& key) const {
+  return findIndex(key, hashOf(key)) < capacity;
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashMap<Key, Value, Hash, KeyEqual, Allocator>::swap(map& other) {
+  std::swap(ctrl, other.ctrl);
+  std::swap(slots, other.slots);
+  std::swap(capacity, other.capacity);
+  std::swap(elementsCount, other.elementsCount);
+  std::swap(growthLeft, other.growthLeft);
+  std::swap(hash, other.hash);
+  std::swap(equal, other.equal);
+  std::swap(allocator, other.allocator);
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashMap<Key, Value, Hash, KeyEqual, Allocator>::merge(map& other) {
+  reserve(elementsCount + other.elementsCount);
+  for (auto it = other.begin(); it != other.end(); ++it) {
+    insert_or_assign(it->first, it->second);
+  }
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <typename... Args>
+CustomVector<std::pair<
+    typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::iterator, bool>>
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::insert_many(Args&&... args) {
+  reserve(elementsCount + sizeof...(Args));
+  CustomVector<std::pair<iterator, bool>> results;
+  (void)std::initializer_list<int>{
+      (results.push_back(insert(std::forward<Args>(args))), 0)...};
+  return results;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashMap<Key, Value, Hash, KeyEqual, Allocator>::reserve(
+    size_type count) {
+  if (count > elementsCount + growthLeft) {
+    rehash(capacityFor(count));
+  }
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashMap<Key, Value, Hash, KeyEqual, Allocator>::rehash(size_type count) {
+  if (count == 0 && elementsCount == 0) {
+    deallocate();
+    return;
+  }
+  resize(std::max(count, capacityFor(elementsCount)));
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename HashMap<Key, Value, Hash, KeyEqual, Allocator>::size_type
+HashMap<Key, Value, Hash, KeyEqual, Allocator>::bucket_count() const {
+  return capacity;
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+float HashMap<Key, Value, Hash, KeyEqual, Allocator>::load_factor() const {
+  return capacity == 0 ? 0.0f
+                       : static_cast<float>(elementsCount) /
+                             static_cast<float>(capacity);
+}
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+float HashMap<Key, Value, Hash, KeyEqual, Allocator>::max_load_factor()
+    const {
+  return 7.0f / 8.0f;
+}
+
+#endif /* SRC_INCLUDE_CUSTOM_HASH_MAP_H_ */
@@ -0,0 +1,583 @@
+#ifndef SRC_INCLUDE_CUSTOM_HASH_SET_H_
+#define SRC_INCLUDE_CUSTOM_HASH_SET_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "custom_vector.h"
+#include "hash_group.h"
+
+// Forward iterator over the full slots of a HashSet, in slot order.
+// Elements are read-only: changing one would move it to another slot.
+template <typename T>
+class HashSetIterator {
+ public:
+  using HashSetIter = HashSetIterator;
+  using value_type = T;
+
+  HashSetIterator();
+  HashSetIterator(const std::int8_t* ctrlPos, const std::int8_t* ctrlEnd,
+                  T* slotPos);
+
+  T* getSlot() const;
+
+  const T& operator*() const;
+  const T* operator->() const;
+  HashSetIterator& operator++();
+  HashSetIterator operator++(int);
+  bool operator==(const HashSetIter& other) const;
+  bool operator!=(const HashSetIter& other) const;
+
+ private:
+  void skipEmpty();
+
+  const std::int8_t* ctrl;
+  const std::int8_t* end;
+  T* slot;
+};
+
+// Unordered set with linear probing over 2^k slots and one control byte per
+// slot, holding either HashCtrl::kEmpty or the low seven bits (H2) of the
+// element's hash. A probe starts at the slot picked by the rest of the hash
+// and compares a whole HashGroup of control bytes against H2 at once (AVX2,
+// SSE2 or the portable word), moving one group to the right until a group
+// has an empty byte. That group also holds the first free slot, so a miss
+// knows where to insert without probing again.
+//
+// erase moves the following elements of the run back (backward shift)
+// instead of leaving a tombstone, so the table never fills up with deleted
+// markers and lookups after heavy erasing stay as short as after inserts.
+// It invalidates iterators to the moved elements; insert may rehash and
+// invalidate all of them.
+template <typename T, typename Hash = std::hash<T>,
+          typename KeyEqual = std::equal_to<T>,
+          typename Allocator = std::allocator<T>>
+class HashSet {
+ public:
+  using key_type = T;
+  using value_type = T;
+  using set = HashSet;
+  using size_type = std::size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using allocator_type = Allocator;
+  using iterator = HashSetIterator<T>;
+
+  HashSet();
+  explicit HashSet(const Allocator& alloc);
+  explicit HashSet(std::initializer_list<T> items);
+  template <typename InputIt>
+  HashSet(InputIt first, InputIt last);
+  explicit HashSet(const set& other);
+  explicit HashSet(set&& other);
+  ~HashSet();
+
+  HashSet& operator=(set&& other);
+
+  std::pair<iterator, bool> insert(const value_type& value);
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last);
+  void erase(const T& value);
+  void erase(iterator pos);
+  void clear();
+
+  iterator find(const T& value);
+  bool contains(const T& value) const;
+  size_type count(const T& value) const;
+  iterator begin();
+  iterator end();
+  size_type size() const;
+  size_type max_size() const;
+  bool empty() const;
+
+  void swap(set& other);
+  void merge(set& other);
+  template <typename... Args>
+  CustomVector<std::pair<iterator, bool>> insert_many(Args&&... args);
+
+  // reserve(n) makes room for n elements without rehashing; rehash(n)
+  // rebuilds the table with at least n slots and enough for the elements.
+  void reserve(size_type count);
+  void rehash(size_type count);
+  size_type bucket_count() const;
+  float load_factor() const;
+  float max_load_factor() const;
+
+ private:
+  using Group = HashGroup;
+  using CtrlAllocator = typename std::allocator_traits<
+      Allocator>::template rebind_alloc<std::int8_t>;
+  using SlotTraits = std::allocator_traits<Allocator>;
+  using CtrlTraits = std::allocator_traits<CtrlAllocator>;
+
+  static constexpr size_type kWidth = Group::kWidth;
+
+  static size_type normalizeCapacity(size_type count);
+  static size_type growthLimit(size_type capacity);
+  static size_type capacityFor(size_type count);
+  static std::int8_t h2(size_type valueHash);
+
+  size_type hashOf(const T& value) const;
+  size_type homeOf(size_type valueHash) const;
+  // The slot holding `value` and true, or the first empty slot of its run
+  // and false. The table must not be empty.
+  std::pair<size_type, bool> findSlot(const T& value,
+                                      size_type valueHash) const;
+  size_type findFirstEmpty(size_type valueHash) const;
+  void setCtrl(size_type index, std::int8_t value);
+  void eraseAt(size_type index);
+  void resize(size_type newCapacity);
+  void destroySlots();
+  void deallocate();
+  iterator iteratorAt(size_type index);
+
+  std::int8_t* ctrl;
+  T* slots;
+  size_type capacity;
+  size_type elementsCount;
+  size_type growthLeft;
+  Hash hash;
+  KeyEqual equal;
+  Allocator allocator;
+};
+
+template <typename T>
+HashSetIterator<T>::HashSetIterator()
+    : ctrl(nullptr), end(nullptr), slot(nullptr) {}
+template <typename T>
+HashSetIterator<T>::HashSetIterator(const std::int8_t* ctrlPos,
+                                    const std::int8_t* ctrlEnd, T* slotPos)
+    : ctrl(ctrlPos), end(ctrlEnd), slot(slotPos) {
+  skipEmpty();
+}
+template <typename T>
+void HashSetIterator<T>::skipEmpty() {
+  while (ctrl != end && !HashCtrl::isFull(*ctrl)) {
+    ++ctrl;
+    ++slot;
+  }
+  if (ctrl == end) {
+    *this = HashSetIterator();
+  }
+}
+template <typename T>
+T* HashSetIterator<T>::getSlot() const {
+  return slot;
+}
+template <typename T>
+const T& HashSetIterator<T>::operator*() const {
+  return *slot;
+}
+template <typename T>
+const T* HashSetIterator<T>::operator->() const {
+  return slot;
+}
+template <typename T>
+HashSetIterator<T>& HashSetIterator<T>::operator++() {
+  ++ctrl;
+  ++slot;
+  skipEmpty();
+  return *this;
+}
+template <typename T>
+HashSetIterator<T> HashSetIterator<T>::operator++(int) {
+  HashSetIter temp = *this;
+  ++(*this);
+  return temp;
+}
+template <typename T>
+bool HashSetIterator<T>::operator==(const HashSetIter& other) const {
+  return slot == other.slot;
+}
+template <typename T>
+bool HashSetIterator<T>::operator!=(const HashSetIter& other) const {
+  return slot != other.slot;
+}
+
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+HashSet<T, Hash, KeyEqual, Allocator>::HashSet()
+    : HashSet(Allocator()) {}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+HashSet<T, Hash, KeyEqual, Allocator>::HashSet(const Allocator& alloc)
+    : ctrl(nullptr),
+      slots(nullptr),
+      capacity(0),
+      elementsCount(0),
+      growthLeft(0),
+      hash(),
+      equal(),
+      allocator(alloc) {}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+HashSet<T, Hash, KeyEqual, Allocator>::HashSet(std::initializer_list<T> items)
+    : HashSet() {
+  reserve(items.size());
+  insert(items.begin(), items.end());
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+template <typename InputIt>
+HashSet<T, Hash, KeyEqual, Allocator>::HashSet(InputIt first, InputIt last)
+    : HashSet() {
+  insert(first, last);
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+HashSet<T, Hash, KeyEqual, Allocator>::HashSet(const set& other)
+    : ctrl(nullptr),
+      slots(nullptr),
+      capacity(0),
+      elementsCount(0),
+      growthLeft(0),
+      hash(other.hash),
+      equal(other.equal),
+      allocator(SlotTraits::select_on_container_copy_construction(
+          other.allocator)) {
+  if (other.capacity == 0) return;
+  CtrlAllocator ctrlAllocator(allocator);
+  ctrl = CtrlTraits::allocate(ctrlAllocator, other.capacity + kWidth - 1);
+  slots = SlotTraits::allocate(allocator, other.capacity);
+  capacity = other.capacity;
+  std::memset(ctrl, HashCtrl::kEmpty, capacity + kWidth - 1);
+  for (size_type i = 0; i < capacity; ++i) {
+    if (HashCtrl::isFull(other.ctrl[i])) {
+      SlotTraits::construct(allocator, slots + i, other.slots[i]);
+      setCtrl(i, other.ctrl[i]);
+      ++elementsCount;
+    }
+  }
+  growthLeft = other.growthLeft;
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+HashSet<T, Hash, KeyEqual, Allocator>::HashSet(set&& other)
+    : ctrl(other.ctrl),
+      slots(other.slots),
+      capacity(other.capacity),
+      elementsCount(other.elementsCount),
+      growthLeft(other.growthLeft),
+      hash(std::move(other.hash)),
+      equal(std::move(other.equal)),
+      allocator(std::move(other.allocator)) {
+  other.ctrl = nullptr;
+  other.slots = nullptr;
+  other.capacity = 0;
+  other.elementsCount = 0;
+  other.growthLeft = 0;
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+HashSet<T, Hash, KeyEqual, Allocator>::~HashSet() {
+  destroySlots();
+  deallocate();
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+HashSet<T, Hash, KeyEqual, Allocator>&
+HashSet<T, Hash, KeyEqual, Allocator>::operator=(set&& other) {
+  if (this != &other) {
+    set moved(std::move(other));
+    swap(moved);
+  }
+  return *this;
+}
+
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+typename HashSet<T, Hash, KeyEqual, Allocator>::size_type
+HashSet<T, Hash, KeyEqual, Allocator>::normalizeCapacity(size_type count) {
+  size_type capacity = kWidth;
+  while (capacity < count) capacity *= 2;
+  return capacity;
+}
+// At least one slot stays empty so that every probe ends.
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+typename HashSet<T, Hash, KeyEqual, Allocator>::size_type
+HashSet<T, Hash, KeyEqual, Allocator>::growthLimit(size_type capacity) {
+  return capacity - capacity / 8;
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+typename HashSet<T, Hash, KeyEqual, Allocator>::size_type
+HashSet<T, Hash, KeyEqual, Allocator>::capacityFor(size_type count) {
+  return count == 0 ? 0 : count + (count - 1) / 7;
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+std::int8_t HashSet<T, Hash, KeyEqual, Allocator>::h2(size_type valueHash) {
+  return static_cast<std::int8_t>(valueHash & 0x7f);
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+typename HashSet<T, Hash, KeyEqual, Allocator>::size_type
+HashSet<T, Hash, KeyEqual, Allocator>::hashOf(const T& value) const {
+  return static_cast<size_type>(HashMix(hash(value)));
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+typename HashSet<T, Hash, KeyEqual, Allocator>::size_type
+HashSet<T, Hash, KeyEqual, Allocator>::homeOf(size_type valueHash) const {
+  return (valueHash >> 7) & (capacity - 1);
+}
+
+// Every slot from an element's home up to the element is full, so an empty
+// byte in a group means the element is not past it, and that byte is the
+// first free slot of the run.
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+std::pair<typename HashSet<T, Hash, KeyEqual, Allocator>::size_type, bool>
+HashSet<T, Hash, KeyEqual, Allocator>::findSlot(const T& value,
+                                                size_type valueHash) const {
+  size_type mask = capacity - 1;
+  size_type offset = homeOf(valueHash);
+  while (true) {
+    Group group(ctrl + offset);
+    for (size_type i : group.match(h2(valueHash))) {
+      size_type index = (offset + i) & mask;
+      if (equal(slots[index], value)) return std::make_pair(index, true);
+    }
+    auto empty = group.matchEmpty();
+    if (empty) return std::make_pair((offset + empty.lowest()) & mask, false);
+    offset = (offset + kWidth) & mask;
+  }
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+typename HashSet<T, Hash, KeyEqual, Allocator>::size_type
+HashSet<T, Hash, KeyEqual, Allocator>::findFirstEmpty(
+    size_type valueHash) const {
+  size_type mask = capacity - 1;
+  size_type offset = homeOf(valueHash);
+  while (true) {
+    auto empty = Group(ctrl + offset).matchEmpty();
+    if (empty) return (offset + empty.lowest()) & mask;
+    offset = (offset + kWidth) & mask;
+  }
+}
+// The first kWidth - 1 control bytes are repeated after the last one, so a
+// group loaded near the end of the table wraps around.
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+void HashSet<T, Hash, KeyEqual, Allocator>::setCtrl(size_type index,
+                                                    std::int8_t value) {
+  ctrl[index] = value;
+  ctrl[((index - (kWidth - 1)) & (capacity - 1)) + (kWidth - 1)] = value;
+}
+// Backward shift: walk the run after the hole and pull back every element
+// whose home is not between the hole and its current slot. The run stays
+// contiguous from each element's home, which is all findSlot relies on.
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+void HashSet<T, Hash, KeyEqual, Allocator>::eraseAt(size_type index) {
+  size_type mask = capacity - 1;
+  size_type hole = index;
+  SlotTraits::destroy(allocator, slots + hole);
+  for (size_type next = (hole + 1) & mask; HashCtrl::isFull(ctrl[next]);
+       next = (next + 1) & mask) {
+    size_type home = homeOf(hashOf(slots[next]));
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      SlotTraits::construct(allocator, slots + hole, std::move(slots[next]));
+      SlotTraits::destroy(allocator, slots + next);
+      setCtrl(hole, ctrl[next]);
+      hole = next;
+    }
+  }
+  setCtrl(hole, HashCtrl::kEmpty);
+  --elementsCount;
+  ++growthLeft;
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+void HashSet<T, Hash, KeyEqual, Allocator>::resize(size_type newCapacity) {
+  std::int8_t* oldCtrl = ctrl;
+  T* oldSlots = slots;
+  size_type oldCapacity = capacity;
+
+  CtrlAllocator ctrlAllocator(allocator);
+  newCapacity = normalizeCapacity(newCapacity);
+  ctrl = CtrlTraits::allocate(ctrlAllocator, newCapacity + kWidth - 1);
+  slots = SlotTraits::allocate(allocator, newCapacity);
+  capacity = newCapacity;
+  std::memset(ctrl, HashCtrl::kEmpty, capacity + kWidth - 1);
+  growthLeft = growthLimit(capacity) - elementsCount;
+
+  for (size_type i = 0; i < oldCapacity; ++i) {
+    if (!HashCtrl::isFull(oldCtrl[i])) continue;
+    size_type valueHash = hashOf(oldSlots[i]);
+    size_type index = findFirstEmpty(valueHash);
+    SlotTraits::construct(allocator, slots + index, std::move(oldSlots[i]));
+    SlotTraits::destroy(allocator, oldSlots + i);
+    setCtrl(index, h2(valueHash));
+  }
+  if (oldCapacity != 0) {
+    CtrlTraits::deallocate(ctrlAllocator, oldCtrl, oldCapacity + kWidth - 1);
+    SlotTraits::deallocate(allocator, oldSlots, oldCapacity);
+  }
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+void HashSet<T, Hash, KeyEqual, Allocator>::destroySlots() {
+  for (size_type i = 0; i < capacity; ++i) {
+    if (HashCtrl::isFull(ctrl[i])) {
+      SlotTraits::destroy(allocator, slots + i);
+    }
+  }
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+void HashSet<T, Hash, KeyEqual, Allocator>::deallocate() {
+  if (capacity == 0) return;
+  CtrlAllocator ctrlAllocator(allocator);
+  CtrlTraits::deallocate(ctrlAllocator, ctrl, capacity + kWidth - 1);
+  SlotTraits::deallocate(allocator, slots, capacity);
+  ctrl = nullptr;
+  slots = nullptr;
+  capacity = 0;
+  growthLeft = 0;
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+typename HashSet<T, Hash, KeyEqual, Allocator>::iterator
+HashSet<T, Hash, KeyEqual, Allocator>::iteratorAt(size_type index) {
+  return iterator(ctrl + index, ctrl + capacity, slots + index);
+}
+
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+std::pair<typename HashSet<T, Hash, KeyEqual, Allocator>::iterator, bool>
+HashSet<T, Hash, KeyEqual, Allocator>::insert(const value_type& value) {
+  size_type valueHash = hashOf(value);
+  size_type index = 0;
+  if (capacity != 0) {
+    auto [slot, found] = findSlot(value, valueHash);
+    if (found) return std::make_pair(iteratorAt(slot), false);
+    index = slot;
+  }
+  if (growthLeft == 0) {
+    resize(capacity == 0 ? kWidth : capacity * 2);
+    index = findFirstEmpty(valueHash);
+  }
+  SlotTraits::construct(allocator, slots + index, value);
+  setCtrl(index, h2(valueHash));
+  --growthLeft;
+  ++elementsCount;
+  return std::make_pair(iteratorAt(index), true);
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+template <typename InputIt>
+void HashSet<T, Hash, KeyEqual, Allocator>::insert(InputIt first,
+                                                   InputIt last) {
+  for (; first != last; ++first) {
+    insert(*first);
+  }
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+void HashSet<T, Hash, KeyEqual, Allocator>::erase(const T& value) {
+  if (capacity == 0) return;
+  auto [index, found] = findSlot(value, hashOf(value));
+  if (found) eraseAt(index);
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+void HashSet<T, Hash, KeyEqual, Allocator>::erase(iterator pos) {
+  if (pos == end()) {
+    throw std::runtime_error("Iterator does not point to a valid slot");
+  }
+  eraseAt(static_cast<size_type>(pos.getSlot() - slots));
+}
+// Keeps the allocation; only the slots and the control bytes are reset.
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+void HashSet<T, Hash, KeyEqual, Allocator>::clear() {
+  if (capacity == 0) return;
+  destroySlots();
+  std::memset(ctrl, HashCtrl::kEmpty, capacity + kWidth - 1);
+  elementsCount = 0;
+  growthLeft = growthLimit(capacity);
+}
+
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+typename HashSet<T, Hash, KeyEqual, Allocator>::iterator
+HashSet<T, Hash, KeyEqual, Allocator>::find(const T& value) {
+  if (capacity == 0) return end();
+  auto [index, found] = findSlot(value, hashOf(value));
+  return found ? iteratorAt(index) : end();
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+bool HashSet<T, Hash, KeyEqual, Allocator>::contains(const T& value) const {
+  return capacity != 0 && findSlot(value, hashOf(value)).second;
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+typename HashSet<T, Hash, KeyEqual, Allocator>::size_type
+HashSet<T, Hash, KeyEqual, Allocator>::count(const T& value) const {
+  return contains(value) ? 1 : 0;
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+typename HashSet<T, Hash, KeyEqual, Allocator>::iterator
+HashSet<T, Hash, KeyEqual, Allocator>::begin() {
+  return capacity == 0 ? end() : iteratorAt(0);
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+typename HashSet<T, Hash, KeyEqual, Allocator>::iterator
+HashSet<T, Hash, KeyEqual, Allocator>::end() {
+  return iterator();
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+typename HashSet<T, Hash, KeyEqual, Allocator>::size_type
+HashSet<T, Hash, KeyEqual, Allocator>::size() const {
+  return elementsCount;
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+typename HashSet<T, Hash, KeyEqual, Allocator>::size_type
+HashSet<T, Hash, KeyEqual, Allocator>::max_size() const {
+  return std::numeric_limits<size_type>::max();
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+bool HashSet<T, Hash, KeyEqual, Allocator>::empty() const {
+  return elementsCount == 0;
+}
+
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+void HashSet<T, Hash, KeyEqual, Allocator>::swap(set& other) {
+  std::swap(ctrl, other.ctrl);
+  std::swap(slots, other.slots);
+  std::swap(capacity, other.capacity);
+  std::swap(elementsCount, other.elementsCount);
+  std::swap(growthLeft, other.growthLeft);
+  std::swap(hash, other.hash);
+  std::swap(equal, other.equal);
+  std::swap(allocator, other.allocator);
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+void HashSet<T, Hash, KeyEqual, Allocator>::merge(set& other) {
+  insert(other.begin(), other.end());
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+template <typename... Args>
+CustomVector<
+    std::pair<typename HashSet<T, Hash, KeyEqual, Allocator>::iterator, bool>>
+HashSet<T, Hash, KeyEqual, Allocator>::insert_many(Args&&... args) {
+  reserve(elementsCount + sizeof...(Args));
+  CustomVector<std::pair<iterator, bool>> results;
+  (void)std::initializer_list<int>{
+      (results.push_back(insert(std::forward<Args>(args))), 0)...};
+  return results;
+}
+
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+void HashSet<T, Hash, KeyEqual, Allocator>::reserve(size_type count) {
+  if (count > elementsCount + growthLeft) {
+    resize(capacityFor(count));
+  }
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+void HashSet<T, Hash, KeyEqual, Allocator>::rehash(size_type count) {
+  if (count == 0 && elementsCount == 0) {
+    deallocate();
+    return;
+  }
+  resize(std::max(count, capacityFor(elementsCount)));
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+typename HashSet<T, Hash, KeyEqual, Allocator>::size_type
+HashSet<T, Hash, KeyEqual, Allocator>::bucket_count() const {
+  return capacity;
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+float HashSet<T, Hash, KeyEqual, Allocator>::load_factor() const {
+  return capacity == 0 ? 0.0f
+                       : static_cast<float>(elementsCount) /
+                             static_cast<float>(capacity);
+}
+template <typename T, typename Hash, typename KeyEqual, typename Allocator>
+float HashSet<T, Hash, KeyEqual, Allocator>::max_load_factor() const {
+  return 7.0f / 8.0f;
+}
+
+#endif /* SRC_INCLUDE_CUSTOM_HASH_SET_H_ */
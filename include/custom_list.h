@@ -4,10 +4,13 @@
 #include <cstddef>
 #include <initializer_list>
 #include <limits>
+#include <memory>
 #include <stdexcept>
 #include <utility>
 
-template <class T>
+// Doubly linked list. Nodes come from Allocator rebound to the node type
+// through std::allocator_traits.
+template <class T, class Allocator = std::allocator<T>>
 class CustomList {
  public:
   struct Node {
@@ -60,6 +63,7 @@ class CustomList {
   };
 
   using value_type = T;
+  using allocator_type = Allocator;
   using reference = T&;
   using pointer = T*;
   using const_reference = T const&;
@@ -67,14 +71,15 @@ class CustomList {
   using iterator = CustomListIterator;
 
   CustomList();
+  explicit CustomList(const Allocator& alloc);
   explicit CustomList(size_type n);
   explicit CustomList(std::initializer_list<T> const& list);
-  explicit CustomList(const CustomList<T>& other);
-  explicit CustomList(CustomList<T>&& other);
+  explicit CustomList(const CustomList<T, Allocator>& other);
+  explicit CustomList(CustomList<T, Allocator>&& other);
   ~CustomList();
 
-  CustomList& operator=(const CustomList<T>& other);
-  CustomList& operator=(CustomList<T>&& other);
+  CustomList& operator=(const CustomList<T, Allocator>& other);
+  CustomList& operator=(CustomList<T, Allocator>&& other);
 
   const_reference front();
   const_reference back();
@@ -123,10 +128,11 @@ class CustomList {
   void pop_front();
   void pop_back();
 
-  void swap(CustomList<T>& other);
-  void splice(CustomList<T> const& other);
-  void splice(iterator pos, CustomList<T> const& other);
-  void merge(CustomList<T> const& other);
+  void swap(CustomList<T, Allocator>& other);
+  void splice(CustomList<T, Allocator> const& other);
+  void splice(iterator pos, CustomList<T, Allocator> const& other);
+  void merge(CustomList<T, Allocator> const& other);
+  allocator_type get_allocator() const;
 
   template <typename... Args>
   void emplace(size_type index, Args... args);
@@ -136,25 +142,38 @@ class CustomList {
   void emplace_back(Args... args);
 
  private:
+  using NodeAllocator = typename std::allocator_traits<
+      Allocator>::template rebind_alloc<Node>;
+  using NodeTraits = std::allocator_traits<NodeAllocator>;
+
   Node* head = nullptr;
   Node* tail = nullptr;
   std::size_t size_ = 0;
+  NodeAllocator allocator;
+
+  template <typename... Args>
+  Node* createNode(Args&&... args);
+  void destroyNode(Node* node);
 
   int find_position(const iterator& it) const;
   void localSwap(Node* ptr1, Node* ptr2);
 };
 
-template <typename T>
-CustomList<T>::CustomList() : head(nullptr), tail(nullptr), size_(0) {}
-template <typename T>
-CustomList<T>::CustomList(size_type n)
+template <typename T, typename Allocator>
+CustomList<T, Allocator>::CustomList()
+    : head(nullptr), tail(nullptr), size_(0), allocator() {}
+template <typename T, typename Allocator>
+CustomList<T, Allocator>::CustomList(const Allocator& alloc)
+    : head(nullptr), tail(nullptr), size_(0), allocator(alloc) {}
+template <typename T, typename Allocator>
+CustomList<T, Allocator>::CustomList(size_type n)
     : head(nullptr), tail(nullptr), size_(0) {
   for (std::size_t i = 0; i < n; i++) {
     push_back(T());
   }
 }
-template <typename T>
-CustomList<T>::CustomList(std::initializer_list<T> const& initList) {
+template <typename T, typename Allocator>
+CustomList<T, Allocator>::CustomList(std::initializer_list<T> const& initList) {
   head = nullptr;
   tail = nullptr;
   size_ = 0;
@@ -162,30 +181,41 @@ CustomList<T>::CustomList(std::initializer_list<T> const& initList) {
     push_back(value);
   }
 }
-template <typename T>
-CustomList<T>::CustomList(const CustomList<T>& other)
-    : head(nullptr), tail(nullptr), size_(0) {
+template <typename T, typename Allocator>
+CustomList<T, Allocator>::CustomList(const CustomList& other)
+    : head(nullptr),
+      tail(nullptr),
+      size_(0),
+      allocator(NodeTraits::select_on_container_copy_construction(
+          other.allocator)) {
   Node* current = other.head;
   while (current != nullptr) {
     push_back(current->data);
     current = current->next;
   }
 }
-template <typename T>
-CustomList<T>::CustomList(CustomList<T>&& other)
-    : head(other.head), tail(other.tail), size_(other.size_) {
+template <typename T, typename Allocator>
+CustomList<T, Allocator>::CustomList(CustomList&& other)
+    : head(other.head),
+      tail(other.tail),
+      size_(other.size_),
+      allocator(std::move(other.allocator)) {
   other.head = nullptr;
   other.tail = nullptr;
   other.size_ = 0;
 }
-template <typename T>
-CustomList<T>::~CustomList() {
+template <typename T, typename Allocator>
+CustomList<T, Allocator>::~CustomList() {
   clear();
 }
-template <typename T>
-CustomList<T>& CustomList<T>::operator=(const CustomList<T>& other) {
+template <typename T, typename Allocator>
+CustomList<T, Allocator>& CustomList<T, Allocator>::operator=(
+    const CustomList& other) {
   if (this != &other) {
     clear();
+    if constexpr (NodeTraits::propagate_on_container_copy_assignment::value) {
+      allocator = other.allocator;
+    }
 
     Node* current = other.head;
     while (current != nullptr) {
@@ -196,10 +226,24 @@ CustomList<T>& CustomList<T>::operator=(const CustomList<T>& other) {
   }
   return *this;
 }
-template <typename T>
-CustomList<T>& CustomList<T>::operator=(CustomList<T>&& other) {
+template <typename T, typename Allocator>
+CustomList<T, Allocator>& CustomList<T, Allocator>::operator=(
+    CustomList&& other) {
   if (this != &other) {
     clear();
+    if constexpr (!NodeTraits::propagate_on_container_move_assignment::value) {
+      // Nodes from an unequal allocator cannot be freed through this one,
+      // so only their elements come over.
+      if (allocator != other.allocator) {
+        for (Node* node = other.head; node != nullptr; node = node->next) {
+          push_back(std::move(node->data));
+        }
+        other.clear();
+        return *this;
+      }
+    } else {
+      allocator = std::move(other.allocator);
+    }
 
     head = other.head;
     tail = other.tail;
@@ -211,9 +255,32 @@ CustomList<T>& CustomList<T>::operator=(CustomList<T>&& other) {
   }
   return *this;
 }
-template <typename T>
-void CustomList<T>::push_back(const T& value) {
-  Node* node = new Node(value);
+template <typename T, typename Allocator>
+template <typename... Args>
+typename CustomList<T, Allocator>::Node* CustomList<T, Allocator>::createNode(
+    Args&&... args) {
+  Node* node = NodeTraits::allocate(allocator, 1);
+  try {
+    NodeTraits::construct(allocator, node, std::forward<Args>(args)...);
+  } catch (...) {
+    NodeTraits::deallocate(allocator, node, 1);
+    throw;
+  }
+  return node;
+}
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::destroyNode(Node* node) {
+  NodeTraits::destroy(allocator, node);
+  NodeTraits::deallocate(allocator, node, 1);
+}
+template <typename T, typename Allocator>
+typename CustomList<T, Allocator>::allocator_type
+CustomList<T, Allocator>::get_allocator() const {
+  return allocator_type(allocator);
+}
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::push_back(const T& value) {
+  Node* node = createNode(value);
   if (tail == nullptr) {
     head = tail = node;
   } else {
@@ -223,67 +290,71 @@ void CustomList<T>::push_back(const T& value) {
   }
   size_++;
 }
-template <typename T>
-void CustomList<T>::clear() {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::clear() {
   Node* current = head;
   while (current != nullptr) {
     Node* next = current->next;
-    delete current;
+    destroyNode(current);
     current = next;
   }
   head = tail = nullptr;
   size_ = 0;
 }
-template <typename T>
-const T& CustomList<T>::front() {
+template <typename T, typename Allocator>
+const T& CustomList<T, Allocator>::front() {
   return head->data;
 }
-template <typename T>
-const T& CustomList<T>::back() {
+template <typename T, typename Allocator>
+const T& CustomList<T, Allocator>::back() {
   return tail->data;
 }
-template <typename T>
-typename CustomList<T>::iterator CustomList<T>::begin() {
+template <typename T, typename Allocator>
+typename CustomList<T, Allocator>::iterator CustomList<T, Allocator>::begin() {
   return iterator(head);
 }
-template <typename T>
-typename CustomList<T>::iterator CustomList<T>::end() {
+template <typename T, typename Allocator>
+typename CustomList<T, Allocator>::iterator CustomList<T, Allocator>::end() {
   return iterator(tail);
 }
-template <typename T>
-const typename CustomList<T>::iterator CustomList<T>::cbegin() const {
+template <typename T, typename Allocator>
+const typename CustomList<T, Allocator>::iterator
+CustomList<T, Allocator>::cbegin() const {
   return iterator(head);
 }
-template <typename T>
-const typename CustomList<T>::iterator CustomList<T>::cend() const {
+template <typename T, typename Allocator>
+const typename CustomList<T, Allocator>::iterator
+CustomList<T, Allocator>::cend() const {
   return iterator(nullptr);
 }
-template <typename T>
-typename CustomList<T>::iterator CustomList<T>::rbegin() {
+template <typename T, typename Allocator>
+typename CustomList<T, Allocator>::iterator CustomList<T, Allocator>::rbegin() {
   return iterator(tail);
 }
-template <typename T>
-typename CustomList<T>::iterator CustomList<T>::rend() {
+template <typename T, typename Allocator>
+typename CustomList<T, Allocator>::iterator CustomList<T, Allocator>::rend() {
   return iterator(nullptr);
 }
-template <typename T>
-const typename CustomList<T>::iterator CustomList<T>::crbegin() const {
+template <typename T, typename Allocator>
+const typename CustomList<T, Allocator>::iterator
+CustomList<T, Allocator>::crbegin() const {
   return iterator(tail);
 }
-template <typename T>
-const typename CustomList<T>::iterator CustomList<T>::crend() const {
+template <typename T, typename Allocator>
+const typename CustomList<T, Allocator>::iterator
+CustomList<T, Allocator>::crend() const {
   return iterator(nullptr);
 }
-template <typename T>
-std::size_t CustomList<T>::size() const {
+template <typename T, typename Allocator>
+std::size_t CustomList<T, Allocator>::size() const {
   return size_;
 }
-template <typename T>
-bool CustomList<T>::empty() const {
+template <typename T, typename Allocator>
+bool CustomList<T, Allocator>::empty() const {
   return head == nullptr;
 }
-template <typename T>
-void CustomList<T>::pop_back() {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::pop_back() {
   if (size_ == 0) return;
 
   Node* ptr = tail;
@@ -293,11 +364,11 @@ void CustomList<T>::pop_back() {
     tail = tail->prev;
     tail->next = nullptr;
   }
-  delete ptr;
+  destroyNode(ptr);
   size_--;
 }
-template <typename T>
-void CustomList<T>::resize(std::size_t newSize) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::resize(std::size_t newSize) {
   while (size_ < newSize) {
     push_back(T());
   }
@@ -305,8 +376,8 @@ void CustomList<T>::resize(std::size_t newSize) {
     pop_back();
   }
 }
-template <typename T>
-void CustomList<T>::resize(std::size_t newSize, const T& value) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::resize(std::size_t newSize, const T& value) {
   while (size_ < newSize) {
     push_back(value);
   }
@@ -314,13 +385,13 @@ void CustomList<T>::resize(std::size_t newSize, const T& value) {
     pop_back();
   }
 }
-template <typename T>
-std::size_t CustomList<T>::max_size() const {
+template <typename T, typename Allocator>
+std::size_t CustomList<T, Allocator>::max_size() const {
   return std::numeric_limits<std::size_t>::max() / sizeof(T);
 }
-template <typename T>
-void CustomList<T>::push_front(const T& value) {
-  Node* newHead = new Node(value);
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::push_front(const T& value) {
+  Node* newHead = createNode(value);
   if (head != nullptr) {
     head->prev = newHead;
     newHead->next = head;
@@ -330,8 +401,8 @@ void CustomList<T>::push_front(const T& value) {
   head = newHead;
   ++size_;
 }
-template <typename T>
-void CustomList<T>::pop_front() {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::pop_front() {
   if (head == nullptr) return;
 
   Node* ptr = head;
@@ -341,11 +412,11 @@ void CustomList<T>::pop_front() {
     head = ptr->next;
     head->prev = nullptr;
   }
-  delete ptr;
+  destroyNode(ptr);
   --size_;
 }
-template <typename T>
-void CustomList<T>::remove(const T& value) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::remove(const T& value) {
   Node* ptr = head;
   while (ptr != nullptr) {
     if (ptr->data == value) {
@@ -360,7 +431,7 @@ void CustomList<T>::remove(const T& value) {
         ptr->prev->next = ptr->next;
         ptr->next->prev = ptr->prev;
         ptr = ptr->next;
-        delete toDelete;
+        destroyNode(toDelete);
         --size_;
       }
     } else {
@@ -368,14 +439,14 @@ void CustomList<T>::remove(const T& value) {
     }
   }
 }
-template <typename T>
-void CustomList<T>::localSwap(Node* ptr1, Node* ptr2) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::localSwap(Node* ptr1, Node* ptr2) {
   T tmp = ptr1->data;
   ptr1->data = ptr2->data;
   ptr2->data = tmp;
 }
-template <typename T>
-void CustomList<T>::sort() {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::sort() {
   if (size_ > 1) {
     for (std::size_t i = 0; i < size_; i++) {
       Node* ptr = head;
@@ -388,8 +459,8 @@ void CustomList<T>::sort() {
     }
   }
 }
-template <typename T>
-void CustomList<T>::reverse() {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::reverse() {
   if (size_ > 1) {
     Node* ptr1 = head;
     Node* ptr2 = tail;
@@ -400,10 +471,10 @@ void CustomList<T>::reverse() {
     }
   }
 }
-template <typename T>
-void CustomList<T>::insert(std::size_t index, T const& value) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::insert(std::size_t index, T const& value) {
   if (index > size_) throw std::out_of_range("Index out of range.");
-  Node* newNode = new Node(value);
+  Node* newNode = createNode(value);
   if (index == 0) {
     newNode->next = head;
     if (head != nullptr) head->prev = newNode;
@@ -423,22 +494,23 @@ void CustomList<T>::insert(std::size_t index, T const& value) {
   size_++;
 }
 
-template <typename T>
-void CustomList<T>::insert(std::size_t index, std::size_t range, T& value) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::insert(std::size_t index, std::size_t range,
+                                      T& value) {
   for (std::size_t i = 0; i < range; i++) {
     insert(index + i, value);
   }
 }
-template <typename T>
-void CustomList<T>::insert(std::size_t posIndex,
-                           std::initializer_list<T> initList) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::insert(std::size_t posIndex,
+                                      std::initializer_list<T> initList) {
   insert(posIndex, initList.begin(), initList.end());
 }
-template <typename T>
-typename CustomList<T>::iterator CustomList<T>::insert(iterator pos,
-                                                       const_reference value) {
+template <typename T, typename Allocator>
+typename CustomList<T, Allocator>::iterator CustomList<T, Allocator>::insert(
+    iterator pos, const_reference value) {
   if (pos.ptr_ == head) {
-    Node* newNode = new Node(value, nullptr, head);
+    Node* newNode = createNode(value, nullptr, head);
     if (head != nullptr) {
       head->prev = newNode;
     }
@@ -452,7 +524,7 @@ typename CustomList<T>::iterator CustomList<T>::insert(iterator pos,
       current = current->next;
     }
     if (current != nullptr) {
-      Node* newNode = new Node(value, current, current->next);
+      Node* newNode = createNode(value, current, current->next);
       if (current->next != nullptr) {
         current->next->prev = newNode;
       }
@@ -465,8 +537,8 @@ typename CustomList<T>::iterator CustomList<T>::insert(iterator pos,
   size_++;
   return iterator(pos.ptr_);
 }
-template <typename T>
-void CustomList<T>::erase(iterator pos) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::erase(iterator pos) {
   Node* posNode = pos.getNodePtr();
   if (posNode == nullptr) return;
   if (posNode == head) {
@@ -478,12 +550,12 @@ void CustomList<T>::erase(iterator pos) {
     if (posNode->next != nullptr) {
       posNode->next->prev = posNode->prev;
     }
-    delete posNode;
+    destroyNode(posNode);
     size_--;
   }
 }
-template <typename T>
-void CustomList<T>::erase(std::size_t index) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::erase(std::size_t index) {
   if (index >= size_) throw std::out_of_range("Index out of range.");
   if (index == 0) {
     Node* ptr = head;
@@ -493,7 +565,7 @@ void CustomList<T>::erase(std::size_t index) {
     } else {
       tail = nullptr;
     }
-    delete ptr;
+    destroyNode(ptr);
   } else {
     Node* ptr = head;
     for (std::size_t i = 0; i < index; i++) {
@@ -507,12 +579,12 @@ void CustomList<T>::erase(std::size_t index) {
     if (ptr->prev != nullptr) {
       ptr->prev->next = ptr->next;
     }
-    delete ptr;
+    destroyNode(ptr);
   }
   size_--;
 }
-template <typename T>
-void CustomList<T>::assign(std::size_t index, const T& value) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::assign(std::size_t index, const T& value) {
   if (index >= size_) throw std::out_of_range("Index out of range.");
   if (index == 0) {
     head->data = value;
@@ -524,8 +596,8 @@ void CustomList<T>::assign(std::size_t index, const T& value) {
     ptr->data = value;
   }
 }
-template <typename T>
-void CustomList<T>::assign(std::initializer_list<T> initList) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::assign(std::initializer_list<T> initList) {
   if (initList.size() > size_) {
     clear();
     for (const auto& value : initList) {
@@ -541,9 +613,9 @@ void CustomList<T>::assign(std::initializer_list<T> initList) {
     }
   }
 }
-template <typename T>
-void CustomList<T>::assign(std::size_t index, std::size_t range,
-                           const T& value) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::assign(std::size_t index, std::size_t range,
+                                      const T& value) {
   if (index + range > size_) throw std::out_of_range("Range out of bounds.");
   Node* ptr = head;
   for (std::size_t i = 0; i < index; ++i) ptr = ptr->next;
@@ -554,8 +626,8 @@ void CustomList<T>::assign(std::size_t index, std::size_t range,
     }
   }
 }
-template <typename T>
-void CustomList<T>::unique() {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::unique() {
   Node* current = head;
   while (current != nullptr && current->next != nullptr) {
     Node* runner = current;
@@ -568,7 +640,7 @@ void CustomList<T>::unique() {
         } else {
           tail = runner;
         }
-        delete duplicate;
+        destroyNode(duplicate);
         size_--;
       } else {
         runner = runner->next;
@@ -577,8 +649,8 @@ void CustomList<T>::unique() {
     current = current->next;
   }
 }
-template <typename T>
-void CustomList<T>::unique(bool (*func)(const T&, const T&)) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::unique(bool (*func)(const T&, const T&)) {
   Node* current = head;
   while (current != nullptr && current->next != nullptr) {
     Node* runner = current;
@@ -591,7 +663,7 @@ void CustomList<T>::unique(bool (*func)(const T&, const T&)) {
         } else {
           tail = runner;
         }
-        delete duplicate;
+        destroyNode(duplicate);
         size_--;
       } else {
         runner = runner->next;
@@ -601,17 +673,20 @@ void CustomList<T>::unique(bool (*func)(const T&, const T&)) {
   }
 }
 
-template <typename T>
-void CustomList<T>::swap(CustomList<T>& other) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::swap(CustomList& other) {
+  if constexpr (NodeTraits::propagate_on_container_swap::value) {
+    std::swap(allocator, other.allocator);
+  }
   std::swap(head, other.head);
   std::swap(tail, other.tail);
   std::swap(size_, other.size_);
 }
-template <typename T>
-void CustomList<T>::merge(CustomList<T> const& other) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::merge(CustomList<T, Allocator> const& other) {
   Node* thisPtr = head;
   Node* otherPtr = other.head;
-  CustomList<T> resultList;
+  CustomList<T, Allocator> resultList;
   while (thisPtr != nullptr && otherPtr != nullptr) {
     if (thisPtr->data < otherPtr->data) {
       resultList.push_back(thisPtr->data);
@@ -632,8 +707,8 @@ void CustomList<T>::merge(CustomList<T> const& other) {
   swap(resultList);
   other.clear();
 }
-template <typename T>
-void CustomList<T>::splice(CustomList<T> const& other) {
+template <typename T, typename Allocator>
+void CustomList<T, Allocator>::splice(CustomList<T, Allocator> const& other) {
   if (other.head != nullptr) {
     if (head == nullptr) {
       head = other.head;
@@ -648,9 +723,9 @@ void CustomList<T>::splice(CustomList<T> const& other) {
     other.size_ = 0;
   }
 }
-template <typename T>
+template <typename T, typename Allocator>
 template <typename... Args>
-void CustomList<T>::emplace(std::size_t index, Args&&... args) {
+void CustomList<T, Allocator>::emplace(std::size_t index, Args&&... args) {
   if (index > size_) throw std::out_of_range("Index out of range.");
   if (index == 0) {
     emplace_front(std::forward<Args>(args)...);
@@ -659,7 +734,7 @@ void CustomList<T>::emplace(std::size_t index, Args&&... args) {
   Node* ptr = head;
   for (std::size_t i = 0; i < index - 1; i++) ptr = ptr->next;
   T value(std::forward<Args>(args)...);
-  Node* newNode = new Node(value);
+  Node* newNode = createNode(value);
   newNode->next = ptr->next;
   if (ptr->next != nullptr) {
     ptr->next->prev = newNode;
@@ -670,11 +745,11 @@ void CustomList<T>::emplace(std::size_t index, Args&&... args) {
   ptr->next = newNode;
   size_++;
 }
-template <typename T>
+template <typename T, typename Allocator>
 template <typename... Args>
-void CustomList<T>::emplace_front(Args&&... args) {
+void CustomList<T, Allocator>::emplace_front(Args&&... args) {
   T value(std::forward<Args>(args)...);
-  Node* newNode = new Node(value);
+  Node* newNode = createNode(value);
   if (head != nullptr) {
     newNode->next = head;
     head->prev = newNode;
@@ -684,16 +759,16 @@ void CustomList<T>::emplace_front(Args&&... args) {
   head = newNode;
   size_++;
 }
-template <typename T>
+template <typename T, typename Allocator>
 template <typename... Args>
-void CustomList<T>::emplace_back(Args&&... args) {
-  Node* newNode = new Node(T(std::forward<Args>(args)...));
+void CustomList<T, Allocator>::emplace_back(Args&&... args) {
+  Node* newNode = createNode(T(std::forward<Args>(args)...));
   tail->next = newNode;
   newNode->prev = tail;
   tail = newNode;
 }
-template <typename T>
-int CustomList<T>::find_position(const iterator& it) const {
+template <typename T, typename Allocator>
+int CustomList<T, Allocator>::find_position(const iterator& it) const {
   Node* current = head;
   int index = 0;
   while (current != nullptr) {
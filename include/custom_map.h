@@ -1,23 +1,35 @@
 #ifndef SRC_INCLUDE_CUSTOM_MAP_H_
 #define SRC_INCLUDE_CUSTOM_MAP_H_
 
+#include <algorithm>
 #include <cstddef>
+#include <functional>
 #include <initializer_list>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 
 #include "custom_vector.h"
+#include "b_tree.h"
+#include "node_pool.h"
+#include "persistent_rb_tree.h"
 #include "rb_tree.h"
 
-template <typename Key, typename T>
+// Tree is the map's tree type; the iterator holds one of its positions and
+// steps with Tree::findNext and Tree::findPrev.
+template <typename Key, typename T,
+          typename Tree = RBTree<Key, std::pair<const Key, T>>>
 class MapIterator {
  public:
-  using Node = typename RBTree<Key, std::pair<const Key, T>>::Node;
   using MapIter = MapIterator;
+  using Position = typename Tree::Position;
 
   MapIterator();
-  explicit MapIterator(Node* node);
+  explicit MapIterator(Position pos);
 
   Key getKey() const;
+  Position getPosition() const;
 
   std::pair<const Key, T>& operator*() const;
   std::pair<const Key, T>* operator->() const;
@@ -29,154 +41,302 @@ class MapIterator {
   bool operator!=(const MapIter& other) const;
 
  private:
-  Node* nodePtr;
+  Position position;
 };
 
-template <typename Key, typename Value>
+// Backend picks the underlying tree; RBTreeBackend<true> keeps subtree sizes
+// so that select, rank and count_in_range run in O(log n),
+// BTreeBackend<> stores the elements in a B-tree, and
+// PersistentRBTreeBackend shares nodes between the map, its copies and its
+// snapshots (see PersistentRBTree).
+//
+// Compare orders the keys. With a transparent comparator such as
+// std::less<> the lookups take any key type it can compare with Key, so a
+// Map<std::string, T, ..., std::less<>> can be searched with a
+// std::string_view or a string literal without building a std::string.
+template <typename Key, typename Value,
+          typename Allocator = NodePool<std::pair<const Key, Value>>,
+          typename Backend = RBTreeBackend<>,
+          typename Compare = std::less<Key>>
 class Map {
  public:
   using key_type = Key;
-  using iterator = MapIterator<Key, Value>;
   using mapped_type = Value;
   using value_type = std::pair<const Key, Value>;
   using map = Map;
   using size_type = std::size_t;
+  using allocator_type = Allocator;
+  using key_compare = Compare;
+  using tree_type =
+      typename Backend::template tree<key_type, value_type, Allocator, true,
+                                      RBTreeFirstKey, Compare>;
+  using iterator = MapIterator<Key, Value, tree_type>;
+  using node_type = typename tree_type::NodeHandle;
+  struct insert_return_type {
+    iterator position;
+    bool inserted;
+    node_type node;
+  };
 
   explicit Map();
+  explicit Map(const Allocator& alloc);
   explicit Map(std::initializer_list<value_type> const& items);
+  // Sorted forward ranges are bulk-loaded in O(n); anything else is
+  // inserted element by element. Like insert, the first of equal keys wins.
+  template <typename InputIt>
+  Map(InputIt first, InputIt last);
   explicit Map(const map& m);
   explicit Map(map&& m);
   ~Map();
 
   Map& operator=(map&& m);
 
+  // Elements are built once, inside their node, and the rvalue overloads
+  // move into it. Only emplace and emplace_hint build an element before
+  // they know whether its key is new, since they read the key from it.
   std::pair<iterator, bool> insert(const value_type& value);
+  std::pair<iterator, bool> insert(value_type&& value);
+  iterator insert(iterator hint, const value_type& value);
+  iterator insert(iterator hint, value_type&& value);
   std::pair<iterator, bool> insert(const key_type& key,
                                    const mapped_type& value);
   std::pair<iterator, bool> insert_or_assign(const key_type& key,
                                              const mapped_type& value);
+  std::pair<iterator, bool> insert_or_assign(const key_type& key,
+                                             mapped_type&& value);
+  // The mapped value is built from args only if key is not in the map yet.
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args);
+  template <typename... Args>
+  iterator try_emplace(iterator hint, const key_type& key, Args&&... args);
+  template <typename... Args>
+  iterator try_emplace(iterator hint, key_type&& key, Args&&... args);
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args);
+  template <typename... Args>
+  iterator emplace_hint(iterator hint, Args&&... args);
   void erase(iterator pos);
+  // Node handles move elements between maps without copying them (see
+  // RBTree::extractNode). extract(key) returns an empty handle when the
+  // key is absent; insert(node) hands the node back in insert_return_type
+  // when the key is already there.
+  node_type extract(iterator pos);
+  node_type extract(const key_type& key);
+  insert_return_type insert(node_type&& node);
+  iterator insert(iterator hint, node_type&& node);
   Value& operator[](const key_type& key);
-  Value& at(const key_type& key);
+  Value& operator[](key_type&& key);
   iterator begin();
   iterator end();
   size_type size() const;
   size_type max_size() const;
   bool empty() const;
   void clear();
-  bool contains(const key_type& key) const;
+
+  // Each lookup takes a key_type, or with a transparent Compare any K it
+  // can compare with Key (see RBTreeLookup).
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  iterator find(const K& key);
+  iterator find(const key_type& key) { return find<key_type>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  Value& at(const K& key);
+  Value& at(const key_type& key) { return at<key_type>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  bool contains(const K& key) const;
+  bool contains(const key_type& key) const { return contains<key_type>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  iterator lower_bound(const K& key);
+  iterator lower_bound(const key_type& key) {
+    return lower_bound<key_type>(key);
+  }
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  iterator upper_bound(const K& key);
+  iterator upper_bound(const key_type& key) {
+    return upper_bound<key_type>(key);
+  }
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  std::pair<iterator, iterator> equal_range(const K& key);
+  std::pair<iterator, iterator> equal_range(const key_type& key) {
+    return equal_range<key_type>(key);
+  }
 
   void swap(map& other);
+  // Moves over the elements of `other` whose keys are not in this map; the
+  // others stay in `other`. Nodes are relinked when the two allocators
+  // compare equal and otherwise their values move into new nodes, as with
+  // the default NodePool, which every map keeps one of.
   void merge(map& other);
+  // Set algebra by key, in time linear in the two sizes (logarithmic per
+  // element of the smaller map when they are far apart). Surviving
+  // elements keep this map's values; union_with adds copies of the
+  // elements of `other` whose keys are new here.
+  void union_with(const map& other);
+  void intersect_with(const map& other);
+  void difference_with(const map& other);
+  void symmetric_difference_with(const map& other);
+  // Partitioning on the red-black backend (see RBTree::split). split_at
+  // moves the elements with keys not less than `key` into the returned
+  // map; concat moves in all of `other`, whose keys must all be greater
+  // than this map's, and throws std::invalid_argument otherwise. The two
+  // maps of a split share the NodePool, so their nodes are relinked and
+  // concat takes O(log n), as does split_at with RBTreeBackend<true>; on
+  // the default backend split_at counts the smaller part, O(min(k, n - k)).
+  // Maps sharing a pool must be used from one thread. Between maps with
+  // separate pools, the smaller side's values move into new nodes.
+  map split_at(const key_type& key);
+  void concat(map& other);
   template <typename... Args>
   CustomVector<std::pair<iterator, bool>> insert_many(Args&&... args);
 
+  // On the persistent backend, a read-only view of the map as it is now,
+  // taken in O(1); later writes to the map copy only the nodes they touch.
+  // It invalidates the map's iterators (see PersistentRBTree::Snapshot).
+  template <typename Tree = tree_type>
+  typename Tree::Snapshot snapshot() const {
+    return tree.snapshot();
+  }
+
+  // Order statistics; need an order-statistics backend. select(k) is the
+  // k-th element in key order (end() if k >= size()), rank(key) the number
+  // of keys less than `key`, count_in_range the number in [low, high).
+  iterator select(size_type index);
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  size_type rank(const K& key) const;
+  size_type rank(const key_type& key) const { return rank<key_type>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  size_type count_in_range(const K& low, const K& high) const;
+  size_type count_in_range(const key_type& low, const key_type& high) const {
+    return count_in_range<key_type>(low, high);
+  }
+
  private:
-  RBTree<key_type, value_type> tree;
+  tree_type tree;
   int elementsCount;
 };
 
-template <typename Key, typename T>
-MapIterator<Key, T>::MapIterator() : nodePtr(nullptr) {}
-template <typename Key, typename T>
-MapIterator<Key, T>::MapIterator(Node* node) : nodePtr(node) {}
-template <typename Key, typename T>
-std::pair<const Key, T>& MapIterator<Key, T>::operator*() const {
-  return nodePtr->value;
-}
-template <typename Key, typename T>
-std::pair<const Key, T>* MapIterator<Key, T>::operator->() const {
-  return &(nodePtr->value);
-}
-template <typename Key, typename T>
-MapIterator<Key, T>& MapIterator<Key, T>::operator++() {
-  if (nodePtr->right != nullptr) {
-    nodePtr = nodePtr->right;
-    while (nodePtr->left != nullptr) {
-      nodePtr = nodePtr->left;
-    }
-  } else {
-    Node* parent = nodePtr->parent;
-    while (parent != nullptr && nodePtr == parent->right) {
-      nodePtr = parent;
-      parent = parent->parent;
-    }
-    nodePtr = parent;
-  }
+template <typename Key, typename T, typename Tree>
+MapIterator<Key, T, Tree>::MapIterator() : position() {}
+template <typename Key, typename T, typename Tree>
+MapIterator<Key, T, Tree>::MapIterator(Position pos) : position(pos) {}
+template <typename Key, typename T, typename Tree>
+std::pair<const Key, T>& MapIterator<Key, T, Tree>::operator*() const {
+  return Tree::valueOf(position);
+}
+template <typename Key, typename T, typename Tree>
+std::pair<const Key, T>* MapIterator<Key, T, Tree>::operator->() const {
+  return &Tree::valueOf(position);
+}
+template <typename Key, typename T, typename Tree>
+MapIterator<Key, T, Tree>& MapIterator<Key, T, Tree>::operator++() {
+  position = Tree::findNext(position);
   return *this;
 }
-template <typename Key, typename T>
-MapIterator<Key, T> MapIterator<Key, T>::operator++(int) {
+template <typename Key, typename T, typename Tree>
+MapIterator<Key, T, Tree> MapIterator<Key, T, Tree>::operator++(int) {
   MapIter temp = *this;
   ++(*this);
   return temp;
 }
-template <typename Key, typename T>
-MapIterator<Key, T>& MapIterator<Key, T>::operator--() {
-  if (nodePtr->left != nullptr) {
-    nodePtr = nodePtr->left;
-    while (nodePtr->right != nullptr) {
-      nodePtr = nodePtr->right;
-    }
-  } else {
-    Node* parent = nodePtr->parent;
-    while (parent != nullptr && nodePtr == parent->left) {
-      nodePtr = parent;
-      parent = parent->parent;
-    }
-    nodePtr = parent;
-  }
+template <typename Key, typename T, typename Tree>
+MapIterator<Key, T, Tree>& MapIterator<Key, T, Tree>::operator--() {
+  position = Tree::findPrev(position);
   return *this;
 }
-template <typename Key, typename T>
-MapIterator<Key, T> MapIterator<Key, T>::operator--(int) {
+template <typename Key, typename T, typename Tree>
+MapIterator<Key, T, Tree> MapIterator<Key, T, Tree>::operator--(int) {
   MapIter temp = *this;
   --(*this);
   return temp;
 }
-template <typename Key, typename T>
-bool MapIterator<Key, T>::operator==(const MapIter& other) const {
-  return nodePtr == other.nodePtr;
+template <typename Key, typename T, typename Tree>
+bool MapIterator<Key, T, Tree>::operator==(const MapIter& other) const {
+  return position == other.position;
 }
-template <typename Key, typename T>
-bool MapIterator<Key, T>::operator!=(const MapIter& other) const {
-  return nodePtr != other.nodePtr;
+template <typename Key, typename T, typename Tree>
+bool MapIterator<Key, T, Tree>::operator!=(const MapIter& other) const {
+  return position != other.position;
 }
-template <typename Key, typename T>
-Key MapIterator<Key, T>::getKey() const {
-  if (nodePtr == nullptr) {
+template <typename Key, typename T, typename Tree>
+Key MapIterator<Key, T, Tree>::getKey() const {
+  if (position == Position()) {
     throw std::runtime_error("Iterator does not point to a valid node");
   }
-  return nodePtr->key;
+  return Tree::valueOf(position).first;
+}
+template <typename Key, typename T, typename Tree>
+typename MapIterator<Key, T, Tree>::Position
+MapIterator<Key, T, Tree>::getPosition() const {
+  return position;
 }
 
-template <typename Key, typename Value>
-Map<Key, Value>::Map() : tree(), elementsCount(0) {}
-template <typename Key, typename Value>
-Map<Key, Value>::Map(const map& m)
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+Map<Key, Value, Allocator, Backend, Compare>::Map()
+    : tree(), elementsCount(0) {}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+Map<Key, Value, Allocator, Backend, Compare>::Map(const Allocator& alloc)
+    : tree(alloc), elementsCount(0) {}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+Map<Key, Value, Allocator, Backend, Compare>::Map(const map& m)
     : tree(m.tree), elementsCount(m.elementsCount) {}
-template <typename Key, typename Value>
-Map<Key, Value>::Map(map&& m)
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+Map<Key, Value, Allocator, Backend, Compare>::Map(map&& m)
     : tree(std::move(m.tree)), elementsCount(m.elementsCount) {
   m.elementsCount = 0;
 }
-template <typename Key, typename Value>
-void Map<Key, Value>::clear() {
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+void Map<Key, Value, Allocator, Backend, Compare>::clear() {
   tree.clear();
   elementsCount = 0;
 }
-template <typename Key, typename Value>
-Map<Key, Value>::Map(std::initializer_list<value_type> const& items) : Map() {
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+Map<Key, Value, Allocator, Backend, Compare>::Map(
+    std::initializer_list<value_type> const& items)
+    : Map() {
   for (const auto& item : items) {
-    insert(item.first, item.second);
+    insert(end(), item);
+  }
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename InputIt>
+Map<Key, Value, Allocator, Backend, Compare>::Map(InputIt first,
+                                                  InputIt last)
+    : Map() {
+  using Category = typename std::iterator_traits<InputIt>::iterator_category;
+  if constexpr (std::is_base_of<std::forward_iterator_tag, Category>::value) {
+    auto byKey = [compare = tree.keyComp()](const auto& lhs,
+                                            const auto& rhs) {
+      return compare(lhs.first, rhs.first);
+    };
+    if (std::is_sorted(first, last, byKey)) {
+      tree.buildFromSorted(first, last, [](const auto& item) -> const auto& {
+        return item.first;
+      });
+      elementsCount = tree.size();
+      return;
+    }
+  }
+  for (; first != last; ++first) {
+    insert(end(), *first);
   }
 }
-template <typename Key, typename Value>
-Map<Key, Value>::~Map() {
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+Map<Key, Value, Allocator, Backend, Compare>::~Map() {
   clear();
 }
-template <typename Key, typename Value>
-Map<Key, Value>& Map<Key, Value>::operator=(map&& m) {
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+Map<Key, Value, Allocator, Backend, Compare>&
+Map<Key, Value, Allocator, Backend, Compare>::operator=(map&& m) {
   if (this != &m) {
     clear();
     tree = std::move(m.tree);
@@ -185,113 +345,395 @@ Map<Key, Value>& Map<Key, Value>::operator=(map&& m) {
   }
   return *this;
 }
-template <typename Key, typename Value>
-std::pair<typename Map<Key, Value>::iterator, bool> Map<Key, Value>::insert(
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+std::pair<typename Map<Key, Value, Allocator, Backend, Compare>::iterator, bool>
+Map<Key, Value, Allocator, Backend, Compare>::insert(
     const Key& key, const Value& value) {
-  auto node = tree.find(key);
-  if (node != nullptr) {
-    return std::make_pair(iterator(node), false);
-  } else {
-    tree.insert(key, std::make_pair(key, value));
+  auto [position, inserted] = tree.emplace(key, key, value);
+  if (inserted) {
     ++elementsCount;
-    node = tree.find(key);
-    return std::make_pair(iterator(node), true);
   }
+  return std::make_pair(iterator(position), inserted);
 }
-template <typename Key, typename Value>
-std::pair<typename Map<Key, Value>::iterator, bool>
-Map<Key, Value>::insert_or_assign(const key_type& key,
-                                  const mapped_type& value) {
-  auto node = tree.find(key);
-  if (node != nullptr) {
-    node->value.second = value;
-    return std::make_pair(iterator(node), false);
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+std::pair<typename Map<Key, Value, Allocator, Backend, Compare>::iterator, bool>
+Map<Key, Value, Allocator, Backend, Compare>::insert_or_assign(
+    const key_type& key, const mapped_type& value) {
+  auto [position, inserted] = tree.emplace(key, key, value);
+  if (inserted) {
+    ++elementsCount;
+  } else {
+    tree_type::valueOf(position).second = value;
+  }
+  return std::make_pair(iterator(position), inserted);
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+std::pair<typename Map<Key, Value, Allocator, Backend, Compare>::iterator, bool>
+Map<Key, Value, Allocator, Backend, Compare>::insert_or_assign(
+    const key_type& key, mapped_type&& value) {
+  auto [position, inserted] = tree.emplace(key, key, std::move(value));
+  if (inserted) {
+    ++elementsCount;
   } else {
-    tree.insert(key, std::make_pair(key, value));
+    tree_type::valueOf(position).second = std::move(value);
+  }
+  return std::make_pair(iterator(position), inserted);
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename... Args>
+std::pair<typename Map<Key, Value, Allocator, Backend, Compare>::iterator, bool>
+Map<Key, Value, Allocator, Backend, Compare>::try_emplace(const key_type& key,
+                                                          Args&&... args) {
+  auto [position, inserted] = tree.emplace(
+      key, std::piecewise_construct, std::forward_as_tuple(key),
+      std::forward_as_tuple(std::forward<Args>(args)...));
+  if (inserted) {
+    ++elementsCount;
+  }
+  return std::make_pair(iterator(position), inserted);
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename... Args>
+std::pair<typename Map<Key, Value, Allocator, Backend, Compare>::iterator, bool>
+Map<Key, Value, Allocator, Backend, Compare>::try_emplace(key_type&& key,
+                                                          Args&&... args) {
+  auto [position, inserted] = tree.emplace(
+      key, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+      std::forward_as_tuple(std::forward<Args>(args)...));
+  if (inserted) {
+    ++elementsCount;
+  }
+  return std::make_pair(iterator(position), inserted);
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename... Args>
+typename Map<Key, Value, Allocator, Backend, Compare>::iterator
+Map<Key, Value, Allocator, Backend, Compare>::try_emplace(
+    iterator hint, const key_type& key, Args&&... args) {
+  auto [position, inserted] = tree.emplaceWithHint(
+      hint.getPosition(), key, std::piecewise_construct,
+      std::forward_as_tuple(key),
+      std::forward_as_tuple(std::forward<Args>(args)...));
+  if (inserted) {
+    ++elementsCount;
+  }
+  return iterator(position);
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename... Args>
+typename Map<Key, Value, Allocator, Backend, Compare>::iterator
+Map<Key, Value, Allocator, Backend, Compare>::try_emplace(
+    iterator hint, key_type&& key, Args&&... args) {
+  auto [position, inserted] = tree.emplaceWithHint(
+      hint.getPosition(), key, std::piecewise_construct,
+      std::forward_as_tuple(std::move(key)),
+      std::forward_as_tuple(std::forward<Args>(args)...));
+  if (inserted) {
     ++elementsCount;
-    node = tree.find(key);
-    return std::make_pair(iterator(node), true);
   }
+  return iterator(position);
 }
-template <typename Key, typename Value>
-typename Map<Key, Value>::iterator Map<Key, Value>::begin() {
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename... Args>
+std::pair<typename Map<Key, Value, Allocator, Backend, Compare>::iterator, bool>
+Map<Key, Value, Allocator, Backend, Compare>::emplace(Args&&... args) {
+  auto [position, inserted] = tree.emplaceValue(std::forward<Args>(args)...);
+  if (inserted) {
+    ++elementsCount;
+  }
+  return std::make_pair(iterator(position), inserted);
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename... Args>
+typename Map<Key, Value, Allocator, Backend, Compare>::iterator
+Map<Key, Value, Allocator, Backend, Compare>::emplace_hint(iterator hint,
+                                                           Args&&... args) {
+  auto [position, inserted] = tree.emplaceValueWithHint(
+      hint.getPosition(), std::forward<Args>(args)...);
+  if (inserted) {
+    ++elementsCount;
+  }
+  return iterator(position);
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+typename Map<Key, Value, Allocator, Backend, Compare>::iterator
+Map<Key, Value, Allocator, Backend, Compare>::begin() {
   return iterator(tree.minimum());
 }
-template <typename Key, typename Value>
-typename Map<Key, Value>::iterator Map<Key, Value>::end() {
-  return iterator(nullptr);
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+typename Map<Key, Value, Allocator, Backend, Compare>::iterator
+Map<Key, Value, Allocator, Backend, Compare>::end() {
+  return iterator();
 }
-template <typename Key, typename Value>
-void Map<Key, Value>::erase(iterator pos) {
-  Key key = pos.getKey();
-  tree.remove(key);
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+void Map<Key, Value, Allocator, Backend, Compare>::erase(iterator pos) {
+  if (pos == end()) {
+    throw std::runtime_error("Iterator does not point to a valid node");
+  }
+  tree.removeNode(pos.getPosition());
   --elementsCount;
 }
-template <typename Key, typename Value>
-Value& Map<Key, Value>::operator[](const key_type& key) {
-  auto* node = tree.find(key);
-  if (node == nullptr) {
-    insert(key, Value{});
-    node = tree.find(key);
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+typename Map<Key, Value, Allocator, Backend, Compare>::node_type
+Map<Key, Value, Allocator, Backend, Compare>::extract(iterator pos) {
+  if (pos == end()) {
+    throw std::runtime_error("Iterator does not point to a valid node");
   }
-  return node->value.second;
+  --elementsCount;
+  return tree.extractNode(pos.getPosition());
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+typename Map<Key, Value, Allocator, Backend, Compare>::node_type
+Map<Key, Value, Allocator, Backend, Compare>::extract(const key_type& key) {
+  iterator found = find(key);
+  if (found == end()) {
+    return node_type();
+  }
+  return extract(found);
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+typename Map<Key, Value, Allocator, Backend, Compare>::insert_return_type
+Map<Key, Value, Allocator, Backend, Compare>::insert(node_type&& node) {
+  auto [position, inserted] = tree.insertNode(node);
+  if (inserted) {
+    ++elementsCount;
+  }
+  return insert_return_type{iterator(position), inserted, std::move(node)};
 }
-template <typename Key, typename Value>
-Value& Map<Key, Value>::at(const key_type& key) {
-  auto* node = tree.find(key);
-  if (node == nullptr) {
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+typename Map<Key, Value, Allocator, Backend, Compare>::iterator
+Map<Key, Value, Allocator, Backend, Compare>::insert(iterator hint,
+                                                     node_type&& node) {
+  auto [position, inserted] = tree.insertNodeWithHint(hint.getPosition(), node);
+  if (inserted) {
+    ++elementsCount;
+  }
+  return iterator(position);
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+Value& Map<Key, Value, Allocator, Backend, Compare>::operator[](
+    const key_type& key) {
+  return try_emplace(key).first->second;
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+Value& Map<Key, Value, Allocator, Backend, Compare>::operator[](
+    key_type&& key) {
+  return try_emplace(std::move(key)).first->second;
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename K, typename>
+Value& Map<Key, Value, Allocator, Backend, Compare>::at(const K& key) {
+  iterator found(tree.find(key));
+  if (found == end()) {
     throw std::out_of_range("Key not found");
   }
-  return node->value.second;
+  return found->second;
 }
-template <typename Key, typename Value>
-std::size_t Map<Key, Value>::size() const {
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+std::size_t Map<Key, Value, Allocator, Backend, Compare>::size() const {
   return elementsCount;
 }
-template <typename Key, typename Value>
-bool Map<Key, Value>::empty() const {
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+bool Map<Key, Value, Allocator, Backend, Compare>::empty() const {
   return elementsCount == 0;
 }
-template <typename Key, typename Value>
-bool Map<Key, Value>::contains(const key_type& key) const {
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename K, typename>
+bool Map<Key, Value, Allocator, Backend, Compare>::contains(
+    const K& key) const {
   return tree.contains(key);
 }
-template <typename Key, typename Value>
-typename Map<Key, Value>::size_type Map<Key, Value>::max_size() const {
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename K, typename>
+typename Map<Key, Value, Allocator, Backend, Compare>::iterator
+Map<Key, Value, Allocator, Backend, Compare>::lower_bound(const K& key) {
+  return iterator(tree.lowerBound(key));
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename K, typename>
+typename Map<Key, Value, Allocator, Backend, Compare>::iterator
+Map<Key, Value, Allocator, Backend, Compare>::upper_bound(const K& key) {
+  return iterator(tree.upperBound(key));
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename K, typename>
+std::pair<typename Map<Key, Value, Allocator, Backend, Compare>::iterator,
+          typename Map<Key, Value, Allocator, Backend, Compare>::iterator>
+Map<Key, Value, Allocator, Backend, Compare>::equal_range(const K& key) {
+  return std::make_pair(lower_bound(key), upper_bound(key));
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename K, typename>
+typename Map<Key, Value, Allocator, Backend, Compare>::iterator
+Map<Key, Value, Allocator, Backend, Compare>::find(const K& key) {
+  return iterator(tree.find(key));
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+typename Map<Key, Value, Allocator, Backend, Compare>::size_type
+Map<Key, Value, Allocator, Backend, Compare>::max_size() const {
   return std::numeric_limits<size_type>::max();
 }
-template <typename Key, typename Value>
-void Map<Key, Value>::swap(map& other) {
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+void Map<Key, Value, Allocator, Backend, Compare>::swap(map& other) {
   std::swap(tree, other.tree);
   std::swap(elementsCount, other.elementsCount);
 }
-template <typename Key, typename Value>
-void Map<Key, Value>::merge(map& other) {
-  for (auto it = other.begin(); it != other.end(); ++it) {
-    insert_or_assign(it->first, it->second);
-  }
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+void Map<Key, Value, Allocator, Backend, Compare>::merge(map& other) {
+  tree.mergeFrom(other.tree);
+  elementsCount = tree.size();
+  other.elementsCount = other.tree.size();
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+void Map<Key, Value, Allocator, Backend, Compare>::union_with(
+    const map& other) {
+  tree.combine(other.tree, RBTreeSetOp::kUnion);
+  elementsCount = tree.size();
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+void Map<Key, Value, Allocator, Backend, Compare>::intersect_with(
+    const map& other) {
+  tree.combine(other.tree, RBTreeSetOp::kIntersection);
+  elementsCount = tree.size();
 }
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+void Map<Key, Value, Allocator, Backend, Compare>::difference_with(
+    const map& other) {
+  tree.combine(other.tree, RBTreeSetOp::kDifference);
+  elementsCount = tree.size();
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+void Map<Key, Value, Allocator, Backend, Compare>::symmetric_difference_with(
+    const map& other) {
+  tree.combine(other.tree, RBTreeSetOp::kSymmetricDifference);
+  elementsCount = tree.size();
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+typename Map<Key, Value, Allocator, Backend, Compare>::map
+Map<Key, Value, Allocator, Backend, Compare>::split_at(const key_type& key) {
+  map right;
+  tree.split(key, right.tree);
+  elementsCount = tree.size();
+  right.elementsCount = right.tree.size();
+  return map(std::move(right));
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+void Map<Key, Value, Allocator, Backend, Compare>::concat(map& other) {
+  tree.join(other.tree);
+  elementsCount = tree.size();
+  other.elementsCount = 0;
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
 template <typename... Args>
-CustomVector<std::pair<typename Map<Key, Value>::iterator, bool>>
-Map<Key, Value>::insert_many(Args&&... args) {
+CustomVector<std::pair<
+    typename Map<Key, Value, Allocator, Backend, Compare>::iterator, bool>>
+Map<Key, Value, Allocator, Backend, Compare>::insert_many(Args&&... args) {
   CustomVector<std::pair<iterator, bool>> results;
   (void)std::initializer_list<int>{
       (results.push_back(insert(std::forward<Args>(args))), 0)...};
   return results;
 }
-template <typename Key, typename Value>
-std::pair<typename Map<Key, Value>::iterator, bool> Map<Key, Value>::insert(
-    const value_type& value) {
-  auto node = tree.find(value.first);
-  if (node != nullptr) {
-    return std::make_pair(iterator(node), false);
-  } else {
-    tree.insert(value.first, value);
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+std::pair<typename Map<Key, Value, Allocator, Backend, Compare>::iterator, bool>
+Map<Key, Value, Allocator, Backend, Compare>::insert(const value_type& value) {
+  auto [node, inserted] = tree.insert(value.first, value);
+  if (inserted) {
+    ++elementsCount;
+  }
+  return std::make_pair(iterator(node), inserted);
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+std::pair<typename Map<Key, Value, Allocator, Backend, Compare>::iterator, bool>
+Map<Key, Value, Allocator, Backend, Compare>::insert(value_type&& value) {
+  auto [node, inserted] = tree.emplace(value.first, std::move(value));
+  if (inserted) {
+    ++elementsCount;
+  }
+  return std::make_pair(iterator(node), inserted);
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+typename Map<Key, Value, Allocator, Backend, Compare>::iterator
+Map<Key, Value, Allocator, Backend, Compare>::insert(
+    iterator hint, const value_type& value) {
+  auto [node, inserted] =
+      tree.insertWithHint(hint.getPosition(), value.first, value);
+  if (inserted) {
+    ++elementsCount;
+  }
+  return iterator(node);
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+typename Map<Key, Value, Allocator, Backend, Compare>::iterator
+Map<Key, Value, Allocator, Backend, Compare>::insert(iterator hint,
+                                                     value_type&& value) {
+  auto [node, inserted] = tree.emplaceWithHint(hint.getPosition(),
+                                               value.first, std::move(value));
+  if (inserted) {
     ++elementsCount;
-    node = tree.find(value.first);
-    return std::make_pair(iterator(node), true);
   }
+  return iterator(node);
+}
+
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+typename Map<Key, Value, Allocator, Backend, Compare>::iterator
+Map<Key, Value, Allocator, Backend, Compare>::select(size_type index) {
+  return iterator(tree.select(index));
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename K, typename>
+typename Map<Key, Value, Allocator, Backend, Compare>::size_type
+Map<Key, Value, Allocator, Backend, Compare>::rank(const K& key) const {
+  return tree.rank(key);
+}
+template <typename Key, typename Value, typename Allocator, typename Backend,
+          typename Compare>
+template <typename K, typename>
+typename Map<Key, Value, Allocator, Backend, Compare>::size_type
+Map<Key, Value, Allocator, Backend, Compare>::count_in_range(
+    const K& low, const K& high) const {
+  return tree.countInRange(low, high);
 }
 
 #endif /* SRC_INCLUDE_CUSTOM_MAP_H_ */
@@ -1,55 +1,68 @@
 #ifndef SRC_INCLUDE_CUSTOM_MULTISET_H_
 #define SRC_INCLUDE_CUSTOM_MULTISET_H_
 
+#include <algorithm>
+#include <functional>
 #include <initializer_list>
 #include <iterator>
+#include <type_traits>
 #include <utility>
 
 #include "custom_vector.h"
+#include "b_tree.h"
+#include "node_pool.h"
 #include "rb_tree.h"
 
-template <typename Key>
+// Backend picks the underlying tree; RBTreeBackend<true> keeps subtree sizes
+// so that select, rank and count_in_range run in O(log n), and
+// BTreeBackend<> stores the elements in a B-tree. Compare orders the
+// elements; a transparent one lets the lookups take any type it can compare
+// with Key.
+template <typename Key, typename Allocator = NodePool<Key>,
+          typename Backend = RBTreeBackend<>,
+          typename Compare = std::less<Key>>
 class MultiSet {
  public:
   using key_type = Key;
   using value_type = Key;
   using size_type = size_t;
+  using allocator_type = Allocator;
+  using key_compare = Compare;
+  using tree_type =
+      typename Backend::template tree<key_type, value_type, Allocator, false,
+                                      RBTreeIdentityKey, Compare>;
+  // With a counting backend one node holds several equal elements, so the
+  // iterator also keeps the index of the occurrence it points to.
   class MultiSetIterator {
    public:
-    using Node = typename RBTree<Key, Key>::Node;
+    using Position = typename tree_type::Position;
     using Iter = MultiSetIterator;
 
-    MultiSetIterator() : nodePtr(nullptr) {}
-    explicit MultiSetIterator(Node* node) : nodePtr(node) {}
+    MultiSetIterator() : position(), occurrence(0) {}
+    explicit MultiSetIterator(Position pos, size_type index = 0)
+        : position(pos), occurrence(index) {}
 
     Key& operator*() const {
-      if (!nodePtr) {
+      if (position == Position()) {
         throw std::runtime_error("Iterator does not point to a valid node");
       }
-      return nodePtr->key;
+      return tree_type::valueOf(position);
     }
 
     Key* operator->() const {
-      if (!nodePtr) {
+      if (position == Position()) {
         throw std::runtime_error("Iterator does not point to a valid node");
       }
-      return &(nodePtr->key);
+      return &tree_type::valueOf(position);
     }
 
     Iter& operator++() {
-      if (nodePtr->right != nullptr) {
-        nodePtr = nodePtr->right;
-        while (nodePtr->left != nullptr) {
-          nodePtr = nodePtr->left;
-        }
-      } else {
-        Node* parent = nodePtr->parent;
-        while (parent != nullptr && nodePtr == parent->right) {
-          nodePtr = parent;
-          parent = parent->parent;
-        }
-        nodePtr = parent;
+      if (occurrence + 1 < tree_type::occurrences(position)) {
+        ++occurrence;
+        return *this;
       }
+      occurrence = 0;
+      position = tree_type::findNext(position);
       return *this;
     }
 
@@ -60,18 +73,13 @@ class MultiSet {
     }
 
     Iter& operator--() {
-      if (nodePtr->left != nullptr) {
-        nodePtr = nodePtr->left;
-        while (nodePtr->right != nullptr) {
-          nodePtr = nodePtr->right;
-        }
-      } else {
-        Node* parent = nodePtr->parent;
-        while (parent != nullptr && nodePtr == parent->left) {
-          nodePtr = parent;
-          parent = parent->parent;
-        }
-        nodePtr = parent;
+      if (occurrence > 0) {
+        --occurrence;
+        return *this;
+      }
+      position = tree_type::findPrev(position);
+      if (position != Position()) {
+        occurrence = tree_type::occurrences(position) - 1;
       }
       return *this;
     }
@@ -83,25 +91,30 @@ class MultiSet {
     }
 
     bool operator==(const Iter& other) const {
-      return nodePtr == other.nodePtr;
-    }
-    bool operator!=(const Iter& other) const {
-      return nodePtr != other.nodePtr;
+      return position == other.position && occurrence == other.occurrence;
     }
-    Node* getNodePtr() const { return nodePtr; }
+    bool operator!=(const Iter& other) const { return !(*this == other); }
+    Position getPosition() const { return position; }
 
    private:
-    Node* nodePtr;
+    Position position;
+    size_type occurrence;
   };
   using iterator = MultiSetIterator;
+  using node_type = typename tree_type::NodeHandle;
   MultiSet();
+  explicit MultiSet(const Allocator& alloc);
   explicit MultiSet(std::initializer_list<value_type> const& items);
+  // Sorted forward ranges are bulk-loaded in O(n).
+  template <typename InputIt>
+  MultiSet(InputIt first, InputIt last);
   MultiSet(const MultiSet& ms);
   MultiSet(MultiSet&& ms) noexcept;
   ~MultiSet();
 
   MultiSet& operator=(const MultiSet& ms);
-  MultiSet& operator=(MultiSet&& ms) noexcept;
+  MultiSet& operator=(MultiSet&& ms) noexcept(
+      std::is_nothrow_move_assignable<tree_type>::value);
 
   iterator begin();
   iterator end();
@@ -111,152 +124,377 @@ class MultiSet {
   size_type max_size() const;
 
   void clear();
+  // Elements are built once, inside their node; the rvalue overloads move
+  // into it.
   iterator insert(const value_type& value);
+  iterator insert(value_type&& value);
+  iterator insert(iterator hint, const value_type& value);
+  iterator insert(iterator hint, value_type&& value);
+  template <typename... Args>
+  iterator emplace(Args&&... args);
+  template <typename... Args>
+  iterator emplace_hint(iterator hint, Args&&... args);
   void erase(iterator pos);
+  // Node handles move elements between multisets without copying them (see
+  // RBTree::extractNode); extracting end() or an absent key gives an empty
+  // handle.
+  node_type extract(iterator pos);
+  node_type extract(const key_type& key);
+  iterator insert(node_type&& node);
+  iterator insert(iterator hint, node_type&& node);
   void swap(MultiSet& other);
+  // Moves every element of `other` over: nodes are relinked when the two
+  // allocators compare equal and otherwise their values move into new
+  // nodes, as with the default NodePool, which every multiset keeps one of.
   void merge(MultiSet& other);
+  // Multiset algebra, in time linear in the two sizes: a key ends up
+  // max(a, b), min(a, b), max(a - b, 0) or |a - b| times, where a and b
+  // are its counts here and in `other`.
+  void union_with(const MultiSet& other);
+  void intersect_with(const MultiSet& other);
+  void difference_with(const MultiSet& other);
+  void symmetric_difference_with(const MultiSet& other);
+  // Partitioning on the red-black backend, with the costs of Map::split_at
+  // (see RBTree::split). split_at moves the elements not less than `key`
+  // into the returned multiset, which shares this one's NodePool; concat
+  // moves in all of `other`, none of which may be less than an element
+  // here, and throws std::invalid_argument otherwise.
+  MultiSet split_at(const key_type& key);
+  void concat(MultiSet& other);
   template <typename... Args>
   CustomVector<std::pair<iterator, bool>> insert_many(Args&&... args);
 
-  size_type count(const key_type& key);
-  iterator find(const key_type& key);
-  bool contains(const key_type& key);
-  std::pair<iterator, iterator> equal_range(const key_type& key);
-  iterator lower_bound(const key_type& key);
-  iterator upper_bound(const key_type& key);
+  // Each lookup takes a key_type, or with a transparent Compare any K it
+  // can compare with Key (see RBTreeLookup).
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  size_type count(const K& key);
+  size_type count(const key_type& key) { return count<key_type>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  iterator find(const K& key);
+  iterator find(const key_type& key) { return find<key_type>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  bool contains(const K& key);
+  bool contains(const key_type& key) { return contains<key_type>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  std::pair<iterator, iterator> equal_range(const K& key);
+  std::pair<iterator, iterator> equal_range(const key_type& key) {
+    return equal_range<key_type>(key);
+  }
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  iterator lower_bound(const K& key);
+  iterator lower_bound(const key_type& key) {
+    return lower_bound<key_type>(key);
+  }
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  iterator upper_bound(const K& key);
+  iterator upper_bound(const key_type& key) {
+    return upper_bound<key_type>(key);
+  }
+
+  // Order statistics; need an order-statistics backend. select(k) is the
+  // k-th element in sorted order (end() if k >= size()), rank(key) the
+  // number of elements less than `key`, count_in_range the number in
+  // [low, high).
+  iterator select(size_type index);
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  size_type rank(const K& key) const;
+  size_type rank(const key_type& key) const { return rank<key_type>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, Key>>
+  size_type count_in_range(const K& low, const K& high) const;
+  size_type count_in_range(const key_type& low, const key_type& high) const {
+    return count_in_range<key_type>(low, high);
+  }
 
  private:
-  RBTree<key_type, value_type> tree;
+  tree_type tree;
 };
 
-template <typename Key>
-MultiSet<Key>::MultiSet() : tree() {}
-template <typename Key>
-MultiSet<Key>::MultiSet(std::initializer_list<value_type> const& items)
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+MultiSet<Key, Allocator, Backend, Compare>::MultiSet() : tree() {}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+MultiSet<Key, Allocator, Backend, Compare>::MultiSet(const Allocator& alloc)
+    : tree(alloc) {}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+MultiSet<Key, Allocator, Backend, Compare>::MultiSet(
+    std::initializer_list<value_type> const& items)
     : tree() {
   for (const auto& item : items) {
-    tree.insert(item, item);
+    tree.insertWithHint(typename tree_type::Position(), item, item);
+  }
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+template <typename InputIt>
+MultiSet<Key, Allocator, Backend, Compare>::MultiSet(InputIt first,
+                                                    InputIt last)
+    : tree() {
+  using Category = typename std::iterator_traits<InputIt>::iterator_category;
+  if constexpr (std::is_base_of<std::forward_iterator_tag, Category>::value) {
+    if (std::is_sorted(first, last, tree.keyComp())) {
+      tree.buildFromSorted(first, last, [](const auto& item) -> const auto& {
+        return item;
+      });
+      return;
+    }
+  }
+  for (; first != last; ++first) {
+    insert(end(), *first);
   }
 }
-template <typename Key>
-MultiSet<Key>::MultiSet(const MultiSet& ms) : tree(ms.tree) {}
-template <typename Key>
-MultiSet<Key>::MultiSet(MultiSet&& ms) noexcept : tree(std::move(ms.tree)) {}
-template <typename Key>
-MultiSet<Key>::~MultiSet() {}
-template <typename Key>
-MultiSet<Key>& MultiSet<Key>::operator=(const MultiSet<Key>& ms) {
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+MultiSet<Key, Allocator, Backend, Compare>::MultiSet(const MultiSet& ms)
+    : tree(ms.tree) {}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+MultiSet<Key, Allocator, Backend, Compare>::MultiSet(MultiSet&& ms) noexcept
+    : tree(std::move(ms.tree)) {}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+MultiSet<Key, Allocator, Backend, Compare>::~MultiSet() {}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+MultiSet<Key, Allocator, Backend, Compare>&
+MultiSet<Key, Allocator, Backend, Compare>::operator=(const MultiSet& ms) {
   if (this != &ms) {
     tree = ms.tree;
   }
   return *this;
 }
-template <typename Key>
-MultiSet<Key>& MultiSet<Key>::operator=(MultiSet<Key>&& ms) noexcept {
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+MultiSet<Key, Allocator, Backend, Compare>&
+MultiSet<Key, Allocator, Backend, Compare>::operator=(MultiSet&& ms) noexcept(
+    std::is_nothrow_move_assignable<tree_type>::value) {
   if (this != &ms) {
     tree = std::move(ms.tree);
   }
   return *this;
 }
-template <typename Key>
-typename MultiSet<Key>::iterator MultiSet<Key>::begin() {
-  auto node = tree.minimum();
-  return iterator(node);
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+typename MultiSet<Key, Allocator, Backend, Compare>::iterator
+MultiSet<Key, Allocator, Backend, Compare>::begin() {
+  return iterator(tree.minimum());
 }
-template <typename Key>
-typename MultiSet<Key>::iterator MultiSet<Key>::end() {
-  return iterator(nullptr);
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+typename MultiSet<Key, Allocator, Backend, Compare>::iterator
+MultiSet<Key, Allocator, Backend, Compare>::end() {
+  return iterator();
 }
-template <typename Key>
-bool MultiSet<Key>::empty() const {
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+bool MultiSet<Key, Allocator, Backend, Compare>::empty() const {
   return tree.size() == 0;
 }
-template <typename Key>
-typename MultiSet<Key>::size_type MultiSet<Key>::size() const {
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+typename MultiSet<Key, Allocator, Backend, Compare>::size_type
+MultiSet<Key, Allocator, Backend, Compare>::size() const {
   return tree.size();
 }
-template <typename Key>
-typename MultiSet<Key>::size_type MultiSet<Key>::max_size() const {
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+typename MultiSet<Key, Allocator, Backend, Compare>::size_type
+MultiSet<Key, Allocator, Backend, Compare>::max_size() const {
   return std::numeric_limits<size_type>::max();
 }
-template <typename Key>
-void MultiSet<Key>::clear() {
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+void MultiSet<Key, Allocator, Backend, Compare>::clear() {
   tree.clear();
 }
-template <typename Key>
-typename MultiSet<Key>::iterator MultiSet<Key>::insert(
-    const value_type& value) {
-  tree.insert(value, value);
-  auto node = tree.find(value);
-  return iterator(node);
-}
-template <typename Key>
-void MultiSet<Key>::erase(iterator pos) {
-  if (pos.getNodePtr()) {
-    tree.remove(pos.getNodePtr()->key);
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+typename MultiSet<Key, Allocator, Backend, Compare>::iterator
+MultiSet<Key, Allocator, Backend, Compare>::insert(const value_type& value) {
+  auto position = tree.insert(value, value).first;
+  return iterator(position, tree_type::occurrences(position) - 1);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+typename MultiSet<Key, Allocator, Backend, Compare>::iterator
+MultiSet<Key, Allocator, Backend, Compare>::insert(
+    iterator hint, const value_type& value) {
+  auto position =
+      tree.insertWithHint(hint.getPosition(), value, value).first;
+  return iterator(position, tree_type::occurrences(position) - 1);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+typename MultiSet<Key, Allocator, Backend, Compare>::iterator
+MultiSet<Key, Allocator, Backend, Compare>::insert(value_type&& value) {
+  auto position = tree.emplace(value, std::move(value)).first;
+  return iterator(position, tree_type::occurrences(position) - 1);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+typename MultiSet<Key, Allocator, Backend, Compare>::iterator
+MultiSet<Key, Allocator, Backend, Compare>::insert(iterator hint,
+                                                   value_type&& value) {
+  auto position =
+      tree.emplaceWithHint(hint.getPosition(), value, std::move(value)).first;
+  return iterator(position, tree_type::occurrences(position) - 1);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+template <typename... Args>
+typename MultiSet<Key, Allocator, Backend, Compare>::iterator
+MultiSet<Key, Allocator, Backend, Compare>::emplace(Args&&... args) {
+  auto position = tree.emplaceValue(std::forward<Args>(args)...).first;
+  return iterator(position, tree_type::occurrences(position) - 1);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+template <typename... Args>
+typename MultiSet<Key, Allocator, Backend, Compare>::iterator
+MultiSet<Key, Allocator, Backend, Compare>::emplace_hint(iterator hint,
+                                                         Args&&... args) {
+  auto position =
+      tree.emplaceValueWithHint(hint.getPosition(), std::forward<Args>(args)...)
+          .first;
+  return iterator(position, tree_type::occurrences(position) - 1);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+void MultiSet<Key, Allocator, Backend, Compare>::erase(iterator pos) {
+  if (pos != end()) {
+    tree.removeNode(pos.getPosition());
   }
 }
-template <typename Key>
-void MultiSet<Key>::swap(MultiSet& other) {
-  std::swap(tree, other.tree);
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+typename MultiSet<Key, Allocator, Backend, Compare>::node_type
+MultiSet<Key, Allocator, Backend, Compare>::extract(iterator pos) {
+  if (pos == end()) {
+    return node_type();
+  }
+  return tree.extractNode(pos.getPosition());
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+typename MultiSet<Key, Allocator, Backend, Compare>::node_type
+MultiSet<Key, Allocator, Backend, Compare>::extract(const key_type& key) {
+  return extract(find(key));
 }
-template <typename Key>
-void MultiSet<Key>::merge(MultiSet& other) {
-  for (auto it = other.begin(); it != other.end(); ++it) {
-    insert(*it);
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+typename MultiSet<Key, Allocator, Backend, Compare>::iterator
+MultiSet<Key, Allocator, Backend, Compare>::insert(node_type&& node) {
+  if (node.empty()) {
+    return end();
   }
-  other.clear();
+  auto position = tree.insertNode(node).first;
+  return iterator(position, tree_type::occurrences(position) - 1);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+typename MultiSet<Key, Allocator, Backend, Compare>::iterator
+MultiSet<Key, Allocator, Backend, Compare>::insert(iterator hint,
+                                                   node_type&& node) {
+  if (node.empty()) {
+    return end();
+  }
+  auto position = tree.insertNodeWithHint(hint.getPosition(), node).first;
+  return iterator(position, tree_type::occurrences(position) - 1);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+void MultiSet<Key, Allocator, Backend, Compare>::swap(MultiSet& other) {
+  std::swap(tree, other.tree);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+void MultiSet<Key, Allocator, Backend, Compare>::merge(MultiSet& other) {
+  tree.mergeFrom(other.tree);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+void MultiSet<Key, Allocator, Backend, Compare>::union_with(
+    const MultiSet& other) {
+  tree.combine(other.tree, RBTreeSetOp::kUnion);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+void MultiSet<Key, Allocator, Backend, Compare>::intersect_with(
+    const MultiSet& other) {
+  tree.combine(other.tree, RBTreeSetOp::kIntersection);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+void MultiSet<Key, Allocator, Backend, Compare>::difference_with(
+    const MultiSet& other) {
+  tree.combine(other.tree, RBTreeSetOp::kDifference);
 }
-template <typename Key>
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+void MultiSet<Key, Allocator, Backend, Compare>::symmetric_difference_with(
+    const MultiSet& other) {
+  tree.combine(other.tree, RBTreeSetOp::kSymmetricDifference);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+MultiSet<Key, Allocator, Backend, Compare>
+MultiSet<Key, Allocator, Backend, Compare>::split_at(const key_type& key) {
+  MultiSet right;
+  tree.split(key, right.tree);
+  return right;
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+void MultiSet<Key, Allocator, Backend, Compare>::concat(MultiSet& other) {
+  tree.join(other.tree);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
 template <typename... Args>
-CustomVector<std::pair<typename MultiSet<Key>::iterator, bool>>
-MultiSet<Key>::insert_many(Args&&... args) {
+CustomVector<std::pair<
+    typename MultiSet<Key, Allocator, Backend, Compare>::iterator, bool>>
+MultiSet<Key, Allocator, Backend, Compare>::insert_many(Args&&... args) {
   CustomVector<std::pair<iterator, bool>> result;
   (void)std::initializer_list<int>{
       (result.push_back(insert(std::forward<Args>(args))), 0)...};
   return result;
 }
-template <typename Key>
-typename MultiSet<Key>::size_type MultiSet<Key>::count(const key_type& key) {
-  typename RBTree<Key, Key>::Node* found = tree.find(key);
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+template <typename K, typename>
+typename MultiSet<Key, Allocator, Backend, Compare>::size_type
+MultiSet<Key, Allocator, Backend, Compare>::count(const K& key) {
+  typename tree_type::Position found = tree.lowerBound(key);
+  Compare compare = tree.keyComp();
   size_type cnt = 0;
-  while (found != nullptr && found->key == key) {
-    ++cnt;
-    found = tree.findNext(found);
+  while (found != typename tree_type::Position() &&
+         !compare(key, tree_type::valueOf(found))) {
+    cnt += tree_type::occurrences(found);
+    found = tree_type::findNext(found);
   }
   return cnt;
 }
-template <typename Key>
-typename MultiSet<Key>::iterator MultiSet<Key>::find(const key_type& key) {
-  typename RBTree<Key, Key>::Node* found = tree.find(key);
-  return iterator(found);
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+template <typename K, typename>
+typename MultiSet<Key, Allocator, Backend, Compare>::iterator
+MultiSet<Key, Allocator, Backend, Compare>::find(const K& key) {
+  iterator found(tree.lowerBound(key));
+  if (found == end() || tree.keyComp()(key, *found)) {
+    return end();
+  }
+  return found;
 }
-template <typename Key>
-bool MultiSet<Key>::contains(const key_type& key) {
-  return tree.find(key) != nullptr;
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+template <typename K, typename>
+bool MultiSet<Key, Allocator, Backend, Compare>::contains(const K& key) {
+  return find(key) != end();
 }
-template <typename Key>
-std::pair<typename MultiSet<Key>::iterator, typename MultiSet<Key>::iterator>
-MultiSet<Key>::equal_range(const key_type& key) {
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+template <typename K, typename>
+std::pair<typename MultiSet<Key, Allocator, Backend, Compare>::iterator,
+          typename MultiSet<Key, Allocator, Backend, Compare>::iterator>
+MultiSet<Key, Allocator, Backend, Compare>::equal_range(const K& key) {
   return std::make_pair(lower_bound(key), upper_bound(key));
 }
-template <typename Key>
-typename MultiSet<Key>::iterator MultiSet<Key>::lower_bound(
-    const key_type& key) {
-  typename RBTree<Key, Key>::Node* current = tree.minimum();
-  while (current != nullptr && current->key < key) {
-    current = tree.findNext(current);
-  }
-  return iterator(current);
-}
-template <typename Key>
-typename MultiSet<Key>::iterator MultiSet<Key>::upper_bound(
-    const key_type& key) {
-  typename RBTree<Key, Key>::Node* current = tree.minimum();
-  while (current != nullptr && current->key <= key) {
-    current = tree.findNext(current);
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+template <typename K, typename>
+typename MultiSet<Key, Allocator, Backend, Compare>::iterator
+MultiSet<Key, Allocator, Backend, Compare>::lower_bound(const K& key) {
+  return iterator(tree.lowerBound(key));
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+template <typename K, typename>
+typename MultiSet<Key, Allocator, Backend, Compare>::iterator
+MultiSet<Key, Allocator, Backend, Compare>::upper_bound(const K& key) {
+  return iterator(tree.upperBound(key));
+}
+
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+typename MultiSet<Key, Allocator, Backend, Compare>::iterator
+MultiSet<Key, Allocator, Backend, Compare>::select(size_type index) {
+  typename tree_type::Position node = tree.select(index);
+  if (node == nullptr || tree_type::occurrences(node) == 1) {
+    return iterator(node);
   }
-  return iterator(current);
+  return iterator(node, index - tree.rank(node->value));
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+template <typename K, typename>
+typename MultiSet<Key, Allocator, Backend, Compare>::size_type
+MultiSet<Key, Allocator, Backend, Compare>::rank(const K& key) const {
+  return tree.rank(key);
+}
+template <typename Key, typename Allocator, typename Backend, typename Compare>
+template <typename K, typename>
+typename MultiSet<Key, Allocator, Backend, Compare>::size_type
+MultiSet<Key, Allocator, Backend, Compare>::count_in_range(
+    const K& low, const K& high) const {
+  return tree.countInRange(low, high);
 }
 
 #endif /* SRC_INCLUDE_CUSTOM_MULTISET_H_ */
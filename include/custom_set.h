@@ -1,13 +1,33 @@
 #ifndef INCLUDE_CUSTOM_SET_H_
 #define INCLUDE_CUSTOM_SET_H_
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <initializer_list>
+#include <iterator>
 #include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 
-template <class T>
+// Sorted flat set: the elements live in one array in ascending order, so
+// lookups are binary searches and iteration is a linear walk. Inserting or
+// erasing a single element shifts the tail of the array; the range insert
+// appends everything first and then sorts and merges in a single pass.
+//
+// freeze() adds a read-optimized copy of the elements in Eytzinger (BFS)
+// order: the root first, then each level of the implicit search tree. A
+// search then walks down that array with prefetches several levels ahead,
+// which keeps it fast far beyond the last-level cache. Any change to the set
+// drops the copy again.
+//
+// Both arrays, and the index mapping one onto the other, come from
+// Allocator through std::allocator_traits. Every slot of the sorted array
+// up to its capacity holds a T, so T must be default constructible.
+template <class T, class Allocator = std::allocator<T>>
 class CustomSet {
  public:
   class CustomSetIterator {
@@ -61,6 +81,7 @@ class CustomSet {
     pointer ptr_;
   };
   using value_type = T;
+  using allocator_type = Allocator;
   using size_type = std::size_t;
   using reference = T&;
   using const_referenece = const T&;
@@ -68,13 +89,16 @@ class CustomSet {
   using set = CustomSet;
 
   CustomSet();
+  explicit CustomSet(const Allocator& alloc);
   explicit CustomSet(std::initializer_list<T> initList);
+  template <typename InputIt>
+  CustomSet(InputIt first, InputIt last);
   explicit CustomSet(const set& other);
   explicit CustomSet(set&& other);
   ~CustomSet();
 
-  CustomSet<T>& operator=(const set& other);
-  CustomSet<T>& operator=(set&& other);
+  CustomSet<T, Allocator>& operator=(const set& other);
+  CustomSet<T, Allocator>& operator=(set&& other);
 
   iterator begin();
   iterator end();
@@ -88,287 +112,723 @@ class CustomSet {
   size_type size() const;
   size_type max_size() const;
   bool empty() const;
-  bool contains(const value_type* value);
+  bool contains(const T& value) const;
+  void reserve(size_type capacity);
 
   std::pair<iterator, bool> insert(const value_type& value);
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last);
   void erase(const T& value);
   void erase(iterator pos);
   void clear();
 
   iterator find(const T& value);
-  size_type count(const T& value);
+  size_type count(const T& value) const;
 
   template <typename... Args>
   void emplace(Args&&... args);
 
   void swap(set& other);
+  allocator_type get_allocator() const;
   void merge(set const& other);
+  // Set algebra in one pass over both sorted arrays. Intersection and
+  // difference compact this array in place, skipping through `other` by
+  // binary search when it is much the larger; union and symmetric
+  // difference merge into a new array.
+  void union_with(const set& other);
+  void intersect_with(const set& other);
+  void difference_with(const set& other);
+  void symmetric_difference_with(const set& other);
 
-  std::function<bool(const T&, const T&)> key_comp();
-  std::function<bool(const T&, const T&)> value_comp();
+  std::function<bool(const T&, const T&)> key_comp() const;
+  std::function<bool(const T&, const T&)> value_comp() const;
+  iterator lower_bound(const T& value);
   iterator upper_bound(const T& value);
+  std::pair<iterator, iterator> equal_range(const T& value);
+  // freeze builds the Eytzinger copy from the current contents, thaw drops
+  // it. Lookups give the same results either way.
+  void freeze();
+  void thaw();
+  bool frozen() const;
+  // The hint is the element the new one should precede; a correct hint
+  // skips the binary search.
   template <typename... Args>
   iterator emplace_hint(iterator position, Args&&... args);
 
  private:
+  static constexpr std::size_t kCacheLine = 64;
+  // The unit the Eytzinger copy is allocated in, so that any allocator
+  // hands it out aligned to a cache line.
+  struct alignas(kCacheLine) CacheLine {
+    unsigned char bytes[kCacheLine];
+  };
+  using Traits = std::allocator_traits<Allocator>;
+  using LineAllocator = typename Traits::template rebind_alloc<CacheLine>;
+  using LineTraits = std::allocator_traits<LineAllocator>;
+  using IndexAllocator = typename Traits::template rebind_alloc<std::size_t>;
+  using IndexTraits = std::allocator_traits<IndexAllocator>;
+  // Eytzinger slots per cache line: the descendants of slot k that are that
+  // many levels down share the line starting at slot k * kPrefetchStride.
+  static constexpr std::size_t kPrefetchStride =
+      sizeof(T) < kCacheLine ? kCacheLine / sizeof(T) : 1;
+
   std::size_t size_;
   std::size_t capacity_;
   T* array_;
+  // One-based Eytzinger copy and, per slot, the element's index in array_.
+  T* eytzinger_;
+  std::size_t* eytzingerIndex_;
+  Allocator allocator;
 
+  // An array of count value-initialized elements, and its release.
+  T* newArray(std::size_t count);
+  void deleteArray(T* array, std::size_t count);
+  void adopt(set& other);
+  static std::size_t eytzingerLines(std::size_t size);
   void resize();
+  template <bool Upper>
+  std::size_t eytzingerSlot(const T& value) const;
+  template <bool Upper>
+  std::size_t searchIndex(const T& value) const;
+  std::size_t lowerIndex(const T& value) const;
+  void layoutEytzinger(std::size_t slot, std::size_t& next);
+  iterator insertAt(std::size_t index, T&& value);
+  void mergeTail(std::size_t sortedSize);
+  void stableSort(T* first, T* last);
+  void combine(const set& other, bool keepOwn, bool keepShared,
+               bool keepOthers);
 };
 
-template <typename T>
-CustomSet<T>::CustomSet() : size_(0), capacity_(0), array_(nullptr) {}
-template <typename T>
-CustomSet<T>::~CustomSet() {
-  delete[] array_;
-}
-template <typename T>
-CustomSet<T>::CustomSet(const CustomSet<T>& other)
-    : size_(other.size_),
-      capacity_(other.capacity_),
-      array_(new T[other.capacity_]) {
+template <typename T, typename Allocator>
+CustomSet<T, Allocator>::CustomSet() : CustomSet(Allocator()) {}
+template <typename T, typename Allocator>
+CustomSet<T, Allocator>::CustomSet(const Allocator& alloc)
+    : size_(0),
+      capacity_(0),
+      array_(nullptr),
+      eytzinger_(nullptr),
+      eytzingerIndex_(nullptr),
+      allocator(alloc) {}
+template <typename T, typename Allocator>
+CustomSet<T, Allocator>::~CustomSet() {
+  thaw();
+  deleteArray(array_, capacity_);
+}
+template <typename T, typename Allocator>
+CustomSet<T, Allocator>::CustomSet(const CustomSet& other)
+    : CustomSet(Traits::select_on_container_copy_construction(
+          other.allocator)) {
+  array_ = newArray(other.capacity_);
+  capacity_ = other.capacity_;
   std::copy(other.array_, other.array_ + other.size_, array_);
-}
-template <typename T>
-CustomSet<T>::CustomSet(set&& other) {
-  if (array_ == nullptr) {
-    clear();
+  size_ = other.size_;
+  if (other.frozen()) {
+    freeze();
   }
+}
+template <typename T, typename Allocator>
+CustomSet<T, Allocator>::CustomSet(set&& other)
+    : CustomSet(std::move(other.allocator)) {
+  adopt(other);
+}
+// Moves other's arrays over, frozen copy included. The allocators must be
+// equal.
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::adopt(set& other) {
   size_ = other.size_;
   capacity_ = other.capacity_;
   array_ = other.array_;
+  eytzinger_ = other.eytzinger_;
+  eytzingerIndex_ = other.eytzingerIndex_;
 
   other.size_ = 0;
   other.capacity_ = 0;
   other.array_ = nullptr;
+  other.eytzinger_ = nullptr;
+  other.eytzingerIndex_ = nullptr;
 }
-template <typename T>
-CustomSet<T>& CustomSet<T>::operator=(set&& other) {
+// With an unequal allocator that does not propagate, the arrays cannot
+// change hands and the elements are copied instead.
+template <typename T, typename Allocator>
+CustomSet<T, Allocator>& CustomSet<T, Allocator>::operator=(set&& other) {
   if (this != &other) {
+    if constexpr (!Traits::propagate_on_container_move_assignment::value) {
+      if (allocator != other.allocator) {
+        *this = static_cast<const set&>(other);
+        other.clear();
+        return *this;
+      }
+    }
     clear();
-
-    size_ = other.size_;
-    capacity_ = other.capacity_;
-    array_ = other.array_;
-
-    other.size_ = 0;
-    other.capacity_ = 0;
-    other.array_ = nullptr;
+    if constexpr (Traits::propagate_on_container_move_assignment::value) {
+      allocator = std::move(other.allocator);
+    }
+    adopt(other);
   }
   return *this;
 }
-template <typename T>
-CustomSet<T>& CustomSet<T>::operator=(const CustomSet<T>& other) {
+template <typename T, typename Allocator>
+CustomSet<T, Allocator>& CustomSet<T, Allocator>::operator=(
+    const CustomSet& other) {
   if (this != &other) {
-    T* newArray = new T[other.capacity_];
+    thaw();
+    if constexpr (Traits::propagate_on_container_copy_assignment::value) {
+      if (allocator != other.allocator) clear();
+      allocator = other.allocator;
+    }
+    T* copy = newArray(other.capacity_);
     for (std::size_t i = 0; i < other.size_; i++) {
-      newArray[i] = other.array_[i];
+      copy[i] = other.array_[i];
     }
-    delete[] array_;
-    array_ = newArray;
+    deleteArray(array_, capacity_);
+    array_ = copy;
     size_ = other.size_;
     capacity_ = other.capacity_;
+    if (other.frozen()) {
+      freeze();
+    }
   }
   return *this;
 }
-template <typename T>
-void CustomSet<T>::resize() {
-  T* ptr = new T[capacity_ == 0 ? 1 : capacity_ * 2];
+template <typename T, typename Allocator>
+T* CustomSet<T, Allocator>::newArray(std::size_t count) {
+  if (count == 0) return nullptr;
+  T* array = Traits::allocate(allocator, count);
+  std::size_t built = 0;
+  try {
+    for (; built < count; ++built) Traits::construct(allocator, array + built);
+  } catch (...) {
+    deleteArray(array, built);
+    throw;
+  }
+  return array;
+}
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::deleteArray(T* array, std::size_t count) {
+  if (array == nullptr) return;
+  for (std::size_t i = 0; i < count; ++i) Traits::destroy(allocator, array + i);
+  Traits::deallocate(allocator, array, count);
+}
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::resize() {
+  T* ptr = newArray(capacity_ == 0 ? 1 : capacity_ * 2);
   for (size_t i = 0; i < size_; i++) {
-    ptr[i] = array_[i];
+    ptr[i] = std::move(array_[i]);
   }
-  delete[] array_;
+  deleteArray(array_, capacity_);
   array_ = ptr;
   capacity_ = capacity_ == 0 ? 1 : capacity_ * 2;
 }
-template <typename T>
-std::pair<typename CustomSet<T>::iterator, bool> CustomSet<T>::insert(
-    const value_type& value) {
-  for (std::size_t i = 0; i < size_; ++i) {
-    if (array_[i] == value) {
-      return std::make_pair(iterator(array_ + i), false);
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::reserve(size_type capacity) {
+  if (capacity <= capacity_) {
+    return;
+  }
+  T* ptr = newArray(capacity);
+  std::move(array_, array_ + size_, ptr);
+  deleteArray(array_, capacity_);
+  array_ = ptr;
+  capacity_ = capacity;
+}
+// Eytzinger slot of the first element not less than `value` (with Upper,
+// greater than it), or 0 if there is none. Each step prefetches the cache
+// line holding the descendants a few levels below.
+template <typename T, typename Allocator>
+template <bool Upper>
+std::size_t CustomSet<T, Allocator>::eytzingerSlot(const T& value) const {
+  std::size_t slot = 1;
+  while (slot <= size_) {
+#if defined(__GNUC__)
+    __builtin_prefetch(reinterpret_cast<const void*>(
+        reinterpret_cast<std::uintptr_t>(eytzinger_) +
+        slot * kPrefetchStride * sizeof(T)));
+#endif
+    const T& element = eytzinger_[slot];
+    slot = 2 * slot + (Upper ? !(value < element) : element < value);
+  }
+  // Undo the right turns taken after the last left turn; that left turn
+  // was at the answer.
+#if defined(__GNUC__)
+  return slot >> (__builtin_ctzll(~static_cast<unsigned long long>(slot)) + 1);
+#else
+  while (slot & 1) slot >>= 1;
+  return slot >> 1;
+#endif
+}
+// Index of the first element not less than `value` (with Upper, greater
+// than it). Both layouts pick the next step with a conditional move rather
+// than a branch; the sorted one prefetches both candidates for the next
+// midpoint.
+template <typename T, typename Allocator>
+template <bool Upper>
+std::size_t CustomSet<T, Allocator>::searchIndex(const T& value) const {
+  auto before = [&value](const T& element) {
+    return Upper ? !(value < element) : element < value;
+  };
+  if (eytzinger_ != nullptr) {
+    std::size_t slot = eytzingerSlot<Upper>(value);
+    return slot == 0 ? size_ : eytzingerIndex_[slot];
+  }
+  if (size_ == 0) return 0;
+  const T* base = array_;
+  std::size_t length = size_;
+  while (length > 1) {
+    std::size_t half = length / 2;
+#if defined(__GNUC__)
+    // Both possible next midpoints, so the load is in flight either way.
+    __builtin_prefetch(base + half / 2);
+    __builtin_prefetch(base + half + half / 2);
+#endif
+    base = before(base[half]) ? base + half : base;
+    length -= half;
+  }
+  return (base - array_) + (before(*base) ? 1 : 0);
+}
+template <typename T, typename Allocator>
+std::size_t CustomSet<T, Allocator>::lowerIndex(const T& value) const {
+  return searchIndex<false>(value);
+}
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::layoutEytzinger(std::size_t slot,
+                                              std::size_t& next) {
+  if (slot > size_) {
+    return;
+  }
+  layoutEytzinger(2 * slot, next);
+  eytzingerIndex_[slot] = next++;
+  layoutEytzinger(2 * slot + 1, next);
+}
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::freeze() {
+  thaw();
+  if (size_ == 0) {
+    return;
+  }
+  IndexAllocator indexAllocator(allocator);
+  eytzingerIndex_ = IndexTraits::allocate(indexAllocator, size_ + 1);
+  std::size_t next = 0;
+  layoutEytzinger(1, next);
+  // Slots are numbered from 1, and slot 0 is left unused. The base is
+  // cache-line aligned, so slots k * kPrefetchStride up to
+  // k * kPrefetchStride + kPrefetchStride - 1 share one line; the prefetch
+  // in eytzingerSlot fetches such a line with one address.
+  LineAllocator lineAllocator(allocator);
+  std::size_t lines = eytzingerLines(size_);
+  CacheLine* raw = LineTraits::allocate(lineAllocator, lines);
+  T* slots = reinterpret_cast<T*>(raw);
+  std::size_t built = 1;
+  try {
+    for (; built <= size_; ++built) {
+      Traits::construct(allocator, slots + built,
+                        array_[eytzingerIndex_[built]]);
     }
+  } catch (...) {
+    for (std::size_t i = 1; i < built; ++i) {
+      Traits::destroy(allocator, slots + i);
+    }
+    LineTraits::deallocate(lineAllocator, raw, lines);
+    IndexTraits::deallocate(indexAllocator, eytzingerIndex_, size_ + 1);
+    eytzingerIndex_ = nullptr;
+    throw;
+  }
+  eytzinger_ = slots;
+}
+template <typename T, typename Allocator>
+std::size_t CustomSet<T, Allocator>::eytzingerLines(std::size_t size) {
+  return ((size + 1) * sizeof(T) + kCacheLine - 1) / kCacheLine;
+}
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::thaw() {
+  if (eytzinger_ == nullptr) {
+    return;
   }
+  for (std::size_t i = 1; i <= size_; ++i) {
+    Traits::destroy(allocator, eytzinger_ + i);
+  }
+  LineAllocator lineAllocator(allocator);
+  LineTraits::deallocate(lineAllocator,
+                         reinterpret_cast<CacheLine*>(eytzinger_),
+                         eytzingerLines(size_));
+  IndexAllocator indexAllocator(allocator);
+  IndexTraits::deallocate(indexAllocator, eytzingerIndex_, size_ + 1);
+  eytzinger_ = nullptr;
+  eytzingerIndex_ = nullptr;
+}
+template <typename T, typename Allocator>
+bool CustomSet<T, Allocator>::frozen() const {
+  return eytzinger_ != nullptr;
+}
+template <typename T, typename Allocator>
+typename CustomSet<T, Allocator>::iterator
+CustomSet<T, Allocator>::insertAt(std::size_t index, T&& value) {
+  thaw();
   if (size_ == capacity_) {
     resize();
   }
-  array_[size_] = value;
+  std::move_backward(array_ + index, array_ + size_, array_ + size_ + 1);
+  array_[index] = std::move(value);
   ++size_;
-  return std::make_pair(iterator(array_ + size_ - 1), true);
+  return iterator(array_ + index);
 }
-template <typename T>
-void CustomSet<T>::erase(CustomSet::iterator pos) {
-  if (pos < begin() || pos >= end()) {
+// Sorts the elements appended after the first `sortedSize` ones and merges
+// them into that sorted prefix. Of several equal elements the one already
+// in the set, or else the first appended, is kept.
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::mergeTail(std::size_t sortedSize) {
+  T* tail = array_ + sortedSize;
+  T* tailEnd = array_ + size_;
+  if (!std::is_sorted(tail, tailEnd)) {
+    stableSort(tail, tailEnd);
+  }
+  auto equal = [](const T& lhs, const T& rhs) {
+    return !(lhs < rhs) && !(rhs < lhs);
+  };
+  tailEnd = std::unique(tail, tailEnd, equal);
+  if (sortedSize == 0 || tail == tailEnd || tail[-1] < *tail) {
+    size_ = tailEnd - array_;
     return;
   }
-  for (iterator it = pos; it != end() - 1; ++it) {
-    *it = std::move(*(it + 1));
+  T* merged = newArray(capacity_);
+  std::size_t count = 0;
+  T* head = array_;
+  T* headEnd = array_ + sortedSize;
+  while (head != headEnd && tail != tailEnd) {
+    if (*tail < *head) {
+      merged[count++] = std::move(*tail++);
+    } else {
+      if (!(*head < *tail)) ++tail;
+      merged[count++] = std::move(*head++);
+    }
   }
-  --size_;
+  while (head != headEnd) merged[count++] = std::move(*head++);
+  while (tail != tailEnd) merged[count++] = std::move(*tail++);
+  deleteArray(array_, capacity_);
+  array_ = merged;
+  size_ = count;
+}
+// std::stable_sort takes its scratch space from the global heap; this
+// bottom-up merge sort takes it from the allocator instead. Runs of
+// kInsertionRun elements are insertion-sorted first, then merged pairwise
+// back and forth between the range and the scratch array. Equal integers,
+// enums and pointers are identical, so those skip stability and the
+// scratch array and go to std::sort.
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::stableSort(T* first, T* last) {
+  if constexpr (std::is_integral<T>::value || std::is_enum<T>::value ||
+                std::is_pointer<T>::value) {
+    std::sort(first, last);
+    return;
+  }
+  constexpr std::size_t kInsertionRun = 16;
+  std::size_t count = last - first;
+  for (std::size_t run = 0; run < count; run += kInsertionRun) {
+    T* runEnd = first + std::min(count, run + kInsertionRun);
+    for (T* it = first + run + 1; it < runEnd; ++it) {
+      std::rotate(std::upper_bound(first + run, it, *it), it, it + 1);
+    }
+  }
+  if (count <= kInsertionRun) return;
+  T* scratch = newArray(count);
+  try {
+    T* from = first;
+    T* to = scratch;
+    for (std::size_t width = kInsertionRun; width < count; width *= 2) {
+      for (std::size_t lo = 0; lo < count; lo += 2 * width) {
+        std::size_t mid = std::min(count, lo + width);
+        std::size_t hi = std::min(count, lo + 2 * width);
+        std::merge(std::make_move_iterator(from + lo),
+                   std::make_move_iterator(from + mid),
+                   std::make_move_iterator(from + mid),
+                   std::make_move_iterator(from + hi), to + lo);
+      }
+      std::swap(from, to);
+    }
+    if (from != first) std::move(from, from + count, first);
+  } catch (...) {
+    deleteArray(scratch, count);
+    throw;
+  }
+  deleteArray(scratch, count);
+}
+template <typename T, typename Allocator>
+std::pair<typename CustomSet<T, Allocator>::iterator, bool>
+CustomSet<T, Allocator>::insert(const value_type& value) {
+  std::size_t index = lowerIndex(value);
+  if (index < size_ && !(value < array_[index])) {
+    return std::make_pair(iterator(array_ + index), false);
+  }
+  return std::make_pair(insertAt(index, T(value)), true);
+}
+template <typename T, typename Allocator>
+template <typename InputIt>
+void CustomSet<T, Allocator>::insert(InputIt first, InputIt last) {
+  thaw();
+  std::size_t sortedSize = size_;
+  for (; first != last; ++first) {
+    if (size_ == capacity_) {
+      resize();
+    }
+    array_[size_++] = *first;
+  }
+  mergeTail(sortedSize);
 }
-template <typename T>
-CustomSet<T>::CustomSet(std::initializer_list<T> initList)
-    : size_(0), capacity_(initList.size()), array_(new T[capacity_]) {
-  for (const T& value : initList) {
-    insert(value);
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::erase(CustomSet::iterator pos) {
+  if (pos - begin() < 0 || pos - end() >= 0) {
+    return;
   }
+  thaw();
+  T* target = &*pos;
+  std::move(target + 1, array_ + size_, target);
+  --size_;
 }
-template <typename T>
-typename CustomSet<T>::iterator CustomSet<T>::begin() {
+template <typename T, typename Allocator>
+CustomSet<T, Allocator>::CustomSet(std::initializer_list<T> initList)
+    : size_(0),
+      capacity_(initList.size()),
+      array_(nullptr),
+      eytzinger_(nullptr),
+      eytzingerIndex_(nullptr),
+      allocator() {
+  array_ = newArray(capacity_);
+  insert(initList.begin(), initList.end());
+}
+template <typename T, typename Allocator>
+template <typename InputIt>
+CustomSet<T, Allocator>::CustomSet(InputIt first, InputIt last) : CustomSet() {
+  insert(first, last);
+}
+template <typename T, typename Allocator>
+typename CustomSet<T, Allocator>::iterator CustomSet<T, Allocator>::begin() {
   return iterator(array_);
 }
-template <typename T>
-typename CustomSet<T>::iterator CustomSet<T>::end() {
+template <typename T, typename Allocator>
+typename CustomSet<T, Allocator>::iterator CustomSet<T, Allocator>::end() {
   return iterator(array_ + size_);
 }
-template <typename T>
-const typename CustomSet<T>::iterator CustomSet<T>::cbegin() const {
+template <typename T, typename Allocator>
+const typename CustomSet<T, Allocator>::iterator
+CustomSet<T, Allocator>::cbegin() const {
   return iterator(array_);
 }
-template <typename T>
-const typename CustomSet<T>::iterator CustomSet<T>::cend() const {
+template <typename T, typename Allocator>
+const typename CustomSet<T, Allocator>::iterator
+CustomSet<T, Allocator>::cend() const {
   return iterator(array_ + size_);
 }
-template <typename T>
-typename CustomSet<T>::iterator CustomSet<T>::rbegin() {
+template <typename T, typename Allocator>
+typename CustomSet<T, Allocator>::iterator CustomSet<T, Allocator>::rbegin() {
   return iterator(array_ + size_ - 1);
 }
-template <typename T>
-typename CustomSet<T>::iterator CustomSet<T>::rend() {
+template <typename T, typename Allocator>
+typename CustomSet<T, Allocator>::iterator CustomSet<T, Allocator>::rend() {
   return iterator(array_ - 1);
 }
-template <typename T>
-const typename CustomSet<T>::iterator CustomSet<T>::crbegin() const {
+template <typename T, typename Allocator>
+const typename CustomSet<T, Allocator>::iterator
+CustomSet<T, Allocator>::crbegin() const {
   return iterator(array_ + size_ - 1);
 }
-template <typename T>
-const typename CustomSet<T>::iterator CustomSet<T>::crend() const {
+template <typename T, typename Allocator>
+const typename CustomSet<T, Allocator>::iterator
+CustomSet<T, Allocator>::crend() const {
   return iterator(array_ - 1);
 }
-template <typename T>
-std::size_t CustomSet<T>::size() const {
+template <typename T, typename Allocator>
+std::size_t CustomSet<T, Allocator>::size() const {
   return size_;
 }
-template <typename T>
-std::size_t CustomSet<T>::max_size() const {
+template <typename T, typename Allocator>
+std::size_t CustomSet<T, Allocator>::max_size() const {
   return std::numeric_limits<std::size_t>::max() / sizeof(T);
 }
-template <typename T>
-bool CustomSet<T>::empty() const {
+template <typename T, typename Allocator>
+bool CustomSet<T, Allocator>::empty() const {
   return size_ == 0;
 }
-template <typename T>
-bool CustomSet<T>::contains(const T* value) {
-  bool answer = false;
-  if (array_ != nullptr) {
-    for (std::size_t i = 0; i < size_; i++)
-      if (array_[i] == value) {
-        answer = true;
-        break;
-      }
-  }
-  return answer;
+template <typename T, typename Allocator>
+bool CustomSet<T, Allocator>::contains(const T& value) const {
+  return count(value) != 0;
 }
-template <typename T>
-void CustomSet<T>::erase(const T& value) {
-  for (std::size_t i = 0; i < size_; ++i) {
-    if (array_[i] == value) {
-      for (std::size_t j = i; j < size_ - 1; ++j) {
-        array_[j] = array_[j + 1];
-      }
-      --size_;
-      return;
-    }
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::erase(const T& value) {
+  iterator found = find(value);
+  if (found != end()) {
+    erase(found);
   }
 }
-template <typename T>
-void CustomSet<T>::clear() {
-  delete[] array_;
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::clear() {
+  thaw();
+  deleteArray(array_, capacity_);
   array_ = nullptr;
   size_ = 0;
   capacity_ = 0;
 }
-template <typename T>
-typename CustomSet<T>::iterator CustomSet<T>::find(const T& value) {
-  for (std::size_t i = 0; i < size_; ++i) {
-    if (array_[i] == value) {
-      return iterator(array_ + i);
-    }
+template <typename T, typename Allocator>
+typename CustomSet<T, Allocator>::iterator
+CustomSet<T, Allocator>::find(const T& value) {
+  std::size_t index = lowerIndex(value);
+  if (index < size_ && !(value < array_[index])) {
+    return iterator(array_ + index);
   }
   return end();
 }
-template <typename T>
-std::size_t CustomSet<T>::count(const T& value) {
-  for (std::size_t i = 0; i < size_; ++i) {
-    if (array_[i] == value) {
-      return 1;
-    }
+template <typename T, typename Allocator>
+std::size_t CustomSet<T, Allocator>::count(const T& value) const {
+  if (eytzinger_ != nullptr) {
+    std::size_t slot = eytzingerSlot<false>(value);
+    return slot != 0 && !(value < eytzinger_[slot]) ? 1 : 0;
   }
-  return 0;
+  std::size_t index = lowerIndex(value);
+  return index < size_ && !(value < array_[index]) ? 1 : 0;
 }
-template <typename T>
+template <typename T, typename Allocator>
 template <typename... Args>
-void CustomSet<T>::emplace(Args&&... args) {
+void CustomSet<T, Allocator>::emplace(Args&&... args) {
   T temp(std::forward<Args>(args)...);
-  if (find(temp) != nullptr) {
+  std::size_t index = lowerIndex(temp);
+  if (index < size_ && !(temp < array_[index])) {
     return;
   }
-  if (size_ == capacity_) {
-    resize();
-  }
-  new (&array_[size_]) T(std::move(temp));
-  ++size_;
+  insertAt(index, std::move(temp));
 }
-template <typename T>
-void CustomSet<T>::swap(CustomSet<T>& other) {
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::swap(CustomSet& other) {
+  if constexpr (Traits::propagate_on_container_swap::value) {
+    std::swap(allocator, other.allocator);
+  }
   std::swap(size_, other.size_);
   std::swap(capacity_, other.capacity_);
   std::swap(array_, other.array_);
-}
-template <typename T>
-void CustomSet<T>::merge(set const& other) {
-  for (std::size_t i = 0; i < other.size_; i++) {
-    if (!contains(other.array_[i])) {
-      if (size_ == capacity_) {
-        resize();
+  std::swap(eytzinger_, other.eytzinger_);
+  std::swap(eytzingerIndex_, other.eytzingerIndex_);
+}
+template <typename T, typename Allocator>
+typename CustomSet<T, Allocator>::allocator_type
+CustomSet<T, Allocator>::get_allocator() const {
+  return allocator;
+}
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::merge(set const& other) {
+  reserve(size_ + other.size_);
+  insert(other.array_, other.array_ + other.size_);
+}
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::union_with(const set& other) {
+  combine(other, true, true, true);
+}
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::intersect_with(const set& other) {
+  combine(other, false, true, false);
+}
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::difference_with(const set& other) {
+  combine(other, true, false, false);
+}
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::symmetric_difference_with(const set& other) {
+  combine(other, true, false, true);
+}
+// Keeps the elements found only here, in both sets, or only in `other`
+// (copied) as the flags say.
+template <typename T, typename Allocator>
+void CustomSet<T, Allocator>::combine(const set& other, bool keepOwn,
+                                      bool keepShared, bool keepOthers) {
+  if (this == &other) {
+    if (!keepShared) clear();
+    return;
+  }
+  thaw();
+  const T* theirs = other.array_;
+  const T* theirsEnd = other.array_ + other.size_;
+  if (!keepOthers) {
+    // A binary search per element beats the walk once `other` is more than
+    // about log2(other.size()) times larger.
+    std::size_t depth = 1;
+    while ((other.size_ >> depth) != 0) ++depth;
+    bool skip = size_ * depth < other.size_;
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < size_; ++i) {
+      if (skip) {
+        theirs = std::lower_bound(theirs, theirsEnd, array_[i]);
+      } else {
+        while (theirs != theirsEnd && *theirs < array_[i]) ++theirs;
+      }
+      bool shared = theirs != theirsEnd && !(array_[i] < *theirs);
+      if (shared ? keepShared : keepOwn) {
+        if (kept != i) array_[kept] = std::move(array_[i]);
+        ++kept;
       }
-      array_[size_++] = other.array_[i];
     }
+    size_ = kept;
+    return;
   }
-}
-template <typename T>
-std::function<bool(const T&, const T&)> key_comp() {
+  if (other.size_ == 0) return;
+  std::size_t capacity = size_ + other.size_;
+  T* merged = newArray(capacity);
+  std::size_t count = 0;
+  T* mine = array_;
+  T* mineEnd = array_ + size_;
+  while (mine != mineEnd && theirs != theirsEnd) {
+    if (*theirs < *mine) {
+      merged[count++] = *theirs++;
+    } else if (*mine < *theirs) {
+      merged[count++] = std::move(*mine++);
+    } else {
+      if (keepShared) merged[count++] = std::move(*mine);
+      ++mine;
+      ++theirs;
+    }
+  }
+  while (mine != mineEnd) merged[count++] = std::move(*mine++);
+  while (theirs != theirsEnd) merged[count++] = *theirs++;
+  deleteArray(array_, capacity_);
+  array_ = merged;
+  size_ = count;
+  capacity_ = capacity;
+}
+template <typename T, typename Allocator>
+std::function<bool(const T&, const T&)>
+CustomSet<T, Allocator>::key_comp() const {
   return std::less<T>();
 }
-
-template <typename T>
-std::function<bool(const T&, const T&)> value_comp() {
+template <typename T, typename Allocator>
+std::function<bool(const T&, const T&)>
+CustomSet<T, Allocator>::value_comp() const {
   return std::less<T>();
 }
-template <typename T>
-typename CustomSet<T>::iterator CustomSet<T>::upper_bound(const T& value) {
-  auto comp = key_comp();
-  for (std::size_t i = 0; i < size_; ++i) {
-    if (comp(value, array_[i])) {
-      return iterator(array_ + i);
-    }
-  }
-  return iterator(array_ + size_);
+template <typename T, typename Allocator>
+typename CustomSet<T, Allocator>::iterator
+CustomSet<T, Allocator>::lower_bound(const T& value) {
+  return iterator(array_ + lowerIndex(value));
+}
+template <typename T, typename Allocator>
+typename CustomSet<T, Allocator>::iterator
+CustomSet<T, Allocator>::upper_bound(const T& value) {
+  return iterator(array_ + searchIndex<true>(value));
 }
-template <typename T>
+template <typename T, typename Allocator>
+std::pair<typename CustomSet<T, Allocator>::iterator,
+          typename CustomSet<T, Allocator>::iterator>
+CustomSet<T, Allocator>::equal_range(const T& value) {
+  return std::make_pair(lower_bound(value), upper_bound(value));
+}
+template <typename T, typename Allocator>
 template <typename... Args>
-typename CustomSet<T>::iterator CustomSet<T>::emplace_hint(iterator pos,
-                                                           Args&&... args) {
-  if (size_ == capacity_) resize();
+typename CustomSet<T, Allocator>::iterator
+CustomSet<T, Allocator>::emplace_hint(iterator pos, Args&&... args) {
+  T temp(std::forward<Args>(args)...);
   std::size_t index = pos - begin();
-  for (std::size_t i = size_; i > index; --i) {
-    array_[i] = std::move(array_[i - 1]);
+  bool fits = index <= size_ && (index == size_ || temp < array_[index]) &&
+              (index == 0 || array_[index - 1] < temp);
+  if (!fits) {
+    index = lowerIndex(temp);
+    if (index < size_ && !(temp < array_[index])) {
+      return iterator(array_ + index);
+    }
   }
-  new (array_ + index) T(std::forward<Args>(args)...);
-  ++size_;
-  return iterator(array_ + index);
+  return insertAt(index, std::move(temp));
 }
 
 #endif  // INCLUDE_CUSTOM_SET_H_
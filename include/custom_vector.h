@@ -3,11 +3,63 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <limits>
+#include <memory>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 
-template <class T>
+#include "vector_growth.h"
+
+// Whether a T can be moved to other storage by copying its bytes, the
+// original then being treated as raw memory and never destroyed. True for
+// trivially copyable types. Specialize it to std::true_type for a type
+// that qualifies without being trivially copyable, such as a record that
+// owns a buffer through a pointer; never for a type that points into
+// itself, as libstdc++'s std::string does with its inline buffer.
+template <typename T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+template <typename First, typename Second>
+struct IsTriviallyRelocatable<std::pair<First, Second>>
+    : std::integral_constant<bool,
+                             IsTriviallyRelocatable<First>::value &&
+                                 IsTriviallyRelocatable<Second>::value> {};
+
+template <class T, std::size_t N, class Allocator>
+class SmallVector;
+
+// Dynamic array over raw storage: only the first size() slots hold
+// objects, so spare capacity costs no constructions and T needs no
+// default constructor. Elements are constructed in place when added and
+// destroyed when removed; growth moves them to the new storage, or copies
+// them if T's move constructor may throw.
+//
+// Trivially relocatable elements take bulk-memory paths instead: growth
+// and shrink_to_fit copy the whole buffer at once, and insert and erase
+// shift the tail with one memmove. Their storage comes from malloc when
+// their alignment allows, so that growth can go through realloc, which
+// extends the block in place when the memory after it is free.
+//
+// Storage and elements go through Allocator by way of
+// std::allocator_traits, which rebinds, propagates and compares it as the
+// standard containers do. The malloc and realloc path is only taken with
+// the default std::allocator.
+//
+// A SmallVector is a CustomVector that starts out on an inline buffer of
+// its own. That buffer is never freed or reallocated; when another vector
+// takes the elements over, they are moved out of it one by one.
+//
+// Growth picks the capacity a full vector grows to (see vector_growth.h):
+// DoublingGrowth by default, HalfAgainGrowth, ChunkGrowth or
+// SizeClassGrowth, and GrowthStats around any of them to count the
+// reallocations.
+template <class T, class Allocator = std::allocator<T>,
+          class Growth = DoublingGrowth>
 class CustomVector {
  public:
   class CustomVectorIterator {
@@ -48,6 +100,8 @@ class CustomVector {
   };
 
   using value_type = T;
+  using allocator_type = Allocator;
+  using growth_type = Growth;
   using reference = T&;
   using const_reference = T const&;
   using iterator = CustomVectorIterator;
@@ -56,13 +110,16 @@ class CustomVector {
   using vector_reference = CustomVector&;
 
   CustomVector();
-  explicit CustomVector(std::size_t initialCapacity);
-  CustomVector(const CustomVector<T>& other);
+  explicit CustomVector(const Allocator& alloc);
+  explicit CustomVector(std::size_t initialCapacity,
+                        const Allocator& alloc = Allocator());
+  CustomVector(const CustomVector& other);
+  CustomVector(const CustomVector& other, const Allocator& alloc);
   explicit CustomVector(vector&& other) noexcept;
   ~CustomVector();
 
   // Operators
-  CustomVector& operator=(vector_reference other);
+  CustomVector& operator=(const CustomVector& other);
   CustomVector& operator=(vector&& other);
 
   // Iterators
@@ -82,7 +139,7 @@ class CustomVector {
   size_type capacity() const;
   bool empty() const;
   size_type max_size() const;
-  void shrink_to_fit() const;
+  void shrink_to_fit();
 
   // Element access
   reference operator[](size_type index);
@@ -95,12 +152,15 @@ class CustomVector {
   // Modifiers
   void assign(size_type count, const_reference value);
   void push_back(const_reference value);
+  void push_back(T&& value);
   void pop_back();
   void insert(size_type index, const_reference value);
   iterator insert(iterator pos, const_reference value);
   void erase(size_type index);
   void clear();
   void swap(vector_reference other);
+  allocator_type get_allocator() const;
+  const growth_type& growth_policy() const;
 
   template <typename... Args>
   void emplace_back(Args&&... args);
@@ -108,15 +168,65 @@ class CustomVector {
   void emplace(size_type index, Args&&... args);
 
  private:
+  template <class, std::size_t, class>
+  friend class SmallVector;
+  using Traits = std::allocator_traits<Allocator>;
+
   T* array;
   std::size_t size_;
   std::size_t capacity_;
-
+  Allocator allocator;
+  // Whether array is a SmallVector's inline buffer.
+  bool inlineArray_;
+  Growth growth_;
+
+  static constexpr bool kRelocatable = IsTriviallyRelocatable<T>::value;
+  // With std::allocator, construct and destroy do nothing beyond placement
+  // new and the destructor, so the std::uninitialized_* algorithms, which
+  // use memcpy and memset where they can, stand in for them.
+  static constexpr bool kDefaultAllocator =
+      std::is_same<Allocator, std::allocator<T>>::value;
+  static constexpr bool kReallocates =
+      kRelocatable && kDefaultAllocator &&
+      alignof(T) <= alignof(std::max_align_t);
+
+  // Starts on `buffer`, inline storage for bufferCapacity elements.
+  CustomVector(T* buffer, std::size_t bufferCapacity, const Allocator& alloc);
+
+  static std::size_t bytesFor(std::size_t count);
+  T* allocate(std::size_t count);
+  void deallocate(T* storage, std::size_t count);
+  // Frees array unless it is inline.
+  void freeArray();
+  template <typename... Args>
+  void construct(T* slot, Args&&... args);
+  void destroy(T* first, T* last);
+  // Build copies of [first, last) at out, or count copies of value. If a
+  // constructor throws, the objects already built are destroyed again.
+  void copyInto(const T* first, const T* last, T* out);
+  void fillInto(T* out, std::size_t count, const T& value);
+  // Moves [first, last) to the raw storage at out and ends the originals.
+  // If it throws, nothing has changed.
+  void transfer(T* first, T* last, T* out);
+  // Takes over other's storage, leaving it empty. The allocators must be
+  // equal and other's storage must not be inline.
+  void adopt(CustomVector& other);
+  // Takes over other's elements, leaving it empty: its storage if that can
+  // be freed through this vector's allocator and is not inline, otherwise
+  // element by element into this vector's storage.
+  void take(CustomVector& other);
+  void moveElements(CustomVector& other);
+  // Moves the elements into new storage of newCapacity slots. The checked
+  // variant only grows; relocate also serves shrink_to_fit.
   void reallocate(std::size_t newCapacity);
+  void relocate(std::size_t newCapacity);
+  std::size_t grownCapacity();
+  // Tells the growth policy that array now has capacity_ slots.
+  void relocated(std::size_t oldCapacity, std::size_t bytesCopied);
 };
 
-template <class T>
-T& CustomVector<T>::at(size_type index) {
+template <typename T, typename Allocator, typename Growth>
+T& CustomVector<T, Allocator, Growth>::at(size_type index) {
   if (index >= this->size_) {
     throw std::out_of_range("Index out of range.");
   }
@@ -124,308 +234,660 @@ T& CustomVector<T>::at(size_type index) {
   return this->array[index];
 }
 
-template <typename T>
-CustomVector<T>::CustomVector() : array(nullptr), size_(0), capacity_(0) {}
+template <typename T, typename Allocator, typename Growth>
+CustomVector<T, Allocator, Growth>::CustomVector()
+    : array(nullptr),
+      size_(0),
+      capacity_(0),
+      allocator(),
+      inlineArray_(false),
+      growth_() {}
+
+template <typename T, typename Allocator, typename Growth>
+CustomVector<T, Allocator, Growth>::CustomVector(const Allocator& alloc)
+    : array(nullptr),
+      size_(0),
+      capacity_(0),
+      allocator(alloc),
+      inlineArray_(false),
+      growth_() {}
+
+template <typename T, typename Allocator, typename Growth>
+CustomVector<T, Allocator, Growth>::CustomVector(size_type initialCapacity,
+                                                 const Allocator& alloc)
+    : CustomVector(alloc) {
+  array = allocate(initialCapacity);
+  capacity_ = initialCapacity;
+}
+
+template <typename T, typename Allocator, typename Growth>
+CustomVector<T, Allocator, Growth>::CustomVector(T* buffer,
+                                                 std::size_t bufferCapacity,
+                                                 const Allocator& alloc)
+    : array(buffer),
+      size_(0),
+      capacity_(bufferCapacity),
+      allocator(alloc),
+      inlineArray_(true),
+      growth_() {}
+
+template <typename T, typename Allocator, typename Growth>
+CustomVector<T, Allocator, Growth>::CustomVector(const CustomVector& other)
+    : CustomVector(other,
+                   Traits::select_on_container_copy_construction(
+                       other.allocator)) {}
+
+template <typename T, typename Allocator, typename Growth>
+CustomVector<T, Allocator, Growth>::CustomVector(const CustomVector& other,
+                                                 const Allocator& alloc)
+    : CustomVector(other.capacity_, alloc) {
+  copyInto(other.array, other.array + other.size_, array);
+  size_ = other.size_;
+}
+
+// Taking the elements out of an inline buffer allocates; should that fail,
+// the noexcept ends the program.
+template <typename T, typename Allocator, typename Growth>
+CustomVector<T, Allocator, Growth>::CustomVector(CustomVector&& other) noexcept
+    : array(nullptr),
+      size_(0),
+      capacity_(0),
+      allocator(std::move(other.allocator)),
+      inlineArray_(false),
+      growth_() {
+  if (other.inlineArray_) {
+    moveElements(other);
+  } else {
+    adopt(other);
+  }
+}
+template <typename T, typename Allocator, typename Growth>
+CustomVector<T, Allocator, Growth>::~CustomVector() {
+  destroy(array, array + size_);
+  freeArray();
+}
 
-template <typename T>
-CustomVector<T>::CustomVector(size_type initialCapacity)
-    : array(new T[initialCapacity]), size_(0), capacity_(initialCapacity) {}
+// The copy is built first, with the allocator this vector ends up with,
+// so a throwing copy leaves the vector as it was.
+template <typename T, typename Allocator, typename Growth>
+CustomVector<T, Allocator, Growth>&
+CustomVector<T, Allocator, Growth>::operator=(const CustomVector& other) {
+  if (this != &other) {
+    if constexpr (Traits::propagate_on_container_copy_assignment::value) {
+      CustomVector copy(other, other.allocator);
+      clear();
+      allocator = other.allocator;
+      take(copy);
+    } else {
+      CustomVector copy(other, get_allocator());
+      take(copy);
+    }
+  }
+  return *this;
+}
 
-template <typename T>
-CustomVector<T>::CustomVector(const CustomVector<T>& other)
-    : array(new T[other.capacity_]),
-      size_(other.size_),
-      capacity_(other.capacity_) {
-  for (std::size_t i = 0; i < size_; ++i) {
-    array[i] = other.array[i];
+template <typename T, typename Allocator, typename Growth>
+CustomVector<T, Allocator, Growth>&
+CustomVector<T, Allocator, Growth>::operator=(CustomVector&& other) {
+  if (this == &other) return *this;
+  if constexpr (Traits::propagate_on_container_move_assignment::value) {
+    if (!other.inlineArray_) {
+      clear();
+      allocator = std::move(other.allocator);
+      adopt(other);
+      return *this;
+    }
+    if (allocator != other.allocator) {
+      clear();
+      allocator = other.allocator;
+    }
   }
+  take(other);
+  return *this;
 }
-template <typename T>
-CustomVector<T>::CustomVector(CustomVector<T>&& other) noexcept
-    : array(other.array), size_(other.size_), capacity_(other.capacity_) {
+
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::adopt(CustomVector& other) {
+  array = other.array;
+  size_ = other.size_;
+  capacity_ = other.capacity_;
+  inlineArray_ = false;
   other.array = nullptr;
   other.size_ = 0;
   other.capacity_ = 0;
 }
-template <typename T>
-CustomVector<T>::~CustomVector() {
-  delete[] array;
-}
 
-template <typename T>
-typename CustomVector<T>::vector_reference CustomVector<T>::operator=(
-    vector_reference other) {
-  if (this != &other) {
-    T* newArray = new T[other.capacity_];
-    for (size_type i = 0; i < other.size_; ++i) {
-      newArray[i] = other.array[i];
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::take(CustomVector& other) {
+  if (other.inlineArray_ || allocator != other.allocator) {
+    moveElements(other);
+    return;
+  }
+  destroy(array, array + size_);
+  freeArray();
+  adopt(other);
+}
+
+// Reuses this vector's storage when other's elements fit; otherwise they
+// move into new storage first, so a throwing copy leaves this vector as
+// it was.
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::moveElements(CustomVector& other) {
+  if (other.size_ <= capacity_) {
+    destroy(array, array + size_);
+    size_ = 0;
+    transfer(other.array, other.array + other.size_, array);
+  } else {
+    T* newArray = allocate(other.size_);
+    try {
+      transfer(other.array, other.array + other.size_, newArray);
+    } catch (...) {
+      deallocate(newArray, other.size_);
+      throw;
     }
-    delete[] array;
+    destroy(array, array + size_);
+    freeArray();
     array = newArray;
-    size_ = other.size_;
-    capacity_ = other.capacity_;
+    capacity_ = other.size_;
+    inlineArray_ = false;
   }
-  return *this;
+  size_ = other.size_;
+  other.size_ = 0;
+  other.clear();
 }
 
-template <class T>
-CustomVector<T>& CustomVector<T>::operator=(CustomVector<T>&& other) {
-  if (this != &other) {
-    delete[] array;
-    array = other.array;
-    size_ = other.size_;
-    capacity_ = other.capacity_;
+template <typename T, typename Allocator, typename Growth>
+T& CustomVector<T, Allocator, Growth>::operator[](size_type index) {
+  return array[index];
+}
+
+template <typename T, typename Allocator, typename Growth>
+const T& CustomVector<T, Allocator, Growth>::operator[](size_type index) const {
+  return array[index];
+}
 
-    other.array = nullptr;
-    other.size_ = 0;
-    other.capacity_ = 0;
+template <typename T, typename Allocator, typename Growth>
+std::size_t CustomVector<T, Allocator, Growth>::bytesFor(std::size_t count) {
+  if (count > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+    throw std::length_error("Capacity exceeds max_size().");
+  }
+  return count * sizeof(T);
+}
+
+template <typename T, typename Allocator, typename Growth>
+T* CustomVector<T, Allocator, Growth>::allocate(std::size_t count) {
+  if (count == 0) return nullptr;
+  if constexpr (kReallocates) {
+    void* storage = std::malloc(bytesFor(count));
+    if (storage == nullptr) throw std::bad_alloc();
+    return static_cast<T*>(storage);
+  } else {
+    return Traits::allocate(allocator, count);
   }
-  return *this;
 }
 
-template <typename T>
-T& CustomVector<T>::operator[](size_type index) {
-  return array[index];
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::deallocate(T* storage,
+                                                    std::size_t count) {
+  if (storage == nullptr) return;
+  if constexpr (kReallocates) {
+    std::free(storage);
+  } else {
+    Traits::deallocate(allocator, storage, count);
+  }
 }
 
-template <typename T>
-const T& CustomVector<T>::operator[](size_type index) const {
-  return array[index];
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::freeArray() {
+  if (!inlineArray_) deallocate(array, capacity_);
 }
 
-template <typename T>
-void CustomVector<T>::reallocate(size_type newCapacity) {
+template <typename T, typename Allocator, typename Growth>
+template <typename... Args>
+void CustomVector<T, Allocator, Growth>::construct(T* slot, Args&&... args) {
+  Traits::construct(allocator, slot, std::forward<Args>(args)...);
+}
+
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::destroy(T* first, T* last) {
+  if constexpr (!kDefaultAllocator ||
+                !std::is_trivially_destructible<T>::value) {
+    for (; first != last; ++first) Traits::destroy(allocator, first);
+  }
+}
+
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::copyInto(const T* first, const T* last,
+                                                  T* out) {
+  if constexpr (kDefaultAllocator) {
+    std::uninitialized_copy(first, last, out);
+  } else {
+    T* built = out;
+    try {
+      for (; first != last; ++first, ++built) construct(built, *first);
+    } catch (...) {
+      destroy(out, built);
+      throw;
+    }
+  }
+}
+
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::fillInto(T* out, std::size_t count,
+                                                  const T& value) {
+  if constexpr (kDefaultAllocator) {
+    std::uninitialized_fill_n(out, count, value);
+  } else {
+    std::size_t built = 0;
+    try {
+      for (; built < count; ++built) construct(out + built, value);
+    } catch (...) {
+      destroy(out, out + built);
+      throw;
+    }
+  }
+}
+
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::transfer(T* first, T* last, T* out) {
+  if constexpr (kRelocatable) {
+    if (first != last) {
+      std::memcpy(static_cast<void*>(out), static_cast<const void*>(first),
+                  (last - first) * sizeof(T));
+    }
+  } else if constexpr (std::is_nothrow_move_constructible<T>::value ||
+                       !std::is_copy_constructible<T>::value) {
+    if constexpr (kDefaultAllocator) {
+      std::uninitialized_move(first, last, out);
+    } else {
+      T* built = out;
+      try {
+        for (T* it = first; it != last; ++it, ++built) {
+          construct(built, std::move(*it));
+        }
+      } catch (...) {
+        destroy(out, built);
+        throw;
+      }
+    }
+    destroy(first, last);
+  } else {
+    copyInto(first, last, out);
+    destroy(first, last);
+  }
+}
+
+template <typename T, typename Allocator, typename Growth>
+std::size_t CustomVector<T, Allocator, Growth>::grownCapacity() {
+  return growth_.next(capacity_, sizeof(T));
+}
+
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::relocated(std::size_t oldCapacity,
+                                                   std::size_t bytesCopied) {
+  growth_.relocated(VectorReallocation{oldCapacity, capacity_, size_,
+                                       bytesCopied, sizeof(T)});
+}
+
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::reallocate(size_type newCapacity) {
   if (newCapacity <= capacity_) {
     throw std::invalid_argument(
         "New capacity must be greater than current capacity.");
   }
-  T* newArray = new T[newCapacity];
-  for (std::size_t i = 0; i < size_; i++) {
-    newArray[i] = std::move(array[i]);
+  relocate(newCapacity);
+}
+
+// realloc leaves the old block alone when it fails, so a failure leaves
+// the vector as it was on either path. An inline buffer is never passed
+// to realloc. A block that realloc grows in place copies no bytes.
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::relocate(size_type newCapacity) {
+  std::size_t oldCapacity = capacity_;
+  if constexpr (kReallocates) {
+    if (!inlineArray_) {
+      std::size_t bytesCopied = 0;
+      if (newCapacity == 0) {
+        deallocate(array, capacity_);
+        array = nullptr;
+      } else {
+        // The address only, read as bits: GCC counts any later use of the
+        // pointer itself as a use after realloc.
+        std::uintptr_t old;
+        std::memcpy(&old, &array, sizeof(old));
+        void* storage = std::realloc(static_cast<void*>(array),
+                                     bytesFor(newCapacity));
+        if (storage == nullptr) throw std::bad_alloc();
+        array = static_cast<T*>(storage);
+        if (old != 0 && reinterpret_cast<std::uintptr_t>(storage) != old) {
+          bytesCopied = size_ * sizeof(T);
+        }
+      }
+      capacity_ = newCapacity;
+      relocated(oldCapacity, bytesCopied);
+      return;
+    }
+  }
+  T* newArray = allocate(newCapacity);
+  try {
+    transfer(array, array + size_, newArray);
+  } catch (...) {
+    deallocate(newArray, newCapacity);
+    throw;
   }
-  delete[] array;
+  freeArray();
   array = newArray;
   capacity_ = newCapacity;
+  inlineArray_ = false;
+  relocated(oldCapacity, size_ * sizeof(T));
 }
 
-template <typename T>
-void CustomVector<T>::push_back(const T& value) {
-  if (size_ == capacity_) {
-    reallocate(capacity_ > 0 ? capacity_ * 2 : 1);
-  }
-  array[size_++] = value;
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::push_back(const T& value) {
+  emplace_back(value);
 }
 
-template <typename T>
-void CustomVector<T>::reserve(std::size_t newCapacity) {
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::push_back(T&& value) {
+  emplace_back(std::move(value));
+}
+
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::reserve(std::size_t newCapacity) {
   if (newCapacity > capacity_) {
     reallocate(newCapacity);
   }
 }
 
-template <typename T>
-std::size_t CustomVector<T>::size() const {
+template <typename T, typename Allocator, typename Growth>
+std::size_t CustomVector<T, Allocator, Growth>::size() const {
   return size_;
 }
 
-template <typename T>
-std::size_t CustomVector<T>::capacity() const {
+template <typename T, typename Allocator, typename Growth>
+std::size_t CustomVector<T, Allocator, Growth>::capacity() const {
   return capacity_;
 }
 
-template <typename T>
-bool CustomVector<T>::empty() const {
+template <typename T, typename Allocator, typename Growth>
+bool CustomVector<T, Allocator, Growth>::empty() const {
   return size_ == 0;
 }
 
-template <typename T>
-typename CustomVector<T>::const_reference CustomVector<T>::front() const {
+template <typename T, typename Allocator, typename Growth>
+typename CustomVector<T, Allocator, Growth>::const_reference
+CustomVector<T, Allocator, Growth>::front() const {
   if (size_ == 0) {
     throw std::out_of_range("Vector is empty.");
   }
   return array[0];
 }
 
-template <typename T>
-typename CustomVector<T>::const_reference CustomVector<T>::back() const {
+template <typename T, typename Allocator, typename Growth>
+typename CustomVector<T, Allocator, Growth>::const_reference
+CustomVector<T, Allocator, Growth>::back() const {
   if (size_ == 0) {
     throw std::out_of_range("Vector is empty.");
   }
   return array[size_ - 1];
 }
 
-template <typename T>
-typename CustomVector<T>::reference CustomVector<T>::data() const {
+template <typename T, typename Allocator, typename Growth>
+typename CustomVector<T, Allocator, Growth>::reference
+CustomVector<T, Allocator, Growth>::data() const {
   return array;
 }
 
-template <typename T>
-void CustomVector<T>::resize(std::size_t newSize, const T& value) {
+// `value` may be an element of this vector, so growing copies it first.
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::resize(std::size_t newSize,
+                                                const T& value) {
+  if (newSize <= size_) {
+    destroy(array + newSize, array + size_);
+    size_ = newSize;
+    return;
+  }
   if (newSize > capacity_) {
+    T copy(value);
     reallocate(newSize);
-  }
-  for (std::size_t i = size_; i < newSize; ++i) {
-    array[i] = value;
+    fillInto(array + size_, newSize - size_, copy);
+  } else {
+    fillInto(array + size_, newSize - size_, value);
   }
   size_ = newSize;
 }
 
-template <typename T>
-void CustomVector<T>::pop_back() {
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::pop_back() {
   if (size_ > 0) {
     size_ -= 1;
+    destroy(array + size_, array + size_ + 1);
   }
 }
 
-template <typename T>
-void CustomVector<T>::clear() {
-  delete[] array;
+// An inline buffer stays in place for the next elements.
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::clear() {
+  destroy(array, array + size_);
   size_ = 0;
+  if (inlineArray_) return;
+  deallocate(array, capacity_);
+  array = nullptr;
   capacity_ = 0;
 }
 
-template <typename T>
-void CustomVector<T>::assign(std::size_t count, const T& value) {
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::assign(std::size_t count,
+                                                const T& value) {
+  T copy(value);
   clear();
   if (count > capacity_) {
     reallocate(count);
   }
-  for (std::size_t i = 0; i < count; i++) {
-    array[i] = value;
-  }
+  fillInto(array, count, copy);
   size_ = count;
 }
 
-template <typename T>
-void CustomVector<T>::insert(std::size_t index, const T& value) {
-  if (index > size_) {
-    throw std::out_of_range("Index is out of range.");
-  }
-  if (size_ == capacity_) {
-    reallocate(capacity_ > 0 ? capacity_ * 2 : 1);
-  }
-  for (std::size_t i = size_; i > index; --i) {
-    array[i] = std::move(array[i - 1]);
-  }
-  array[index] = value;
-  ++size_;
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::insert(std::size_t index,
+                                                const T& value) {
+  emplace(index, value);
 }
 
-template <typename T>
-void CustomVector<T>::erase(std::size_t index) {
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::erase(std::size_t index) {
   if (index >= size_) {
     throw std::out_of_range("Index is out of range.");
   }
-  for (std::size_t i = index; i < size_ - 1; i++) {
-    array[i] = std::move(array[i + 1]);
+  if constexpr (kRelocatable) {
+    T* slot = array + index;
+    destroy(slot, slot + 1);
+    std::memmove(static_cast<void*>(slot), static_cast<const void*>(slot + 1),
+                 (size_ - index - 1) * sizeof(T));
+    --size_;
+  } else {
+    std::move(array + index + 1, array + size_, array + index);
+    pop_back();
   }
-  --size_;
 }
 
-template <typename T>
-void CustomVector<T>::swap(CustomVector<T>& other) {
+// Inline elements cannot change hands with their buffer, so they are
+// swapped through a third vector.
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::swap(CustomVector& other) {
+  if (inlineArray_ || other.inlineArray_) {
+    CustomVector held(std::move(other));
+    other = std::move(*this);
+    *this = std::move(held);
+    return;
+  }
+  if constexpr (Traits::propagate_on_container_swap::value) {
+    std::swap(allocator, other.allocator);
+  }
   std::swap(array, other.array);
   std::swap(size_, other.size_);
   std::swap(capacity_, other.capacity_);
 }
 
-template <typename T>
+template <typename T, typename Allocator, typename Growth>
+typename CustomVector<T, Allocator, Growth>::allocator_type
+CustomVector<T, Allocator, Growth>::get_allocator() const {
+  return allocator;
+}
+
+template <typename T, typename Allocator, typename Growth>
+const typename CustomVector<T, Allocator, Growth>::growth_type&
+CustomVector<T, Allocator, Growth>::growth_policy() const {
+  return growth_;
+}
+
+// args may refer to elements of this vector. When the vector is full,
+// the new element is built in the new storage before the old elements
+// move there, so they are still intact while it is built; with realloc,
+// which may move them at once, it is built aside first.
+template <typename T, typename Allocator, typename Growth>
 template <typename... Args>
-void CustomVector<T>::emplace_back(Args&&... args) {
-  if (size_ == capacity_) {
-    reallocate(capacity_ > 0 ? capacity_ * 2 : 1);
+void CustomVector<T, Allocator, Growth>::emplace_back(Args&&... args) {
+  if (size_ < capacity_) {
+    construct(array + size_, std::forward<Args>(args)...);
+    ++size_;
+    return;
+  }
+  if constexpr (kReallocates) {
+    T element(std::forward<Args>(args)...);
+    relocate(grownCapacity());
+    construct(array + size_, std::move(element));
+    ++size_;
+    return;
+  }
+  std::size_t newCapacity = grownCapacity();
+  T* newArray = allocate(newCapacity);
+  try {
+    construct(newArray + size_, std::forward<Args>(args)...);
+  } catch (...) {
+    deallocate(newArray, newCapacity);
+    throw;
+  }
+  try {
+    transfer(array, array + size_, newArray);
+  } catch (...) {
+    destroy(newArray + size_, newArray + size_ + 1);
+    deallocate(newArray, newCapacity);
+    throw;
   }
-  new (&array[size_]) T(std::forward<Args>(args)...);
+  freeArray();
+  array = newArray;
+  std::size_t oldCapacity = capacity_;
+  capacity_ = newCapacity;
+  inlineArray_ = false;
+  relocated(oldCapacity, size_ * sizeof(T));
   ++size_;
 }
 
-template <typename T>
+// The new element is built first, since args may refer to an element that
+// is about to move. Relocatable elements then shift up with one memmove
+// and the new one moves into the gap. Otherwise the last element moves
+// into the first free slot and the others shift up by assignment.
+template <typename T, typename Allocator, typename Growth>
 template <typename... Args>
-void CustomVector<T>::emplace(std::size_t index, Args&&... args) {
+void CustomVector<T, Allocator, Growth>::emplace(std::size_t index,
+                                                 Args&&... args) {
   if (index > size_) {
     throw std::out_of_range("Index out of range.");
   }
-  if (size_ == capacity_) {
-    reallocate(capacity_ > 0 ? capacity_ * 2 : 1);
+  if (index == size_) {
+    emplace_back(std::forward<Args>(args)...);
+    return;
   }
-  for (std::size_t i = size_; i > index; --i) {
-    array[i] = std::move(array[i - 1]);
+  T element(std::forward<Args>(args)...);
+  if constexpr (kRelocatable) {
+    if (size_ == capacity_) relocate(grownCapacity());
+    T* slot = array + index;
+    std::size_t tail = (size_ - index) * sizeof(T);
+    std::memmove(static_cast<void*>(slot + 1), static_cast<const void*>(slot),
+                 tail);
+    try {
+      construct(slot, std::move(element));
+    } catch (...) {
+      std::memmove(static_cast<void*>(slot),
+                   static_cast<const void*>(slot + 1), tail);
+      throw;
+    }
+    ++size_;
+    return;
   }
-  new (&array[index]) T(std::forward<Args>(args)...);
-  ++size_;
+  emplace_back(std::move(array[size_ - 1]));
+  std::move_backward(array + index, array + size_ - 2, array + size_ - 1);
+  array[index] = std::move(element);
 }
 
-template <typename T>
-typename CustomVector<T>::iterator CustomVector<T>::begin() {
+template <typename T, typename Allocator, typename Growth>
+typename CustomVector<T, Allocator, Growth>::iterator
+CustomVector<T, Allocator, Growth>::begin() {
   return iterator(array);
 }
 
-template <typename T>
-typename CustomVector<T>::iterator CustomVector<T>::end() {
+template <typename T, typename Allocator, typename Growth>
+typename CustomVector<T, Allocator, Growth>::iterator
+CustomVector<T, Allocator, Growth>::end() {
   return iterator(array + size_);
 }
 
-template <typename T>
-const typename CustomVector<T>::iterator CustomVector<T>::cbegin() const {
+template <typename T, typename Allocator, typename Growth>
+const typename CustomVector<T, Allocator, Growth>::iterator
+CustomVector<T, Allocator, Growth>::cbegin() const {
   return iterator(array);
 }
 
-template <typename T>
-const typename CustomVector<T>::iterator CustomVector<T>::cend() const {
+template <typename T, typename Allocator, typename Growth>
+const typename CustomVector<T, Allocator, Growth>::iterator
+CustomVector<T, Allocator, Growth>::cend() const {
   return iterator(array + size_);
 }
 
-template <typename T>
-typename CustomVector<T>::iterator CustomVector<T>::rbegin() {
+template <typename T, typename Allocator, typename Growth>
+typename CustomVector<T, Allocator, Growth>::iterator
+CustomVector<T, Allocator, Growth>::rbegin() {
   return iterator(array + size_ - 1);
 }
 
-template <typename T>
-typename CustomVector<T>::iterator CustomVector<T>::rend() {
+template <typename T, typename Allocator, typename Growth>
+typename CustomVector<T, Allocator, Growth>::iterator
+CustomVector<T, Allocator, Growth>::rend() {
   return iterator(array - 1);
 }
 
-template <typename T>
-const typename CustomVector<T>::iterator CustomVector<T>::crbegin() const {
+template <typename T, typename Allocator, typename Growth>
+const typename CustomVector<T, Allocator, Growth>::iterator
+CustomVector<T, Allocator, Growth>::crbegin() const {
   return iterator(array + size_ - 1);
 }
 
-template <typename T>
-const typename CustomVector<T>::iterator CustomVector<T>::crend() const {
+template <typename T, typename Allocator, typename Growth>
+const typename CustomVector<T, Allocator, Growth>::iterator
+CustomVector<T, Allocator, Growth>::crend() const {
   return iterator(array - 1);
 }
 
-template <typename T>
-typename CustomVector<T>::size_type CustomVector<T>::max_size() const {
+template <typename T, typename Allocator, typename Growth>
+typename CustomVector<T, Allocator, Growth>::size_type
+CustomVector<T, Allocator, Growth>::max_size() const {
   return std::numeric_limits<std::size_t>::max() / sizeof(T);
 }
 
-template <typename T>
-void CustomVector<T>::shrink_to_fit() const {
-  if (size_ < capacity_) {
-    T* newArray = new T[size_];
-    for (std::size_t i = 0; i < size_; i++) {
-      newArray[i] = std::move(array[i]);
-    }
-    delete[] array;
-    array = newArray;
-    this->capacity_ = this->size_;
+template <typename T, typename Allocator, typename Growth>
+void CustomVector<T, Allocator, Growth>::shrink_to_fit() {
+  if (!inlineArray_ && size_ < capacity_) {
+    relocate(size_);
   }
 }
-template <typename T>
-typename CustomVector<T>::iterator CustomVector<T>::insert(
-    iterator pos, const_reference value) {
-  size_t index = pos - begin();
-  if (size_ == capacity_) {
-    size_t newCapacity = capacity_ > 0 ? capacity_ * 2 : 1;
-    reallocate(newCapacity);
-  }
-  for (size_t i = size_; i > index; --i) {
-    array[i] = std::move(array[i - 1]);
-  }
-  array[index] = value;
-  ++size_;
-  return iterator(&array[index]);
+template <typename T, typename Allocator, typename Growth>
+typename CustomVector<T, Allocator, Growth>::iterator
+CustomVector<T, Allocator, Growth>::insert(iterator pos,
+                                           const_reference value) {
+  size_type index = static_cast<size_type>(&*pos - array);
+  emplace(index, value);
+  return iterator(array + index);
 }
 
 #endif  // INCLUDE_CUSTOM_VECTOR_H_
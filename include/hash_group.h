@@ -0,0 +1,192 @@
+#ifndef SRC_HASH_GROUP_H
+#define SRC_HASH_GROUP_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Control bytes of an open-addressing table, one per slot. A full slot
+// stores the low seven bits of its hash (H2), so a group of them can be
+// compared against a key's H2 in one instruction; the other states have the
+// sign bit set.
+struct HashCtrl {
+  static constexpr std::int8_t kEmpty = -128;  // 0b10000000
+  static constexpr std::int8_t kDeleted = -2;  // 0b11111110
+  static constexpr std::int8_t kSentinel = -1;  // 0b11111111, ends iteration
+
+  static bool isFull(std::int8_t ctrl) { return ctrl >= 0; }
+  static bool isEmptyOrDeleted(std::int8_t ctrl) { return ctrl < kSentinel; }
+};
+
+inline unsigned HashCountTrailingZeros(std::uint64_t value) {
+#if defined(__GNUC__)
+  return static_cast<unsigned>(__builtin_ctzll(value));
+#else
+  unsigned count = 0;
+  while ((value & 1) == 0) {
+    value >>= 1;
+    ++count;
+  }
+  return count;
+#endif
+}
+
+inline unsigned HashCountLeadingZeros(std::uint64_t value) {
+#if defined(__GNUC__)
+  return static_cast<unsigned>(__builtin_clzll(value));
+#else
+  unsigned count = 0;
+  while ((value & (std::uint64_t{1} << 63)) == 0) {
+    value <<= 1;
+    ++count;
+  }
+  return count;
+#endif
+}
+
+// Set of matching slots in a group, one bit (Shift == 0) or one byte
+// (Shift == 3) per slot. Iterating yields slot indices in ascending order.
+template <std::size_t Width, unsigned Shift>
+class HashBitMask {
+ public:
+  explicit HashBitMask(std::uint64_t bits) : mask(bits) {}
+
+  explicit operator bool() const { return mask != 0; }
+  std::size_t lowest() const { return HashCountTrailingZeros(mask) >> Shift; }
+  // Number of unmatched slots before the first match, from either end.
+  std::size_t trailingZeros() const {
+    return HashCountTrailingZeros(mask) >> Shift;
+  }
+  std::size_t leadingZeros() const {
+    constexpr unsigned kUnused = 64 - (Width << Shift);
+    return HashCountLeadingZeros(mask << kUnused) >> Shift;
+  }
+
+  HashBitMask& operator++() {
+    mask &= mask - 1;
+    return *this;
+  }
+  std::size_t operator*() const { return lowest(); }
+  HashBitMask begin() const { return *this; }
+  HashBitMask end() const { return HashBitMask(0); }
+  bool operator!=(const HashBitMask& other) const {
+    return mask != other.mask;
+  }
+
+ private:
+  std::uint64_t mask;
+};
+
+#if defined(__SSE2__)
+// Sixteen control bytes compared with SSE2 and reduced with movemask.
+class HashGroupSse2 {
+ public:
+  static constexpr std::size_t kWidth = 16;
+  using Mask = HashBitMask<kWidth, 0>;
+
+  explicit HashGroupSse2(const std::int8_t* pos)
+      : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+  Mask match(std::int8_t h2) const {
+    return toMask(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+  }
+  Mask matchEmpty() const {
+    return toMask(_mm_cmpeq_epi8(_mm_set1_epi8(HashCtrl::kEmpty), ctrl));
+  }
+  Mask matchEmptyOrDeleted() const {
+    return toMask(_mm_cmpgt_epi8(_mm_set1_epi8(HashCtrl::kSentinel), ctrl));
+  }
+
+ private:
+  static Mask toMask(__m128i bytes) {
+    return Mask(static_cast<std::uint16_t>(_mm_movemask_epi8(bytes)));
+  }
+
+  __m128i ctrl;
+};
+#endif
+
+#if defined(__AVX2__)
+// Thirty-two control bytes per compare, for builds with -mavx2.
+class HashGroupAvx2 {
+ public:
+  static constexpr std::size_t kWidth = 32;
+  using Mask = HashBitMask<kWidth, 0>;
+
+  explicit HashGroupAvx2(const std::int8_t* pos)
+      : ctrl(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos))) {}
+
+  Mask match(std::int8_t h2) const {
+    return toMask(_mm256_cmpeq_epi8(_mm256_set1_epi8(h2), ctrl));
+  }
+  Mask matchEmpty() const {
+    return toMask(_mm256_cmpeq_epi8(_mm256_set1_epi8(HashCtrl::kEmpty), ctrl));
+  }
+  Mask matchEmptyOrDeleted() const {
+    return toMask(
+        _mm256_cmpgt_epi8(_mm256_set1_epi8(HashCtrl::kSentinel), ctrl));
+  }
+
+ private:
+  static Mask toMask(__m256i bytes) {
+    return Mask(static_cast<std::uint32_t>(_mm256_movemask_epi8(bytes)));
+  }
+
+  __m256i ctrl;
+};
+#endif
+
+// Eight control bytes handled as one 64-bit word. match() may report a
+// false positive right after a real match; callers compare keys anyway.
+class HashGroupPortable {
+ public:
+  static constexpr std::size_t kWidth = 8;
+  using Mask = HashBitMask<kWidth, 3>;
+
+  explicit HashGroupPortable(const std::int8_t* pos) : ctrl(0) {
+    for (std::size_t i = 0; i < kWidth; ++i) {
+      ctrl |= std::uint64_t{static_cast<std::uint8_t>(pos[i])} << (8 * i);
+    }
+  }
+
+  Mask match(std::int8_t h2) const {
+    std::uint64_t x = ctrl ^ (kLsbs * static_cast<std::uint8_t>(h2));
+    return Mask((x - kLsbs) & ~x & kMsbs);
+  }
+  Mask matchEmpty() const { return Mask(ctrl & ~(ctrl << 6) & kMsbs); }
+  Mask matchEmptyOrDeleted() const {
+    return Mask(ctrl & ~(ctrl << 7) & kMsbs);
+  }
+
+ private:
+  static constexpr std::uint64_t kLsbs = 0x0101010101010101ULL;
+  static constexpr std::uint64_t kMsbs = 0x8080808080808080ULL;
+
+  std::uint64_t ctrl;
+};
+
+#if defined(__AVX2__)
+using HashGroup = HashGroupAvx2;
+#elif defined(__SSE2__)
+using HashGroup = HashGroupSse2;
+#else
+using HashGroup = HashGroupPortable;
+#endif
+
+// Spreads the bits of a hash so that identity hashes such as
+// std::hash<int> still fill both H1 and H2 (the murmur3 finalizer).
+inline std::uint64_t HashMix(std::uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+#endif  // SRC_HASH_GROUP_H
@@ -0,0 +1,238 @@
+#ifndef INCLUDE_NODE_POOL_H_
+#define INCLUDE_NODE_POOL_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+// Slab allocator for node-based containers. Nodes are carved out of large
+// chunks, freed nodes are recycled through an intrusive free list and the
+// whole pool can be dropped in O(chunks) with release().
+//
+// Copies of a pool share its memory and compare equal, so a node can be
+// freed through any of them and a container can relink nodes between trees
+// that hold copies of one pool. The memory goes back when the last copy is
+// destroyed, or at once for all copies with release(). A pool that has not
+// allocated yet has nothing to share: its copies start out on their own.
+// The copies count their users without atomics and share one free list, so
+// they all have to be used from one thread. Containers keep one pool per
+// instance (select_on_container_copy_construction gives a new one) and
+// move it together with their nodes.
+template <typename T, std::size_t MaxChunkSlots = 65536>
+class NodePool {
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  template <typename U>
+  struct rebind {
+    using other = NodePool<U, MaxChunkSlots>;
+  };
+
+  NodePool() noexcept;
+  NodePool(const NodePool& other) noexcept;
+  template <typename U>
+  NodePool(const NodePool<U, MaxChunkSlots>& other) noexcept;
+  NodePool(NodePool&& other) noexcept;
+  ~NodePool();
+
+  NodePool& operator=(const NodePool& other) noexcept;
+  NodePool& operator=(NodePool&& other) noexcept;
+
+  T* allocate(size_type n);
+  void deallocate(T* ptr, size_type n) noexcept;
+  void release() noexcept;
+  NodePool select_on_container_copy_construction() const noexcept;
+
+  // The copies sharing this pool, this one included; 0 before the first
+  // allocation.
+  size_type use_count() const noexcept;
+  size_type chunk_count() const noexcept;
+  size_type reserved_bytes() const noexcept;
+
+  bool operator==(const NodePool& other) const noexcept;
+  bool operator!=(const NodePool& other) const noexcept;
+
+ private:
+  union Slot {
+    Slot* next;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+  struct Chunk {
+    Chunk* next;
+    size_type slots;
+  };
+  // What the copies of a pool share, created by its first allocation.
+  struct Shared {
+    Chunk* chunks;
+    Slot* freeList;
+    Slot* cursor;
+    Slot* cursorEnd;
+    size_type chunkCount;
+    size_type reservedBytes;
+    size_type users;
+  };
+
+  static constexpr size_type kFirstChunkSlots = 32;
+  static constexpr size_type kHeaderBytes =
+      (sizeof(Chunk) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+
+  Shared* shared;
+
+  void grow();
+  void leave() noexcept;
+};
+
+template <typename T, std::size_t MaxChunkSlots>
+NodePool<T, MaxChunkSlots>::NodePool() noexcept : shared(nullptr) {}
+template <typename T, std::size_t MaxChunkSlots>
+NodePool<T, MaxChunkSlots>::NodePool(const NodePool& other) noexcept
+    : shared(other.shared) {
+  if (shared != nullptr) ++shared->users;
+}
+// Nodes of another type need slots of another size, so a rebound copy gets
+// a pool of its own.
+template <typename T, std::size_t MaxChunkSlots>
+template <typename U>
+NodePool<T, MaxChunkSlots>::NodePool(
+    const NodePool<U, MaxChunkSlots>&) noexcept
+    : NodePool() {}
+template <typename T, std::size_t MaxChunkSlots>
+NodePool<T, MaxChunkSlots>::NodePool(NodePool&& other) noexcept
+    : shared(other.shared) {
+  other.shared = nullptr;
+}
+template <typename T, std::size_t MaxChunkSlots>
+NodePool<T, MaxChunkSlots>::~NodePool() {
+  leave();
+}
+template <typename T, std::size_t MaxChunkSlots>
+NodePool<T, MaxChunkSlots>& NodePool<T, MaxChunkSlots>::operator=(
+    const NodePool& other) noexcept {
+  if (shared != other.shared) {
+    leave();
+    shared = other.shared;
+    if (shared != nullptr) ++shared->users;
+  }
+  return *this;
+}
+template <typename T, std::size_t MaxChunkSlots>
+NodePool<T, MaxChunkSlots>& NodePool<T, MaxChunkSlots>::operator=(
+    NodePool&& other) noexcept {
+  if (this != &other) {
+    leave();
+    shared = other.shared;
+    other.shared = nullptr;
+  }
+  return *this;
+}
+
+template <typename T, std::size_t MaxChunkSlots>
+T* NodePool<T, MaxChunkSlots>::allocate(size_type n) {
+  if (n != 1) {
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+  if (shared == nullptr) {
+    shared = new Shared{nullptr, nullptr, nullptr, nullptr, 0, 0, 1};
+  }
+  Slot* slot = shared->freeList;
+  if (slot != nullptr) {
+    shared->freeList = slot->next;
+  } else {
+    if (shared->cursor == shared->cursorEnd) {
+      grow();
+    }
+    slot = shared->cursor++;
+  }
+  return reinterpret_cast<T*>(slot->storage);
+}
+
+template <typename T, std::size_t MaxChunkSlots>
+void NodePool<T, MaxChunkSlots>::deallocate(T* ptr, size_type n) noexcept {
+  if (n != 1) {
+    ::operator delete(ptr);
+    return;
+  }
+  Slot* slot = reinterpret_cast<Slot*>(ptr);
+  slot->next = shared->freeList;
+  shared->freeList = slot;
+}
+
+template <typename T, std::size_t MaxChunkSlots>
+void NodePool<T, MaxChunkSlots>::release() noexcept {
+  if (shared == nullptr) return;
+  while (shared->chunks != nullptr) {
+    Chunk* next = shared->chunks->next;
+    ::operator delete(shared->chunks);
+    shared->chunks = next;
+  }
+  shared->freeList = nullptr;
+  shared->cursor = nullptr;
+  shared->cursorEnd = nullptr;
+  shared->chunkCount = 0;
+  shared->reservedBytes = 0;
+}
+
+template <typename T, std::size_t MaxChunkSlots>
+void NodePool<T, MaxChunkSlots>::leave() noexcept {
+  if (shared == nullptr) return;
+  if (--shared->users == 0) {
+    release();
+    delete shared;
+  }
+  shared = nullptr;
+}
+
+template <typename T, std::size_t MaxChunkSlots>
+void NodePool<T, MaxChunkSlots>::grow() {
+  Chunk* chunks = shared->chunks;
+  size_type slots = chunks == nullptr ? kFirstChunkSlots : chunks->slots * 2;
+  if (slots > MaxChunkSlots) {
+    slots = MaxChunkSlots;
+  }
+  size_type bytes = kHeaderBytes + slots * sizeof(Slot);
+  Chunk* chunk = static_cast<Chunk*>(::operator new(bytes));
+  chunk->next = chunks;
+  chunk->slots = slots;
+  shared->chunks = chunk;
+  shared->cursor = reinterpret_cast<Slot*>(
+      reinterpret_cast<unsigned char*>(chunk) + kHeaderBytes);
+  shared->cursorEnd = shared->cursor + slots;
+  ++shared->chunkCount;
+  shared->reservedBytes += bytes;
+}
+
+template <typename T, std::size_t MaxChunkSlots>
+NodePool<T, MaxChunkSlots>
+NodePool<T, MaxChunkSlots>::select_on_container_copy_construction()
+    const noexcept {
+  return NodePool();
+}
+template <typename T, std::size_t MaxChunkSlots>
+std::size_t NodePool<T, MaxChunkSlots>::use_count() const noexcept {
+  return shared == nullptr ? 0 : shared->users;
+}
+template <typename T, std::size_t MaxChunkSlots>
+std::size_t NodePool<T, MaxChunkSlots>::chunk_count() const noexcept {
+  return shared == nullptr ? 0 : shared->chunkCount;
+}
+template <typename T, std::size_t MaxChunkSlots>
+std::size_t NodePool<T, MaxChunkSlots>::reserved_bytes() const noexcept {
+  return shared == nullptr ? 0 : shared->reservedBytes;
+}
+template <typename T, std::size_t MaxChunkSlots>
+bool NodePool<T, MaxChunkSlots>::operator==(
+    const NodePool& other) const noexcept {
+  return shared == nullptr ? this == &other : shared == other.shared;
+}
+template <typename T, std::size_t MaxChunkSlots>
+bool NodePool<T, MaxChunkSlots>::operator!=(
+    const NodePool& other) const noexcept {
+  return !(*this == other);
+}
+
+#endif  // INCLUDE_NODE_POOL_H_
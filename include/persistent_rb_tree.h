@@ -0,0 +1,1074 @@
+#ifndef SRC_PERSISTENT_RB_TREE_H
+#define SRC_PERSISTENT_RB_TREE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "b_tree.h"
+#include "rb_tree.h"
+
+// Node of a PersistentRBTree. There is no parent pointer, since a node
+// shared between versions has a different parent in each of them; refs
+// counts the links to it from parent nodes and from the roots of versions.
+template <typename ValueType>
+struct PersistentRBTreeNode {
+  template <typename... Args>
+  explicit PersistentRBTreeNode(std::in_place_t, Args&&... args)
+      : value(std::forward<Args>(args)...),
+        left(nullptr),
+        right(nullptr),
+        refs(1),
+        color(RED) {}
+  // Links to the same children; the caller adds the references for them.
+  PersistentRBTreeNode(const PersistentRBTreeNode& other)
+      : value(other.value),
+        left(other.left),
+        right(other.right),
+        refs(1),
+        color(other.color) {}
+
+  ValueType value;
+  PersistentRBTreeNode* left;
+  PersistentRBTreeNode* right;
+  std::atomic<std::uint32_t> refs;
+  bool color;
+};
+
+// Red-black tree whose versions share structure: snapshot() and the copy
+// constructor take O(1), and a later insert or erase copies only the nodes
+// on its path that are still shared, O(log n) per update, while unchanged
+// subtrees stay shared. A node is freed with the last version that links
+// to it. Map uses it through PersistentRBTreeBackend.
+//
+// A node is changed in place only when the tree holds the one reference to
+// it and to every node above it. Lookups that hand out a Position copy the
+// shared part of the path first, so a Position always refers to a node of
+// this version alone and its value may be modified. Taking a snapshot or a
+// copy makes the nodes shared again and so invalidates every Position;
+// inserts and erases leave the others valid, as in RBTree. A Position also
+// refers to the tree object, so moving or swapping the tree invalidates it.
+//
+// Without parent pointers, findNext and findPrev descend from the root
+// when the neighbour is an ancestor, O(log n) per step. Snapshots iterate
+// with a stack instead.
+//
+// One thread writes the tree and takes its snapshots. Other threads may
+// read the snapshots and drop them while the writer goes on; the reference
+// counts are atomic and all versions share one allocator, which then has
+// to be safe to call from several threads. std::allocator, the default, is;
+// NodePool is not, so with it snapshots must be dropped on the writer's
+// thread.
+//
+// Keys are unique and read from the values through KeyOfValue, one of
+// RBTreeIdentityKey and RBTreeFirstKey. Node handles are not supported;
+// NodeHandle only names a type for Map.
+template <typename KeyType, typename ValueType,
+          typename Allocator = std::allocator<ValueType>,
+          bool UniqueKeys = true, typename KeyOfValue = RBTreeFirstKey,
+          typename Compare = std::less<KeyType>>
+class PersistentRBTree {
+  static_assert(UniqueKeys, "PersistentRBTree holds unique keys only");
+  static_assert(!KeyOfValue::kStoresKey,
+                "PersistentRBTree reads the keys from the values");
+
+ public:
+  using Node = PersistentRBTreeNode<ValueType>;
+  struct Position {
+    Node* node = nullptr;
+    PersistentRBTree* tree = nullptr;
+
+    bool operator==(const Position& other) const {
+      return node == other.node;
+    }
+    bool operator!=(const Position& other) const {
+      return node != other.node;
+    }
+  };
+  using InsertResult = std::pair<Position, bool>;
+  using NodeHandle = BTreeNodeHandle<KeyType, ValueType, KeyOfValue>;
+  using key_type = KeyType;
+  using value_type = ValueType;
+  using allocator_type = Allocator;
+  using key_compare = Compare;
+  class Snapshot;
+
+  PersistentRBTree();
+  explicit PersistentRBTree(const Allocator& alloc);
+  // Shares every node with `other` in O(1).
+  PersistentRBTree(const PersistentRBTree& other);
+  PersistentRBTree(PersistentRBTree&& other) noexcept;
+  ~PersistentRBTree();
+
+  PersistentRBTree& operator=(const PersistentRBTree& other);
+  PersistentRBTree& operator=(PersistentRBTree&& other) noexcept;
+
+  // As in RBTree, except that hints are ignored: every insert descends
+  // from the root, since that is where shared nodes have to be copied.
+  InsertResult insert(const KeyType& key, const ValueType& value);
+  InsertResult insertWithHint(Position hint, const KeyType& key,
+                              const ValueType& value);
+  template <typename... Args>
+  InsertResult emplace(const KeyType& key, Args&&... args);
+  template <typename... Args>
+  InsertResult emplaceWithHint(Position hint, const KeyType& key,
+                               Args&&... args);
+  template <typename... Args>
+  InsertResult emplaceValue(Args&&... args);
+  template <typename... Args>
+  InsertResult emplaceValueWithHint(Position hint, Args&&... args);
+  template <typename ForwardIt, typename GetKey>
+  void buildFromSorted(ForwardIt first, ForwardIt last, GetKey keyOf);
+  void removeNode(Position position);
+  void clear();
+  int size() const;
+
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  bool contains(const K& key) const;
+  bool contains(const KeyType& key) const { return contains<KeyType>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  Position find(const K& key);
+  Position find(const KeyType& key) { return find<KeyType>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  Position lowerBound(const K& key);
+  Position lowerBound(const KeyType& key) { return lowerBound<KeyType>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  Position upperBound(const K& key);
+  Position upperBound(const KeyType& key) { return upperBound<KeyType>(key); }
+  Position minimum();
+  Position maximum();
+  static Position findNext(Position position);
+  static Position findPrev(Position position);
+  static ValueType& valueOf(Position position) {
+    return position.node->value;
+  }
+  Compare keyComp() const { return compare; }
+
+  // The tree as it is now, in O(1).
+  Snapshot snapshot() const;
+
+ private:
+  using NodeAllocator = typename std::allocator_traits<
+      Allocator>::template rebind_alloc<Node>;
+  using NodeTraits = std::allocator_traits<NodeAllocator>;
+
+  // Red-black heights stay below 2 log2(n + 1), and size() is an int.
+  static constexpr int kMaxDepth = 64;
+
+  std::shared_ptr<NodeAllocator> allocator;
+  Compare compare;
+  Node* root;
+  int treeSize;
+
+  static const KeyType& nodeKey(const Node* node) {
+    return KeyOfValue::get(node->value);
+  }
+  static bool isBlack(const Node* node) {
+    return node == nullptr || node->color == BLACK;
+  }
+  static Node*& child(Node* node, bool left) {
+    return left ? node->left : node->right;
+  }
+  static void retain(Node* node);
+  static void release(Node* node, NodeAllocator& allocator);
+  template <typename... Args>
+  Node* createNode(Args&&... args);
+  void destroyNode(Node* node);
+  // Makes the node `link` points to exclusive to this version, copying it
+  // if it is shared, and returns it. The node holding `link` must already
+  // be exclusive (or `link` is the root).
+  Node* own(Node*& link);
+  // Owns the path down to `node`, which must be in the tree; returns the
+  // exclusive node for its key.
+  Node* unshare(const Node* node);
+  Position positionOf(Node* node) { return Position{node, this}; }
+
+  template <typename K>
+  Node* findNode(const K& key) const;
+  // Upper ? first key greater than `key` : first key not less than `key`.
+  template <bool Upper, typename K>
+  Node* boundNode(const K& key) const;
+
+  template <typename Make>
+  InsertResult insertWith(const KeyType& key, Make make);
+  void fixInsert(Node** path, int depth);
+  void eraseAt(const KeyType& key);
+  void fixErase(Node** path, int index, bool isLeft);
+  // Rotates the subtree at `node` so that it moves down to the left
+  // (left == true) or right, and returns the new top. Both nodes must be
+  // exclusive; the links move, so no reference count changes.
+  static Node* rotate(Node* node, bool left);
+  void replaceChild(Node* parent, Node* node, Node* replacement);
+  static int redDepthFor(std::size_t count);
+  template <typename ForwardIt, typename GetKey>
+  Node* buildSubtree(ForwardIt& it, ForwardIt last, GetKey& keyOf,
+                     std::size_t count, int depth, int redDepth);
+};
+
+// A read-only version of a PersistentRBTree. It holds a reference to the
+// root it was taken from, so writes to the tree after snapshot() do not
+// show in it, and its nodes live as long as it does. Iterators keep their
+// path on a stack, so a full walk takes O(n).
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+class PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                       Compare>::Snapshot {
+ public:
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = ValueType;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const ValueType*;
+    using reference = const ValueType&;
+
+    const_iterator() = default;
+
+    reference operator*() const { return path.back()->value; }
+    pointer operator->() const { return &path.back()->value; }
+    const_iterator& operator++() {
+      const Node* node = path.back();
+      path.pop_back();
+      descendLeft(node->right);
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator temp = *this;
+      ++(*this);
+      return temp;
+    }
+    bool operator==(const const_iterator& other) const {
+      return current() == other.current();
+    }
+    bool operator!=(const const_iterator& other) const {
+      return current() != other.current();
+    }
+
+   private:
+    friend Snapshot;
+
+    const Node* current() const {
+      return path.empty() ? nullptr : path.back();
+    }
+    void descendLeft(const Node* node) {
+      for (; node != nullptr; node = node->left) path.push_back(node);
+    }
+
+    // The current node on top of the ancestors still to be visited.
+    std::vector<const Node*> path;
+  };
+  using iterator = const_iterator;
+  using key_type = KeyType;
+  using value_type = ValueType;
+  using size_type = std::size_t;
+
+  Snapshot() : root(nullptr), count(0) {}
+  Snapshot(const Snapshot& other)
+      : allocator(other.allocator),
+        compare(other.compare),
+        root(other.root),
+        count(other.count) {
+    retain(root);
+  }
+  Snapshot(Snapshot&& other) noexcept
+      : allocator(std::move(other.allocator)),
+        compare(other.compare),
+        root(other.root),
+        count(other.count) {
+    other.root = nullptr;
+    other.count = 0;
+  }
+  ~Snapshot() {
+    if (root != nullptr) release(root, *allocator);
+  }
+  Snapshot& operator=(Snapshot other) noexcept {
+    std::swap(allocator, other.allocator);
+    std::swap(compare, other.compare);
+    std::swap(root, other.root);
+    std::swap(count, other.count);
+    return *this;
+  }
+
+  size_type size() const { return count; }
+  bool empty() const { return count == 0; }
+  const_iterator begin() const {
+    const_iterator it;
+    it.descendLeft(root);
+    return it;
+  }
+  const_iterator end() const { return const_iterator(); }
+
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  bool contains(const K& key) const {
+    return find(key) != end();
+  }
+  bool contains(const KeyType& key) const { return contains<KeyType>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  const_iterator find(const K& key) const {
+    const_iterator it = lower_bound(key);
+    if (it != end() && compare(key, nodeKey(it.current()))) return end();
+    return it;
+  }
+  const_iterator find(const KeyType& key) const {
+    return find<KeyType>(key);
+  }
+  // The element with `key`; throws std::out_of_range if there is none.
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  const ValueType& at(const K& key) const {
+    const_iterator it = find(key);
+    if (it == end()) throw std::out_of_range("Key not found");
+    return *it;
+  }
+  const ValueType& at(const KeyType& key) const { return at<KeyType>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  const_iterator lower_bound(const K& key) const {
+    return bound<false>(key);
+  }
+  const_iterator lower_bound(const KeyType& key) const {
+    return lower_bound<KeyType>(key);
+  }
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  const_iterator upper_bound(const K& key) const {
+    return bound<true>(key);
+  }
+  const_iterator upper_bound(const KeyType& key) const {
+    return upper_bound<KeyType>(key);
+  }
+
+ private:
+  friend PersistentRBTree;
+
+  Snapshot(std::shared_ptr<NodeAllocator> alloc, const Compare& comp,
+           Node* top, int size)
+      : allocator(std::move(alloc)),
+        compare(comp),
+        root(top),
+        count(static_cast<size_type>(size)) {
+    retain(root);
+  }
+
+  template <bool Upper, typename K>
+  const_iterator bound(const K& key) const {
+    const_iterator it;
+    for (const Node* node = root; node != nullptr;) {
+      bool below = Upper ? compare(key, nodeKey(node))
+                         : !compare(nodeKey(node), key);
+      if (below) {
+        it.path.push_back(node);
+        node = node->left;
+      } else {
+        node = node->right;
+      }
+    }
+    return it;
+  }
+
+  std::shared_ptr<NodeAllocator> allocator;
+  Compare compare;
+  Node* root;
+  size_type count;
+};
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::PersistentRBTree()
+    : PersistentRBTree(Allocator()) {}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::PersistentRBTree(const Allocator& alloc)
+    : allocator(std::make_shared<NodeAllocator>(alloc)),
+      compare(),
+      root(nullptr),
+      treeSize(0) {}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::PersistentRBTree(const PersistentRBTree& other)
+    : allocator(other.allocator),
+      compare(other.compare),
+      root(other.root),
+      treeSize(other.treeSize) {
+  retain(root);
+}
+
+// The moved-from tree keeps sharing the allocator, so it stays usable.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::PersistentRBTree(PersistentRBTree&& other) noexcept
+    : allocator(other.allocator),
+      compare(other.compare),
+      root(other.root),
+      treeSize(other.treeSize) {
+  other.root = nullptr;
+  other.treeSize = 0;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::~PersistentRBTree() {
+  clear();
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>&
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::operator=(const PersistentRBTree& other) {
+  if (this != &other) {
+    retain(other.root);
+    clear();
+    allocator = other.allocator;
+    compare = other.compare;
+    root = other.root;
+    treeSize = other.treeSize;
+  }
+  return *this;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>&
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::operator=(PersistentRBTree&& other) noexcept {
+  if (this != &other) {
+    clear();
+    allocator = other.allocator;
+    compare = other.compare;
+    root = other.root;
+    treeSize = other.treeSize;
+    other.root = nullptr;
+    other.treeSize = 0;
+  }
+  return *this;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+void PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                      Compare>::retain(Node* node) {
+  if (node != nullptr) node->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Drops one reference. The last one frees the node, which then drops its
+// references to the children; the acquire side makes every earlier use of
+// the node by other versions happen before it is freed.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+void PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                      Compare>::release(Node* node,
+                                        NodeAllocator& allocator) {
+  while (node != nullptr &&
+         node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    release(node->left, allocator);
+    Node* right = node->right;
+    NodeTraits::destroy(allocator, node);
+    NodeTraits::deallocate(allocator, node, 1);
+    node = right;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+template <typename... Args>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Node*
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::createNode(Args&&... args) {
+  Node* node = NodeTraits::allocate(*allocator, 1);
+  try {
+    NodeTraits::construct(*allocator, node, std::forward<Args>(args)...);
+  } catch (...) {
+    NodeTraits::deallocate(*allocator, node, 1);
+    throw;
+  }
+  return node;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+void PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                      Compare>::destroyNode(Node* node) {
+  NodeTraits::destroy(*allocator, node);
+  NodeTraits::deallocate(*allocator, node, 1);
+}
+
+// refs == 1 means only `link` refers to the node, and since the node
+// holding `link` belongs to this version alone, so does this one; no other
+// version can add a reference to it meanwhile. A copy takes a reference to
+// each child and gives up the one to the original, which other versions
+// still use.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Node*
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::own(Node*& link) {
+  Node* node = link;
+  if (node->refs.load(std::memory_order_acquire) == 1) return node;
+  Node* copy = createNode(static_cast<const Node&>(*node));
+  retain(copy->left);
+  retain(copy->right);
+  link = copy;
+  release(node, *allocator);
+  return copy;
+}
+
+// Compares before owning each node: owning the last one may free `node`,
+// whose key is the one searched for.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Node*
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::unshare(const Node* node) {
+  if (node == nullptr) return nullptr;
+  const KeyType& key = nodeKey(node);
+  Node** link = &root;
+  while (true) {
+    int order = RBTreeThreeWay(compare, key, nodeKey(*link));
+    Node* current = own(*link);
+    if (order == 0) return current;
+    link = &child(current, order < 0);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+int PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                     Compare>::size() const {
+  return treeSize;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+void PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                      Compare>::clear() {
+  release(root, *allocator);
+  root = nullptr;
+  treeSize = 0;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Snapshot
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::snapshot() const {
+  return Snapshot(allocator, compare, root, treeSize);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::InsertResult
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::insert(const KeyType& key,
+                                  const ValueType& value) {
+  return emplace(key, value);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::InsertResult
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::insertWithHint(Position, const KeyType& key,
+                                          const ValueType& value) {
+  return emplace(key, value);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+template <typename... Args>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::InsertResult
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::emplace(const KeyType& key, Args&&... args) {
+  return insertWith(key, [&] {
+    return createNode(std::in_place, std::forward<Args>(args)...);
+  });
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+template <typename... Args>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::InsertResult
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::emplaceWithHint(Position, const KeyType& key,
+                                           Args&&... args) {
+  return emplace(key, std::forward<Args>(args)...);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+template <typename... Args>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::InsertResult
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::emplaceValue(Args&&... args) {
+  Node* node = createNode(std::in_place, std::forward<Args>(args)...);
+  bool linked = false;
+  InsertResult result;
+  try {
+    result = insertWith(nodeKey(node), [&] {
+      linked = true;
+      return node;
+    });
+  } catch (...) {
+    destroyNode(node);
+    throw;
+  }
+  if (!linked) destroyNode(node);
+  return result;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+template <typename... Args>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::InsertResult
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::emplaceValueWithHint(Position, Args&&... args) {
+  return emplaceValue(std::forward<Args>(args)...);
+}
+
+// Owns the whole search path, since the new node or the match is handed
+// out as a Position; the path array then serves the bottom-up fix.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+template <typename Make>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::InsertResult
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::insertWith(const KeyType& key, Make make) {
+  Node* path[kMaxDepth];
+  int depth = 0;
+  Node** link = &root;
+  while (*link != nullptr) {
+    int order = RBTreeThreeWay(compare, key, nodeKey(*link));
+    Node* node = own(*link);
+    if (order == 0) return InsertResult(positionOf(node), false);
+    path[depth++] = node;
+    link = &child(node, order < 0);
+  }
+  Node* node = make();
+  node->color = RED;
+  *link = node;
+  path[depth] = node;
+  ++treeSize;
+  fixInsert(path, depth);
+  return InsertResult(positionOf(node), true);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+void PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                      Compare>::fixInsert(Node** path, int depth) {
+  while (depth >= 2 && path[depth - 1]->color == RED) {
+    Node* parent = path[depth - 1];
+    Node* grand = path[depth - 2];
+    bool parentLeft = grand->left == parent;
+    Node*& uncle = child(grand, !parentLeft);
+    if (!isBlack(uncle)) {
+      own(uncle)->color = BLACK;
+      parent->color = BLACK;
+      grand->color = RED;
+      depth -= 2;
+      continue;
+    }
+    if (path[depth] == child(parent, !parentLeft)) {
+      parent = rotate(parent, parentLeft);
+      child(grand, parentLeft) = parent;
+    }
+    parent->color = BLACK;
+    grand->color = RED;
+    replaceChild(depth >= 3 ? path[depth - 3] : nullptr, grand,
+                 rotate(grand, !parentLeft));
+    break;
+  }
+  root->color = BLACK;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+void PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                      Compare>::removeNode(Position position) {
+  eraseAt(nodeKey(position.node));
+}
+
+// A node with two children first trades places with its successor, as in
+// RBTree::removeNode; the values never move.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+void PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                      Compare>::eraseAt(const KeyType& key) {
+  Node* path[kMaxDepth];
+  int depth = 0;
+  Node** link = &root;
+  while (true) {
+    if (*link == nullptr) return;
+    int order = RBTreeThreeWay(compare, key, nodeKey(*link));
+    Node* node = own(*link);
+    path[depth++] = node;
+    if (order == 0) break;
+    link = &child(node, order < 0);
+  }
+  int index = depth - 1;
+  Node* target = path[index];
+  if (target->left != nullptr && target->right != nullptr) {
+    link = &target->right;
+    while (true) {
+      Node* node = own(*link);
+      path[depth++] = node;
+      if (node->left == nullptr) break;
+      link = &node->left;
+    }
+    Node* successor = path[depth - 1];
+    if (depth - 1 == index + 1) {
+      target->right = successor->right;
+      successor->right = target;
+    } else {
+      path[depth - 2]->left = target;
+      std::swap(target->right, successor->right);
+    }
+    successor->left = target->left;
+    target->left = nullptr;
+    std::swap(target->color, successor->color);
+    replaceChild(index > 0 ? path[index - 1] : nullptr, target, successor);
+    path[index] = successor;
+    path[depth - 1] = target;
+  }
+
+  Node* parent = depth >= 2 ? path[depth - 2] : nullptr;
+  bool isLeft = parent != nullptr && parent->left == target;
+  Node*& childLink = target->left != nullptr ? target->left : target->right;
+  Node* replacement = childLink == nullptr ? nullptr : own(childLink);
+  replaceChild(parent, target, replacement);
+  bool wasBlack = target->color == BLACK;
+  target->left = nullptr;
+  target->right = nullptr;
+  destroyNode(target);
+  --treeSize;
+  if (!wasBlack) return;
+  if (replacement != nullptr && replacement->color == RED) {
+    replacement->color = BLACK;
+    return;
+  }
+  fixErase(path, depth - 2, isLeft);
+}
+
+// The subtree on side isLeft of path[index] is one black node short.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+void PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                      Compare>::fixErase(Node** path, int index,
+                                         bool isLeft) {
+  while (index >= 0) {
+    Node* parent = path[index];
+    Node* sibling = own(child(parent, !isLeft));
+    if (sibling->color == RED) {
+      sibling->color = BLACK;
+      parent->color = RED;
+      replaceChild(index > 0 ? path[index - 1] : nullptr, parent,
+                   rotate(parent, isLeft));
+      path[index] = sibling;
+      path[++index] = parent;
+      sibling = own(child(parent, !isLeft));
+    }
+    if (isBlack(sibling->left) && isBlack(sibling->right)) {
+      sibling->color = RED;
+      if (parent->color == RED) {
+        parent->color = BLACK;
+        return;
+      }
+      if (--index >= 0) isLeft = path[index]->left == parent;
+      continue;
+    }
+    if (isBlack(child(sibling, !isLeft))) {
+      own(child(sibling, isLeft))->color = BLACK;
+      sibling->color = RED;
+      sibling = rotate(sibling, !isLeft);
+      child(parent, !isLeft) = sibling;
+    }
+    sibling->color = parent->color;
+    parent->color = BLACK;
+    own(child(sibling, !isLeft))->color = BLACK;
+    replaceChild(index > 0 ? path[index - 1] : nullptr, parent,
+                 rotate(parent, isLeft));
+    return;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Node*
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::rotate(Node* node, bool left) {
+  Node* top = child(node, !left);
+  child(node, !left) = child(top, left);
+  child(top, left) = node;
+  return top;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+void PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                      Compare>::replaceChild(Node* parent, Node* node,
+                                             Node* replacement) {
+  if (parent == nullptr) {
+    root = replacement;
+  } else if (parent->left == node) {
+    parent->left = replacement;
+  } else {
+    parent->right = replacement;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+template <typename K, typename>
+bool PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                      Compare>::contains(const K& key) const {
+  return findNode(key) != nullptr;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+template <typename K>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Node*
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::findNode(const K& key) const {
+  Node* current = root;
+  while (current != nullptr) {
+    int order = RBTreeThreeWay(compare, key, nodeKey(current));
+    if (order == 0) return current;
+    current = child(current, order < 0);
+  }
+  return nullptr;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+template <bool Upper, typename K>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Node*
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::boundNode(const K& key) const {
+  Node* bound = nullptr;
+  for (Node* current = root; current != nullptr;) {
+    bool below = Upper ? compare(key, nodeKey(current))
+                       : !compare(nodeKey(current), key);
+    if (below) {
+      bound = current;
+      current = current->left;
+    } else {
+      current = current->right;
+    }
+  }
+  return bound;
+}
+
+// Lookups search without copying anything and then own the path to what
+// they found, so a miss costs nothing.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+template <typename K, typename>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Position
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::find(const K& key) {
+  return positionOf(unshare(findNode(key)));
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+template <typename K, typename>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Position
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::lowerBound(const K& key) {
+  return positionOf(unshare(boundNode<false>(key)));
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+template <typename K, typename>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Position
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::upperBound(const K& key) {
+  return positionOf(unshare(boundNode<true>(key)));
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Position
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::minimum() {
+  if (root == nullptr) return positionOf(nullptr);
+  Node* node = own(root);
+  while (node->left != nullptr) node = own(node->left);
+  return positionOf(node);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Position
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::maximum() {
+  if (root == nullptr) return positionOf(nullptr);
+  Node* node = own(root);
+  while (node->right != nullptr) node = own(node->right);
+  return positionOf(node);
+}
+
+// The successor is either in the right subtree, reached through exclusive
+// nodes only, or an ancestor, which the path to `position` already owns.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Position
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::findNext(Position position) {
+  Node* node = position.node;
+  PersistentRBTree* tree = position.tree;
+  if (node == nullptr) return Position();
+  if (node->right != nullptr) {
+    Node* next = tree->own(node->right);
+    while (next->left != nullptr) next = tree->own(next->left);
+    return tree->positionOf(next);
+  }
+  Node* next = nullptr;
+  for (Node* current = tree->root; current != node;) {
+    if (tree->compare(nodeKey(node), nodeKey(current))) {
+      next = current;
+      current = current->left;
+    } else {
+      current = current->right;
+    }
+  }
+  return tree->positionOf(next);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Position
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::findPrev(Position position) {
+  Node* node = position.node;
+  PersistentRBTree* tree = position.tree;
+  if (node == nullptr) return Position();
+  if (node->left != nullptr) {
+    Node* prev = tree->own(node->left);
+    while (prev->right != nullptr) prev = tree->own(prev->right);
+    return tree->positionOf(prev);
+  }
+  Node* prev = nullptr;
+  for (Node* current = tree->root; current != node;) {
+    if (tree->compare(nodeKey(current), nodeKey(node))) {
+      prev = current;
+      current = current->right;
+    } else {
+      current = current->left;
+    }
+  }
+  return tree->positionOf(prev);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+template <typename ForwardIt, typename GetKey>
+void PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                      Compare>::buildFromSorted(ForwardIt first,
+                                                ForwardIt last,
+                                                GetKey keyOf) {
+  clear();
+  std::size_t count = 0;
+  for (ForwardIt it = first; it != last;) {
+    ForwardIt next = it;
+    ++next;
+    while (next != last && !compare(keyOf(*it), keyOf(*next))) ++next;
+    ++count;
+    it = next;
+  }
+  root = buildSubtree(first, last, keyOf, count, 0, redDepthFor(count));
+  treeSize = static_cast<int>(count);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+template <typename ForwardIt, typename GetKey>
+typename PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                          KeyOfValue, Compare>::Node*
+PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                 Compare>::buildSubtree(ForwardIt& it, ForwardIt last,
+                                        GetKey& keyOf, std::size_t count,
+                                        int depth, int redDepth) {
+  if (count == 0) return nullptr;
+  std::size_t leftCount = (count - 1) / 2;
+  Node* left = buildSubtree(it, last, keyOf, leftCount, depth + 1, redDepth);
+  Node* node;
+  try {
+    node = createNode(std::in_place, *it);
+  } catch (...) {
+    release(left, *allocator);
+    throw;
+  }
+  ++it;
+  while (it != last && !compare(nodeKey(node), keyOf(*it))) ++it;
+  node->color = depth == redDepth ? RED : BLACK;
+  node->left = left;
+  try {
+    node->right = buildSubtree(it, last, keyOf, count - 1 - leftCount,
+                               depth + 1, redDepth);
+  } catch (...) {
+    release(node, *allocator);
+    throw;
+  }
+  return node;
+}
+
+// As RBTree::redDepthFor: the incomplete last level of a tree split at
+// midpoints is coloured red.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool UniqueKeys, typename KeyOfValue, typename Compare>
+int PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys, KeyOfValue,
+                     Compare>::redDepthFor(std::size_t count) {
+  int redDepth = 0;
+  for (std::size_t full = count + 1; full > 1; full >>= 1) {
+    ++redDepth;
+  }
+  return redDepth;
+}
+
+// Backend for Map: Map<Key, T, std::allocator<std::pair<const Key, T>>,
+// PersistentRBTreeBackend> gets snapshot() and O(1) copies.
+struct PersistentRBTreeBackend {
+  template <typename KeyType, typename ValueType, typename Allocator,
+            bool UniqueKeys, typename KeyOfValue,
+            typename Compare = std::less<KeyType>>
+  using tree = PersistentRBTree<KeyType, ValueType, Allocator, UniqueKeys,
+                                KeyOfValue, Compare>;
+};
+
+#endif  // SRC_PERSISTENT_RB_TREE_H
@@ -0,0 +1,61 @@
+#ifndef INCLUDE_PMR_CONTAINERS_H_
+#define INCLUDE_PMR_CONTAINERS_H_
+
+#include <functional>
+#include <memory_resource>
+#include <utility>
+
+#include "custom_hash_map.h"
+#include "custom_hash_set.h"
+#include "custom_list.h"
+#include "custom_map.h"
+#include "custom_multiset.h"
+#include "custom_queue.h"
+#include "custom_set.h"
+#include "custom_stack.h"
+#include "custom_vector.h"
+#include "rb_tree.h"
+
+// The containers on std::pmr::polymorphic_allocator, mirroring std::pmr:
+// pass a std::pmr::memory_resource* (an ArenaResource, say) to the
+// allocator constructor and every allocation of the container goes to it.
+//
+// As in the standard library the allocator never propagates, so a copy
+// constructed without one takes the default resource, and moving between
+// containers on different resources moves the elements one by one.
+namespace pmr {
+
+template <typename T>
+using CustomVector = ::CustomVector<T, std::pmr::polymorphic_allocator<T>>;
+template <typename T>
+using CustomList = ::CustomList<T, std::pmr::polymorphic_allocator<T>>;
+template <typename T>
+using CustomStack = ::CustomStack<T, std::pmr::polymorphic_allocator<T>>;
+template <typename T>
+using CustomQueue = ::CustomQueue<T, std::pmr::polymorphic_allocator<T>>;
+template <typename T>
+using CustomSet = ::CustomSet<T, std::pmr::polymorphic_allocator<T>>;
+
+template <typename Key, typename Value, typename Backend = RBTreeBackend<>,
+          typename Compare = std::less<Key>>
+using Map = ::Map<Key, Value,
+                  std::pmr::polymorphic_allocator<std::pair<const Key, Value>>,
+                  Backend, Compare>;
+template <typename Key, typename Backend = RBTreeBackend<>,
+          typename Compare = std::less<Key>>
+using MultiSet =
+    ::MultiSet<Key, std::pmr::polymorphic_allocator<Key>, Backend, Compare>;
+
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+using HashMap =
+    ::HashMap<Key, Value, Hash, KeyEqual,
+              std::pmr::polymorphic_allocator<std::pair<const Key, Value>>>;
+template <typename T, typename Hash = std::hash<T>,
+          typename KeyEqual = std::equal_to<T>>
+using HashSet =
+    ::HashSet<T, Hash, KeyEqual, std::pmr::polymorphic_allocator<T>>;
+
+}  // namespace pmr
+
+#endif  // INCLUDE_PMR_CONTAINERS_H_
@@ -2,132 +2,963 @@
 #define SRC_RB_TREE_H
 
 #include <cstddef>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "node_pool.h"
 
 #define RED true
 #define BLACK false
 
-template <typename KeyType, typename ValueType>
+// How a tree treats a key that is already present: kUnique keeps the first
+// one, kEqual links a new node after the existing equal keys and kCounted
+// bumps an occurrence counter in the existing node.
+enum class RBTreeKeys { kUnique, kEqual, kCounted };
+
+// Subtree size, stored only in trees built with OrderStatistics. In a
+// kCounted tree it is the number of occurrences, not of nodes.
+template <bool OrderStatistics>
+struct RBTreeNodeSize {};
+template <>
+struct RBTreeNodeSize<true> {
+  std::size_t size = 1;
+};
+
+// Occurrence counter, stored only in kCounted trees.
+template <bool Counted>
+struct RBTreeNodeCount {};
+template <>
+struct RBTreeNodeCount<true> {
+  std::size_t count = 1;
+};
+
+// Key extractors: where a tree finds the key of an element. RBTreeStoredKey
+// keeps a copy of the key in every node next to the value. The other two
+// read it from the value, so the node holds the key only once:
+// RBTreeIdentityKey for sets (the value is the key) and RBTreeFirstKey for
+// maps (the value is a std::pair<const Key, T>).
+struct RBTreeStoredKey {
+  static constexpr bool kStoresKey = true;
+};
+struct RBTreeIdentityKey {
+  static constexpr bool kStoresKey = false;
+  template <typename ValueType>
+  static const ValueType& get(const ValueType& value) {
+    return value;
+  }
+};
+struct RBTreeFirstKey {
+  static constexpr bool kStoresKey = false;
+  template <typename ValueType>
+  static const typename ValueType::first_type& get(const ValueType& value) {
+    return value.first;
+  }
+};
+
+// Separate key, present only in trees that use RBTreeStoredKey.
+template <typename KeyType, bool Stored>
+struct RBTreeNodeKey {
+  RBTreeNodeKey() = default;
+  explicit RBTreeNodeKey(const KeyType&) {}
+};
+template <typename KeyType>
+struct RBTreeNodeKey<KeyType, true> {
+  explicit RBTreeNodeKey(const KeyType& k) : key(k) {}
+  KeyType key;
+};
+
+template <typename KeyType, typename ValueType, bool OrderStatistics = false,
+          bool Counted = false, bool StoresKey = true>
+struct RBTreeNode : RBTreeNodeKey<KeyType, StoresKey>,
+                    RBTreeNodeSize<OrderStatistics>,
+                    RBTreeNodeCount<Counted> {
+  ValueType value;
+  RBTreeNode* left;
+  RBTreeNode* right;
+  RBTreeNode* parent;
+  bool color;
+
+  // The value is built in place from args. The key is copied before the
+  // value is built, so args may move from the object `k` refers to. Without
+  // a stored key the key argument is left out.
+  template <typename... Args>
+  RBTreeNode(const KeyType& k, std::in_place_t, Args&&... args)
+      : RBTreeNodeKey<KeyType, StoresKey>(k),
+        value(std::forward<Args>(args)...),
+        left(nullptr),
+        right(nullptr),
+        parent(nullptr),
+        color(RED) {}
+  template <typename... Args>
+  explicit RBTreeNode(std::in_place_t, Args&&... args)
+      : value(std::forward<Args>(args)...),
+        left(nullptr),
+        right(nullptr),
+        parent(nullptr),
+        color(RED) {}
+};
+
+// Set operations that RBTree::combine applies to a tree in place. Each key
+// ends up with as many occurrences as the operation gives for its counts in
+// the two trees: the larger one, the smaller one, the first minus the
+// second, or the difference either way.
+enum class RBTreeSetOp {
+  kUnion,
+  kIntersection,
+  kDifference,
+  kSymmetricDifference
+};
+
+inline std::size_t RBTreeCombinedCount(RBTreeSetOp op, std::size_t own,
+                                       std::size_t other) {
+  switch (op) {
+    case RBTreeSetOp::kUnion:
+      return own > other ? own : other;
+    case RBTreeSetOp::kIntersection:
+      return own < other ? own : other;
+    case RBTreeSetOp::kDifference:
+      return own > other ? own - other : 0;
+    default:
+      return own > other ? own - other : other - own;
+  }
+}
+
+// Whether `searches` lookups in a tree of `size` elements, O(m log n), beat
+// one ordered walk over both, O(n + m), counting a step of the walk as four
+// comparisons. Operations between trees of very different sizes pick the
+// lookups.
+inline bool RBTreeSearchEach(std::size_t searches, std::size_t size) {
+  std::size_t depth = 1;
+  for (std::size_t rest = size; rest > 1; rest >>= 1) ++depth;
+  return searches * depth < 4 * size;
+}
+
+// Whether RBTree::mergeFrom should merge `incoming` elements into a tree of
+// `size` in one ordered walk rather than by a lookup each. The walk touches
+// every node of both trees and only wins while they fit in cache together:
+// with shuffled keys, merging 8K nodes into 8K took 102 ns per element by
+// walk against 182 by lookups, 16K into 16K 322 against 258, and 1M into
+// 1M 1490 against 586 (std::allocator, std::string values).
+inline bool RBTreeMergeLinear(std::size_t incoming, std::size_t size) {
+  constexpr std::size_t kMaxNodes = 16384;
+  return size + incoming <= kMaxNodes && incoming * 2 >= size;
+}
+
+// Compare is transparent when it declares is_transparent, as std::less<>
+// does. Lookups then accept any key type it can compare with KeyType, e.g. a
+// std::string_view for std::string keys, without building a KeyType first.
+template <typename Compare, typename = void>
+struct RBTreeIsTransparent : std::false_type {};
+template <typename Compare>
+struct RBTreeIsTransparent<Compare,
+                           std::void_t<typename Compare::is_transparent>>
+    : std::true_type {};
+// Enables a lookup member template for K: always for the container's own
+// key type, for other types only with a transparent Compare.
+template <typename Compare, typename K, typename KeyType>
+using RBTreeLookup =
+    std::enable_if_t<std::is_same<K, KeyType>::value ||
+                     RBTreeIsTransparent<Compare>::value>;
+
+// Detects a three-way member compare(lhs, rhs) on a comparator, and on a
+// key type a member lhs.compare(rhs) such as std::string's.
+template <typename Compare, typename L, typename R, typename = void>
+struct RBTreeHasThreeWay : std::false_type {};
+template <typename Compare, typename L, typename R>
+struct RBTreeHasThreeWay<
+    Compare, L, R,
+    std::void_t<decltype(std::declval<const Compare&>().compare(
+        std::declval<const L&>(), std::declval<const R&>()))>>
+    : std::true_type {};
+template <typename L, typename R, typename = void>
+struct RBTreeKeyHasThreeWay : std::false_type {};
+template <typename L, typename R>
+struct RBTreeKeyHasThreeWay<
+    L, R,
+    std::void_t<decltype(std::declval<const L&>().compare(
+        std::declval<const R&>()))>> : std::true_type {};
+template <typename Compare>
+struct RBTreeIsStdLess : std::false_type {};
+template <typename T>
+struct RBTreeIsStdLess<std::less<T>> : std::true_type {};
+
+// Orders lhs against rhs in one call: negative, zero or positive as lhs
+// sorts before, together with or after rhs. Descents that must tell a match
+// from "go right" use it to compare once per node instead of twice.
+// A comparator supplies it as an int compare(lhs, rhs) member that agrees
+// with its operator(). Under std::less the key's own compare member is used
+// (std::string, std::string_view). Anything else falls back to Compare
+// called both ways.
+template <typename Compare, typename L, typename R>
+int RBTreeThreeWay(const Compare& compare, const L& lhs, const R& rhs) {
+  if constexpr (RBTreeHasThreeWay<Compare, L, R>::value) {
+    return compare.compare(lhs, rhs);
+  } else if constexpr (RBTreeIsStdLess<Compare>::value &&
+                       RBTreeKeyHasThreeWay<L, R>::value) {
+    return lhs.compare(rhs);
+  } else {
+    return compare(lhs, rhs) ? -1 : compare(rhs, lhs) ? 1 : 0;
+  }
+}
+
+// Owns a node taken out of a Tree by RBTree::extractNode until a tree links
+// it again (RBTree::insertNode) or the handle is dropped. The node stays in
+// the memory of the source tree's allocator, and the handle keeps a copy of
+// that allocator to free it with. Copies of a NodePool share the pool, so
+// the handle may outlive the source tree; an allocator that only refers to
+// memory it does not own, such as polymorphic_allocator, needs that memory
+// to outlive the handle.
+template <typename Tree>
+class RBTreeNodeHandle {
+ public:
+  using key_type = typename Tree::key_type;
+  using value_type = typename Tree::value_type;
+
+  RBTreeNodeHandle() : node(nullptr) {}
+  RBTreeNodeHandle(RBTreeNodeHandle&& other) noexcept
+      : node(other.node), allocator(std::move(other.allocator)) {
+    other.node = nullptr;
+    other.allocator.reset();
+  }
+  RBTreeNodeHandle& operator=(RBTreeNodeHandle&& other) noexcept {
+    if (this != &other) {
+      reset();
+      node = other.node;
+      if (other.allocator) allocator.emplace(std::move(*other.allocator));
+      other.node = nullptr;
+      other.allocator.reset();
+    }
+    return *this;
+  }
+  ~RBTreeNodeHandle() { reset(); }
+
+  bool empty() const { return node == nullptr; }
+  explicit operator bool() const { return node != nullptr; }
+  value_type& value() const { return node->value; }
+  const key_type& key() const { return Tree::nodeKey(node); }
+
+ private:
+  friend Tree;
+  using Node = typename Tree::Node;
+  using NodeAllocator = typename Tree::NodeAllocator;
+  using NodeTraits = std::allocator_traits<NodeAllocator>;
+
+  RBTreeNodeHandle(Node* n, const NodeAllocator& a) : node(n), allocator(a) {}
+
+  void reset() {
+    if (node != nullptr) {
+      NodeTraits::destroy(*allocator, node);
+      NodeTraits::deallocate(*allocator, node, 1);
+      node = nullptr;
+    }
+    allocator.reset();
+  }
+  // Once a tree has linked the node.
+  void release() {
+    node = nullptr;
+    allocator.reset();
+  }
+
+  Node* node;
+  // Empty with the node; optional because allocators need not be
+  // assignable, as polymorphic_allocator is not.
+  std::optional<NodeAllocator> allocator;
+};
+
+// Allocator is rebound to the node type through std::allocator_traits. The
+// default NodePool keeps nodes in large chunks; pass std::allocator<ValueType>
+// to get one heap allocation per node.
+//
+// With OrderStatistics every node also stores the size of its subtree, which
+// enables select, rank and countInRange in O(log n). Keys selects how equal
+// keys are stored; size() always counts elements, including repeats.
+// KeyOfValue is one of the key extractors above; with RBTreeIdentityKey or
+// RBTreeFirstKey the key passed to insert must match the one in the value.
+// Compare orders the keys; two keys are equal when neither is less.
+template <typename KeyType, typename ValueType,
+          typename Allocator = NodePool<ValueType>,
+          bool OrderStatistics = false, RBTreeKeys Keys = RBTreeKeys::kUnique,
+          typename KeyOfValue = RBTreeStoredKey,
+          typename Compare = std::less<KeyType>>
 class RBTree {
  public:
-  struct Node {
-    KeyType key;
-    ValueType value;
-    Node* left;
-    Node* right;
-    Node* parent;
-    bool color;
-
-    Node(const KeyType& k, const ValueType& v)
-        : key(k),
-          value(v),
-          left(nullptr),
-          right(nullptr),
-          parent(nullptr),
-          color(RED) {}
-  };
+  using Node =
+      RBTreeNode<KeyType, ValueType, OrderStatistics,
+                 Keys == RBTreeKeys::kCounted, KeyOfValue::kStoresKey>;
+  // Where an element lives; containers iterate through findNext, findPrev
+  // and valueOf so that they also work on other backends.
+  using Position = Node*;
+  using InsertResult = std::pair<Node*, bool>;
+  using NodeHandle = RBTreeNodeHandle<RBTree>;
+  using key_type = KeyType;
+  using value_type = ValueType;
+  using allocator_type = Allocator;
+  using key_compare = Compare;
+
   RBTree();
+  explicit RBTree(const Allocator& alloc);
   RBTree(const RBTree& other);
   RBTree(RBTree&& other) noexcept;
   ~RBTree();
 
   RBTree& operator=(const RBTree& other);
-  RBTree& operator=(RBTree&& other) noexcept;
+  // Takes other's nodes as they are when the allocator propagates or the
+  // two compare equal. Otherwise each value moves into a node from this
+  // tree's allocator, which may throw; the elements not moved by then are
+  // lost.
+  RBTree& operator=(RBTree&& other) noexcept(
+      NodeTraits::propagate_on_container_move_assignment::value ||
+      NodeTraits::is_always_equal::value);
 
-  void insert(const KeyType& key, const ValueType& value);
+  // Both inserts descend the tree once and return the node holding `key`
+  // together with whether it was created. A hint is the node the new key
+  // should precede (nullptr for end()); when it is right, no descent from
+  // the root is needed, so appending sorted keys with an end() hint is
+  // amortized O(1). Without a hint, a kEqual tree places the new key after
+  // its equals, and a kCounted tree adds an occurrence to the existing node
+  // and reports it as not created.
+  InsertResult insert(const KeyType& key, const ValueType& value);
+  InsertResult insertWithHint(Node* hint, const KeyType& key,
+                              const ValueType& value);
+  // Same as the inserts, but the value is built inside the new node from
+  // args, and only if a node is created. args may move from the object
+  // `key` refers to.
+  template <typename... Args>
+  InsertResult emplace(const KeyType& key, Args&&... args);
+  template <typename... Args>
+  InsertResult emplaceWithHint(Node* hint, const KeyType& key,
+                               Args&&... args);
+  // For keys read from the value, which is only known once it is built:
+  // the node is constructed from args first and then placed by its key. A
+  // kUnique tree that already has the key destroys it again.
+  template <typename... Args>
+  InsertResult emplaceValue(Args&&... args);
+  template <typename... Args>
+  InsertResult emplaceValueWithHint(Node* hint, Args&&... args);
+  // Replaces the contents with the sorted range [first, last) in O(n). Keys
+  // come from keyOf(element); equal keys are handled as by insert, so a
+  // kUnique tree keeps only the first of them.
+  // Nodes are allocated in key order, so with NodePool an in-order walk
+  // touches memory sequentially.
+  template <typename ForwardIt, typename GetKey>
+  void buildFromSorted(ForwardIt first, ForwardIt last, GetKey keyOf);
+  // remove erases one element equal to `key` and throws if there is none.
+  // removeNode erases one element held by `node`: in a kCounted tree that
+  // only drops an occurrence until the last one goes.
   void remove(const KeyType& key);
-  bool contains(const KeyType& key) const;
+  void removeNode(Node* node);
+  // Node handles move elements between trees without copying them.
+  // extractNode unlinks the node and hands it over; where a kCounted node
+  // holds more than one occurrence, one is split off into a new node
+  // instead. insertNode links the handle's node where insert would put its
+  // key and empties the handle; a kUnique tree that already has the key
+  // leaves the node in the handle, and a kCounted one adds an occurrence
+  // and drops it. The node itself is relinked when both trees' allocators
+  // compare equal; otherwise its value moves into a node from this tree's
+  // allocator.
+  NodeHandle extractNode(Node* node);
+  InsertResult insertNode(NodeHandle& handle);
+  InsertResult insertNodeWithHint(Node* hint, NodeHandle& handle);
+  // Moves over every element of `other` that insert would accept, i.e. all
+  // of them unless this tree is kUnique, relinking nodes as insertNode does.
+  // The rest stay in `other`. Each element of `other` is looked up here and
+  // only the missing ones are moved, O(m log(n + m)); small trees of
+  // similar size are merged in one ordered walk over both instead and
+  // relinked as balanced trees in O(n + m) (see RBTreeMergeLinear).
+  void mergeFrom(RBTree& other);
+  // Applies op with `other` to this tree in place (see RBTreeSetOp). Nodes
+  // that stay are this tree's own, and elements only `other` has are
+  // copied. Both trees are walked in order and the result is relinked as a
+  // balanced tree in O(n + m). When `other` is much smaller, its elements
+  // are looked up here instead, and when this tree is much smaller, an
+  // intersection or difference skips through `other` by lookups, so either
+  // way the cost is O(m log n) for the smaller size m.
+  void combine(const RBTree& other, RBTreeSetOp op);
+  // split moves the elements whose keys are not less than `key` into
+  // `right`, replacing its contents; join appends all of `right`, whose
+  // keys must not be less than this tree's (for kUnique, must be greater),
+  // and throws std::invalid_argument otherwise. Both cut and stitch whole
+  // subtrees along one path in O(log n), and so does all of split with
+  // OrderStatistics, which gives the two element counts from the subtree
+  // sizes; without it split counts the smaller part, O(min(k, n - k)).
+  // Where allocators propagate on move assignment, as NodePool's do,
+  // `right` takes a copy of this tree's allocator first, so the two share
+  // a pool and later joins relink too. Otherwise, when the allocators
+  // compare unequal, the smaller part's values move into nodes from the
+  // other allocator, O(min(k, n - k)) allocations, and the larger part
+  // takes its allocator along where allocators propagate on swap.
+  void split(const KeyType& key, RBTree& right);
+  void join(RBTree& right);
   void clear();
   int size() const;
-  Node* find(const KeyType& key);
+  // The lookups below take a KeyType, or with a transparent Compare any key
+  // type it accepts (see RBTreeLookup).
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  bool contains(const K& key) const;
+  bool contains(const KeyType& key) const { return contains<KeyType>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  Node* find(const K& key);
+  Node* find(const KeyType& key) { return find<KeyType>(key); }
+  // The first and last nodes, nullptr for an empty tree.
   Node* minimum();
   Node* maximum();
   Node* minimum(Node* node);
   Node* maximum(Node* node);
-  Node* findNext(Node* node);
+  static Node* findNext(Node* node);
+  static Node* findPrev(Node* node);
+  // First node whose key is not less than (lowerBound) or greater than
+  // (upperBound) `key`, found in one descent; nullptr if there is none.
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  Node* lowerBound(const K& key);
+  Node* lowerBound(const KeyType& key) { return lowerBound<KeyType>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  Node* upperBound(const K& key);
+  Node* upperBound(const KeyType& key) { return upperBound<KeyType>(key); }
   bool isEmpty() const { return root == nullptr; }
+  // Number of elements a node stands for: its count in a kCounted tree,
+  // otherwise 1.
+  static std::size_t occurrences(const Node* node);
+  // The node's key, wherever KeyOfValue says it lives.
+  static const KeyType& nodeKey(const Node* node);
+  static ValueType& valueOf(Node* node) { return node->value; }
+  Compare keyComp() const { return compare; }
+
+  // Order statistics, available when OrderStatistics is true. select is
+  // zero-based and returns nullptr past the end; rank is the number of keys
+  // less than `key`; countInRange counts keys in [low, high).
+  Node* select(std::size_t index);
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  std::size_t rank(const K& key) const;
+  std::size_t rank(const KeyType& key) const { return rank<KeyType>(key); }
+  template <typename K, typename = RBTreeLookup<Compare, K, KeyType>>
+  std::size_t countInRange(const K& low, const K& high) const;
+  std::size_t countInRange(const KeyType& low, const KeyType& high) const {
+    return countInRange<KeyType>(low, high);
+  }
 
  private:
+  using NodeAllocator = typename std::allocator_traits<
+      Allocator>::template rebind_alloc<Node>;
+  using NodeTraits = std::allocator_traits<NodeAllocator>;
+
+  // A pool such as NodePool, which clear() can drop at once while no other
+  // copy of it is in use.
+  template <typename A, typename = void>
+  struct HasRelease : std::false_type {};
+  template <typename A>
+  struct HasRelease<A, std::void_t<decltype(std::declval<A&>().release(),
+                                            std::declval<A&>().use_count())>>
+      : std::true_type {};
+
+  // Where a new element goes: below `parent` on the side given by asLeft,
+  // or nowhere when `match` already holds its key (kUnique and kCounted).
+  struct InsertSlot {
+    Node* match;
+    Node* parent;
+    bool asLeft;
+  };
+
+  friend NodeHandle;
+
+  NodeAllocator allocator;
+  Compare compare;
   Node* root;
+  Node* rightmost;
   int treeSize;
 
+  template <typename... Args>
+  Node* createNode(const KeyType& key, Args&&... args);
+  template <typename... Args>
+  Node* createValueNode(Args&&... args);
+  void destroyNode(Node* node);
+  void destroySubtree(Node* node);
+  template <typename ForwardIt, typename GetKey>
+  Node* buildSubtree(ForwardIt& it, ForwardIt last, GetKey& keyOf,
+                     std::size_t count, int depth, int redDepth);
+  // Black depth at which a tree of `count` nodes split at midpoints gets
+  // its red, incomplete last level.
+  static int redDepthFor(std::size_t count);
+  // Turns the subtree into a list chained through `right`, in key order,
+  // and puts it in front of `list`.
+  static void flattenInto(Node* node, Node*& list);
+  // Makes the tree out of the sorted list of nodes, balanced as by
+  // buildFromSorted.
+  void linkSorted(Node* list);
+  Node* linkSubtree(Node*& list, std::size_t count, int depth, int redDepth);
+  Node* copyOf(const Node* node);
+  void combineEach(const RBTree& other, RBTreeSetOp op);
+  void mergeLinear(RBTree& other);
+  // Black nodes on a path from `node` down to a leaf, counting `node`.
+  static int blackHeight(const Node* node);
+  // Makes the subtree a tree of its own, with a black root.
+  static Node* detachSubtree(Node* node, int& height);
+  // Links the detached subtrees `left` and `right` below and beside
+  // `pivot`, whose key lies between theirs, in O(|leftHeight -
+  // rightHeight| + 1) and returns the root. Uses `root` while it works.
+  Node* joinSubtrees(Node* left, int leftHeight, Node* pivot, Node* right,
+                     int rightHeight, int& height);
+  void splitSubtree(Node* node, int height, const KeyType& key, Node*& left,
+                    int& leftHeight, Node*& right, int& rightHeight);
+  // Element count of the subtree `left` of `total`, counting only as far
+  // as the smaller of `left` and `right` when there are no subtree sizes.
+  int countLeft(Node* left, Node* right, int total);
+  // Replaces every node of the subtree, allocated by `owner`, with one
+  // holding its moved value from this tree's allocator.
+  void adoptSubtree(Node*& subtree, NodeAllocator& owner);
+  static int countElements(Node* node);
+  static std::size_t subtreeSize(const Node* node);
+  void updateSize(Node* node);
+  void adjustSizesUpward(Node* node, int delta);
   void rotateLeft(Node*& pt);
   void rotateRight(Node*& pt);
-  void fixViolation(Node*& pt);
-  void insertBST(Node*& root, Node* pt);
-  void removeBST(Node*& root, const KeyType& key);
+  // Restores the colours after linking a red node; returns whether that
+  // turned the root red, i.e. the tree's black height grew by one.
+  bool fixViolation(Node*& pt);
+  InsertSlot findInsertSlot(const KeyType& key);
+  InsertSlot findInsertSlot(Node* hint, const KeyType& key);
+  // Links a node built ahead of its slot, or destroys it when the slot
+  // holds a match.
+  InsertResult placeNode(Node* node, const InsertSlot& slot);
+  InsertResult addOccurrence(Node* match);
+  // Links newNode, fresh or taken from another tree, below parent.
+  InsertResult attachNode(Node* parent, bool asLeft, Node* newNode);
+  InsertResult linkHandle(NodeHandle& handle, const InsertSlot& slot);
+  // The node to link for one that lives in owner's memory: itself when
+  // owner and this tree's allocator compare equal, otherwise a new node
+  // holding its moved value. The caller frees the old node in that case.
+  Node* relocateNode(Node* node, const NodeAllocator& owner);
+  // Takes the node out of the tree without freeing it.
+  void unlinkNode(Node* node);
   void clearNode(Node*& ptr);
   void rbTransplant(Node* u, Node* v);
   void fixRemoveViolation(Node* x, Node* xParent);
   Node* copyNode(const Node* node, Node* parent = nullptr);
 };
 
-template <typename KeyType, typename ValueType>
-RBTree<KeyType, ValueType>::RBTree() : root(nullptr), treeSize(0) {}
-template <typename KeyType, typename ValueType>
-RBTree<KeyType, ValueType>::~RBTree() {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::RBTree()
+    : allocator(),
+      compare(),
+      root(nullptr),
+      rightmost(nullptr),
+      treeSize(0) {}
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::RBTree(const Allocator& alloc)
+    : allocator(alloc),
+      compare(),
+      root(nullptr),
+      rightmost(nullptr),
+      treeSize(0) {}
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::~RBTree() {
   clear();
 }
-template <typename KeyType, typename ValueType>
-void RBTree<KeyType, ValueType>::clear() {
-  clearNode(this->root);
-  this->root = nullptr;
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::clear() {
+  bool released = false;
+  if constexpr (HasRelease<NodeAllocator>::value) {
+    if (allocator.use_count() <= 1) {
+      if constexpr (!std::is_trivially_destructible<Node>::value) {
+        destroySubtree(this->root);
+      }
+      allocator.release();
+      this->root = nullptr;
+      released = true;
+    }
+  }
+  if (!released) clearNode(this->root);
+  this->rightmost = nullptr;
+  this->treeSize = 0;
 }
 
-template <typename KeyType, typename ValueType>
-void RBTree<KeyType, ValueType>::clearNode(Node*& ptr) {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::clearNode(Node*& ptr) {
   if (ptr != nullptr) {
     clearNode(ptr->left);
     clearNode(ptr->right);
-    delete ptr;
+    destroyNode(ptr);
     ptr = nullptr;
     this->treeSize -= 1;
   }
 }
 
-template <typename KeyType, typename ValueType>
-int RBTree<KeyType, ValueType>::size() const {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::destroySubtree(Node* node) {
+  while (node != nullptr) {
+    destroySubtree(node->left);
+    Node* right = node->right;
+    NodeTraits::destroy(allocator, node);
+    node = right;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+template <typename... Args>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::createNode(const KeyType& key,
+                                        Args&&... args) {
+  Node* node = NodeTraits::allocate(allocator, 1);
+  try {
+    NodeTraits::construct(allocator, node, key, std::in_place,
+                          std::forward<Args>(args)...);
+  } catch (...) {
+    NodeTraits::deallocate(allocator, node, 1);
+    throw;
+  }
+  return node;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+template <typename... Args>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::createValueNode(Args&&... args) {
+  static_assert(!KeyOfValue::kStoresKey,
+                "a node without a key argument must read it from the value");
+  Node* node = NodeTraits::allocate(allocator, 1);
+  try {
+    NodeTraits::construct(allocator, node, std::in_place,
+                          std::forward<Args>(args)...);
+  } catch (...) {
+    NodeTraits::deallocate(allocator, node, 1);
+    throw;
+  }
+  return node;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::destroyNode(Node* node) {
+  NodeTraits::destroy(allocator, node);
+  NodeTraits::deallocate(allocator, node, 1);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+int RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+           KeyOfValue, Compare>::size() const {
   return this->treeSize;
 }
 
-template <typename KeyType, typename ValueType>
-void RBTree<KeyType, ValueType>::insert(const KeyType& key,
-                                        const ValueType& value) {
-  Node* newNode = new Node(key, value);
-  insertBST(this->root, newNode);
-  fixViolation(newNode);
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::InsertResult
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::insert(const KeyType& key,
+                                    const ValueType& value) {
+  return emplace(key, value);
 }
 
-template <typename KeyType, typename ValueType>
-void RBTree<KeyType, ValueType>::insertBST(Node*& root, Node* newNode) {
-  if (root == nullptr) {
-    root = newNode;
-    treeSize++;
-    return;
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::InsertResult
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::insertWithHint(Node* hint, const KeyType& key,
+                                            const ValueType& value) {
+  return emplaceWithHint(hint, key, value);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+template <typename... Args>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::InsertResult
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::emplace(const KeyType& key, Args&&... args) {
+  InsertSlot slot = findInsertSlot(key);
+  if (slot.match != nullptr) {
+    return addOccurrence(slot.match);
+  }
+  return attachNode(slot.parent, slot.asLeft,
+                    createNode(key, std::forward<Args>(args)...));
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+template <typename... Args>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::InsertResult
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::emplaceWithHint(Node* hint, const KeyType& key,
+                                             Args&&... args) {
+  InsertSlot slot = findInsertSlot(hint, key);
+  if (slot.match != nullptr) {
+    return addOccurrence(slot.match);
   }
+  return attachNode(slot.parent, slot.asLeft,
+                    createNode(key, std::forward<Args>(args)...));
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+template <typename... Args>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::InsertResult
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::emplaceValue(Args&&... args) {
+  Node* node = createValueNode(std::forward<Args>(args)...);
+  InsertSlot slot;
+  try {
+    slot = findInsertSlot(nodeKey(node));
+  } catch (...) {
+    destroyNode(node);
+    throw;
+  }
+  return placeNode(node, slot);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+template <typename... Args>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::InsertResult
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::emplaceValueWithHint(Node* hint,
+                                                  Args&&... args) {
+  Node* node = createValueNode(std::forward<Args>(args)...);
+  InsertSlot slot;
+  try {
+    slot = findInsertSlot(hint, nodeKey(node));
+  } catch (...) {
+    destroyNode(node);
+    throw;
+  }
+  return placeNode(node, slot);
+}
 
-  if (newNode->key < root->key) {
-    if (root->left == nullptr) {
-      root->left = newNode;
-      newNode->parent = root;
-      treeSize++;
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::InsertSlot
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::findInsertSlot(const KeyType& key) {
+  InsertSlot slot{nullptr, nullptr, false};
+  Node* current = root;
+  while (current != nullptr) {
+    slot.parent = current;
+    // Equal keys go right in a kEqual tree, so one "less" decides there.
+    int order = Keys == RBTreeKeys::kEqual
+                    ? (compare(key, nodeKey(current)) ? -1 : 1)
+                    : RBTreeThreeWay(compare, key, nodeKey(current));
+    if (order < 0) {
+      slot.asLeft = true;
+      current = current->left;
+    } else if (order > 0) {
+      slot.asLeft = false;
+      current = current->right;
     } else {
-      insertBST(root->left, newNode);
+      slot.match = current;
+      return slot;
     }
-  } else if (newNode->key > root->key) {
-    if (root->right == nullptr) {
-      root->right = newNode;
-      newNode->parent = root;
-      treeSize++;
-    } else {
-      insertBST(root->right, newNode);
+  }
+  return slot;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::InsertSlot
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::findInsertSlot(Node* hint, const KeyType& key) {
+  // In a kEqual tree the new key may sit next to keys equal to it.
+  constexpr bool kEqualKeys = Keys == RBTreeKeys::kEqual;
+  if (hint == nullptr) {
+    if (rightmost == nullptr) {
+      return InsertSlot{nullptr, nullptr, false};
+    }
+    if (kEqualKeys ? !compare(key, nodeKey(rightmost))
+                   : compare(nodeKey(rightmost), key)) {
+      return InsertSlot{nullptr, rightmost, false};
+    }
+  } else if (kEqualKeys ? !compare(nodeKey(hint), key)
+                        : compare(key, nodeKey(hint))) {
+    Node* prev = findPrev(hint);
+    if (prev == nullptr || (kEqualKeys ? !compare(key, nodeKey(prev))
+                                       : compare(nodeKey(prev), key))) {
+      if (hint->left == nullptr) {
+        return InsertSlot{nullptr, hint, true};
+      }
+      return InsertSlot{nullptr, prev, false};
+    }
+  } else if (Keys == RBTreeKeys::kUnique && !compare(nodeKey(hint), key)) {
+    return InsertSlot{hint, nullptr, false};
+  }
+  return findInsertSlot(key);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::InsertResult
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::placeNode(Node* node,
+                                       const InsertSlot& slot) {
+  if (slot.match != nullptr) {
+    destroyNode(node);
+    return addOccurrence(slot.match);
+  }
+  return attachNode(slot.parent, slot.asLeft, node);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::InsertResult
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::addOccurrence(Node* match) {
+  if constexpr (Keys == RBTreeKeys::kCounted) {
+    ++match->count;
+    ++treeSize;
+    adjustSizesUpward(match, 1);
+  }
+  return std::make_pair(match, false);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::InsertResult
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::attachNode(Node* parent, bool asLeft,
+                                        Node* newNode) {
+  newNode->left = nullptr;
+  newNode->right = nullptr;
+  newNode->parent = parent;
+  newNode->color = RED;
+  int added = static_cast<int>(occurrences(newNode));
+  if constexpr (OrderStatistics) {
+    newNode->size = added;
+  }
+  if (parent == nullptr) {
+    root = newNode;
+  } else if (asLeft) {
+    parent->left = newNode;
+  } else {
+    parent->right = newNode;
+  }
+  if (parent == rightmost && !asLeft) {
+    rightmost = newNode;
+  }
+  treeSize += added;
+  adjustSizesUpward(parent, added);
+  Node* placed = newNode;
+  fixViolation(newNode);
+  return std::make_pair(placed, true);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+template <typename ForwardIt, typename GetKey>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::buildFromSorted(
+    ForwardIt first, ForwardIt last, GetKey keyOf) {
+  clear();
+  std::size_t count = 0;
+  std::size_t elements = 0;
+  for (ForwardIt it = first; it != last;) {
+    ForwardIt next = it;
+    ++next;
+    ++elements;
+    while (Keys != RBTreeKeys::kEqual && next != last &&
+           !compare(keyOf(*it), keyOf(*next))) {
+      ++next;
+      if (Keys == RBTreeKeys::kCounted) ++elements;
     }
+    ++count;
+    it = next;
   }
+
+  root = buildSubtree(first, last, keyOf, count, 0, redDepthFor(count));
+  rightmost = root == nullptr ? nullptr : maximum(root);
+  treeSize = static_cast<int>(elements);
 }
 
-template <typename KeyType, typename ValueType>
-void RBTree<KeyType, ValueType>::rotateLeft(Node*& pt) {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+template <typename ForwardIt, typename GetKey>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::buildSubtree(ForwardIt& it, ForwardIt last,
+                                          GetKey& keyOf, std::size_t count,
+                                          int depth, int redDepth) {
+  if (count == 0) return nullptr;
+  std::size_t leftCount = (count - 1) / 2;
+  Node* left = buildSubtree(it, last, keyOf, leftCount, depth + 1, redDepth);
+
+  Node* node = createNode(keyOf(*it), *it);
+  ++it;
+  while (Keys != RBTreeKeys::kEqual && it != last &&
+         !compare(nodeKey(node), keyOf(*it))) {
+    if constexpr (Keys == RBTreeKeys::kCounted) {
+      ++node->count;
+    }
+    ++it;
+  }
+  node->color = depth == redDepth ? RED : BLACK;
+  node->left = left;
+  if (left != nullptr) left->parent = node;
+  node->right = buildSubtree(it, last, keyOf, count - 1 - leftCount,
+                             depth + 1, redDepth);
+  if (node->right != nullptr) node->right->parent = node;
+  updateSize(node);
+  return node;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::rotateLeft(Node*& pt) {
   Node* pt_right = pt->right;
   pt->right = pt_right->left;
 
@@ -147,10 +978,17 @@ void RBTree<KeyType, ValueType>::rotateLeft(Node*& pt) {
 
   pt_right->left = pt;
   pt->parent = pt_right;
+  if constexpr (OrderStatistics) {
+    pt_right->size = pt->size;
+    updateSize(pt);
+  }
 }
 
-template <typename KeyType, typename ValueType>
-void RBTree<KeyType, ValueType>::rotateRight(Node*& pt) {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::rotateRight(Node*& pt) {
   Node* pt_left = pt->left;
   pt->left = pt_left->right;
 
@@ -170,10 +1008,17 @@ void RBTree<KeyType, ValueType>::rotateRight(Node*& pt) {
 
   pt_left->right = pt;
   pt->parent = pt_left;
+  if constexpr (OrderStatistics) {
+    pt_left->size = pt->size;
+    updateSize(pt);
+  }
 }
 
-template <typename KeyType, typename ValueType>
-void RBTree<KeyType, ValueType>::fixViolation(Node*& newNode) {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+bool RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::fixViolation(Node*& newNode) {
   Node* parent = nullptr;
   Node* grandParent = nullptr;
   while ((newNode != root) && (newNode->color != BLACK) &&
@@ -216,44 +1061,74 @@ void RBTree<KeyType, ValueType>::fixViolation(Node*& newNode) {
       }
     }
   }
+  bool grew = root->color == RED;
   root->color = BLACK;
+  return grew;
 }
 
-template <typename KeyType, typename ValueType>
-typename RBTree<KeyType, ValueType>::Node* RBTree<KeyType, ValueType>::find(
-    const KeyType& key) {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+template <typename K, typename>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::find(const K& key) {
   Node* current = root;
   while (current != nullptr) {
-    if (key == current->key) {
-      return current;
-    } else if (key < current->key) {
+    int order = RBTreeThreeWay(compare, key, nodeKey(current));
+    if (order < 0) {
       current = current->left;
-    } else {
+    } else if (order > 0) {
       current = current->right;
+    } else {
+      return current;
     }
   }
   return nullptr;
 }
 
-template <typename KeyType, typename ValueType>
-void RBTree<KeyType, ValueType>::remove(const KeyType& key) {
-  Node* nodeToDelete = root;
-  Node* parent = nullptr;
-  Node* child = nullptr;
-  bool found = false;
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::remove(const KeyType& key) {
+  Node* node = find(key);
+  if (node == nullptr) {
+    throw std::invalid_argument("Key not found.");
+  }
+  removeNode(node);
+}
 
-  while (nodeToDelete != nullptr) {
-    if (key == nodeToDelete->key) {
-      found = true;
-      break;
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::removeNode(Node* nodeToDelete) {
+  if constexpr (Keys == RBTreeKeys::kCounted) {
+    if (nodeToDelete->count > 1) {
+      --treeSize;
+      --nodeToDelete->count;
+      adjustSizesUpward(nodeToDelete, -1);
+      return;
     }
-    parent = nodeToDelete;
-    nodeToDelete =
-        key < nodeToDelete->key ? nodeToDelete->left : nodeToDelete->right;
   }
+  unlinkNode(nodeToDelete);
+  destroyNode(nodeToDelete);
+}
 
-  if (!found) {
-    throw std::invalid_argument("Key not found.");
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::unlinkNode(Node* nodeToDelete) {
+  int removed = static_cast<int>(occurrences(nodeToDelete));
+  treeSize -= removed;
+  Node* parent = nodeToDelete->parent;
+  Node* child = nullptr;
+
+  if (nodeToDelete == rightmost) {
+    rightmost = findPrev(nodeToDelete);
   }
 
   bool originalColor = nodeToDelete->color;
@@ -268,8 +1143,10 @@ void RBTree<KeyType, ValueType>::remove(const KeyType& key) {
     originalColor = successor->color;
     child = successor->right;
     if (successor->parent == nodeToDelete) {
+      parent = successor;
       if (child) child->parent = successor;
     } else {
+      parent = successor->parent;
       rbTransplant(successor, successor->right);
       successor->right = nodeToDelete->right;
       successor->right->parent = successor;
@@ -278,16 +1155,745 @@ void RBTree<KeyType, ValueType>::remove(const KeyType& key) {
     successor->left = nodeToDelete->left;
     successor->left->parent = successor;
     successor->color = nodeToDelete->color;
+    if constexpr (OrderStatistics) {
+      successor->size = nodeToDelete->size;
+    }
   }
+  adjustSizesUpward(parent, -removed);
 
-  delete nodeToDelete;
   if (originalColor == BLACK) {
     fixRemoveViolation(child, parent);
   }
 }
 
-template <typename KeyType, typename ValueType>
-void RBTree<KeyType, ValueType>::rbTransplant(Node* u, Node* v) {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::NodeHandle
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::extractNode(Node* node) {
+  if constexpr (Keys == RBTreeKeys::kCounted) {
+    if (node->count > 1) {
+      Node* single;
+      if constexpr (KeyOfValue::kStoresKey) {
+        single = createNode(nodeKey(node), node->value);
+      } else {
+        single = createValueNode(node->value);
+      }
+      removeNode(node);
+      return NodeHandle(single, allocator);
+    }
+  }
+  unlinkNode(node);
+  return NodeHandle(node, allocator);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::InsertResult
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::insertNode(NodeHandle& handle) {
+  if (handle.empty()) {
+    return std::make_pair(nullptr, false);
+  }
+  return linkHandle(handle, findInsertSlot(nodeKey(handle.node)));
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::InsertResult
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::insertNodeWithHint(Node* hint,
+                                               NodeHandle& handle) {
+  if (handle.empty()) {
+    return std::make_pair(nullptr, false);
+  }
+  return linkHandle(handle, findInsertSlot(hint, nodeKey(handle.node)));
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::InsertResult
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::linkHandle(NodeHandle& handle,
+                                       const InsertSlot& slot) {
+  if (slot.match != nullptr) {
+    if constexpr (Keys == RBTreeKeys::kCounted) {
+      handle.reset();
+      return addOccurrence(slot.match);
+    }
+    return std::make_pair(slot.match, false);
+  }
+  Node* node = relocateNode(handle.node, *handle.allocator);
+  if (node == handle.node) {
+    handle.release();
+  } else {
+    handle.reset();
+  }
+  return attachNode(slot.parent, slot.asLeft, node);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::mergeFrom(RBTree& other) {
+  if (this == &other || other.root == nullptr) return;
+  if (RBTreeMergeLinear(other.size(), size())) {
+    mergeLinear(other);
+    return;
+  }
+  Node* node = other.minimum();
+  while (node != nullptr) {
+    Node* next = findNext(node);
+    InsertSlot slot = findInsertSlot(nodeKey(node));
+    if (slot.match == nullptr) {
+      Node* moved = relocateNode(node, other.allocator);
+      other.unlinkNode(node);
+      if (moved != node) {
+        other.destroyNode(node);
+      }
+      attachNode(slot.parent, slot.asLeft, moved);
+    } else if constexpr (Keys == RBTreeKeys::kCounted) {
+      std::size_t added = node->count;
+      other.unlinkNode(node);
+      other.destroyNode(node);
+      slot.match->count += added;
+      treeSize += static_cast<int>(added);
+      adjustSizesUpward(slot.match, static_cast<int>(added));
+    }
+    node = next;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::relocateNode(Node* node,
+                                         const NodeAllocator& owner) {
+  if constexpr (!NodeTraits::is_always_equal::value) {
+    if (!(owner == allocator)) {
+      Node* moved;
+      if constexpr (KeyOfValue::kStoresKey) {
+        moved = createNode(nodeKey(node), std::move(node->value));
+      } else {
+        moved = createValueNode(std::move(node->value));
+      }
+      if constexpr (Keys == RBTreeKeys::kCounted) {
+        moved->count = node->count;
+      }
+      return moved;
+    }
+  }
+  return node;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::split(const KeyType& key,
+                                            RBTree& right) {
+  if (this == &right) return;
+  right.clear();
+  right.compare = compare;
+  if constexpr (!NodeTraits::is_always_equal::value &&
+                NodeTraits::propagate_on_container_move_assignment::value) {
+    // Sharing this tree's allocator, `right` can take the nodes as they are.
+    if (!(allocator == right.allocator)) {
+      right.allocator = NodeAllocator(allocator);
+    }
+  }
+  Node* left = nullptr;
+  Node* rest = nullptr;
+  int leftHeight = 0;
+  int restHeight = 0;
+  splitSubtree(root, blackHeight(root), key, left, leftHeight, rest,
+               restHeight);
+  int total = treeSize;
+  int leftCount = countLeft(left, rest, total);
+  root = left;
+  treeSize = leftCount;
+  right.root = rest;
+  right.treeSize = total - leftCount;
+  if constexpr (!NodeTraits::is_always_equal::value) {
+    if (!(allocator == right.allocator)) {
+      // The larger part keeps its nodes; its allocator goes with it.
+      bool moveLeft = NodeTraits::propagate_on_container_swap::value &&
+                      leftCount < total - leftCount;
+      RBTree& moving = moveLeft ? *this : right;
+      if constexpr (NodeTraits::propagate_on_container_swap::value) {
+        if (moveLeft) {
+          using std::swap;
+          swap(allocator, right.allocator);
+        }
+      }
+      try {
+        moving.adoptSubtree(moving.root, moveLeft ? right.allocator
+                                                  : allocator);
+      } catch (...) {
+        moving.treeSize = countElements(moving.root);
+        rightmost = root == nullptr ? nullptr : maximum(root);
+        right.rightmost =
+            right.root == nullptr ? nullptr : right.maximum(right.root);
+        throw;
+      }
+    }
+  }
+  rightmost = root == nullptr ? nullptr : maximum(root);
+  right.rightmost = right.root == nullptr ? nullptr : right.maximum(right.root);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::join(RBTree& right) {
+  if (this == &right) {
+    throw std::invalid_argument("Cannot join a tree to itself.");
+  }
+  if (right.root == nullptr) return;
+  Node* first = right.minimum();
+  if (root != nullptr) {
+    int order = RBTreeThreeWay(compare, nodeKey(first), nodeKey(rightmost));
+    if (order < 0 || (order == 0 && Keys == RBTreeKeys::kUnique)) {
+      throw std::invalid_argument("Keys of the joined tree overlap.");
+    }
+    if constexpr (Keys == RBTreeKeys::kCounted) {
+      // The key on both sides of the seam becomes one node.
+      if (order == 0) {
+        rightmost->count += first->count;
+        treeSize += static_cast<int>(first->count);
+        adjustSizesUpward(rightmost, static_cast<int>(first->count));
+        right.unlinkNode(first);
+        right.destroyNode(first);
+        if (right.root == nullptr) return;
+      }
+    }
+  }
+  if constexpr (!NodeTraits::is_always_equal::value) {
+    if (!(allocator == right.allocator)) {
+      bool moveLeft = NodeTraits::propagate_on_container_swap::value &&
+                      treeSize < right.treeSize;
+      RBTree& moving = moveLeft ? *this : right;
+      if constexpr (NodeTraits::propagate_on_container_swap::value) {
+        if (moveLeft) {
+          using std::swap;
+          swap(allocator, right.allocator);
+        }
+      }
+      try {
+        // Either way the nodes end up in this tree's allocator.
+        adoptSubtree(moving.root, right.allocator);
+      } catch (...) {
+        moving.treeSize = countElements(moving.root);
+        moving.rightmost =
+            moving.root == nullptr ? nullptr : maximum(moving.root);
+        throw;
+      }
+      moving.rightmost =
+          moving.root == nullptr ? nullptr : maximum(moving.root);
+    }
+  }
+  if (root == nullptr) {
+    std::swap(root, right.root);
+    std::swap(rightmost, right.rightmost);
+    std::swap(treeSize, right.treeSize);
+    return;
+  }
+  Node* pivot = right.minimum();
+  right.unlinkNode(pivot);
+  int added = right.treeSize + static_cast<int>(occurrences(pivot));
+  int height = 0;
+  root = joinSubtrees(root, blackHeight(root), pivot, right.root,
+                      blackHeight(right.root), height);
+  rightmost = right.root == nullptr ? pivot : right.rightmost;
+  treeSize += added;
+  right.root = nullptr;
+  right.rightmost = nullptr;
+  right.treeSize = 0;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+int RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+           KeyOfValue, Compare>::blackHeight(const Node* node) {
+  int height = 0;
+  for (; node != nullptr; node = node->left) {
+    if (node->color == BLACK) ++height;
+  }
+  return height;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::detachSubtree(Node* node, int& height) {
+  if (node != nullptr) {
+    node->parent = nullptr;
+    if (node->color == RED) {
+      node->color = BLACK;
+      ++height;
+    }
+  }
+  return node;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::joinSubtrees(Node* left, int leftHeight,
+                                          Node* pivot, Node* right,
+                                          int rightHeight, int& height) {
+  if (leftHeight == rightHeight) {
+    pivot->parent = nullptr;
+    pivot->left = left;
+    pivot->right = right;
+    if (left != nullptr) left->parent = pivot;
+    if (right != nullptr) right->parent = pivot;
+    pivot->color = BLACK;
+    updateSize(pivot);
+    height = leftHeight + 1;
+    return pivot;
+  }
+  // Down the inner spine of the taller tree to the first black node (or
+  // leaf) as high as the shorter tree; the pivot, red, takes its place
+  // with the two as children, and the insert fix-up handles the rest.
+  bool intoLeft = leftHeight > rightHeight;
+  Node* taller = intoLeft ? left : right;
+  Node* shorter = intoLeft ? right : left;
+  int target = intoLeft ? rightHeight : leftHeight;
+  int level = intoLeft ? leftHeight : rightHeight;
+  Node* parent = nullptr;
+  Node* node = taller;
+  while (node != nullptr && (node->color == RED || level > target)) {
+    if (node->color == BLACK) --level;
+    parent = node;
+    node = intoLeft ? node->right : node->left;
+  }
+  pivot->parent = parent;
+  pivot->left = intoLeft ? node : shorter;
+  pivot->right = intoLeft ? shorter : node;
+  if (pivot->left != nullptr) pivot->left->parent = pivot;
+  if (pivot->right != nullptr) pivot->right->parent = pivot;
+  pivot->color = RED;
+  updateSize(pivot);
+  (intoLeft ? parent->right : parent->left) = pivot;
+  adjustSizesUpward(parent, static_cast<int>(subtreeSize(shorter) +
+                                             occurrences(pivot)));
+  root = taller;
+  height = (intoLeft ? leftHeight : rightHeight) +
+           (fixViolation(pivot) ? 1 : 0);
+  return root;
+}
+
+// Cuts the subtree along the search path for `key`. Each node on the path
+// is joined with the subtree hanging off its far side, and the heights of
+// those joins add up to O(log n) in total.
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::splitSubtree(Node* node, int height,
+                                                   const KeyType& key,
+                                                   Node*& left,
+                                                   int& leftHeight,
+                                                   Node*& right,
+                                                   int& rightHeight) {
+  if (node == nullptr) {
+    left = right = nullptr;
+    leftHeight = rightHeight = 0;
+    return;
+  }
+  int childHeight = height - (node->color == BLACK ? 1 : 0);
+  int lowHeight = childHeight;
+  int highHeight = childHeight;
+  Node* low = detachSubtree(node->left, lowHeight);
+  Node* high = detachSubtree(node->right, highHeight);
+  Node* middle = nullptr;
+  int middleHeight = 0;
+  if (compare(nodeKey(node), key)) {
+    splitSubtree(high, highHeight, key, middle, middleHeight, right,
+                 rightHeight);
+    left = joinSubtrees(low, lowHeight, node, middle, middleHeight,
+                        leftHeight);
+  } else {
+    splitSubtree(low, lowHeight, key, left, leftHeight, middle,
+                 middleHeight);
+    right = joinSubtrees(middle, middleHeight, node, high, highHeight,
+                         rightHeight);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+int RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+           KeyOfValue, Compare>::countLeft(Node* left, Node* right, int total) {
+  if constexpr (OrderStatistics) {
+    return static_cast<int>(subtreeSize(left));
+  } else {
+    // Both walks advance together, so the shorter one ends first.
+    int leftCount = 0;
+    int rightCount = 0;
+    Node* a = left == nullptr ? nullptr : minimum(left);
+    Node* b = right == nullptr ? nullptr : minimum(right);
+    while (a != nullptr && b != nullptr) {
+      leftCount += static_cast<int>(occurrences(a));
+      rightCount += static_cast<int>(occurrences(b));
+      a = findNext(a);
+      b = findNext(b);
+    }
+    return a == nullptr ? leftCount : total - rightCount;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::adoptSubtree(Node*& subtree,
+                                                   NodeAllocator& owner) {
+  Node* list = nullptr;
+  flattenInto(subtree, list);
+  Node* adopted = nullptr;
+  Node** tail = &adopted;
+  std::size_t count = 0;
+  try {
+    for (; list != nullptr; ++count) {
+      Node* node = list;
+      list = node->right;
+      Node* moved = relocateNode(node, owner);
+      if (moved != node) {
+        NodeTraits::destroy(owner, node);
+        NodeTraits::deallocate(owner, node, 1);
+      }
+      *tail = moved;
+      tail = &moved->right;
+    }
+  } catch (...) {
+    // The values not moved yet are dropped with their nodes.
+    while (list != nullptr) {
+      Node* node = list;
+      list = node->right;
+      NodeTraits::destroy(owner, node);
+      NodeTraits::deallocate(owner, node, 1);
+    }
+    *tail = nullptr;
+    subtree = linkSubtree(adopted, count, 0, redDepthFor(count));
+    if (subtree != nullptr) subtree->parent = nullptr;
+    throw;
+  }
+  *tail = nullptr;
+  subtree = linkSubtree(adopted, count, 0, redDepthFor(count));
+  if (subtree != nullptr) subtree->parent = nullptr;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+int RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+           KeyOfValue, Compare>::countElements(Node* node) {
+  int count = 0;
+  if (node == nullptr) return count;
+  while (node->left != nullptr) node = node->left;
+  for (; node != nullptr; node = findNext(node)) {
+    count += static_cast<int>(occurrences(node));
+  }
+  return count;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+int RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+           KeyOfValue, Compare>::redDepthFor(std::size_t count) {
+  // A tree split at midpoints has all its empty links on the last two
+  // levels. Colouring the incomplete last level red keeps every path at
+  // the same black height.
+  int redDepth = 0;
+  for (std::size_t full = count + 1; full > 1; full >>= 1) {
+    ++redDepth;
+  }
+  return redDepth;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::flattenInto(Node* node,
+                                                Node*& list) {
+  while (node != nullptr) {
+    flattenInto(node->right, list);
+    Node* left = node->left;
+    node->right = list;
+    list = node;
+    node = left;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::linkSorted(Node* list) {
+  std::size_t count = 0;
+  int elements = 0;
+  for (Node* node = list; node != nullptr; node = node->right) {
+    ++count;
+    elements += static_cast<int>(occurrences(node));
+  }
+  root = linkSubtree(list, count, 0, redDepthFor(count));
+  if (root != nullptr) {
+    root->parent = nullptr;
+  }
+  rightmost = root == nullptr ? nullptr : maximum(root);
+  treeSize = elements;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::linkSubtree(Node*& list, std::size_t count,
+                                        int depth, int redDepth) {
+  if (count == 0) return nullptr;
+  std::size_t leftCount = (count - 1) / 2;
+  Node* left = linkSubtree(list, leftCount, depth + 1, redDepth);
+  Node* node = list;
+  list = list->right;
+  node->color = depth == redDepth ? RED : BLACK;
+  node->left = left;
+  if (left != nullptr) left->parent = node;
+  node->right =
+      linkSubtree(list, count - 1 - leftCount, depth + 1, redDepth);
+  if (node->right != nullptr) node->right->parent = node;
+  updateSize(node);
+  return node;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::copyOf(const Node* node) {
+  Node* copy;
+  if constexpr (KeyOfValue::kStoresKey) {
+    copy = createNode(nodeKey(node), node->value);
+  } else {
+    copy = createValueNode(node->value);
+  }
+  if constexpr (Keys == RBTreeKeys::kCounted) {
+    copy->count = node->count;
+  }
+  return copy;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::combine(const RBTree& other,
+                                            RBTreeSetOp op) {
+  bool takesOthers =
+      op == RBTreeSetOp::kUnion || op == RBTreeSetOp::kSymmetricDifference;
+  if (this == &other) {
+    if (op == RBTreeSetOp::kDifference ||
+        op == RBTreeSetOp::kSymmetricDifference) {
+      clear();
+    }
+    return;
+  }
+  std::size_t own = size();
+  std::size_t others = other.size();
+  if (Keys != RBTreeKeys::kEqual && op != RBTreeSetOp::kIntersection &&
+      RBTreeSearchEach(others, own)) {
+    combineEach(other, op);
+    return;
+  }
+  bool skipThroughOther = !takesOthers && RBTreeSearchEach(own, others);
+
+  Node* list = nullptr;
+  flattenInto(root, list);
+  root = nullptr;
+  Node* kept = nullptr;
+  Node** tail = &kept;
+  Node* theirs = other.root;
+  while (theirs != nullptr && theirs->left != nullptr) theirs = theirs->left;
+  try {
+    while (list != nullptr || (takesOthers && theirs != nullptr)) {
+      int order = list == nullptr     ? 1
+                  : theirs == nullptr ? -1
+                                      : RBTreeThreeWay(compare, nodeKey(list),
+                                                       nodeKey(theirs));
+      if (order > 0) {
+        if (takesOthers) {
+          *tail = copyOf(theirs);
+          tail = &(*tail)->right;
+          theirs = findNext(theirs);
+        } else if (skipThroughOther) {
+          // First of other's keys that is not less than the next own key.
+          Node* bound = nullptr;
+          for (Node* current = other.root; current != nullptr;) {
+            if (compare(nodeKey(current), nodeKey(list))) {
+              current = current->right;
+            } else {
+              bound = current;
+              current = current->left;
+            }
+          }
+          theirs = bound;
+        } else {
+          theirs = findNext(theirs);
+        }
+        continue;
+      }
+      Node* node = list;
+      list = list->right;
+      std::size_t count = occurrences(node);
+      if (order == 0) {
+        count = RBTreeCombinedCount(op, count, occurrences(theirs));
+        theirs = findNext(theirs);
+      } else if (op == RBTreeSetOp::kIntersection) {
+        count = 0;
+      }
+      if (count == 0) {
+        destroyNode(node);
+        continue;
+      }
+      if constexpr (Keys == RBTreeKeys::kCounted) {
+        node->count = count;
+      }
+      *tail = node;
+      tail = &node->right;
+    }
+  } catch (...) {
+    *tail = list;
+    linkSorted(kept);
+    throw;
+  }
+  *tail = nullptr;
+  linkSorted(kept);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::combineEach(const RBTree& other,
+                                                RBTreeSetOp op) {
+  Node* theirs = other.root;
+  while (theirs != nullptr && theirs->left != nullptr) theirs = theirs->left;
+  for (; theirs != nullptr; theirs = findNext(theirs)) {
+    InsertSlot slot = findInsertSlot(nodeKey(theirs));
+    if (slot.match == nullptr) {
+      if (op != RBTreeSetOp::kDifference) {
+        attachNode(slot.parent, slot.asLeft, copyOf(theirs));
+      }
+      continue;
+    }
+    std::size_t own = occurrences(slot.match);
+    std::size_t count = RBTreeCombinedCount(op, own, occurrences(theirs));
+    if (count == 0) {
+      unlinkNode(slot.match);
+      destroyNode(slot.match);
+    } else if constexpr (Keys == RBTreeKeys::kCounted) {
+      int delta = static_cast<int>(count) - static_cast<int>(own);
+      slot.match->count = count;
+      treeSize += delta;
+      adjustSizesUpward(slot.match, delta);
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::mergeLinear(RBTree& other) {
+  Node* ownList = nullptr;
+  Node* theirList = nullptr;
+  flattenInto(root, ownList);
+  flattenInto(other.root, theirList);
+  root = nullptr;
+  other.root = nullptr;
+  Node* merged = nullptr;
+  Node** tail = &merged;
+  Node* left = nullptr;
+  Node** leftTail = &left;
+  try {
+    while (theirList != nullptr) {
+      int order = ownList == nullptr
+                      ? 1
+                      : RBTreeThreeWay(compare, nodeKey(ownList),
+                                       nodeKey(theirList));
+      // Equal keys of a kEqual tree: this tree's go first.
+      if (order < 0 || (order == 0 && Keys == RBTreeKeys::kEqual)) {
+        *tail = ownList;
+        tail = &ownList->right;
+        ownList = ownList->right;
+        continue;
+      }
+      Node* node = theirList;
+      if (order == 0) {
+        theirList = node->right;
+        if constexpr (Keys == RBTreeKeys::kCounted) {
+          ownList->count += node->count;
+          other.destroyNode(node);
+        } else {
+          *leftTail = node;
+          leftTail = &node->right;
+        }
+        continue;
+      }
+      Node* moved = relocateNode(node, other.allocator);
+      theirList = node->right;
+      if (moved != node) {
+        other.destroyNode(node);
+      }
+      *tail = moved;
+      tail = &moved->right;
+    }
+  } catch (...) {
+    *tail = ownList;
+    *leftTail = theirList;
+    linkSorted(merged);
+    other.linkSorted(left);
+    throw;
+  }
+  *tail = ownList;
+  *leftTail = nullptr;
+  linkSorted(merged);
+  other.linkSorted(left);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::rbTransplant(Node* u, Node* v) {
   if (u->parent == nullptr) {
     root = v;
   } else if (u == u->parent->left) {
@@ -300,53 +1906,77 @@ void RBTree<KeyType, ValueType>::rbTransplant(Node* u, Node* v) {
   }
 }
 
-template <typename KeyType, typename ValueType>
-typename RBTree<KeyType, ValueType>::Node* RBTree<KeyType, ValueType>::minimum(
-    Node* node) {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::minimum(Node* node) {
   while (node->left != nullptr) {
     node = node->left;
   }
   return node;
 }
 
-template <typename KeyType, typename ValueType>
-typename RBTree<KeyType, ValueType>::Node*
-RBTree<KeyType, ValueType>::minimum() {
-  return minimum(this->root);
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::minimum() {
+  return this->root == nullptr ? nullptr : minimum(this->root);
 }
 
-template <typename KeyType, typename ValueType>
-typename RBTree<KeyType, ValueType>::Node* RBTree<KeyType, ValueType>::maximum(
-    Node* node) {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::maximum(Node* node) {
   while (node->right != nullptr) {
     node = node->right;
   }
   return node;
 }
 
-template <typename KeyType, typename ValueType>
-typename RBTree<KeyType, ValueType>::Node*
-RBTree<KeyType, ValueType>::maximum() {
-  return maximum(this->root);
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::maximum() {
+  return rightmost;
 }
 
-template <typename KeyType, typename ValueType>
-bool RBTree<KeyType, ValueType>::contains(const KeyType& key) const {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+template <typename K, typename>
+bool RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::contains(const K& key) const {
   Node* current = root;
   while (current != nullptr) {
-    if (key == current->key) {
-      return true;
-    } else if (key < current->key) {
+    int order = RBTreeThreeWay(compare, key, nodeKey(current));
+    if (order < 0) {
       current = current->left;
-    } else {
+    } else if (order > 0) {
       current = current->right;
+    } else {
+      return true;
     }
   }
   return false;
 }
 
-template <typename KeyType, typename ValueType>
-void RBTree<KeyType, ValueType>::fixRemoveViolation(Node* x, Node* xParent) {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::fixRemoveViolation(Node* x, Node* xParent) {
   Node* sibling;
   while (x != root && (x == nullptr || x->color == BLACK)) {
     if (x == xParent->left) {
@@ -413,56 +2043,124 @@ void RBTree<KeyType, ValueType>::fixRemoveViolation(Node* x, Node* xParent) {
   }
   if (x != nullptr) x->color = BLACK;
 }
-template <typename KeyType, typename ValueType>
-typename RBTree<KeyType, ValueType>::Node* copyNode(
-    const typename RBTree<KeyType, ValueType>::Node* node,
-    typename RBTree<KeyType, ValueType>::Node* parent = nullptr) {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::copyNode(const Node* node, Node* parent) {
   if (node == nullptr) return nullptr;
 
-  typename RBTree<KeyType, ValueType>::Node* newNode =
-      new typename RBTree<KeyType, ValueType>::Node(node->key, node->value);
+  Node* newNode = createNode(nodeKey(node), node->value);
   newNode->color = node->color;
   newNode->parent = parent;
+  if constexpr (OrderStatistics) {
+    newNode->size = node->size;
+  }
+  if constexpr (Keys == RBTreeKeys::kCounted) {
+    newNode->count = node->count;
+  }
 
-  newNode->left = copyNode<KeyType, ValueType>(node->left, newNode);
-  newNode->right = copyNode<KeyType, ValueType>(node->right, newNode);
+  newNode->left = copyNode(node->left, newNode);
+  newNode->right = copyNode(node->right, newNode);
 
   return newNode;
 }
-template <typename KeyType, typename ValueType>
-RBTree<KeyType, ValueType>& RBTree<KeyType, ValueType>::operator=(
-    const RBTree<KeyType, ValueType>& other) {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>&
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::operator=(const RBTree& other) {
   if (this != &other) {
     clear();
+    compare = other.compare;
+    if constexpr (NodeTraits::propagate_on_container_copy_assignment::value) {
+      allocator = other.allocator;
+    }
     root = copyNode(other.root);
+    rightmost = root == nullptr ? nullptr : maximum(root);
     treeSize = other.treeSize;
   }
   return *this;
 }
-template <typename KeyType, typename ValueType>
-RBTree<KeyType, ValueType>& RBTree<KeyType, ValueType>::operator=(
-    RBTree<KeyType, ValueType>&& other) noexcept {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>&
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::operator=(RBTree&& other) noexcept(
+    NodeTraits::propagate_on_container_move_assignment::value ||
+    NodeTraits::is_always_equal::value) {
   if (this != &other) {
     clear();
+    compare = other.compare;
+    if constexpr (NodeTraits::propagate_on_container_move_assignment::value) {
+      allocator = std::move(other.allocator);
+    } else if (!(allocator == other.allocator)) {
+      // The nodes stay with other's allocator; their values move over.
+      root = other.root;
+      treeSize = other.treeSize;
+      other.root = nullptr;
+      other.rightmost = nullptr;
+      other.treeSize = 0;
+      try {
+        adoptSubtree(root, other.allocator);
+      } catch (...) {
+        treeSize = countElements(root);
+        rightmost = root == nullptr ? nullptr : maximum(root);
+        throw;
+      }
+      rightmost = root == nullptr ? nullptr : maximum(root);
+      return *this;
+    }
     root = other.root;
+    rightmost = other.rightmost;
     treeSize = other.treeSize;
     other.root = nullptr;
+    other.rightmost = nullptr;
     other.treeSize = 0;
   }
   return *this;
 }
-template <typename KeyType, typename ValueType>
-RBTree<KeyType, ValueType>::RBTree(const RBTree& other)
-    : root(copyNode(other.root)), treeSize(other.treeSize) {}
-template <typename KeyType, typename ValueType>
-RBTree<KeyType, ValueType>::RBTree(RBTree&& other) noexcept
-    : root(other.root), treeSize(other.treeSize) {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::RBTree(const RBTree& other)
+    : allocator(NodeTraits::select_on_container_copy_construction(
+          other.allocator)),
+      compare(other.compare),
+      root(nullptr),
+      rightmost(nullptr),
+      treeSize(other.treeSize) {
+  root = copyNode(other.root);
+  rightmost = root == nullptr ? nullptr : maximum(root);
+}
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::RBTree(RBTree&& other) noexcept
+    : allocator(std::move(other.allocator)),
+      compare(other.compare),
+      root(other.root),
+      rightmost(other.rightmost),
+      treeSize(other.treeSize) {
   other.root = nullptr;
+  other.rightmost = nullptr;
   other.treeSize = 0;
 }
-template <typename KeyType, typename ValueType>
-typename RBTree<KeyType, ValueType>::Node* RBTree<KeyType, ValueType>::findNext(
-    Node* node) {
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::findNext(Node* node) {
   if (node == nullptr) return nullptr;
   if (node->right != nullptr) {
     Node* current = node->right;
@@ -479,4 +2177,200 @@ typename RBTree<KeyType, ValueType>::Node* RBTree<KeyType, ValueType>::findNext(
   return parent;
 }
 
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::findPrev(Node* node) {
+  if (node == nullptr) return nullptr;
+  if (node->left != nullptr) {
+    Node* current = node->left;
+    while (current->right != nullptr) {
+      current = current->right;
+    }
+    return current;
+  }
+  Node* parent = node->parent;
+  while (parent != nullptr && node == parent->left) {
+    node = parent;
+    parent = parent->parent;
+  }
+  return parent;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+template <typename K, typename>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::lowerBound(const K& key) {
+  Node* result = nullptr;
+  Node* current = root;
+  while (current != nullptr) {
+    if (compare(nodeKey(current), key)) {
+      current = current->right;
+    } else {
+      result = current;
+      current = current->left;
+    }
+  }
+  return result;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+template <typename K, typename>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::upperBound(const K& key) {
+  Node* result = nullptr;
+  Node* current = root;
+  while (current != nullptr) {
+    if (compare(key, nodeKey(current))) {
+      result = current;
+      current = current->left;
+    } else {
+      current = current->right;
+    }
+  }
+  return result;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+const KeyType& RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                      KeyOfValue, Compare>::nodeKey(const Node* node) {
+  if constexpr (KeyOfValue::kStoresKey) {
+    return node->key;
+  } else {
+    return KeyOfValue::get(node->value);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+std::size_t RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                   KeyOfValue, Compare>::occurrences(const Node* node) {
+  if constexpr (Keys == RBTreeKeys::kCounted) {
+    return node->count;
+  } else {
+    return 1;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+std::size_t RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                   KeyOfValue, Compare>::subtreeSize(const Node* node) {
+  if constexpr (OrderStatistics) {
+    return node == nullptr ? 0 : node->size;
+  } else {
+    return 0;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::updateSize(Node* node) {
+  if constexpr (OrderStatistics) {
+    node->size =
+        occurrences(node) + subtreeSize(node->left) + subtreeSize(node->right);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+void RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+            KeyOfValue, Compare>::adjustSizesUpward(Node* node, int delta) {
+  if constexpr (OrderStatistics) {
+    for (; node != nullptr; node = node->parent) {
+      node->size += delta;
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+typename RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                KeyOfValue, Compare>::Node*
+RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+       KeyOfValue, Compare>::select(std::size_t index) {
+  static_assert(OrderStatistics, "select requires OrderStatistics");
+  Node* current = root;
+  while (current != nullptr) {
+    std::size_t leftSize = subtreeSize(current->left);
+    if (index < leftSize) {
+      current = current->left;
+    } else if (index < leftSize + occurrences(current)) {
+      return current;
+    } else {
+      index -= leftSize + occurrences(current);
+      current = current->right;
+    }
+  }
+  return nullptr;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+template <typename K, typename>
+std::size_t RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                   KeyOfValue, Compare>::rank(const K& key) const {
+  static_assert(OrderStatistics, "rank requires OrderStatistics");
+  std::size_t result = 0;
+  const Node* current = root;
+  while (current != nullptr) {
+    if (compare(nodeKey(current), key)) {
+      result += subtreeSize(current->left) + occurrences(current);
+      current = current->right;
+    } else {
+      current = current->left;
+    }
+  }
+  return result;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator,
+          bool OrderStatistics, RBTreeKeys Keys, typename KeyOfValue,
+          typename Compare>
+template <typename K, typename>
+std::size_t RBTree<KeyType, ValueType, Allocator, OrderStatistics, Keys,
+                   KeyOfValue, Compare>::countInRange(const K& low,
+                                                      const K& high) const {
+  static_assert(OrderStatistics, "countInRange requires OrderStatistics");
+  if (!compare(low, high)) return 0;
+  return rank<K>(high) - rank<K>(low);
+}
+
+// Backend tag for Map and MultiSet: selects the tree the container is built
+// on and how its nodes find their keys. OrderStatistics adds the subtree
+// sizes needed for select and rank.
+// Containers with equal keys get one node per element, or one counted node
+// per distinct key with CountDuplicates.
+template <bool OrderStatistics = false, bool CountDuplicates = false>
+struct RBTreeBackend {
+  template <typename KeyType, typename ValueType, typename Allocator,
+            bool UniqueKeys, typename KeyOfValue,
+            typename Compare = std::less<KeyType>>
+  using tree = RBTree<KeyType, ValueType, Allocator, OrderStatistics,
+                      UniqueKeys        ? RBTreeKeys::kUnique
+                      : CountDuplicates ? RBTreeKeys::kCounted
+                                        : RBTreeKeys::kEqual,
+                      KeyOfValue, Compare>;
+};
+
 #endif  // SRC_RB_TREE_H
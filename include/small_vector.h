@@ -0,0 +1,171 @@
+#ifndef INCLUDE_SMALL_VECTOR_H_
+#define INCLUDE_SMALL_VECTOR_H_
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "custom_vector.h"
+
+// Raw storage for N elements, a base of SmallVector so that it is built
+// before the CustomVector that uses it and outlives its elements.
+template <class T, std::size_t N>
+class SmallVectorBuffer {
+ protected:
+  T* buffer() { return reinterpret_cast<T*>(bytes); }
+
+ private:
+  alignas(T) unsigned char bytes[N * sizeof(T)];
+};
+
+// CustomVector that keeps up to N elements inside the object and goes to
+// the allocator only when it needs more room, so that short vectors cost
+// no allocation at all. It is a CustomVector and can be passed wherever
+// one is taken by reference.
+//
+// Once spilled, the elements stay on the heap until shrink_to_fit() or
+// clear() brings them back inline; a vector moved from is left empty on
+// its inline buffer. Moving a vector whose elements are
+// inline moves them one by one (or as bytes, for trivially relocatable
+// types), so unlike a heap vector's, its move invalidates iterators. Swap
+// does the same for whichever side is inline.
+template <class T, std::size_t N, class Allocator = std::allocator<T>>
+class SmallVector : private SmallVectorBuffer<T, N>,
+                    public CustomVector<T, Allocator> {
+  static_assert(N > 0, "SmallVector needs room for at least one element.");
+
+ public:
+  using vector = CustomVector<T, Allocator>;
+  using typename vector::allocator_type;
+  using typename vector::size_type;
+  static constexpr size_type inline_capacity = N;
+
+  SmallVector();
+  explicit SmallVector(const Allocator& alloc);
+  SmallVector(const SmallVector& other);
+  SmallVector(const SmallVector& other, const Allocator& alloc);
+  SmallVector(SmallVector&& other) noexcept(
+      std::is_nothrow_move_constructible<T>::value ||
+      IsTriviallyRelocatable<T>::value);
+  ~SmallVector() = default;
+
+  SmallVector& operator=(const SmallVector& other);
+  SmallVector& operator=(SmallVector&& other);
+
+  void shrink_to_fit();
+  void clear();
+  void swap(SmallVector& other);
+  // Whether the elements are in the inline buffer.
+  bool is_inline() const;
+
+ private:
+  using Buffer = SmallVectorBuffer<T, N>;
+  using Traits = std::allocator_traits<Allocator>;
+
+  // Moves the elements into the inline buffer, which must hold them.
+  void returnInline();
+};
+
+template <class T, std::size_t N, class Allocator>
+SmallVector<T, N, Allocator>::SmallVector() : SmallVector(Allocator()) {}
+
+template <class T, std::size_t N, class Allocator>
+SmallVector<T, N, Allocator>::SmallVector(const Allocator& alloc)
+    : Buffer(), vector(Buffer::buffer(), N, alloc) {}
+
+template <class T, std::size_t N, class Allocator>
+SmallVector<T, N, Allocator>::SmallVector(const SmallVector& other)
+    : SmallVector(other, Traits::select_on_container_copy_construction(
+                             other.allocator)) {}
+
+template <class T, std::size_t N, class Allocator>
+SmallVector<T, N, Allocator>::SmallVector(const SmallVector& other,
+                                          const Allocator& alloc)
+    : SmallVector(alloc) {
+  this->reserve(other.size_);
+  this->copyInto(other.array, other.array + other.size_, this->array);
+  this->size_ = other.size_;
+}
+
+template <class T, std::size_t N, class Allocator>
+SmallVector<T, N, Allocator>::SmallVector(SmallVector&& other) noexcept(
+    std::is_nothrow_move_constructible<T>::value ||
+    IsTriviallyRelocatable<T>::value)
+    : SmallVector(other.allocator) {
+  this->take(other);
+  other.returnInline();
+}
+
+// The copy is built inline when it fits, then moved over.
+template <class T, std::size_t N, class Allocator>
+SmallVector<T, N, Allocator>& SmallVector<T, N, Allocator>::operator=(
+    const SmallVector& other) {
+  if (this != &other) {
+    if constexpr (Traits::propagate_on_container_copy_assignment::value) {
+      SmallVector copy(other, other.allocator);
+      clear();
+      this->allocator = other.allocator;
+      this->take(copy);
+    } else {
+      SmallVector copy(other, this->allocator);
+      this->take(copy);
+    }
+  }
+  return *this;
+}
+
+template <class T, std::size_t N, class Allocator>
+SmallVector<T, N, Allocator>& SmallVector<T, N, Allocator>::operator=(
+    SmallVector&& other) {
+  if (this != &other) {
+    vector::operator=(std::move(other));
+    other.returnInline();
+  }
+  return *this;
+}
+
+template <class T, std::size_t N, class Allocator>
+void SmallVector<T, N, Allocator>::shrink_to_fit() {
+  if (this->inlineArray_) return;
+  if (this->size_ <= N) {
+    returnInline();
+  } else {
+    vector::shrink_to_fit();
+  }
+}
+
+template <class T, std::size_t N, class Allocator>
+void SmallVector<T, N, Allocator>::clear() {
+  vector::clear();
+  returnInline();
+}
+
+template <class T, std::size_t N, class Allocator>
+void SmallVector<T, N, Allocator>::swap(SmallVector& other) {
+  if (!this->inlineArray_ && !other.inlineArray_) {
+    vector::swap(other);
+    return;
+  }
+  SmallVector held(std::move(other));
+  other = std::move(*this);
+  *this = std::move(held);
+}
+
+template <class T, std::size_t N, class Allocator>
+bool SmallVector<T, N, Allocator>::is_inline() const {
+  return this->inlineArray_;
+}
+
+template <class T, std::size_t N, class Allocator>
+void SmallVector<T, N, Allocator>::returnInline() {
+  if (this->inlineArray_) return;
+  T* inlineArray = Buffer::buffer();
+  this->transfer(this->array, this->array + this->size_, inlineArray);
+  this->freeArray();
+  this->array = inlineArray;
+  this->capacity_ = N;
+  this->inlineArray_ = true;
+}
+
+#endif  // INCLUDE_SMALL_VECTOR_H_
@@ -0,0 +1,127 @@
+#ifndef INCLUDE_VECTOR_GROWTH_H_
+#define INCLUDE_VECTOR_GROWTH_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+// Growth policies for CustomVector, its third template parameter. A policy
+// is an object the vector keeps; when the vector is full it asks
+//   std::size_t next(std::size_t capacity, std::size_t elementSize)
+// for a capacity larger than `capacity`, and after every reallocation it
+// reports what happened to
+//   void relocated(const VectorReallocation& reallocation)
+// The policy belongs to the vector object: it is default-constructed with
+// it and is not copied, moved or swapped along with the elements.
+
+// What one reallocation did: the capacities before and after, the elements
+// it moved and the bytes it copied to move them. realloc that grows a block
+// in place copies nothing.
+struct VectorReallocation {
+  std::size_t oldCapacity;
+  std::size_t newCapacity;
+  std::size_t size;
+  std::size_t bytesCopied;
+  std::size_t elementSize;
+};
+
+// Multiplies the capacity by Numerator / Denominator, growing by at least
+// one element. DoublingGrowth makes the fewest reallocations and leaves up
+// to half of the buffer unused; 1.5x leaves at most a third and lets a
+// freed block be reused once the vector has grown a few times.
+template <std::size_t Numerator, std::size_t Denominator = 1>
+struct GeometricGrowth {
+  static_assert(Numerator > Denominator, "Growth factor must exceed one.");
+
+  static std::size_t next(std::size_t capacity, std::size_t) {
+    if (capacity > std::numeric_limits<std::size_t>::max() / Numerator) {
+      return std::numeric_limits<std::size_t>::max();
+    }
+    return std::max(capacity + 1, capacity * Numerator / Denominator);
+  }
+  static void relocated(const VectorReallocation&) {}
+};
+
+using DoublingGrowth = GeometricGrowth<2>;
+using HalfAgainGrowth = GeometricGrowth<3, 2>;
+
+// Adds ChunkBytes worth of elements at a time, so no more than one chunk
+// is ever unused. The number of reallocations grows linearly with size:
+// only worth it where realloc can extend the block in place, or when the
+// final size is close to known.
+template <std::size_t ChunkBytes = 65536>
+struct ChunkGrowth {
+  static std::size_t next(std::size_t capacity, std::size_t elementSize) {
+    std::size_t step = std::max<std::size_t>(ChunkBytes / elementSize, 1);
+    if (capacity > std::numeric_limits<std::size_t>::max() - step) {
+      return std::numeric_limits<std::size_t>::max();
+    }
+    return capacity + step;
+  }
+  static void relocated(const VectorReallocation&) {}
+};
+
+// Grows by half and rounds the block up to what the allocator hands out
+// anyway, so the rounding becomes capacity rather than waste. Below a page
+// that is one of four size classes per power of two, as in jemalloc and
+// tcmalloc; from a page up it is whole pages. The first block already
+// holds 16 bytes of elements.
+struct SizeClassGrowth {
+  static constexpr std::size_t kMinBlockBytes = 16;
+  static constexpr std::size_t kPageBytes = 4096;
+
+  static std::size_t next(std::size_t capacity, std::size_t elementSize) {
+    std::size_t target = HalfAgainGrowth::next(capacity, elementSize);
+    if (target >
+        (std::numeric_limits<std::size_t>::max() - kPageBytes) / elementSize) {
+      return target;
+    }
+    return blockBytes(target * elementSize) / elementSize;
+  }
+  static void relocated(const VectorReallocation&) {}
+
+  // The smallest size class that holds `bytes`.
+  static std::size_t blockBytes(std::size_t bytes) {
+    if (bytes <= kMinBlockBytes) return kMinBlockBytes;
+    std::size_t step = kPageBytes;
+    if (bytes <= kPageBytes) {
+      std::size_t power = kMinBlockBytes;
+      while (power * 2 < bytes) power *= 2;
+      step = std::max(power / 4, kMinBlockBytes);
+    }
+    return (bytes + step - 1) / step * step;
+  }
+};
+
+// Wraps a policy and keeps count of the vector's reallocations: how many
+// there were, the bytes they copied, and the most unused capacity any of
+// them left, in bytes. Read through CustomVector::growth_policy().
+template <typename Growth = DoublingGrowth>
+class GrowthStats {
+ public:
+  std::size_t next(std::size_t capacity, std::size_t elementSize) {
+    return growth.next(capacity, elementSize);
+  }
+  void relocated(const VectorReallocation& reallocation) {
+    ++reallocations_;
+    bytesCopied_ += reallocation.bytesCopied;
+    if (reallocation.newCapacity > reallocation.size) {
+      peakSlack_ = std::max(peakSlack_, (reallocation.newCapacity -
+                                         reallocation.size) *
+                                            reallocation.elementSize);
+    }
+    growth.relocated(reallocation);
+  }
+
+  std::size_t reallocations() const { return reallocations_; }
+  std::size_t bytes_copied() const { return bytesCopied_; }
+  std::size_t peak_slack_bytes() const { return peakSlack_; }
+
+ private:
+  Growth growth;
+  std::size_t reallocations_ = 0;
+  std::size_t bytesCopied_ = 0;
+  std::size_t peakSlack_ = 0;
+};
+
+#endif  // INCLUDE_VECTOR_GROWTH_H_
@@ -0,0 +1,242 @@
+#include "arena_resource.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "pmr_containers.h"
+
+namespace {
+
+// Upstream that counts what passes through it.
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  std::size_t allocations = 0;
+  std::size_t live = 0;
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    ++allocations;
+    ++live;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* ptr, std::size_t bytes,
+                     std::size_t alignment) override {
+    --live;
+    std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+  }
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+// Makes every allocation through the default resource throw while alive,
+// so a container that bypasses its allocator fails the test.
+class NoDefaultResource {
+ public:
+  NoDefaultResource()
+      : previous(std::pmr::set_default_resource(
+            std::pmr::null_memory_resource())) {}
+  ~NoDefaultResource() { std::pmr::set_default_resource(previous); }
+
+ private:
+  std::pmr::memory_resource* previous;
+};
+
+void Fill(ArenaResource& arena, int count, std::size_t bytes) {
+  for (int i = 0; i < count; ++i) {
+    ASSERT_NE(arena.allocate(bytes, alignof(std::max_align_t)), nullptr);
+  }
+}
+
+bool AlignedTo(const void* ptr, std::size_t alignment) {
+  return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+}  // namespace
+
+TEST(ArenaResourceTest, BumpAllocation) {
+  CountingResource upstream;
+  ArenaResource arena(&upstream);
+  void* first = arena.allocate(24, 8);
+  void* second = arena.allocate(8, 8);
+  EXPECT_EQ(static_cast<char*>(second), static_cast<char*>(first) + 24);
+  void* line = arena.allocate(64, 64);
+  EXPECT_TRUE(AlignedTo(line, 64));
+  arena.deallocate(first, 24, 8);
+  EXPECT_EQ(upstream.allocations, 1u);
+  EXPECT_EQ(arena.chunk_count(), 1u);
+  EXPECT_GE(arena.used_bytes(), 96u);
+  EXPECT_GE(arena.reserved_bytes(), arena.used_bytes());
+}
+TEST(ArenaResourceTest, ChunksGrowGeometrically) {
+  CountingResource upstream;
+  ArenaResource arena(64, &upstream);
+  Fill(arena, 10000, 16);
+  EXPECT_EQ(arena.used_bytes(), 160000u);
+  EXPECT_LT(upstream.allocations, 16u);
+  void* big = arena.allocate(1 << 20, 16);
+  EXPECT_TRUE(AlignedTo(big, 16));
+  EXPECT_GE(arena.reserved_bytes(), 160000u + (1u << 20));
+}
+TEST(ArenaResourceTest, ReleaseAndReset) {
+  CountingResource upstream;
+  {
+    ArenaResource arena(64, &upstream);
+    Fill(arena, 100, 32);
+    EXPECT_GT(arena.chunk_count(), 1u);
+    arena.reset();
+    EXPECT_EQ(arena.chunk_count(), 1u);
+    EXPECT_EQ(arena.used_bytes(), 0u);
+    EXPECT_EQ(upstream.live, 1u);
+    // The kept chunk is smaller than the whole first request; the one the
+    // second request ends in holds all of it.
+    Fill(arena, 100, 32);
+    arena.reset();
+    std::size_t allocations = upstream.allocations;
+    Fill(arena, 100, 32);
+    EXPECT_EQ(upstream.allocations, allocations);
+    arena.release();
+    EXPECT_EQ(arena.chunk_count(), 0u);
+    EXPECT_EQ(arena.reserved_bytes(), 0u);
+    EXPECT_EQ(upstream.live, 0u);
+    Fill(arena, 1, 8);
+  }
+  EXPECT_EQ(upstream.live, 0u);
+}
+TEST(ArenaResourceTest, ContainersAllocateFromTheArena) {
+  ArenaResource arena;
+  NoDefaultResource guard;
+  pmr::CustomVector<std::pmr::string> vector(&arena);
+  pmr::CustomList<int> list(&arena);
+  pmr::CustomStack<int> stack(&arena);
+  pmr::CustomQueue<int> queue(&arena);
+  pmr::CustomSet<int> set(&arena);
+  pmr::Map<int, int> map(&arena);
+  pmr::MultiSet<int> multiset(&arena);
+  pmr::HashMap<int, int> hashMap(&arena);
+  pmr::HashSet<int> hashSet(&arena);
+  for (int i = 0; i < 100; ++i) {
+    vector.emplace_back("a string too long for the small buffer");
+    list.push_back(i);
+    stack.push(i);
+    queue.push(i);
+    set.insert(i);
+    map.insert(i, i);
+    multiset.insert(i % 10);
+    hashMap.insert(i, i);
+    hashSet.insert(i);
+  }
+  set.freeze();
+  EXPECT_TRUE(set.contains(42));
+  EXPECT_EQ(vector[99].get_allocator().resource(), &arena);
+  EXPECT_EQ(list.size(), 100u);
+  EXPECT_EQ(stack.top(), 99);
+  EXPECT_EQ(queue.front(), 0);
+  EXPECT_EQ(map.at(7), 7);
+  EXPECT_EQ(multiset.count(3), 10u);
+  EXPECT_TRUE(hashMap.contains(50));
+  EXPECT_TRUE(hashSet.contains(50));
+  EXPECT_EQ(vector.get_allocator().resource(), &arena);
+  EXPECT_GT(arena.used_bytes(), 100 * 40u);
+}
+TEST(ArenaResourceTest, CopiesTakeTheDefaultResource) {
+  ArenaResource arena;
+  pmr::CustomVector<int> vector(&arena);
+  vector.push_back(1);
+  pmr::CustomVector<int> copy(vector);
+  EXPECT_EQ(copy.get_allocator().resource(),
+            std::pmr::get_default_resource());
+  pmr::CustomVector<int> onArena(vector, &arena);
+  EXPECT_EQ(onArena.get_allocator().resource(), &arena);
+  EXPECT_EQ(onArena[0], 1);
+}
+TEST(ArenaResourceTest, SplitAndConcat) {
+  // The split-off part takes the default resource, so its values move.
+  ArenaResource arena;
+  pmr::Map<int, std::string> map(&arena);
+  for (int i = 0; i < 100; ++i) map.insert(i, std::to_string(i));
+  pmr::Map<int, std::string> tail = map.split_at(60);
+  EXPECT_EQ(map.size(), 60u);
+  EXPECT_EQ(tail.size(), 40u);
+  EXPECT_EQ(tail.at(99), "99");
+  map.concat(tail);
+  EXPECT_TRUE(tail.empty());
+  EXPECT_EQ(map.size(), 100u);
+  EXPECT_EQ(map.at(60), "60");
+
+  pmr::MultiSet<int> multiset(&arena);
+  for (int i = 0; i < 100; ++i) multiset.insert(i % 10);
+  pmr::MultiSet<int> high = multiset.split_at(7);
+  EXPECT_EQ(multiset.size(), 70u);
+  EXPECT_EQ(high.count(8), 10u);
+  multiset.concat(high);
+  EXPECT_EQ(multiset.size(), 100u);
+  EXPECT_EQ(multiset.count(9), 10u);
+}
+TEST(ArenaResourceTest, BTreeSetAlgebraStaysInTheArena) {
+  using BTreeMap = pmr::Map<int, int, BTreeBackend<>>;
+  ArenaResource arena;
+  NoDefaultResource guard;
+  BTreeMap map(&arena);
+  BTreeMap other(&arena);
+  for (int i = 0; i < 1000; ++i) map.insert(i * 2, i);
+  for (int i = 0; i < 1000; ++i) other.insert(i * 3, i);
+  map.intersect_with(other);
+  EXPECT_EQ(map.size(), 334u);
+  map.union_with(other);
+  EXPECT_EQ(map.size(), 1000u);
+  map.difference_with(other);
+  EXPECT_TRUE(map.empty());
+  map.insert(1, 1);
+  map.symmetric_difference_with(other);
+  EXPECT_EQ(map.size(), 1001u);
+  EXPECT_EQ(map.at(3), 1);
+}
+TEST(ArenaResourceTest, MovesBetweenResources) {
+  ArenaResource source;
+  ArenaResource target;
+  pmr::CustomList<int> from(&source);
+  pmr::CustomList<int> to(&target);
+  for (int i = 0; i < 10; ++i) from.push_back(i);
+  std::size_t used = target.used_bytes();
+  to = std::move(from);
+  EXPECT_EQ(to.get_allocator().resource(), &target);
+  EXPECT_EQ(to.size(), 10u);
+  EXPECT_EQ(to.back(), 9);
+  EXPECT_GT(target.used_bytes(), used);
+
+  pmr::CustomSet<int> setFrom(&source);
+  pmr::CustomSet<int> setTo(&target);
+  setFrom.insert(3);
+  setFrom.insert(1);
+  setTo = std::move(setFrom);
+  EXPECT_TRUE(setFrom.empty());
+  EXPECT_TRUE(setTo.contains(1));
+  EXPECT_EQ(setTo.get_allocator().resource(), &target);
+
+  // Move-only values move into nodes on the target resource.
+  pmr::Map<int, std::unique_ptr<int>> mapFrom(&source);
+  pmr::Map<int, std::unique_ptr<int>> mapTo(&target);
+  for (int i = 0; i < 100; ++i) mapFrom.try_emplace(i, new int(i));
+  const int* pointee = mapFrom.at(42).get();
+  used = target.used_bytes();
+  mapTo = std::move(mapFrom);
+  EXPECT_TRUE(mapFrom.empty());
+  EXPECT_EQ(mapTo.size(), 100u);
+  EXPECT_EQ(mapTo.at(42).get(), pointee);
+  EXPECT_GT(target.used_bytes(), used);
+  mapTo.try_emplace(100, std::make_unique<int>(100));
+  EXPECT_EQ(*mapTo.at(100), 100);
+  static_assert(!std::is_nothrow_move_assignable<pmr::MultiSet<int>>::value,
+                "Moving between resources allocates.");
+  static_assert(std::is_nothrow_move_assignable<MultiSet<int>>::value,
+                "NodePool moves with the nodes.");
+}
@@ -0,0 +1,169 @@
+#include "b_tree.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Four slots per node, so a few hundred keys already give a deep tree.
+using SmallTree = BTree<int, int, NodePool<int>, true, RBTreeIdentityKey, 16>;
+using SmallMultiTree =
+    BTree<int, int, NodePool<int>, false, RBTreeIdentityKey, 16>;
+
+// Returns the depth of the subtree's leaves, or -1 if it breaks an
+// invariant: ordering, fill, parent links or equal leaf depth.
+template <typename Tree, typename Node = typename Tree::Node>
+int LeafDepth(const Node* node, bool isRoot, std::size_t& count) {
+  constexpr std::size_t kMin = (Tree::kSlots - 1) / 2;
+  if (node->count > Tree::kSlots || (!isRoot && node->count < kMin)) {
+    return -1;
+  }
+  for (std::size_t i = 1; i < node->count; ++i) {
+    if (node->values[i] < node->values[i - 1]) return -1;
+  }
+  count += node->count;
+  if (node->leaf) return 1;
+  int depth = -1;
+  for (std::size_t i = 0; i <= node->count; ++i) {
+    const Node* next =
+        static_cast<const typename Tree::InternalNode*>(node)->children[i];
+    if (next->parent != node || next->position != i) return -1;
+    if (i > 0 && next->values[0] < node->values[i - 1]) return -1;
+    if (i < node->count &&
+        node->values[i] < next->values[next->count - 1u]) {
+      return -1;
+    }
+    int childDepth = LeafDepth<Tree>(next, false, count);
+    if (childDepth < 0 || (depth >= 0 && childDepth != depth)) return -1;
+    depth = childDepth;
+  }
+  return depth + 1;
+}
+
+template <typename Tree>
+bool IsValidTree(const Tree& tree) {
+  if (tree.isEmpty()) return true;
+  const typename Tree::Node* root = tree.minimum().node;
+  while (root->parent != nullptr) root = root->parent;
+  std::size_t count = 0;
+  return LeafDepth<Tree>(root, true, count) > 0 &&
+         count == static_cast<std::size_t>(tree.size());
+}
+
+template <typename Tree>
+std::vector<int> Contents(const Tree& tree) {
+  std::vector<int> values;
+  for (auto it = tree.minimum(); it.node != nullptr;
+       it = Tree::findNext(it)) {
+    values.push_back(Tree::valueOf(it));
+  }
+  return values;
+}
+
+}  // namespace
+
+TEST(BTreeTest, InsertAndFind) {
+  using Tree = BTree<int, std::string>;
+  Tree tree;
+  tree.insert(1, "one");
+  tree.insert(2, "two");
+  ASSERT_EQ(Tree::valueOf(tree.find(2)), "two");
+  ASSERT_FALSE(tree.insert(1, "uno").second);
+  ASSERT_EQ(Tree::valueOf(tree.find(1)), "one");
+  ASSERT_TRUE(tree.contains(1));
+  ASSERT_FALSE(tree.contains(3));
+  ASSERT_EQ(tree.size(), 2);
+}
+
+TEST(BTreeTest, RandomInsertEraseKeepsInvariants) {
+  SmallTree tree;
+  std::set<int> expected;
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int> pick(0, 999);
+  for (int step = 0; step < 5000; ++step) {
+    int key = pick(rng);
+    if (step % 3 == 2 && tree.contains(key)) {
+      tree.remove(key);
+      expected.erase(key);
+    } else {
+      bool inserted = tree.insert(key, key).second;
+      ASSERT_EQ(inserted, expected.insert(key).second);
+    }
+    if (step % 250 == 0) {
+      ASSERT_TRUE(IsValidTree(tree));
+    }
+  }
+  ASSERT_TRUE(IsValidTree(tree));
+  std::vector<int> keys(expected.begin(), expected.end());
+  ASSERT_EQ(Contents(tree), keys);
+  for (int key : keys) tree.remove(key);
+  ASSERT_TRUE(tree.isEmpty());
+  ASSERT_EQ(tree.minimum(), SmallTree::Position());
+}
+
+TEST(BTreeTest, WalkBothWays) {
+  SmallTree tree;
+  for (int i = 0; i < 200; ++i) tree.insert(i, i);
+  int expected = 199;
+  for (auto it = tree.maximum(); it.node != nullptr;
+       it = SmallTree::findPrev(it)) {
+    ASSERT_EQ(SmallTree::valueOf(it), expected--);
+  }
+  ASSERT_EQ(expected, -1);
+}
+
+TEST(BTreeTest, LowerAndUpperBound) {
+  SmallTree tree;
+  for (int i = 0; i < 100; ++i) tree.insert(i * 2, i * 2);
+  ASSERT_EQ(SmallTree::valueOf(tree.lowerBound(41)), 42);
+  ASSERT_EQ(SmallTree::valueOf(tree.lowerBound(42)), 42);
+  ASSERT_EQ(SmallTree::valueOf(tree.upperBound(42)), 44);
+  ASSERT_EQ(tree.lowerBound(199), SmallTree::Position());
+  ASSERT_EQ(tree.upperBound(198), SmallTree::Position());
+  ASSERT_EQ(SmallTree::valueOf(tree.upperBound(-1)), 0);
+}
+
+TEST(BTreeTest, EqualKeysAndHints) {
+  SmallMultiTree tree;
+  for (int i = 0; i < 50; ++i) {
+    tree.insert(i % 5, i % 5);
+    tree.insertWithHint(SmallMultiTree::Position(), 100 + i, 100 + i);
+  }
+  ASSERT_TRUE(IsValidTree(tree));
+  ASSERT_EQ(tree.size(), 100);
+  std::size_t threes = 0;
+  for (auto it = tree.lowerBound(3); it != tree.upperBound(3);
+       it = SmallMultiTree::findNext(it)) {
+    ++threes;
+  }
+  ASSERT_EQ(threes, 10u);
+  // A wrong hint falls back to a normal insert.
+  tree.insertWithHint(tree.minimum(), 50, 50);
+  ASSERT_TRUE(IsValidTree(tree));
+  ASSERT_EQ(SmallMultiTree::valueOf(tree.lowerBound(5)), 50);
+}
+
+TEST(BTreeTest, BuildCopyAndMove) {
+  std::vector<std::pair<const int, std::string>> items;
+  for (int i = 0; i < 300; ++i) items.emplace_back(i, std::to_string(i));
+  using Tree = BTree<int, std::pair<const int, std::string>,
+                     NodePool<std::pair<const int, std::string>>, true,
+                     RBTreeFirstKey, 64>;
+  Tree tree;
+  tree.buildFromSorted(items.begin(), items.end(),
+                       [](const auto& item) { return item.first; });
+  ASSERT_EQ(tree.size(), 300);
+  Tree copy(tree);
+  tree.clear();
+  ASSERT_EQ(Tree::valueOf(copy.find(123)).second, "123");
+  Tree moved(std::move(copy));
+  ASSERT_TRUE(copy.isEmpty());
+  ASSERT_EQ(moved.size(), 300);
+  moved.removeNode(moved.find(0));
+  ASSERT_EQ(Tree::valueOf(moved.minimum()).second, "1");
+}
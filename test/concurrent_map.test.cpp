@@ -0,0 +1,128 @@
+#include "concurrent_map.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "custom_map.h"
+
+namespace {
+
+using OrderedShards = ConcurrentMap<int, std::string, std::hash<int>,
+                                    Map<int, std::string>>;
+
+template <typename MapType>
+void SingleThreaded(MapType& map) {
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.insert(1, "one"));
+  EXPECT_FALSE(map.insert(1, "uno"));
+  EXPECT_EQ(map.find(1), std::optional<std::string>("one"));
+  EXPECT_FALSE(map.insert_or_assign(1, "uno"));
+  EXPECT_TRUE(map.insert_or_assign(2, "two"));
+  EXPECT_EQ(map.find(1), std::optional<std::string>("uno"));
+  EXPECT_TRUE(map.update(2, [](std::string& value) { value += "!"; }));
+  EXPECT_FALSE(map.update(3, [](std::string&) {}));
+  EXPECT_EQ(map.find(2), std::optional<std::string>("two!"));
+  EXPECT_TRUE(map.contains(2));
+  EXPECT_EQ(map.size(), 2u);
+  EXPECT_TRUE(map.erase(1));
+  EXPECT_FALSE(map.erase(1));
+  EXPECT_EQ(map.find(1), std::nullopt);
+  // Most shards are empty here.
+  std::size_t visited = 0;
+  map.for_each([&visited](const auto& item) {
+    EXPECT_EQ(item.first, 2);
+    ++visited;
+  });
+  EXPECT_EQ(visited, 1u);
+  map.clear();
+  EXPECT_TRUE(map.empty());
+}
+
+}  // namespace
+
+TEST(ConcurrentMapTest, SingleThreaded) {
+  ConcurrentMap<int, std::string> hashed(8);
+  EXPECT_EQ(hashed.shard_count(), 8u);
+  SingleThreaded(hashed);
+  OrderedShards ordered(5);
+  EXPECT_EQ(ordered.shard_count(), 8u);
+  SingleThreaded(ordered);
+  ConcurrentMap<int, std::string> single(1);
+  SingleThreaded(single);
+  EXPECT_GE((ConcurrentMap<int, int>().shard_count()), 4u);
+}
+
+TEST(ConcurrentMapTest, BatchesKeepInputOrder) {
+  ConcurrentMap<int, int> map(16);
+  std::vector<std::pair<int, int>> items;
+  for (int i = 0; i < 1000; ++i) items.emplace_back(i % 700, i);
+  CustomVector<bool> inserted = map.insert_many(items.begin(), items.end());
+  ASSERT_EQ(inserted.size(), items.size());
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    ASSERT_EQ(inserted[i], i < 700) << i;
+  }
+  EXPECT_EQ(map.size(), 700u);
+
+  std::vector<int> keys;
+  for (int key = 1000; key >= -10; key -= 7) keys.push_back(key);
+  auto found = map.find_many(keys.begin(), keys.end());
+  ASSERT_EQ(found.size(), keys.size());
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    if (keys[i] >= 0 && keys[i] < 700) {
+      ASSERT_EQ(found[i], std::optional<int>(keys[i])) << keys[i];
+    } else {
+      ASSERT_EQ(found[i], std::nullopt) << keys[i];
+    }
+  }
+  EXPECT_EQ(map.find_many(keys.begin(), keys.begin()).size(), 0u);
+
+  long long sum = 0;
+  map.for_each([&sum](const std::pair<const int, int>& item) {
+    sum += item.first;
+  });
+  EXPECT_EQ(sum, 699LL * 700 / 2);
+}
+
+// Writers on disjoint key ranges, readers throughout, and counters bumped
+// by every thread; run under the tsan build mode to check the locking.
+TEST(ConcurrentMapTest, ThreadsShareTheMap) {
+  constexpr int kThreads = 8;
+  constexpr int kKeys = 2000;
+  ConcurrentMap<int, long long> map(16);
+  OrderedShards ordered(4);
+  for (int counter = 0; counter < 16; ++counter) {
+    map.insert(-1 - counter, 0);
+  }
+  std::atomic<int> misses{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < kKeys; ++i) {
+        int key = t * kKeys + i;
+        map.insert(key, key);
+        ordered.insert_or_assign(key, std::to_string(key));
+        map.update(-1 - i % 16, [](long long& value) { ++value; });
+        if (!map.contains(key) || map.find(key) != key) ++misses;
+        if (i % 3 == 0) map.erase(key);
+        std::vector<int> probe = {key, key - 1, -1};
+        auto found = map.find_many(probe.begin(), probe.end());
+        if (!found[2]) ++misses;
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(misses.load(), 0);
+  EXPECT_EQ(map.size(),
+            16u + static_cast<std::size_t>(kThreads * (kKeys - 667)));
+  EXPECT_EQ(ordered.size(), static_cast<std::size_t>(kThreads * kKeys));
+  long long bumps = 0;
+  for (int counter = 0; counter < 16; ++counter) {
+    bumps += map.find(-1 - counter).value();
+  }
+  EXPECT_EQ(bumps, static_cast<long long>(kThreads) * kKeys);
+}
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "custom_hash_map.h"
+
+namespace {
+
+// Sends every key to the same group and the same H2 byte, so lookups only
+// succeed by probing past full groups and comparing keys.
+struct CollidingHash {
+  std::size_t operator()(int) const { return 42; }
+};
+
+}  // namespace
+
+TEST(HashMapTest, InsertAndFind) {
+  HashMap<int, std::string> map;
+  auto [iter, success] = map.insert(1, "one");
+  ASSERT_TRUE(success);
+  ASSERT_EQ(iter->second, "one");
+  ASSERT_EQ(map.at(1), "one");
+  ASSERT_FALSE(map.insert(1, "uno").second);
+  ASSERT_EQ(map.find(1)->second, "one");
+  ASSERT_EQ(map.find(2), map.end());
+}
+TEST(HashMapTest, InsertOrAssign) {
+  HashMap<int, std::string> map;
+  map.insert(2, "two");
+  auto [iter, success] = map.insert_or_assign(2, "second");
+  ASSERT_FALSE(success);
+  ASSERT_EQ(iter->second, "second");
+  ASSERT_EQ(map.at(2), "second");
+}
+TEST(HashMapTest, AccessAndMissingKey) {
+  HashMap<int, std::string> map;
+  map[4] = "four";
+  ASSERT_EQ(map.at(4), "four");
+  ASSERT_EQ(map[5], "");
+  ASSERT_EQ(map.size(), 2u);
+  EXPECT_THROW(map.at(6), std::out_of_range);
+}
+TEST(HashMapTest, EraseAndIterate) {
+  HashMap<int, int> map;
+  ASSERT_EQ(map.begin(), map.end());
+  for (int i = 0; i < 100; ++i) map.insert(i, i * i);
+  map.erase(map.find(50));
+  ASSERT_FALSE(map.contains(50));
+  EXPECT_THROW(map.erase(map.end()), std::runtime_error);
+  std::size_t visited = 0;
+  long sum = 0;
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    ASSERT_EQ(it->second, it->first * it->first);
+    sum += it->first;
+    ++visited;
+  }
+  ASSERT_EQ(visited, 99u);
+  ASSERT_EQ(sum, 99 * 100 / 2 - 50);
+}
+TEST(HashMapTest, RandomChurnMatchesUnorderedMap) {
+  HashMap<int, int> map;
+  std::unordered_map<int, int> expected;
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int> pick(0, 2999);
+  for (int step = 0; step < 50000; ++step) {
+    int key = pick(rng);
+    if (step % 2 == 1) {
+      auto found = map.find(key);
+      ASSERT_EQ(found != map.end(), expected.erase(key) == 1);
+      if (found != map.end()) map.erase(found);
+    } else {
+      ASSERT_EQ(map.insert(key, step).second,
+                expected.emplace(key, step).second);
+    }
+    ASSERT_EQ(map.size(), expected.size());
+  }
+  for (const auto& [key, value] : expected) {
+    ASSERT_EQ(map.at(key), value);
+  }
+  ASSERT_LE(map.load_factor(), map.max_load_factor());
+}
+TEST(HashMapTest, CollidingKeys) {
+  HashMap<int, int, CollidingHash> map;
+  for (int i = 0; i < 200; ++i) map.insert(i, -i);
+  for (int i = 0; i < 200; i += 2) map.erase(map.find(i));
+  ASSERT_EQ(map.size(), 100u);
+  for (int i = 0; i < 200; ++i) {
+    ASSERT_EQ(map.contains(i), i % 2 == 1);
+  }
+  map.insert(0, 7);
+  ASSERT_EQ(map.at(0), 7);
+}
+TEST(HashMapTest, ReserveAndRehash) {
+  HashMap<int, int> map;
+  map.reserve(1000);
+  std::size_t buckets = map.bucket_count();
+  ASSERT_GE(buckets, 1000u);
+  for (int i = 0; i < 1000; ++i) map.insert(i, i);
+  ASSERT_EQ(map.bucket_count(), buckets);
+  for (int i = 0; i < 900; ++i) map.erase(map.find(i));
+  map.rehash(0);
+  ASSERT_LT(map.bucket_count(), buckets);
+  ASSERT_EQ(map.size(), 100u);
+  ASSERT_EQ(map.at(950), 950);
+  map.clear();
+  map.rehash(0);
+  ASSERT_EQ(map.bucket_count(), 0u);
+  ASSERT_FALSE(map.contains(950));
+}
+TEST(HashMapTest, CopyMoveSwapAndMerge) {
+  HashMap<std::string, int> map{{"one", 1}, {"two", 2}};
+  HashMap<std::string, int> copy(map);
+  map["one"] = 10;
+  ASSERT_EQ(copy.at("one"), 1);
+  HashMap<std::string, int> moved(std::move(copy));
+  ASSERT_TRUE(copy.empty());
+  ASSERT_EQ(moved.size(), 2u);
+
+  HashMap<std::string, int> other;
+  other.insert("three", 3);
+  other.swap(moved);
+  ASSERT_TRUE(moved.contains("three"));
+  moved.merge(other);
+  ASSERT_EQ(moved.size(), 3u);
+  ASSERT_EQ(moved.at("two"), 2);
+  moved = std::move(map);
+  ASSERT_EQ(moved.at("one"), 10);
+}
+TEST(HashMapTest, InsertMany) {
+  HashMap<int, std::string> map;
+  auto results = map.insert_many(std::make_pair(1, "one"),
+                                 std::make_pair(2, "two"),
+                                 std::make_pair(1, "uno"));
+  ASSERT_EQ(results.size(), 3u);
+  ASSERT_TRUE(results[0].second);
+  ASSERT_FALSE(results[2].second);
+  ASSERT_EQ(map.at(1), "one");
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "custom_hash_set.h"
+
+namespace {
+
+// Every value shares one home slot and one H2 byte, so all of them form a
+// single run that erase has to shift back.
+struct CollidingHash {
+  std::size_t operator()(int) const { return 42; }
+};
+
+}  // namespace
+
+TEST(HashSetTest, InsertFindAndCount) {
+  HashSet<std::string> set{"one", "two", "one"};
+  ASSERT_EQ(set.size(), 2u);
+  auto [iter, inserted] = set.insert("three");
+  ASSERT_TRUE(inserted);
+  ASSERT_EQ(*iter, "three");
+  ASSERT_FALSE(set.insert("two").second);
+  ASSERT_EQ(*set.find("two"), "two");
+  ASSERT_EQ(set.find("four"), set.end());
+  ASSERT_EQ(set.count("one"), 1u);
+  ASSERT_EQ(set.count("four"), 0u);
+}
+TEST(HashSetTest, EraseAndIterate) {
+  HashSet<int> set;
+  ASSERT_EQ(set.begin(), set.end());
+  for (int i = 0; i < 100; ++i) set.insert(i);
+  set.erase(50);
+  set.erase(set.find(10));
+  set.erase(1000);
+  EXPECT_THROW(set.erase(set.end()), std::runtime_error);
+  std::size_t visited = 0;
+  int sum = 0;
+  for (int value : set) {
+    sum += value;
+    ++visited;
+  }
+  ASSERT_EQ(visited, 98u);
+  ASSERT_EQ(sum, 99 * 100 / 2 - 60);
+}
+TEST(HashSetTest, RandomChurnMatchesUnorderedSet) {
+  HashSet<int> set;
+  std::unordered_set<int> expected;
+  std::mt19937 rng(13);
+  std::uniform_int_distribution<int> pick(0, 3999);
+  for (int step = 0; step < 60000; ++step) {
+    int value = pick(rng);
+    if (step % 3 == 0) {
+      set.erase(value);
+      expected.erase(value);
+    } else {
+      ASSERT_EQ(set.insert(value).second, expected.insert(value).second);
+    }
+    ASSERT_EQ(set.size(), expected.size());
+  }
+  for (int value = 0; value < 4000; ++value) {
+    ASSERT_EQ(set.contains(value), expected.count(value) == 1);
+  }
+}
+TEST(HashSetTest, BackwardShiftKeepsCollidingRun) {
+  HashSet<int, CollidingHash> set;
+  for (int i = 0; i < 100; ++i) set.insert(i);
+  for (int i = 0; i < 100; i += 3) set.erase(i);
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(set.contains(i), i % 3 != 0);
+  }
+  // No tombstones: erasing everything leaves a table that holds as many
+  // elements as before without growing.
+  std::size_t buckets = set.bucket_count();
+  for (int i = 0; i < 100; ++i) set.erase(i);
+  ASSERT_TRUE(set.empty());
+  for (int i = 0; i < 100; ++i) set.insert(i + 100);
+  ASSERT_EQ(set.bucket_count(), buckets);
+  ASSERT_TRUE(set.contains(199));
+}
+TEST(HashSetTest, ReserveAndRehash) {
+  HashSet<int> set;
+  set.reserve(1000);
+  std::size_t buckets = set.bucket_count();
+  ASSERT_GE(buckets, 1000u);
+  for (int i = 0; i < 1000; ++i) set.insert(i);
+  ASSERT_EQ(set.bucket_count(), buckets);
+  ASSERT_LE(set.load_factor(), set.max_load_factor());
+  for (int i = 0; i < 900; ++i) set.erase(i);
+  set.rehash(0);
+  ASSERT_LT(set.bucket_count(), buckets);
+  ASSERT_TRUE(set.contains(999));
+  set.clear();
+  set.rehash(0);
+  ASSERT_EQ(set.bucket_count(), 0u);
+}
+TEST(HashSetTest, CopyMoveSwapAndMerge) {
+  HashSet<int> set{1, 2, 3};
+  HashSet<int> copy(set);
+  set.erase(1);
+  ASSERT_TRUE(copy.contains(1));
+  HashSet<int> moved(std::move(copy));
+  ASSERT_TRUE(copy.empty());
+  ASSERT_EQ(moved.size(), 3u);
+
+  HashSet<int> other{7};
+  other.swap(moved);
+  ASSERT_TRUE(moved.contains(7));
+  moved.merge(other);
+  ASSERT_EQ(moved.size(), 4u);
+  moved = std::move(set);
+  ASSERT_EQ(moved.size(), 2u);
+}
+TEST(HashSetTest, InsertMany) {
+  HashSet<int> set;
+  auto results = set.insert_many(1, 2, 1);
+  ASSERT_EQ(results.size(), 3u);
+  ASSERT_TRUE(results[1].second);
+  ASSERT_FALSE(results[2].second);
+  ASSERT_EQ(set.size(), 2u);
+}
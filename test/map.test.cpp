@@ -1,7 +1,72 @@
 #include <gtest/gtest.h>
 
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
 #include "custom_map.h"
 
+namespace {
+
+// Counts how its instances come about, to check that the emplace family
+// builds each mapped value once, in place.
+struct Counted {
+  static inline int builds = 0;
+  static inline int copies = 0;
+  static inline int moves = 0;
+  static void Reset() { builds = copies = moves = 0; }
+
+  Counted() : Counted(0) {}
+  explicit Counted(int v) : value(v) { ++builds; }
+  Counted(const Counted& other) : value(other.value) { ++copies; }
+  Counted(Counted&& other) noexcept : value(other.value) { ++moves; }
+  Counted& operator=(const Counted& other) = default;
+  Counted& operator=(Counted&& other) noexcept = default;
+
+  int value;
+};
+
+template <typename Backend>
+void CheckInPlaceInserts() {
+  using CountedMap =
+      Map<int, Counted, NodePool<std::pair<const int, Counted>>, Backend>;
+  CountedMap map;
+  Counted::Reset();
+  ASSERT_TRUE(map.try_emplace(1, 10).second);
+  ASSERT_FALSE(map.try_emplace(1, 11).second);
+  map.try_emplace(map.end(), 2, 20);
+  map[3].value = 30;
+  ASSERT_EQ(Counted::builds, 3);
+  ASSERT_EQ(Counted::copies + Counted::moves, 0);
+
+  typename CountedMap::value_type item(4, Counted(40));
+  typename CountedMap::value_type hinted(5, Counted(50));
+  Counted::Reset();
+  ASSERT_TRUE(map.insert(std::move(item)).second);
+  map.insert(map.end(), std::move(hinted));
+  map.insert_or_assign(1, Counted(12));
+  ASSERT_EQ(Counted::copies, 0);
+
+  Counted::Reset();
+  ASSERT_TRUE(map.emplace(6, 60).second);
+  ASSERT_FALSE(map.emplace(6, 61).second);
+  map.emplace_hint(map.end(), 7, 70);
+  ASSERT_EQ(Counted::copies, 0);
+
+  ASSERT_EQ(map.size(), 7u);
+  int key = 1;
+  for (auto it = map.begin(); it != map.end(); ++it, ++key) {
+    ASSERT_EQ(it->first, key);
+    ASSERT_EQ(it->second.value, key == 1 ? 12 : key * 10);
+  }
+}
+
+}  // namespace
+
 TEST(MapTest, InsertAndFind) {
   Map<int, std::string> map;
   auto [iter, success] = map.insert(1, "one");
@@ -58,3 +123,379 @@ TEST(MapTest, InsertMany) {
   ASSERT_TRUE(results[1].second);
   ASSERT_EQ(map.size(), 2);
 }
+TEST(MapTest, InsertWithHint) {
+  Map<int, std::string> map;
+  for (int i = 0; i < 100; ++i) {
+    map.insert(map.end(), std::make_pair(i, std::to_string(i)));
+  }
+  auto iter = map.insert(map.end(), std::make_pair(5, "five"));
+  ASSERT_EQ(map.size(), 100);
+  ASSERT_EQ(iter->second, "5");
+  ASSERT_EQ(map[99], "99");
+  ASSERT_EQ(map[100], "");
+  ASSERT_EQ(map.size(), 101);
+}
+TEST(MapTest, RangeConstructor) {
+  std::vector<std::pair<int, std::string>> sorted = {
+      {1, "one"}, {2, "two"}, {2, "deux"}, {3, "three"}};
+  Map<int, std::string> fromSorted(sorted.begin(), sorted.end());
+  ASSERT_EQ(fromSorted.size(), 3);
+  ASSERT_EQ(fromSorted.at(2), "two");
+
+  std::vector<std::pair<int, std::string>> unsorted = {
+      {3, "three"}, {1, "one"}, {2, "two"}};
+  Map<int, std::string> fromUnsorted(unsorted.begin(), unsorted.end());
+  ASSERT_EQ(fromUnsorted.size(), 3);
+  ASSERT_EQ(fromUnsorted.begin()->first, 1);
+}
+TEST(MapTest, OrderStatistics) {
+  Map<int, std::string, NodePool<std::pair<const int, std::string>>,
+      RBTreeBackend<true>>
+      map;
+  for (int i = 9; i >= 0; --i) {
+    map.insert(i * 10, std::to_string(i));
+  }
+  ASSERT_EQ(map.select(3)->first, 30);
+  ASSERT_EQ(map.select(3)->second, "3");
+  ASSERT_EQ(map.select(10), map.end());
+  ASSERT_EQ(map.rank(35), 4);
+  ASSERT_EQ(map.count_in_range(20, 60), 4);
+  map.erase(map.select(0));
+  ASSERT_EQ(map.select(0)->first, 10);
+  ASSERT_EQ(map.rank(35), 3);
+}
+TEST(MapTest, Bounds) {
+  Map<int, std::string> map({{10, "ten"}, {20, "twenty"}, {30, "thirty"}});
+  ASSERT_EQ(map.lower_bound(20)->second, "twenty");
+  ASSERT_EQ(map.upper_bound(20)->second, "thirty");
+  ASSERT_EQ(map.lower_bound(15)->first, 20);
+  ASSERT_EQ(map.upper_bound(30), map.end());
+  auto [first, last] = map.equal_range(10);
+  ASSERT_EQ(first->first, 10);
+  ASSERT_EQ(last->first, 20);
+  auto missing = map.equal_range(25);
+  ASSERT_EQ(missing.first, missing.second);
+}
+TEST(MapTest, NodesStoreKeyOnce) {
+  using Node = Map<std::string, int>::tree_type::Node;
+  using StoredKeyNode =
+      RBTree<std::string, std::pair<const std::string, int>>::Node;
+  ASSERT_EQ(sizeof(Node) + sizeof(std::string), sizeof(StoredKeyNode));
+  Map<std::string, int> map({{"b", 2}, {"a", 1}});
+  map["c"] = 3;
+  ASSERT_EQ(map.begin()->first, "a");
+  ASSERT_EQ(map.begin().getKey(), "a");
+  ASSERT_EQ(map.at("c"), 3);
+}
+
+TEST(MapTest, BTreeBackend) {
+  Map<int, std::string, NodePool<std::pair<const int, std::string>>,
+      BTreeBackend<>>
+      map;
+  for (int i = 999; i >= 0; --i) map.insert(i, std::to_string(i));
+  ASSERT_EQ(map.size(), 1000u);
+  ASSERT_EQ(map.at(500), "500");
+  ASSERT_EQ(map.lower_bound(250)->second, "250");
+  ASSERT_EQ(map.upper_bound(999), map.end());
+  map[1000] = "1000";
+  for (int i = 0; i < 1000; i += 2) map.erase(map.lower_bound(i));
+  int expected = 1;
+  for (auto it = map.begin(); it != map.end(); ++it, expected += 2) {
+    ASSERT_EQ(it->first, expected < 1000 ? expected : 1000);
+  }
+  ASSERT_EQ(map.size(), 501u);
+  ASSERT_FALSE(map.contains(500));
+}
+TEST(MapTest, CustomCompare) {
+  Map<int, std::string, NodePool<std::pair<const int, std::string>>,
+      RBTreeBackend<>, std::greater<int>>
+      map({{1, "one"}, {3, "three"}, {2, "two"}});
+  std::vector<int> keys;
+  for (auto it = map.begin(); it != map.end(); ++it) keys.push_back(it->first);
+  ASSERT_EQ(keys, (std::vector<int>{3, 2, 1}));
+  ASSERT_EQ(map.find(2)->second, "two");
+  ASSERT_EQ(map.find(4), map.end());
+  ASSERT_EQ(map.lower_bound(4)->first, 3);
+  ASSERT_EQ(map.upper_bound(2)->first, 1);
+
+  std::vector<std::pair<const int, int>> sorted{{9, 0}, {5, 0}, {1, 0}};
+  Map<int, int, NodePool<std::pair<const int, int>>, BTreeBackend<>,
+      std::greater<int>>
+      built(sorted.begin(), sorted.end());
+  ASSERT_EQ(built.begin()->first, 9);
+  ASSERT_TRUE(built.contains(5));
+  ASSERT_EQ(built.lower_bound(6)->first, 5);
+}
+TEST(MapTest, TransparentLookup) {
+  Map<std::string, int, NodePool<std::pair<const std::string, int>>,
+      RBTreeBackend<true>, std::less<>>
+      map;
+  for (int i = 0; i < 10; ++i) map.insert("key" + std::to_string(i), i);
+  std::string_view key = "key4";
+  ASSERT_EQ(map.find(key)->second, 4);
+  ASSERT_EQ(map.at(key), 4);
+  ASSERT_TRUE(map.contains(key));
+  ASSERT_FALSE(map.contains("key10"));
+  EXPECT_THROW(map.at(std::string_view("none")), std::out_of_range);
+  ASSERT_EQ(map.lower_bound("key35")->second, 4);
+  ASSERT_EQ(map.upper_bound(key)->second, 5);
+  auto [first, last] = map.equal_range(key);
+  ASSERT_EQ(first->second, 4);
+  ASSERT_EQ(last->second, 5);
+  ASSERT_EQ(map.rank(key), 4u);
+  ASSERT_EQ(map.count_in_range(std::string_view("key2"), key), 2u);
+
+  Map<std::string, int, NodePool<std::pair<const std::string, int>>,
+      BTreeBackend<>, std::less<>>
+      btree;
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    btree.insert(it->first, it->second);
+  }
+  ASSERT_EQ(btree.find(key)->second, 4);
+  ASSERT_EQ(btree.lower_bound("key35")->second, 4);
+}
+TEST(MapTest, InPlaceInserts) {
+  CheckInPlaceInserts<RBTreeBackend<>>();
+  CheckInPlaceInserts<BTreeBackend<>>();
+}
+TEST(MapTest, MoveOnlyValues) {
+  Map<std::string, std::unique_ptr<int>> map;
+  ASSERT_TRUE(map.try_emplace("a", std::make_unique<int>(1)).second);
+  std::string key = "b";
+  map[std::move(key)] = std::make_unique<int>(2);
+  map.insert(std::make_pair(std::string("c"), std::make_unique<int>(3)));
+  map.insert_or_assign("a", std::make_unique<int>(4));
+  map.emplace("d", std::make_unique<int>(5));
+  ASSERT_EQ(map.size(), 4u);
+  ASSERT_EQ(*map.at("a"), 4);
+  ASSERT_EQ(*map.at("b"), 2);
+  ASSERT_EQ(*map.at("c"), 3);
+  ASSERT_EQ(*map.at("d"), 5);
+}
+TEST(MapTest, ExtractAndInsertNode) {
+  using HeapMap =
+      Map<int, std::string, std::allocator<std::pair<const int, std::string>>>;
+  HeapMap source({{1, "one"}, {2, "two"}, {3, "three"}});
+  HeapMap target({{3, "drei"}});
+  const std::string* address = &source.find(2)->second;
+  auto [position, inserted, node] = target.insert(source.extract(2));
+  ASSERT_TRUE(inserted);
+  ASSERT_TRUE(node.empty());
+  ASSERT_EQ(&position->second, address);
+  ASSERT_EQ(source.size(), 2u);
+  ASSERT_EQ(target.size(), 2u);
+
+  HeapMap::insert_return_type clash = target.insert(source.extract(3));
+  ASSERT_FALSE(clash.inserted);
+  ASSERT_EQ(clash.position->second, "drei");
+  ASSERT_EQ(clash.node.key(), 3);
+  ASSERT_EQ(clash.node.value().second, "three");
+  source.insert(source.end(), std::move(clash.node));
+  ASSERT_EQ(source.at(3), "three");
+
+  ASSERT_TRUE(source.extract(7).empty());
+  ASSERT_EQ(target.insert(HeapMap::node_type()).position, target.end());
+  EXPECT_THROW(source.extract(source.end()), std::runtime_error);
+}
+TEST(MapTest, ExtractBetweenPools) {
+  // Each map has its own NodePool, so the value moves into a new node.
+  Map<std::string, std::unique_ptr<int>> source;
+  Map<std::string, std::unique_ptr<int>> target;
+  source.try_emplace("a", std::make_unique<int>(1));
+  const int* pointee = source.at("a").get();
+  target.insert(source.extract("a"));
+  ASSERT_TRUE(source.empty());
+  ASSERT_EQ(target.at("a").get(), pointee);
+
+  auto node = target.extract(target.begin());
+  target.insert(std::move(node));
+  ASSERT_EQ(target.at("a").get(), pointee);
+}
+TEST(MapTest, NodeHandleOutlivesItsMap) {
+  // The handle keeps a share of the source map's pool.
+  Map<std::string, std::unique_ptr<int>>::node_type dropped;
+  Map<std::string, std::unique_ptr<int>>::node_type kept;
+  {
+    Map<std::string, std::unique_ptr<int>> source;
+    source.try_emplace("a", std::make_unique<int>(1));
+    source.try_emplace("b", std::make_unique<int>(2));
+    dropped = source.extract("a");
+    kept = source.extract("b");
+  }
+  dropped = decltype(dropped)();
+  ASSERT_TRUE(dropped.empty());
+  Map<std::string, std::unique_ptr<int>> target;
+  target.insert(std::move(kept));
+  ASSERT_TRUE(kept.empty());
+  ASSERT_EQ(*target.at("b"), 2);
+}
+TEST(MapTest, MergeLeavesClashingKeys) {
+  Map<int, std::string> map({{1, "one"}, {3, "three"}});
+  Map<int, std::string> other({{2, "two"}, {3, "drei"}, {4, "four"}});
+  map.merge(other);
+  ASSERT_EQ(map.size(), 4u);
+  ASSERT_EQ(map.at(3), "three");
+  ASSERT_EQ(map.at(4), "four");
+  ASSERT_EQ(other.size(), 1u);
+  ASSERT_EQ(other.at(3), "drei");
+  // An empty source, into a small target and into one past the ordered
+  // walk's 16K nodes.
+  Map<int, std::string> empty;
+  map.merge(empty);
+  ASSERT_EQ(map.size(), 4u);
+  Map<int, int> large;
+  for (int i = 0; i < 20000; ++i) large.insert(i, i);
+  Map<int, int> none;
+  large.merge(none);
+  ASSERT_EQ(large.size(), 20000u);
+  ASSERT_TRUE(none.empty());
+
+  Map<int, std::string, NodePool<std::pair<const int, std::string>>,
+      BTreeBackend<>>
+      btree, more;
+  for (int i = 0; i < 500; ++i) btree.insert(i * 2, "even");
+  for (int i = 0; i < 500; ++i) more.insert(i * 3, "triple");
+  btree.merge(more);
+  ASSERT_EQ(btree.size(), 500u + 333u);
+  ASSERT_EQ(more.size(), 167u);
+  ASSERT_EQ(btree.at(3), "triple");
+  ASSERT_EQ(btree.at(6), "even");
+  ASSERT_EQ(more.at(6), "triple");
+  auto node = btree.extract(3);
+  ASSERT_EQ(node.value().second, "triple");
+  ASSERT_FALSE(btree.contains(3));
+  ASSERT_TRUE(btree.insert(std::move(node)).inserted);
+  ASSERT_TRUE(btree.contains(3));
+}
+TEST(MapTest, SetAlgebraByKey) {
+  using BTreeMap = Map<int, std::string,
+                       NodePool<std::pair<const int, std::string>>,
+                       BTreeBackend<>>;
+  Map<int, std::string> map({{1, "one"}, {2, "two"}, {3, "three"}});
+  Map<int, std::string> other({{2, "zwei"}, {4, "vier"}});
+  Map<int, std::string> both(map);
+  both.union_with(other);
+  ASSERT_EQ(both.size(), 4u);
+  ASSERT_EQ(both.at(2), "two");
+  ASSERT_EQ(both.at(4), "vier");
+  Map<int, std::string> common(map);
+  common.intersect_with(other);
+  ASSERT_EQ(common.size(), 1u);
+  ASSERT_EQ(common.at(2), "two");
+  Map<int, std::string> only(map);
+  only.difference_with(other);
+  ASSERT_EQ(only.size(), 2u);
+  ASSERT_FALSE(only.contains(2));
+  map.symmetric_difference_with(other);
+  ASSERT_EQ(map.size(), 3u);
+  ASSERT_EQ(map.at(4), "vier");
+  ASSERT_FALSE(map.contains(2));
+
+  BTreeMap btree;
+  BTreeMap more;
+  for (int i = 0; i < 600; ++i) btree.insert(i * 2, "even");
+  for (int i = 0; i < 400; ++i) more.insert(i * 3, "triple");
+  BTreeMap joined(btree);
+  joined.union_with(more);
+  ASSERT_EQ(joined.size(), 600u + 400u - 200u);
+  ASSERT_EQ(joined.at(6), "even");
+  ASSERT_EQ(joined.at(9), "triple");
+  BTreeMap sixes(btree);
+  sixes.intersect_with(more);
+  ASSERT_EQ(sixes.size(), 200u);
+  btree.symmetric_difference_with(more);
+  ASSERT_EQ(btree.size(), 600u);
+  ASSERT_FALSE(btree.contains(6));
+  // A small map takes a lookup per element instead of the walk.
+  BTreeMap few({{3, "three"}, {4, "four"}});
+  more.difference_with(few);
+  ASSERT_EQ(more.size(), 399u);
+  ASSERT_FALSE(more.contains(3));
+  int previous = -1;
+  for (auto it = more.begin(); it != more.end(); ++it) {
+    ASSERT_LT(previous, it->first);
+    previous = it->first;
+  }
+}
+TEST(MapTest, SplitAtAndConcat) {
+  Map<int, std::string> map;
+  for (int i = 0; i < 1000; ++i) map.insert(i, std::to_string(i));
+  // The two parts share the pool, so the nodes stay where they are.
+  const std::string* tail = &map.at(999);
+  Map<int, std::string> later = map.split_at(600);
+  ASSERT_EQ(&later.at(999), tail);
+  ASSERT_EQ(map.size(), 600u);
+  ASSERT_EQ(later.size(), 400u);
+  ASSERT_EQ(later.begin()->first, 600);
+  ASSERT_FALSE(map.contains(600));
+  ASSERT_EQ(later.at(999), "999");
+  Map<int, std::string> last = later.split_at(2000);
+  ASSERT_TRUE(last.empty());
+  ASSERT_THROW(later.concat(map), std::invalid_argument);
+  ASSERT_EQ(map.size(), 600u);
+  map.concat(later);
+  ASSERT_TRUE(later.empty());
+  ASSERT_EQ(map.size(), 1000u);
+  int expected = 0;
+  for (auto it = map.begin(); it != map.end(); ++it, ++expected) {
+    ASSERT_EQ(it->first, expected);
+  }
+  ASSERT_EQ(expected, 1000);
+  ASSERT_EQ(&map.at(999), tail);
+  map.insert(1000, "new");
+  ASSERT_EQ(map.at(1000), "new");
+  Map<int, std::string> separate;
+  separate.insert(1001, "own pool");
+  map.concat(separate);
+  ASSERT_EQ(map.at(1001), "own pool");
+  ASSERT_EQ(map.size(), 1002u);
+
+  Map<int, int, std::allocator<std::pair<const int, int>>,
+      RBTreeBackend<true>>
+      counted;
+  for (int i = 0; i < 100; ++i) counted.insert(i * 10, i);
+  auto upper = counted.split_at(455);
+  ASSERT_EQ(upper.rank(460), 0u);
+  ASSERT_EQ(counted.select(45)->first, 450);
+  ASSERT_EQ(upper.size(), 54u);
+}
+
+TEST(MapTest, PersistentSnapshots) {
+  using Persistent = Map<int, std::string,
+                         std::allocator<std::pair<const int, std::string>>,
+                         PersistentRBTreeBackend>;
+  Persistent map;
+  for (int i = 0; i < 100; ++i) map.insert(i, std::to_string(i));
+  auto before = map.snapshot();
+  Persistent copy(map);
+
+  map[5] = "five";
+  map.erase(map.find(50));
+  map.insert_or_assign(200, "new");
+  for (auto it = map.lower_bound(90); it != map.end(); ++it) {
+    it->second += "!";
+  }
+  ASSERT_EQ(map.at(5), "five");
+  ASSERT_EQ(map.at(95), "95!");
+  ASSERT_EQ(map.size(), 100u);
+
+  ASSERT_EQ(before.size(), 100u);
+  ASSERT_EQ(before.at(5).second, "5");
+  ASSERT_EQ(before.find(95)->second, "95");
+  ASSERT_TRUE(before.contains(50));
+  ASSERT_FALSE(before.contains(200));
+  ASSERT_EQ(copy.at(5), "5");
+  ASSERT_TRUE(copy.contains(50));
+
+  std::vector<int> descending;
+  for (auto it = map.find(99); it != map.end(); --it) {
+    descending.push_back(it->first);
+  }
+  ASSERT_EQ(descending.size(), 99u);
+  ASSERT_EQ(descending[48], 51);
+  ASSERT_EQ(descending[49], 49);
+  std::vector<std::pair<int, std::string>> items(before.begin(),
+                                                 before.end());
+  ASSERT_EQ(items.size(), 100u);
+  ASSERT_EQ(items[50].second, "50");
+}
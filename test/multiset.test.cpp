@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include "custom_multiset.h"
 
 TEST(MultiSetTest, DefaultConstructor) {
@@ -26,7 +31,7 @@ TEST(MultiSetTest, Erase) {
   MultiSet<int> mset({1, 2, 3});
   auto it = mset.find(2);
   mset.erase(it);
-  EXPECT_EQ(mset.size(), 3);
+  EXPECT_EQ(mset.size(), 2);
   EXPECT_EQ(mset.count(2), 0);
 }
 
@@ -59,6 +64,20 @@ TEST(MultiSetTest, Bounds) {
   EXPECT_EQ(*upper, 4);
 }
 
+TEST(MultiSetTest, BoundsBetweenAndPastKeys) {
+  MultiSet<int> mset({10, 20, 30});
+  EXPECT_EQ(*mset.lower_bound(15), 20);
+  EXPECT_EQ(*mset.upper_bound(15), 20);
+  EXPECT_EQ(*mset.lower_bound(5), 10);
+  EXPECT_EQ(mset.lower_bound(31), mset.end());
+  EXPECT_EQ(mset.upper_bound(30), mset.end());
+  auto range = mset.equal_range(20);
+  EXPECT_EQ(*range.first, 20);
+  EXPECT_EQ(*range.second, 30);
+  EXPECT_EQ(mset.count(20), 1);
+  EXPECT_EQ(mset.count(25), 0);
+}
+
 TEST(MultiSetTest, Swap) {
   MultiSet<int> mset1({1, 2});
   MultiSet<int> mset2({3, 4});
@@ -73,4 +92,220 @@ TEST(MultiSetTest, Merge) {
   mset1.merge(mset2);
   EXPECT_EQ(mset1.size(), 4);
   EXPECT_TRUE(mset2.empty());
-}
\ No newline at end of file
+}
+
+TEST(MultiSetTest, RangeConstructor) {
+  std::vector<int> sorted = {1, 2, 3, 4, 5};
+  MultiSet<int> fromSorted(sorted.begin(), sorted.end());
+  EXPECT_EQ(fromSorted.size(), 5);
+  EXPECT_TRUE(fromSorted.contains(4));
+
+  std::vector<int> unsorted = {5, 3, 1};
+  MultiSet<int> fromUnsorted(unsorted.begin(), unsorted.end());
+  EXPECT_EQ(fromUnsorted.size(), 3);
+  EXPECT_EQ(*fromUnsorted.begin(), 1);
+}
+
+TEST(MultiSetTest, OrderStatistics) {
+  std::vector<int> sorted = {2, 4, 6, 8, 10};
+  MultiSet<int, NodePool<int>, RBTreeBackend<true>> mset(sorted.begin(),
+                                                         sorted.end());
+  EXPECT_EQ(*mset.select(0), 2);
+  EXPECT_EQ(*mset.select(4), 10);
+  EXPECT_EQ(mset.rank(7), 3);
+  EXPECT_EQ(mset.count_in_range(3, 9), 3);
+  mset.insert(5);
+  EXPECT_EQ(*mset.select(2), 5);
+  EXPECT_EQ(mset.count_in_range(3, 9), 4);
+}
+
+TEST(MultiSetTest, DuplicatesAreKept) {
+  MultiSet<int> mset({3, 1, 3, 2, 3});
+  EXPECT_EQ(mset.size(), 5);
+  EXPECT_EQ(mset.count(3), 3);
+  mset.insert(1);
+  EXPECT_EQ(mset.count(1), 2);
+  std::vector<int> items;
+  for (auto it = mset.begin(); it != mset.end(); ++it) items.push_back(*it);
+  EXPECT_EQ(items, std::vector<int>({1, 1, 2, 3, 3, 3}));
+  auto range = mset.equal_range(3);
+  int inRange = 0;
+  for (auto it = range.first; it != range.second; ++it) ++inRange;
+  EXPECT_EQ(inRange, 3);
+  mset.erase(mset.find(3));
+  EXPECT_EQ(mset.count(3), 2);
+  EXPECT_EQ(mset.size(), 5);
+}
+
+TEST(MultiSetTest, CountingBackend) {
+  using CountedSet = MultiSet<int, NodePool<int>, RBTreeBackend<true, true>>;
+  std::vector<int> sorted = {1, 1, 2, 5, 5, 5};
+  CountedSet mset(sorted.begin(), sorted.end());
+  EXPECT_EQ(mset.size(), 6);
+  EXPECT_EQ(mset.count(5), 3);
+  mset.insert(2);
+  mset.insert(7);
+  std::vector<int> items;
+  for (auto it = mset.begin(); it != mset.end(); ++it) items.push_back(*it);
+  EXPECT_EQ(items, std::vector<int>({1, 1, 2, 2, 5, 5, 5, 7}));
+  EXPECT_EQ(*mset.select(5), 5);
+  EXPECT_EQ(*mset.select(7), 7);
+  EXPECT_EQ(mset.rank(5), 4);
+  EXPECT_EQ(mset.count_in_range(2, 6), 5);
+
+  mset.erase(mset.find(5));
+  EXPECT_EQ(mset.count(5), 2);
+  EXPECT_EQ(mset.size(), 7);
+  mset.erase(mset.find(7));
+  EXPECT_FALSE(mset.contains(7));
+  auto last = mset.lower_bound(6);
+  EXPECT_EQ(last, mset.end());
+  --(last = mset.lower_bound(5));
+  EXPECT_EQ(*last, 2);
+}
+TEST(MultiSetTest, BTreeBackend) {
+  MultiSet<int, NodePool<int>, BTreeBackend<>> set;
+  for (int i = 0; i < 3000; ++i) set.insert(i % 100);
+  ASSERT_EQ(set.size(), 3000u);
+  ASSERT_EQ(set.count(42), 30u);
+  auto [first, last] = set.equal_range(42);
+  ASSERT_EQ(*first, 42);
+  ASSERT_EQ(*last, 43);
+  set.erase(set.find(42));
+  ASSERT_EQ(set.count(42), 29u);
+  int previous = -1;
+  std::size_t seen = 0;
+  for (auto it = set.begin(); it != set.end(); ++it, ++seen) {
+    ASSERT_LE(previous, *it);
+    previous = *it;
+  }
+  ASSERT_EQ(seen, set.size());
+  ASSERT_EQ(previous, 99);
+}
+TEST(MultiSetTest, CustomCompare) {
+  MultiSet<int, NodePool<int>, RBTreeBackend<false, true>, std::greater<int>>
+      set({1, 3, 2, 3});
+  std::vector<int> values;
+  for (auto it = set.begin(); it != set.end(); ++it) values.push_back(*it);
+  ASSERT_EQ(values, (std::vector<int>{3, 3, 2, 1}));
+  ASSERT_EQ(set.count(3), 2u);
+  ASSERT_EQ(*set.upper_bound(3), 2);
+  ASSERT_EQ(set.find(4), set.end());
+
+  std::vector<int> sorted{5, 5, 4};
+  MultiSet<int, NodePool<int>, BTreeBackend<>, std::greater<int>> built(
+      sorted.begin(), sorted.end());
+  ASSERT_EQ(built.count(5), 2u);
+  ASSERT_EQ(*built.begin(), 5);
+}
+TEST(MultiSetTest, TransparentLookup) {
+  MultiSet<std::string, NodePool<std::string>, RBTreeBackend<true>,
+           std::less<>>
+      set({"b", "a", "b", "c"});
+  std::string_view key = "b";
+  ASSERT_EQ(set.count(key), 2u);
+  ASSERT_TRUE(set.contains(key));
+  ASSERT_FALSE(set.contains("d"));
+  ASSERT_EQ(*set.find(key), "b");
+  ASSERT_EQ(*set.upper_bound(key), "c");
+  auto [first, last] = set.equal_range(key);
+  ASSERT_EQ(*first, "b");
+  ASSERT_EQ(*last, "c");
+  ASSERT_EQ(set.rank(key), 1u);
+  ASSERT_EQ(set.count_in_range(std::string_view("a"), key), 1u);
+}
+TEST(MultiSetTest, InPlaceInserts) {
+  MultiSet<std::string, NodePool<std::string>, RBTreeBackend<false, true>>
+      set;
+  std::string value = "bb";
+  set.insert(std::move(value));
+  set.insert(set.end(), std::string("cc"));
+  ASSERT_EQ(*set.emplace(2, 'b'), "bb");
+  ASSERT_EQ(*set.emplace_hint(set.begin(), "aa"), "aa");
+  ASSERT_EQ(set.size(), 4u);
+  ASSERT_EQ(set.count("bb"), 2u);
+
+  MultiSet<std::string, NodePool<std::string>, BTreeBackend<>> btree;
+  btree.emplace(3, 'x');
+  btree.emplace_hint(btree.end(), "y");
+  btree.insert(std::string("x"));
+  ASSERT_EQ(*btree.begin(), "x");
+  ASSERT_EQ(btree.count("xxx"), 1u);
+}
+TEST(MultiSetTest, ExtractAndMerge) {
+  MultiSet<int, NodePool<int>, RBTreeBackend<true, true>> counted({1, 2, 2});
+  MultiSet<int, NodePool<int>, RBTreeBackend<true, true>> other({2, 3});
+  auto node = counted.extract(2);
+  ASSERT_EQ(node.value(), 2);
+  ASSERT_EQ(counted.count(2), 1u);
+  ASSERT_EQ(*other.insert(std::move(node)), 2);
+  ASSERT_EQ(other.count(2), 2u);
+  ASSERT_TRUE(counted.extract(5).empty());
+  counted.merge(other);
+  ASSERT_TRUE(other.empty());
+  ASSERT_EQ(counted.size(), 5u);
+  ASSERT_EQ(counted.count(2), 3u);
+  ASSERT_EQ(counted.rank(3), 4u);
+  counted.merge(other);
+  ASSERT_EQ(counted.size(), 5u);
+  MultiSet<int> many;
+  for (int i = 0; i < 20000; ++i) many.insert(i % 100);
+  MultiSet<int> none;
+  many.merge(none);
+  ASSERT_EQ(many.size(), 20000u);
+
+  MultiSet<int, NodePool<int>, BTreeBackend<>> btree({1, 1, 2});
+  MultiSet<int, NodePool<int>, BTreeBackend<>> more({1, 3});
+  btree.merge(more);
+  ASSERT_TRUE(more.empty());
+  ASSERT_EQ(btree.count(1), 3u);
+  more.insert(btree.extract(btree.find(3)));
+  ASSERT_EQ(btree.size(), 4u);
+  ASSERT_EQ(*more.begin(), 3);
+}
+TEST(MultiSetTest, SetAlgebraCountsOccurrences) {
+  MultiSet<int, NodePool<int>, RBTreeBackend<true, true>> counted(
+      {1, 1, 1, 2, 4});
+  MultiSet<int, NodePool<int>, RBTreeBackend<true, true>> other(
+      {1, 1, 2, 2, 3});
+  auto joined = counted;
+  joined.union_with(other);
+  ASSERT_EQ(joined.count(1), 3u);
+  ASSERT_EQ(joined.count(2), 2u);
+  ASSERT_EQ(joined.size(), 7u);
+  auto common = counted;
+  common.intersect_with(other);
+  ASSERT_EQ(common.size(), 3u);
+  counted.difference_with(other);
+  ASSERT_EQ(counted.count(1), 1u);
+  ASSERT_EQ(counted.size(), 2u);
+
+  MultiSet<int, NodePool<int>, BTreeBackend<>> btree({1, 1, 1, 2, 4});
+  MultiSet<int, NodePool<int>, BTreeBackend<>> more({1, 1, 2, 2, 3});
+  btree.symmetric_difference_with(more);
+  ASSERT_EQ(btree.count(1), 1u);
+  ASSERT_EQ(btree.count(2), 1u);
+  ASSERT_EQ(btree.size(), 4u);
+  ASSERT_EQ(*btree.begin(), 1);
+}
+TEST(MultiSetTest, SplitAtAndConcat) {
+  MultiSet<int> set({5, 1, 3, 3, 3, 7, 9});
+  MultiSet<int> high = set.split_at(3);
+  ASSERT_EQ(set.size(), 1u);
+  ASSERT_EQ(high.size(), 6u);
+  ASSERT_EQ(high.count(3), 3u);
+  MultiSet<int, NodePool<int>, RBTreeBackend<true, true>> counted(
+      {1, 2, 2, 4});
+  MultiSet<int, NodePool<int>, RBTreeBackend<true, true>> more({4, 4, 8});
+  counted.concat(more);
+  ASSERT_TRUE(more.empty());
+  ASSERT_EQ(counted.count(4), 3u);
+  ASSERT_EQ(counted.size(), 7u);
+  ASSERT_EQ(counted.rank(8), 6u);
+  auto tail = counted.split_at(2);
+  ASSERT_EQ(counted.size(), 1u);
+  ASSERT_EQ(*tail.begin(), 2);
+  set.concat(high);
+  ASSERT_EQ(set.size(), 7u);
+  ASSERT_EQ(*set.begin(), 1);
+}
@@ -0,0 +1,65 @@
+#include "node_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+TEST(NodePoolTest, AllocateAndRecycle) {
+  NodePool<int> pool;
+  int* first = pool.allocate(1);
+  pool.deallocate(first, 1);
+  int* second = pool.allocate(1);
+  EXPECT_EQ(first, second);
+  pool.deallocate(second, 1);
+}
+TEST(NodePoolTest, NodesShareChunks) {
+  NodePool<long> pool;
+  for (int i = 0; i < 1000; ++i) {
+    pool.allocate(1);
+  }
+  EXPECT_GT(pool.chunk_count(), 0u);
+  EXPECT_LT(pool.chunk_count(), 10u);
+  EXPECT_GE(pool.reserved_bytes(), 1000 * sizeof(long));
+}
+TEST(NodePoolTest, Release) {
+  NodePool<std::string> pool;
+  for (int i = 0; i < 100; ++i) {
+    pool.allocate(1);
+  }
+  pool.release();
+  EXPECT_EQ(pool.chunk_count(), 0u);
+  EXPECT_EQ(pool.reserved_bytes(), 0u);
+}
+TEST(NodePoolTest, MoveTransfersChunks) {
+  NodePool<int> pool;
+  int* value = pool.allocate(1);
+  *value = 42;
+  NodePool<int> other(std::move(pool));
+  EXPECT_EQ(pool.chunk_count(), 0u);
+  EXPECT_EQ(other.chunk_count(), 1u);
+  EXPECT_EQ(*value, 42);
+  other.deallocate(value, 1);
+}
+TEST(NodePoolTest, CopiesShareThePool) {
+  NodePool<int> pool;
+  int* value = pool.allocate(1);
+  *value = 42;
+  NodePool<int>* copy = new NodePool<int>(pool);
+  EXPECT_EQ(copy->chunk_count(), 1u);
+  EXPECT_EQ(copy->use_count(), 2u);
+  EXPECT_TRUE(*copy == pool);
+  EXPECT_EQ(copy->select_on_container_copy_construction().chunk_count(), 0u);
+  pool = NodePool<int>();
+  EXPECT_FALSE(*copy == pool);
+  EXPECT_EQ(*value, 42);
+  copy->deallocate(value, 1);
+  EXPECT_EQ(copy->allocate(1), value);
+  delete copy;
+}
+TEST(NodePoolTest, UnusedPoolCopiesAreSeparate) {
+  NodePool<int> pool;
+  NodePool<int> copy(pool);
+  EXPECT_FALSE(copy == pool);
+  copy.allocate(1);
+  EXPECT_EQ(pool.chunk_count(), 0u);
+}
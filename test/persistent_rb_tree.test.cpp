@@ -0,0 +1,285 @@
+#include "persistent_rb_tree.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Nodes allocated and not yet freed, by all trees of the test.
+std::size_t liveNodes = 0;
+
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+
+  CountingAllocator() = default;
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>&) {}
+
+  T* allocate(std::size_t n) {
+    liveNodes += n;
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* p, std::size_t n) {
+    liveNodes -= n;
+    std::allocator<T>().deallocate(p, n);
+  }
+  template <typename U>
+  bool operator==(const CountingAllocator<U>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const CountingAllocator<U>&) const {
+    return false;
+  }
+};
+
+using Tree = PersistentRBTree<int, int, CountingAllocator<int>, true,
+                              RBTreeIdentityKey>;
+
+template <typename Node>
+int BlackHeight(const Node* node) {
+  if (node == nullptr) return 1;
+  if (node->refs.load() == 0) return -1;
+  if (node->color == RED && ((node->left && node->left->color == RED) ||
+                             (node->right && node->right->color == RED))) {
+    return -1;
+  }
+  int left = BlackHeight(node->left);
+  int right = BlackHeight(node->right);
+  if (left < 0 || left != right) return -1;
+  return left + (node->color == BLACK ? 1 : 0);
+}
+
+// Walks the tree in order, which also checks the ordering, and takes the
+// one node that is nobody's child as the root.
+template <typename TreeType, typename Node = typename TreeType::Node>
+bool IsValidTree(TreeType& tree) {
+  std::vector<const Node*> nodes;
+  for (auto it = tree.minimum(); it != typename TreeType::Position();
+       it = TreeType::findNext(it)) {
+    if (!nodes.empty() && !(nodes.back()->value < it.node->value)) {
+      return false;
+    }
+    nodes.push_back(it.node);
+  }
+  if (nodes.size() != static_cast<std::size_t>(tree.size())) return false;
+  if (nodes.empty()) return true;
+  std::set<const Node*> children;
+  for (const Node* node : nodes) {
+    children.insert(node->left);
+    children.insert(node->right);
+  }
+  const Node* root = nullptr;
+  for (const Node* node : nodes) {
+    if (children.count(node) == 0) {
+      if (root != nullptr) return false;
+      root = node;
+    }
+  }
+  return root != nullptr && root->color == BLACK && BlackHeight(root) > 0;
+}
+
+std::vector<int> Contents(const Tree::Snapshot& snapshot) {
+  return std::vector<int>(snapshot.begin(), snapshot.end());
+}
+
+std::vector<int> Contents(const std::set<int>& model) {
+  return std::vector<int>(model.begin(), model.end());
+}
+
+}  // namespace
+
+TEST(PersistentRBTreeTest, RandomInsertEraseKeepsInvariants) {
+  {
+    Tree tree;
+    std::set<int> model;
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> pick(0, 499);
+    for (int step = 0; step < 4000; ++step) {
+      int key = pick(rng);
+      if (rng() % 3 != 0) {
+        EXPECT_EQ(tree.insert(key, key).second, model.insert(key).second);
+      } else if (model.erase(key) == 1) {
+        tree.removeNode(tree.find(key));
+      } else {
+        EXPECT_EQ(tree.find(key), Tree::Position());
+      }
+      if (step % 100 == 0) {
+        ASSERT_TRUE(IsValidTree(tree));
+        ASSERT_EQ(Contents(tree.snapshot()), Contents(model));
+      }
+    }
+    EXPECT_EQ(liveNodes, model.size());
+  }
+  EXPECT_EQ(liveNodes, 0u);
+}
+
+TEST(PersistentRBTreeTest, SnapshotsKeepTheirContents) {
+  {
+    Tree tree;
+    std::set<int> model;
+    std::vector<std::pair<Tree::Snapshot, std::set<int>>> versions;
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> pick(0, 299);
+    for (int step = 0; step < 3000; ++step) {
+      int key = pick(rng);
+      if (rng() % 2 == 0) {
+        tree.emplace(key, key);
+        model.insert(key);
+      } else if (model.erase(key) == 1) {
+        tree.removeNode(tree.find(key));
+      }
+      if (step % 150 == 0) versions.emplace_back(tree.snapshot(), model);
+    }
+    ASSERT_TRUE(IsValidTree(tree));
+    for (const auto& [snapshot, expected] : versions) {
+      EXPECT_EQ(snapshot.size(), expected.size());
+      EXPECT_EQ(Contents(snapshot), Contents(expected));
+    }
+    // Dropping the snapshots in any order frees what only they held.
+    std::shuffle(versions.begin(), versions.end(), rng);
+    versions.clear();
+    EXPECT_EQ(liveNodes, model.size());
+    EXPECT_EQ(Contents(tree.snapshot()), Contents(model));
+  }
+  EXPECT_EQ(liveNodes, 0u);
+}
+
+TEST(PersistentRBTreeTest, WritesCopyOnlyThePath) {
+  std::vector<int> keys;
+  for (int i = 0; i < 4096; ++i) keys.push_back(2 * i);
+  Tree tree;
+  tree.buildFromSorted(keys.begin(), keys.end(),
+                       [](const int& key) -> const int& { return key; });
+  ASSERT_TRUE(IsValidTree(tree));
+  {
+    Tree::Snapshot before = tree.snapshot();
+    Tree copy(tree);
+    EXPECT_EQ(liveNodes, keys.size());
+
+    // A red-black tree of 4096 nodes is at most 24 levels deep; each write
+    // copies its path plus a few siblings touched by the fix-up.
+    tree.insert(4001, 4001);
+    EXPECT_LE(liveNodes, keys.size() + 1 + 30);
+    std::size_t afterInsert = liveNodes;
+    tree.removeNode(tree.find(6000));
+    EXPECT_LE(liveNodes, afterInsert + 30);
+
+    EXPECT_EQ(Contents(before), keys);
+    EXPECT_TRUE(IsValidTree(copy));
+    EXPECT_FALSE(before.contains(4001));
+    EXPECT_TRUE(before.contains(6000));
+    ASSERT_TRUE(IsValidTree(tree));
+  }
+  EXPECT_EQ(liveNodes, keys.size());
+  tree.clear();
+  EXPECT_EQ(liveNodes, 0u);
+}
+
+TEST(PersistentRBTreeTest, SnapshotLookups) {
+  Tree tree;
+  for (int key : {10, 20, 30, 40}) tree.insert(key, key);
+  Tree::Snapshot snapshot = tree.snapshot();
+  tree.removeNode(tree.find(20));
+  tree.insert(25, 25);
+
+  EXPECT_EQ(*snapshot.find(20), 20);
+  EXPECT_EQ(snapshot.find(25), snapshot.end());
+  EXPECT_EQ(snapshot.at(30), 30);
+  EXPECT_THROW(snapshot.at(25), std::out_of_range);
+  EXPECT_EQ(*snapshot.lower_bound(15), 20);
+  EXPECT_EQ(*snapshot.upper_bound(30), 40);
+  EXPECT_EQ(snapshot.upper_bound(40), snapshot.end());
+  EXPECT_EQ(std::vector<int>(snapshot.lower_bound(20), snapshot.end()),
+            (std::vector<int>{20, 30, 40}));
+
+  Tree::Snapshot empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(empty.begin(), empty.end());
+  empty = snapshot;
+  EXPECT_EQ(empty.size(), 4u);
+}
+
+TEST(PersistentRBTreeTest, WalkBothWays) {
+  Tree tree;
+  for (int key = 0; key < 64; ++key) tree.insert(key, key);
+  Tree::Snapshot snapshot = tree.snapshot();
+  int expected = 0;
+  for (auto it = tree.minimum(); it != Tree::Position();
+       it = Tree::findNext(it)) {
+    EXPECT_EQ(Tree::valueOf(it), expected++);
+  }
+  EXPECT_EQ(expected, 64);
+  for (auto it = tree.maximum(); it != Tree::Position();
+       it = Tree::findPrev(it)) {
+    EXPECT_EQ(Tree::valueOf(it), --expected);
+  }
+  EXPECT_EQ(expected, 0);
+  EXPECT_EQ(Contents(snapshot).size(), 64u);
+}
+
+// One writer hands snapshots to a reader thread, which checks and drops
+// them while the writer keeps going.
+TEST(PersistentRBTreeTest, ReaderThreadDropsSnapshots) {
+  using SharedTree = PersistentRBTree<int, int, std::allocator<int>, true,
+                                      RBTreeIdentityKey>;
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::deque<std::pair<SharedTree::Snapshot, std::size_t>> queue;
+  bool done = false;
+  bool allMatched = true;
+
+  std::thread reader([&] {
+    while (true) {
+      std::unique_lock<std::mutex> lock(mutex);
+      ready.wait(lock, [&] { return done || !queue.empty(); });
+      if (queue.empty()) return;
+      auto [snapshot, expected] = std::move(queue.front());
+      queue.pop_front();
+      lock.unlock();
+      std::size_t count = 0;
+      for (int key : snapshot) count += key >= 0 ? 1 : 0;
+      if (count != expected || snapshot.size() != expected) {
+        allMatched = false;
+      }
+    }
+  });
+
+  SharedTree tree;
+  std::mt19937 rng(3);
+  for (int step = 0; step < 20000; ++step) {
+    int key = static_cast<int>(rng() % 1000);
+    auto found = tree.find(key);
+    if (found == SharedTree::Position()) {
+      tree.insert(key, key);
+    } else {
+      tree.removeNode(found);
+    }
+    if (step % 100 == 0) {
+      std::lock_guard<std::mutex> lock(mutex);
+      queue.emplace_back(tree.snapshot(), tree.size());
+      ready.notify_one();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+  }
+  ready.notify_one();
+  reader.join();
+  EXPECT_TRUE(allMatched);
+  EXPECT_TRUE(IsValidTree(tree));
+}
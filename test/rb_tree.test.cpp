@@ -2,6 +2,92 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Returns the black height of the subtree, or -1 if it breaks an invariant.
+template <typename Tree, typename Node = typename Tree::Node>
+int BlackHeight(const Node* node, const Node* parent) {
+  if (node == nullptr) return 1;
+  if (node->parent != parent) return -1;
+  if (node->color == RED && parent != nullptr && parent->color == RED) {
+    return -1;
+  }
+  typename Tree::key_compare less;
+  if (node->left != nullptr &&
+      less(Tree::nodeKey(node), Tree::nodeKey(node->left))) {
+    return -1;
+  }
+  if (node->right != nullptr &&
+      less(Tree::nodeKey(node->right), Tree::nodeKey(node))) {
+    return -1;
+  }
+  int left = BlackHeight<Tree>(node->left, node);
+  int right = BlackHeight<Tree>(node->right, node);
+  if (left < 0 || left != right) return -1;
+  return left + (node->color == BLACK ? 1 : 0);
+}
+
+template <typename Tree>
+bool IsValidTree(Tree& tree) {
+  if (tree.isEmpty()) return true;
+  auto* root = tree.minimum();
+  while (root->parent != nullptr) root = root->parent;
+  return root->color == BLACK && BlackHeight<Tree>(root, root->parent) > 0;
+}
+
+// Checks the cached subtree sizes of an order-statistics tree.
+template <typename Tree>
+bool SizesMatch(const typename Tree::Node* node, std::size_t& count) {
+  if (node == nullptr) {
+    count = 0;
+    return true;
+  }
+  std::size_t left = 0;
+  std::size_t right = 0;
+  if (!SizesMatch<Tree>(node->left, left) ||
+      !SizesMatch<Tree>(node->right, right)) {
+    return false;
+  }
+  count = left + right + Tree::occurrences(node);
+  return node->size == count;
+}
+
+template <typename Tree>
+bool SizesMatch(Tree& tree) {
+  if (tree.isEmpty()) return true;
+  auto* root = tree.minimum();
+  while (root->parent != nullptr) root = root->parent;
+  std::size_t count = 0;
+  return SizesMatch<Tree>(root, count) && count == tree.size() + 0u;
+}
+
+// Orders ints and counts how often each kind of comparison runs.
+struct CountingCompare {
+  bool operator()(int lhs, int rhs) const {
+    ++lessCalls;
+    return lhs < rhs;
+  }
+  int compare(int lhs, int rhs) const {
+    ++threeWayCalls;
+    return lhs < rhs ? -1 : lhs > rhs ? 1 : 0;
+  }
+
+  static inline int lessCalls = 0;
+  static inline int threeWayCalls = 0;
+};
+
+}  // namespace
+
 TEST(RBTreeTest, InsertAndFind) {
   RBTree<int, std::string> map;
   map.insert(1, "one");
@@ -59,4 +145,583 @@ TEST(RBTreeTest, MinimumAndMaximum) {
   ASSERT_NE(max, nullptr);
   EXPECT_EQ(min->value, "five");
   EXPECT_EQ(max->value, "twenty");
-}
\ No newline at end of file
+}
+TEST(RBTreeTest, HeapAllocator) {
+  RBTree<int, std::string, std::allocator<std::string>> map;
+  for (int i = 0; i < 100; ++i) {
+    map.insert(i, std::to_string(i));
+  }
+  for (int i = 0; i < 100; i += 2) {
+    map.remove(i);
+  }
+  EXPECT_FALSE(map.contains(10));
+  EXPECT_EQ(map.find(11)->value, "11");
+}
+TEST(RBTreeTest, CopyAndReuseAfterClear) {
+  RBTree<int, std::string> map;
+  for (int i = 0; i < 100; ++i) {
+    map.insert(i, std::to_string(i));
+  }
+  RBTree<int, std::string> copy(map);
+  map.clear();
+  EXPECT_EQ(map.size(), 0);
+  map.insert(1, "one");
+  EXPECT_EQ(map.find(1)->value, "one");
+  EXPECT_EQ(copy.size(), 100);
+  EXPECT_EQ(copy.find(99)->value, "99");
+}
+TEST(RBTreeTest, DuplicateInsertKeepsFirst) {
+  RBTree<int, std::string> map;
+  map.insert(1, "one");
+  map.insert(1, "uno");
+  EXPECT_EQ(map.size(), 1);
+  EXPECT_EQ(map.find(1)->value, "one");
+}
+TEST(RBTreeTest, InsertReturnsNode) {
+  RBTree<int, std::string> map;
+  auto [node, inserted] = map.insert(1, "one");
+  ASSERT_TRUE(inserted);
+  EXPECT_EQ(node->value, "one");
+  auto [existing, again] = map.insert(1, "uno");
+  EXPECT_FALSE(again);
+  EXPECT_EQ(existing, node);
+}
+TEST(RBTreeTest, SortedAppendWithEndHint) {
+  RBTree<int, int> map;
+  for (int i = 0; i < 1000; ++i) {
+    auto result = map.insertWithHint(nullptr, i, i);
+    EXPECT_TRUE(result.second);
+  }
+  EXPECT_EQ(map.size(), 1000);
+  EXPECT_EQ(map.maximum()->key, 999);
+  EXPECT_TRUE(IsValidTree(map));
+}
+TEST(RBTreeTest, InsertWithHint) {
+  RBTree<int, int> map;
+  for (int i = 0; i < 100; i += 10) {
+    map.insert(i, i);
+  }
+  auto* hint = map.find(50);
+  EXPECT_EQ(map.insertWithHint(hint, 45, 45).first->key, 45);
+  EXPECT_EQ(map.insertWithHint(hint, 5, 5).first->key, 5);
+  EXPECT_EQ(map.insertWithHint(hint, 95, 95).first->key, 95);
+  EXPECT_FALSE(map.insertWithHint(hint, 50, 0).second);
+  EXPECT_EQ(map.size(), 13);
+  EXPECT_TRUE(IsValidTree(map));
+}
+TEST(RBTreeTest, RemoveKeepsInvariants) {
+  RBTree<int, int> map;
+  for (int i = 0; i < 512; ++i) {
+    map.insert((i * 37) % 512, i);
+  }
+  for (int i = 0; i < 512; i += 3) {
+    map.remove(i);
+    ASSERT_TRUE(IsValidTree(map));
+  }
+  EXPECT_EQ(map.maximum()->key, 511);
+  map.remove(511);
+  EXPECT_EQ(map.maximum()->key, 509);
+}
+TEST(RBTreeTest, BuildFromSorted) {
+  for (int n = 0; n < 300; ++n) {
+    std::vector<int> keys(n);
+    for (int i = 0; i < n; ++i) keys[i] = i * 2;
+    RBTree<int, int> tree;
+    tree.insert(-1, -1);
+    tree.buildFromSorted(keys.begin(), keys.end(), [](int key) { return key; });
+    ASSERT_EQ(tree.size(), n);
+    ASSERT_TRUE(IsValidTree(tree));
+    ASSERT_EQ(tree.find(-1), nullptr);
+    if (n > 0) {
+      ASSERT_EQ(tree.minimum()->key, 0);
+      ASSERT_EQ(tree.maximum()->key, (n - 1) * 2);
+      tree.insert(n * 2, 0);
+      tree.remove(0);
+      ASSERT_TRUE(IsValidTree(tree));
+    }
+  }
+}
+TEST(RBTreeTest, BuildFromSortedSkipsDuplicates) {
+  std::vector<std::pair<int, std::string>> items = {
+      {1, "a"}, {1, "b"}, {2, "c"}, {3, "d"}, {3, "e"}, {3, "f"}};
+  RBTree<int, std::pair<int, std::string>> tree;
+  tree.buildFromSorted(items.begin(), items.end(),
+                       [](const auto& item) { return item.first; });
+  EXPECT_EQ(tree.size(), 3);
+  EXPECT_EQ(tree.find(1)->value.second, "a");
+  EXPECT_EQ(tree.find(3)->value.second, "d");
+  EXPECT_TRUE(IsValidTree(tree));
+}
+TEST(RBTreeTest, OrderStatistics) {
+  RBTree<int, int, NodePool<int>, true> tree;
+  std::vector<int> keys;
+  for (int i = 0; i < 200; ++i) {
+    int key = (i * 37) % 200;
+    tree.insert(key, key);
+    keys.push_back(key);
+  }
+  ASSERT_TRUE(SizesMatch(tree));
+  for (int i = 0; i < 200; i += 3) {
+    tree.remove((i * 37) % 200);
+    ASSERT_TRUE(IsValidTree(tree));
+    ASSERT_TRUE(SizesMatch(tree));
+  }
+
+  std::vector<int> rest;
+  for (int key = 0; key < 200; ++key) {
+    if (tree.contains(key)) rest.push_back(key);
+  }
+  for (std::size_t i = 0; i < rest.size(); ++i) {
+    EXPECT_EQ(tree.select(i)->key, rest[i]);
+    EXPECT_EQ(tree.rank(rest[i]), i);
+  }
+  EXPECT_EQ(tree.select(rest.size()), nullptr);
+  EXPECT_EQ(tree.rank(-1), 0u);
+  EXPECT_EQ(tree.rank(1000), rest.size());
+  EXPECT_EQ(tree.countInRange(0, 200), rest.size());
+  EXPECT_EQ(tree.countInRange(50, 50), 0u);
+  EXPECT_EQ(tree.countInRange(60, 50), 0u);
+}
+TEST(RBTreeTest, OrderStatisticsAfterBuildAndCopy) {
+  std::vector<int> keys;
+  for (int i = 0; i < 100; ++i) keys.push_back(i * 2);
+  RBTree<int, int, NodePool<int>, true> tree;
+  tree.buildFromSorted(keys.begin(), keys.end(),
+                       [](int key) -> int { return key; });
+  ASSERT_TRUE(SizesMatch(tree));
+  RBTree<int, int, NodePool<int>, true> copy(tree);
+  ASSERT_TRUE(SizesMatch(copy));
+  EXPECT_EQ(copy.select(10)->key, 20);
+  EXPECT_EQ(copy.countInRange(10, 21), 6u);
+  copy.insertWithHint(nullptr, 1000, 1000);
+  ASSERT_TRUE(SizesMatch(copy));
+  EXPECT_EQ(copy.rank(1000), 100u);
+}
+TEST(RBTreeTest, LowerAndUpperBound) {
+  RBTree<int, int> tree;
+  for (int i = 0; i < 100; ++i) tree.insert(i * 2, i);
+  EXPECT_EQ(tree.lowerBound(10)->key, 10);
+  EXPECT_EQ(tree.upperBound(10)->key, 12);
+  EXPECT_EQ(tree.lowerBound(11)->key, 12);
+  EXPECT_EQ(tree.upperBound(11)->key, 12);
+  EXPECT_EQ(tree.lowerBound(-5)->key, 0);
+  EXPECT_EQ(tree.lowerBound(198)->key, 198);
+  EXPECT_EQ(tree.upperBound(198), nullptr);
+  EXPECT_EQ(tree.lowerBound(199), nullptr);
+
+  RBTree<int, int> empty;
+  EXPECT_EQ(empty.lowerBound(0), nullptr);
+  EXPECT_EQ(empty.upperBound(0), nullptr);
+}
+TEST(RBTreeTest, EqualKeysKeepInsertionOrder) {
+  RBTree<int, std::string, NodePool<std::string>, false, RBTreeKeys::kEqual>
+      tree;
+  tree.insert(1, "a");
+  tree.insert(2, "x");
+  tree.insert(1, "b");
+  tree.insertWithHint(nullptr, 2, "y");
+  auto [node, inserted] = tree.insert(1, "c");
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(node->value, "c");
+  EXPECT_EQ(tree.size(), 5);
+
+  std::string order;
+  for (auto* it = tree.minimum(); it != nullptr; it = tree.findNext(it)) {
+    order += it->value;
+  }
+  EXPECT_EQ(order, "abcxy");
+  tree.removeNode(tree.lowerBound(1));
+  EXPECT_EQ(tree.lowerBound(1)->value, "b");
+  EXPECT_EQ(tree.size(), 4);
+}
+TEST(RBTreeTest, EqualKeysKeepInvariants) {
+  RBTree<int, int, NodePool<int>, true, RBTreeKeys::kEqual> tree;
+  for (int i = 0; i < 500; ++i) {
+    tree.insert((i * 7) % 10, i);
+    ASSERT_TRUE(IsValidTree(tree));
+  }
+  ASSERT_TRUE(SizesMatch(tree));
+  EXPECT_EQ(tree.countInRange(3, 4), 50u);
+  EXPECT_EQ(tree.rank(3), 150u);
+  for (int i = 0; i < 250; ++i) {
+    tree.remove(i % 10);
+    ASSERT_TRUE(IsValidTree(tree));
+    ASSERT_TRUE(SizesMatch(tree));
+  }
+  EXPECT_EQ(tree.size(), 250);
+  EXPECT_EQ(tree.countInRange(3, 4), 25u);
+}
+TEST(RBTreeTest, CountedKeys) {
+  RBTree<int, int, NodePool<int>, true, RBTreeKeys::kCounted> tree;
+  for (int i = 0; i < 300; ++i) tree.insert(i % 3, i % 3);
+  EXPECT_EQ(tree.size(), 300);
+  EXPECT_EQ(tree.findNext(tree.findNext(tree.minimum())), tree.maximum());
+  EXPECT_EQ(decltype(tree)::occurrences(tree.find(1)), 100u);
+  EXPECT_EQ(tree.select(150)->key, 1);
+  EXPECT_EQ(tree.rank(2), 200u);
+  ASSERT_TRUE(SizesMatch(tree));
+
+  tree.remove(1);
+  EXPECT_EQ(decltype(tree)::occurrences(tree.find(1)), 99u);
+  for (int i = 0; i < 99; ++i) tree.remove(1);
+  EXPECT_FALSE(tree.contains(1));
+  EXPECT_EQ(tree.size(), 200);
+  ASSERT_TRUE(IsValidTree(tree));
+  ASSERT_TRUE(SizesMatch(tree));
+}
+TEST(RBTreeTest, BuildFromSortedWithEqualKeys) {
+  std::vector<int> keys = {1, 1, 2, 3, 3, 3, 4};
+  auto identity = [](int key) -> int { return key; };
+  RBTree<int, int, NodePool<int>, true, RBTreeKeys::kEqual> equal;
+  equal.buildFromSorted(keys.begin(), keys.end(), identity);
+  EXPECT_EQ(equal.size(), 7);
+  ASSERT_TRUE(IsValidTree(equal));
+  ASSERT_TRUE(SizesMatch(equal));
+
+  RBTree<int, int, NodePool<int>, true, RBTreeKeys::kCounted> counted;
+  counted.buildFromSorted(keys.begin(), keys.end(), identity);
+  EXPECT_EQ(counted.size(), 7);
+  EXPECT_EQ(decltype(counted)::occurrences(counted.find(3)), 3u);
+  EXPECT_EQ(counted.select(5)->key, 3);
+  ASSERT_TRUE(IsValidTree(counted));
+  ASSERT_TRUE(SizesMatch(counted));
+}
+TEST(RBTreeTest, KeyFromValue) {
+  using Pair = std::pair<const std::string, int>;
+  RBTree<std::string, Pair, NodePool<Pair>, false, RBTreeKeys::kUnique,
+         RBTreeFirstKey>
+      tree;
+  for (int i = 0; i < 100; ++i) {
+    std::string key = std::to_string(i);
+    tree.insert(key, Pair(key, i));
+  }
+  ASSERT_TRUE(IsValidTree(tree));
+  EXPECT_EQ(tree.find("42")->value.second, 42);
+  EXPECT_EQ(decltype(tree)::nodeKey(tree.minimum()), "0");
+  EXPECT_FALSE(tree.insert("7", Pair("7", 0)).second);
+  tree.remove("42");
+  EXPECT_FALSE(tree.contains("42"));
+
+  RBTree<std::string, std::string, NodePool<std::string>, false,
+         RBTreeKeys::kEqual, RBTreeIdentityKey>
+      set;
+  set.insert("b", "b");
+  set.insert("a", "a");
+  set.insert("b", "b");
+  EXPECT_EQ(set.size(), 3);
+  EXPECT_EQ(set.lowerBound("b")->value, "b");
+  ASSERT_TRUE(IsValidTree(set));
+}
+TEST(RBTreeTest, KeyFromValueShrinksNodes) {
+  using Pair = std::pair<const std::string, int>;
+  using StoredKey = RBTree<std::string, Pair>::Node;
+  using FirstKey = RBTree<std::string, Pair, NodePool<Pair>, false,
+                          RBTreeKeys::kUnique, RBTreeFirstKey>::Node;
+  EXPECT_EQ(sizeof(StoredKey) - sizeof(FirstKey), sizeof(std::string));
+}
+
+TEST(RBTreeTest, CustomCompare) {
+  RBTree<int, int, NodePool<int>, true, RBTreeKeys::kUnique, RBTreeStoredKey,
+         std::greater<int>>
+      tree;
+  for (int i = 0; i < 50; ++i) tree.insert(i, i * 10);
+  ASSERT_TRUE(IsValidTree(tree));
+  EXPECT_EQ(tree.minimum()->key, 49);
+  EXPECT_EQ(tree.maximum()->key, 0);
+  EXPECT_EQ(tree.find(7)->value, 70);
+  EXPECT_EQ(tree.lowerBound(7)->key, 7);
+  EXPECT_EQ(tree.upperBound(7)->key, 6);
+  EXPECT_EQ(tree.rank(40), 9u);
+  EXPECT_EQ(tree.countInRange(40, 30), 10u);
+  tree.remove(7);
+  EXPECT_FALSE(tree.contains(7));
+}
+TEST(RBTreeTest, TransparentLookup) {
+  RBTree<std::string, int, NodePool<int>, false, RBTreeKeys::kUnique,
+         RBTreeStoredKey, std::less<>>
+      tree;
+  for (int i = 0; i < 20; ++i) tree.insert("key" + std::to_string(i), i);
+  std::string_view key = "key12";
+  EXPECT_EQ(tree.find(key)->value, 12);
+  EXPECT_TRUE(tree.contains(key));
+  EXPECT_FALSE(tree.contains(std::string_view("key20")));
+  EXPECT_EQ(tree.lowerBound("key2")->value, 2);
+  EXPECT_EQ(tree.upperBound(std::string_view("key19"))->value, 2);
+}
+TEST(RBTreeTest, ThreeWayCompareOncePerNode) {
+  RBTree<int, int, NodePool<int>, false, RBTreeKeys::kUnique, RBTreeStoredKey,
+         CountingCompare>
+      tree;
+  for (int i = 0; i < 1000; ++i) tree.insert(i * 2, i);
+  ASSERT_TRUE(IsValidTree(tree));
+  EXPECT_FALSE(tree.insert(10, 0).second);
+  CountingCompare::lessCalls = 0;
+  CountingCompare::threeWayCalls = 0;
+  int depth = 0;
+  for (auto* node = tree.find(1998); node != nullptr; node = node->parent) {
+    ++depth;
+  }
+  EXPECT_EQ(CountingCompare::threeWayCalls, depth);
+  EXPECT_EQ(CountingCompare::lessCalls, 0);
+  EXPECT_TRUE(tree.contains(500));
+  EXPECT_FALSE(tree.contains(501));
+  tree.remove(500);
+  EXPECT_FALSE(tree.contains(500));
+  EXPECT_EQ(CountingCompare::lessCalls, 0);
+
+  std::string key = "pear";
+  EXPECT_GT(RBTreeThreeWay(std::less<std::string>(), key, "apple"), 0);
+  EXPECT_LT(RBTreeThreeWay(std::less<>(), std::string_view("fig"), key), 0);
+  EXPECT_EQ(RBTreeThreeWay(std::greater<std::string>(), key, "apple"), -1);
+}
+TEST(RBTreeTest, ExtractAndInsertNode) {
+  using Tree = RBTree<int, std::string, std::allocator<std::string>, true>;
+  Tree source;
+  Tree target;
+  for (int i = 0; i < 100; ++i) source.insert(i, std::to_string(i));
+  target.insert(50, "kept");
+  std::vector<Tree::Node*> moved;
+  for (int i = 0; i < 100; i += 2) {
+    Tree::NodeHandle handle = source.extractNode(source.find(i));
+    ASSERT_EQ(handle.key(), i);
+    Tree::Node* node = target.insertNode(handle).first;
+    ASSERT_EQ(handle.empty(), i != 50);
+    if (i != 50) moved.push_back(node);
+  }
+  ASSERT_EQ(source.size(), 50);
+  ASSERT_EQ(target.size(), 50);
+  ASSERT_EQ(target.find(50)->value, "kept");
+  ASSERT_EQ(target.find(42), moved[21]);
+  ASSERT_TRUE(IsValidTree(source));
+  ASSERT_TRUE(IsValidTree(target));
+  ASSERT_TRUE(SizesMatch(source));
+  ASSERT_TRUE(SizesMatch(target));
+}
+TEST(RBTreeTest, MergeRelinksNodes) {
+  using Tree =
+      RBTree<int, int, std::allocator<int>, true, RBTreeKeys::kCounted>;
+  Tree tree;
+  Tree other;
+  for (int i = 0; i < 200; ++i) tree.insert(i % 50, i);
+  for (int i = 0; i < 200; ++i) other.insert(i % 100, i);
+  Tree::Node* relinked = other.find(75);
+  tree.mergeFrom(other);
+  ASSERT_TRUE(other.isEmpty());
+  ASSERT_EQ(tree.size(), 400);
+  ASSERT_EQ(tree.find(75), relinked);
+  ASSERT_EQ(Tree::occurrences(tree.find(10)), 6u);
+  ASSERT_EQ(tree.countInRange(0, 50), 300u);
+  ASSERT_TRUE(IsValidTree(tree));
+  ASSERT_TRUE(SizesMatch(tree));
+
+  Tree::NodeHandle handle = tree.extractNode(tree.find(10));
+  ASSERT_EQ(Tree::occurrences(tree.find(10)), 5u);
+  ASSERT_EQ(tree.size(), 399);
+  ASSERT_FALSE(tree.insertNode(handle).second);
+  ASSERT_TRUE(handle.empty());
+  ASSERT_EQ(Tree::occurrences(tree.find(10)), 6u);
+  ASSERT_TRUE(SizesMatch(tree));
+}
+TEST(RBTreeTest, MergeEitherWay) {
+  // Small trees of similar size take the ordered walk, the large pair a
+  // lookup per element.
+  using Tree = RBTree<int, int, std::allocator<int>, true>;
+  for (int size : {100, 20000}) {
+    Tree tree;
+    Tree other;
+    for (int i = 0; i < size; ++i) tree.insert(i * 2, i);
+    for (int i = 0; i < size; ++i) other.insert(i * 3, -i);
+    Tree::Node* relinked = other.find(3);
+    tree.mergeFrom(other);
+    int clashing = (size * 2 - 1) / 6 + 1;
+    ASSERT_EQ(other.size(), clashing);
+    ASSERT_EQ(tree.size(), size * 2 - clashing);
+    ASSERT_EQ(tree.find(3), relinked);
+    ASSERT_EQ(tree.find(6)->value, 3);
+    ASSERT_EQ(other.find(6)->value, -2);
+    ASSERT_TRUE(IsValidTree(tree));
+    ASSERT_TRUE(IsValidTree(other));
+    ASSERT_TRUE(SizesMatch(tree));
+    ASSERT_TRUE(SizesMatch(other));
+  }
+}
+TEST(RBTreeTest, CombineMatchesSetAlgorithms) {
+  using Tree = RBTree<int, int, std::allocator<int>, true>;
+  const RBTreeSetOp ops[] = {
+      RBTreeSetOp::kUnion, RBTreeSetOp::kIntersection,
+      RBTreeSetOp::kDifference, RBTreeSetOp::kSymmetricDifference};
+  // Similar sizes take the ordered walk, a tiny `other` one lookup each.
+  for (int otherSize : {3000, 4}) {
+    std::vector<int> mine;
+    std::vector<int> theirs;
+    for (int i = 0; i < 1000; ++i) mine.push_back(i * 2);
+    for (int i = 0; i < otherSize; ++i) theirs.push_back(i * 3 + 1);
+    for (RBTreeSetOp op : ops) {
+      Tree tree;
+      Tree other;
+      for (int key : mine) tree.insert(key, -key);
+      for (int key : theirs) other.insert(key, key);
+      std::vector<int> expected;
+      auto out = std::back_inserter(expected);
+      if (op == RBTreeSetOp::kUnion) {
+        std::set_union(mine.begin(), mine.end(), theirs.begin(),
+                       theirs.end(), out);
+      } else if (op == RBTreeSetOp::kIntersection) {
+        std::set_intersection(mine.begin(), mine.end(), theirs.begin(),
+                              theirs.end(), out);
+      } else if (op == RBTreeSetOp::kDifference) {
+        std::set_difference(mine.begin(), mine.end(), theirs.begin(),
+                            theirs.end(), out);
+      } else {
+        std::set_symmetric_difference(mine.begin(), mine.end(),
+                                      theirs.begin(), theirs.end(), out);
+      }
+      tree.combine(other, op);
+      std::vector<int> keys;
+      for (auto* node = tree.minimum(); node != nullptr;
+           node = Tree::findNext(node)) {
+        keys.push_back(node->key);
+        // Shared keys keep this tree's value.
+        bool own = node->key % 2 == 0 && node->key < 2000;
+        ASSERT_EQ(node->value, own ? -node->key : node->key);
+      }
+      ASSERT_EQ(keys, expected);
+      ASSERT_EQ(tree.size() + 0u, expected.size());
+      ASSERT_EQ(other.size(), otherSize);
+      ASSERT_TRUE(IsValidTree(tree));
+      ASSERT_TRUE(SizesMatch(tree));
+    }
+  }
+  Tree tree;
+  for (int i = 0; i < 10; ++i) tree.insert(i, i);
+  tree.combine(tree, RBTreeSetOp::kIntersection);
+  ASSERT_EQ(tree.size(), 10);
+  tree.combine(tree, RBTreeSetOp::kSymmetricDifference);
+  ASSERT_TRUE(tree.isEmpty());
+}
+TEST(RBTreeTest, CombineCountsOccurrences) {
+  using Tree =
+      RBTree<int, int, std::allocator<int>, true, RBTreeKeys::kCounted>;
+  Tree tree;
+  Tree other;
+  for (int i = 0; i < 3; ++i) tree.insert(1, 1);
+  tree.insert(2, 2);
+  for (int i = 0; i < 5; ++i) other.insert(1, 1);
+  other.insert(3, 3);
+  Tree unionTree(tree);
+  unionTree.combine(other, RBTreeSetOp::kUnion);
+  ASSERT_EQ(Tree::occurrences(unionTree.find(1)), 5u);
+  ASSERT_EQ(unionTree.size(), 7);
+  Tree difference(other);
+  difference.combine(tree, RBTreeSetOp::kDifference);
+  ASSERT_EQ(Tree::occurrences(difference.find(1)), 2u);
+  ASSERT_EQ(difference.size(), 3);
+  tree.combine(other, RBTreeSetOp::kSymmetricDifference);
+  ASSERT_EQ(Tree::occurrences(tree.find(1)), 2u);
+  ASSERT_EQ(tree.size(), 4);
+  ASSERT_TRUE(SizesMatch(unionTree));
+  ASSERT_TRUE(SizesMatch(difference));
+  ASSERT_TRUE(SizesMatch(tree));
+}
+// Splits at every tenth key and joins the parts back, checking both
+// trees each time.
+template <typename Tree>
+void SplitAndJoinEverywhere() {
+  Tree tree;
+  for (int i = 0; i < 500; ++i) tree.insert(i * 2, i);
+  for (int key = -1; key <= 1001; key += 10) {
+    Tree right;
+    right.insert(-5, 0);  // replaced by the split
+    tree.split(key, right);
+    ASSERT_TRUE(IsValidTree(tree));
+    ASSERT_TRUE(IsValidTree(right));
+    int expectedLeft = key <= 0 ? 0 : (key + 1) / 2;
+    if (expectedLeft > 500) expectedLeft = 500;
+    ASSERT_EQ(tree.size(), expectedLeft);
+    ASSERT_EQ(right.size(), 500 - expectedLeft);
+    if (!tree.isEmpty()) {
+      ASSERT_LT(tree.maximum()->key, key);
+    }
+    if (!right.isEmpty()) {
+      ASSERT_GE(right.minimum()->key, key);
+    }
+    tree.join(right);
+    ASSERT_TRUE(right.isEmpty());
+    ASSERT_EQ(tree.size(), 500);
+    ASSERT_TRUE(IsValidTree(tree));
+    ASSERT_EQ(tree.maximum()->key, 998);
+    int expected = 0;
+    for (auto* node = tree.minimum(); node != nullptr;
+         node = Tree::findNext(node), expected += 2) {
+      ASSERT_EQ(node->key, expected);
+    }
+    ASSERT_EQ(expected, 1000);
+  }
+}
+TEST(RBTreeTest, SplitAndJoin) {
+  SplitAndJoinEverywhere<RBTree<int, int, std::allocator<int>, true>>();
+  SplitAndJoinEverywhere<RBTree<int, int, std::allocator<int>>>();
+  // The split-off tree shares the pool and keeps the nodes.
+  SplitAndJoinEverywhere<RBTree<int, int>>();
+  SplitAndJoinEverywhere<RBTree<int, int, NodePool<int>, true>>();
+  // Pools of their own: the smaller tree's values move to the other pool.
+  RBTree<int, int> few;
+  RBTree<int, int> many;
+  for (int i = 0; i < 10; ++i) few.insert(i, i);
+  for (int i = 10; i < 300; ++i) many.insert(i, i);
+  RBTree<int, int>::Node* manyNode = many.find(200);
+  few.join(many);
+  ASSERT_EQ(few.size(), 300);
+  ASSERT_EQ(few.find(200), manyNode);
+  ASSERT_TRUE(many.isEmpty());
+  ASSERT_TRUE(IsValidTree(few));
+
+  using Tree = RBTree<int, int, std::allocator<int>, true>;
+  Tree tree;
+  Tree right;
+  for (int i = 0; i < 300; ++i) tree.insert(i, i);
+  Tree::Node* kept = tree.find(250);
+  tree.split(200, right);
+  ASSERT_EQ(right.find(250), kept);
+  ASSERT_EQ(right.rank(250), 50u);
+  ASSERT_TRUE(SizesMatch(tree));
+  ASSERT_TRUE(SizesMatch(right));
+  // Joining unequal heights: one small tree onto a large one.
+  Tree small;
+  small.insert(1000, 0);
+  right.join(small);
+  ASSERT_EQ(right.size(), 101);
+  ASSERT_EQ(right.maximum()->key, 1000);
+  ASSERT_TRUE(IsValidTree(right));
+  ASSERT_TRUE(SizesMatch(right));
+  small.insert(-1, 0);
+  small.join(tree);
+  ASSERT_EQ(small.size(), 201);
+  ASSERT_TRUE(IsValidTree(small));
+  ASSERT_TRUE(SizesMatch(small));
+  ASSERT_TRUE(tree.isEmpty());
+  ASSERT_EQ(small.find(5)->value, 5);
+  ASSERT_THROW(small.join(small), std::invalid_argument);
+  Tree overlap;
+  overlap.insert(100, 0);
+  ASSERT_THROW(small.join(overlap), std::invalid_argument);
+  ASSERT_EQ(overlap.size(), 1);
+}
+TEST(RBTreeTest, JoinMergesCountedSeam) {
+  using Tree =
+      RBTree<int, int, NodePool<int>, true, RBTreeKeys::kCounted>;
+  Tree tree;
+  Tree right;
+  for (int i = 0; i < 100; ++i) tree.insert(i % 10, i);
+  tree.split(5, right);
+  ASSERT_EQ(tree.size(), 50);
+  ASSERT_EQ(right.size(), 50);
+  right.insert(5, 0);
+  tree.insert(5, 0);
+  tree.join(right);
+  ASSERT_EQ(tree.size(), 102);
+  ASSERT_EQ(Tree::occurrences(tree.find(5)), 12u);
+  ASSERT_EQ(tree.countInRange(5, 6), 12u);
+  ASSERT_TRUE(IsValidTree(tree));
+  ASSERT_TRUE(SizesMatch(tree));
+}
@@ -1,15 +1,19 @@
 #include <gtest/gtest.h>
 
+#include <vector>
+
 #include "custom_set.h"
 
 TEST(CustomSetTest, DefaultConstructor) {
   CustomSet<int> set;
   EXPECT_TRUE(set.empty());
 }
+
 TEST(CustomSetTest, InitializerListConstructor) {
   CustomSet<int> set({1, 2, 3});
   EXPECT_EQ(set.size(), 3);
 }
+
 TEST(CustomSetTest, InsertAndFind) {
   CustomSet<int> set;
   auto result = set.insert(1);
@@ -17,17 +21,20 @@ TEST(CustomSetTest, InsertAndFind) {
   EXPECT_EQ(*set.find(1), 1);
   EXPECT_EQ(set.size(), 1);
 }
+
 TEST(CustomSetTest, Erase) {
   CustomSet<int> set({1, 2, 3});
   set.erase(2);
   EXPECT_EQ(set.size(), 2);
   EXPECT_EQ(set.find(2), set.end());
 }
+
 TEST(CustomSetTest, Clear) {
   CustomSet<int> set({1, 2, 3});
   set.clear();
   EXPECT_TRUE(set.empty());
 }
+
 TEST(CustomSetTest, EmplaceHint) {
   CustomSet<int> set;
   set.insert(1);
@@ -35,5 +42,127 @@ TEST(CustomSetTest, EmplaceHint) {
   auto it = set.find(3);
   set.emplace_hint(it, 2);
   EXPECT_EQ(set.size(), 3);
-  EXPECT_EQ(set.find(2), set.end());
-}
\ No newline at end of file
+  EXPECT_EQ(*set.find(2), 2);
+  set.emplace_hint(set.begin(), 5);
+  EXPECT_EQ(*(set.end() - 1), 5);
+  EXPECT_EQ(set.emplace_hint(set.end(), 3) - set.begin(), 2);
+  EXPECT_EQ(set.size(), 4);
+}
+
+TEST(CustomSetTest, KeepsElementsSorted) {
+  CustomSet<int> set({5, 1, 4, 1, 3});
+  set.insert(2);
+  set.insert(4);
+  set.emplace(0);
+  std::vector<int> elements;
+  for (auto it = set.begin(); it != set.end(); ++it) elements.push_back(*it);
+  EXPECT_EQ(elements, std::vector<int>({0, 1, 2, 3, 4, 5}));
+  EXPECT_TRUE(set.contains(3));
+  EXPECT_EQ(set.count(6), 0);
+}
+
+TEST(CustomSetTest, Bounds) {
+  CustomSet<int> set({10, 20, 30});
+  EXPECT_EQ(*set.lower_bound(20), 20);
+  EXPECT_EQ(*set.upper_bound(20), 30);
+  EXPECT_EQ(*set.lower_bound(15), 20);
+  EXPECT_EQ(set.upper_bound(30), set.end());
+  auto [first, last] = set.equal_range(25);
+  EXPECT_EQ(first, last);
+  EXPECT_EQ(set.equal_range(10).second - set.equal_range(10).first, 1);
+}
+
+TEST(CustomSetTest, RangeInsertAndMerge) {
+  CustomSet<int> set({1, 5, 9});
+  std::vector<int> more = {7, 3, 5, 11, 3};
+  set.insert(more.begin(), more.end());
+  CustomSet<int> other({0, 9, 12});
+  set.merge(other);
+  std::vector<int> elements;
+  for (auto it = set.begin(); it != set.end(); ++it) elements.push_back(*it);
+  EXPECT_EQ(elements, std::vector<int>({0, 1, 3, 5, 7, 9, 11, 12}));
+  set.erase(set.find(7));
+  set.erase(4);
+  EXPECT_EQ(set.size(), 7);
+  EXPECT_FALSE(set.contains(7));
+}
+
+TEST(CustomSetTest, FrozenLookupsMatchSorted) {
+  CustomSet<int> sorted;
+  for (int i = 0; i < 1000; ++i) sorted.insert(i * 7 % 1999);
+  CustomSet<int> frozen(sorted);
+  frozen.freeze();
+  EXPECT_TRUE(frozen.frozen());
+  for (int probe = -1; probe <= 2000; ++probe) {
+    EXPECT_EQ(frozen.lower_bound(probe) - frozen.begin(),
+              sorted.lower_bound(probe) - sorted.begin());
+    EXPECT_EQ(frozen.upper_bound(probe) - frozen.begin(),
+              sorted.upper_bound(probe) - sorted.begin());
+    EXPECT_EQ(frozen.contains(probe), sorted.contains(probe));
+  }
+  EXPECT_EQ(*frozen.find(7), 7);
+  CustomSet<int> copy(frozen);
+  EXPECT_TRUE(copy.frozen());
+  frozen.insert(-5);
+  EXPECT_FALSE(frozen.frozen());
+  EXPECT_EQ(*frozen.begin(), -5);
+  EXPECT_EQ(*copy.lower_bound(-5), 0);
+}
+
+TEST(CustomSetTest, SetAlgebra) {
+  CustomSet<int> set({1, 2, 3, 5});
+  CustomSet<int> other({2, 5, 8});
+  CustomSet<int> joined(set);
+  joined.union_with(other);
+  std::vector<int> elements;
+  for (auto it = joined.begin(); it != joined.end(); ++it) {
+    elements.push_back(*it);
+  }
+  EXPECT_EQ(elements, std::vector<int>({1, 2, 3, 5, 8}));
+  CustomSet<int> common(set);
+  common.intersect_with(other);
+  EXPECT_EQ(common.size(), 2);
+  EXPECT_TRUE(common.contains(5));
+  CustomSet<int> only(set);
+  only.difference_with(other);
+  EXPECT_EQ(*only.begin(), 1);
+  EXPECT_EQ(*(only.begin() + 1), 3);
+  set.freeze();
+  set.symmetric_difference_with(other);
+  EXPECT_FALSE(set.frozen());
+  EXPECT_EQ(set.size(), 3);
+  EXPECT_TRUE(set.contains(8));
+  set.intersect_with(set);
+  EXPECT_EQ(set.size(), 3);
+  set.difference_with(set);
+  EXPECT_TRUE(set.empty());
+
+  // A much larger `other` is searched rather than walked.
+  CustomSet<int> few({-1, 40, 41, 999999});
+  CustomSet<int> many;
+  std::vector<int> evens;
+  for (int i = 0; i < 100000; ++i) evens.push_back(i * 2);
+  many.insert(evens.begin(), evens.end());
+  few.intersect_with(many);
+  EXPECT_EQ(few.size(), 1);
+  EXPECT_EQ(*few.begin(), 40);
+}
+
+TEST(CustomSetTest, RangeInsertKeepsFirstOfEqual) {
+  // Ordered by key only, so the tag tells equal elements apart.
+  struct Tagged {
+    int key = 0;
+    int tag = 0;
+    bool operator<(const Tagged& other) const { return key < other.key; }
+  };
+  std::vector<Tagged> items;
+  for (int i = 0; i < 3000; ++i) items.push_back({(i * 7919) % 1000, i});
+  CustomSet<Tagged> set;
+  set.insert(items.begin(), items.end());
+  ASSERT_EQ(set.size(), 1000);
+  int key = 0;
+  for (auto it = set.begin(); it != set.end(); ++it, ++key) {
+    EXPECT_EQ((*it).key, key);
+    EXPECT_LT((*it).tag, 1000);
+  }
+}
@@ -0,0 +1,214 @@
+#include "small_vector.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+
+#include "arena_resource.h"
+#include "pmr_containers.h"
+
+namespace {
+
+// Counts the objects alive, so a test sees every element destroyed
+// exactly once whether it lived inline or on the heap.
+struct Tracked {
+  static int alive;
+
+  explicit Tracked(int v) : value(v) { ++alive; }
+  Tracked(const Tracked& other) : value(other.value) { ++alive; }
+  Tracked(Tracked&& other) noexcept : value(other.value) {
+    other.value = -1;
+    ++alive;
+  }
+  Tracked& operator=(const Tracked&) = default;
+  Tracked& operator=(Tracked&&) = default;
+  ~Tracked() { --alive; }
+
+  int value;
+};
+
+int Tracked::alive = 0;
+
+const std::string kLong = "a string too long for the small buffer";
+
+template <std::size_t N>
+void Fill(SmallVector<std::string, N>& vector, int count) {
+  for (int i = 0; i < count; ++i) vector.push_back(kLong + std::to_string(i));
+}
+
+template <std::size_t N>
+void ExpectFilled(const SmallVector<std::string, N>& vector, int count) {
+  ASSERT_EQ(vector.size(), static_cast<std::size_t>(count));
+  for (int i = 0; i < count; ++i) {
+    EXPECT_EQ(vector[i], kLong + std::to_string(i));
+  }
+}
+
+bool Within(const void* ptr, const void* object, std::size_t bytes) {
+  const char* p = static_cast<const char*>(ptr);
+  const char* o = static_cast<const char*>(object);
+  return p >= o && p < o + bytes;
+}
+
+long long Sum(CustomVector<int>& vector) {
+  long long sum = 0;
+  for (int value : vector) sum += value;
+  return sum;
+}
+
+}  // namespace
+
+TEST(SmallVectorTest, StaysInlineUpToN) {
+  SmallVector<int, 4> vector;
+  EXPECT_TRUE(vector.is_inline());
+  EXPECT_EQ(vector.capacity(), 4u);
+  for (int i = 0; i < 4; ++i) vector.push_back(i);
+  EXPECT_TRUE(vector.is_inline());
+  EXPECT_TRUE(Within(&vector[0], &vector, sizeof(vector)));
+  vector.push_back(4);
+  EXPECT_FALSE(vector.is_inline());
+  EXPECT_FALSE(Within(&vector[0], &vector, sizeof(vector)));
+  EXPECT_GT(vector.capacity(), 4u);
+  for (int i = 0; i < 5; ++i) EXPECT_EQ(vector[i], i);
+}
+TEST(SmallVectorTest, DestroysEveryElement) {
+  Tracked::alive = 0;
+  {
+    SmallVector<Tracked, 2> vector;
+    vector.emplace_back(1);
+    vector.emplace_back(2);
+    EXPECT_EQ(Tracked::alive, 2);
+    vector.emplace_back(3);
+    EXPECT_EQ(Tracked::alive, 3);
+    vector.pop_back();
+    EXPECT_EQ(Tracked::alive, 2);
+  }
+  EXPECT_EQ(Tracked::alive, 0);
+}
+TEST(SmallVectorTest, CopyStaysInlineWhenItFits) {
+  SmallVector<std::string, 4> inlined;
+  Fill(inlined, 3);
+  SmallVector<std::string, 4> copy(inlined);
+  EXPECT_TRUE(copy.is_inline());
+  ExpectFilled(copy, 3);
+
+  SmallVector<std::string, 4> spilled;
+  Fill(spilled, 6);
+  copy = spilled;
+  EXPECT_FALSE(copy.is_inline());
+  ExpectFilled(copy, 6);
+  copy = inlined;
+  ExpectFilled(copy, 3);
+  ExpectFilled(spilled, 6);
+}
+TEST(SmallVectorTest, MoveInlineAndSpilled) {
+  SmallVector<std::string, 4> inlined;
+  Fill(inlined, 3);
+  SmallVector<std::string, 4> moved(std::move(inlined));
+  EXPECT_TRUE(moved.is_inline());
+  EXPECT_TRUE(inlined.empty());
+  EXPECT_TRUE(inlined.is_inline());
+  ExpectFilled(moved, 3);
+
+  SmallVector<std::string, 4> spilled;
+  Fill(spilled, 6);
+  const std::string* data = &spilled[0];
+  SmallVector<std::string, 4> stolen(std::move(spilled));
+  EXPECT_EQ(&stolen[0], data);
+  EXPECT_TRUE(spilled.empty());
+  EXPECT_TRUE(spilled.is_inline());
+  ExpectFilled(stolen, 6);
+
+  stolen = std::move(moved);
+  EXPECT_TRUE(moved.empty());
+  ExpectFilled(stolen, 3);
+  moved = std::move(stolen);
+  ExpectFilled(moved, 3);
+  spilled.push_back("reused");
+  EXPECT_EQ(spilled.back(), "reused");
+}
+TEST(SmallVectorTest, SwapEveryCombination) {
+  SmallVector<std::string, 4> a;
+  SmallVector<std::string, 4> b;
+  Fill(a, 2);
+  Fill(b, 7);
+  a.swap(b);
+  ExpectFilled(a, 7);
+  ExpectFilled(b, 2);
+  EXPECT_TRUE(b.is_inline());
+  b.swap(a);
+  ExpectFilled(a, 2);
+  ExpectFilled(b, 7);
+
+  SmallVector<std::string, 4> c;
+  Fill(c, 4);
+  c.pop_back();
+  a.swap(c);
+  ExpectFilled(a, 3);
+  ExpectFilled(c, 2);
+  EXPECT_TRUE(a.is_inline());
+  EXPECT_TRUE(c.is_inline());
+
+  SmallVector<std::string, 4> d;
+  Fill(d, 9);
+  const std::string* data = &d[0];
+  b.swap(d);
+  EXPECT_EQ(&b[0], data);
+  ExpectFilled(b, 9);
+  ExpectFilled(d, 7);
+  a.swap(a);
+  ExpectFilled(a, 3);
+}
+TEST(SmallVectorTest, ClearAndShrinkReturnInline) {
+  SmallVector<int, 4> vector;
+  for (int i = 0; i < 10; ++i) vector.push_back(i);
+  vector.clear();
+  EXPECT_TRUE(vector.is_inline());
+  EXPECT_EQ(vector.capacity(), 4u);
+
+  SmallVector<std::string, 4> strings;
+  Fill(strings, 10);
+  while (strings.size() > 3) strings.pop_back();
+  strings.shrink_to_fit();
+  EXPECT_TRUE(strings.is_inline());
+  ExpectFilled(strings, 3);
+  Fill(strings, 10);
+  strings.erase(9);
+  strings.shrink_to_fit();
+  EXPECT_FALSE(strings.is_inline());
+  EXPECT_EQ(strings.capacity(), 12u);
+}
+TEST(SmallVectorTest, PassesAsCustomVector) {
+  SmallVector<int, 4> small;
+  for (int i = 1; i <= 3; ++i) small.push_back(i);
+  EXPECT_EQ(Sum(small), 6);
+  CustomVector<int>& base = small;
+  base.push_back(4);
+  EXPECT_TRUE(small.is_inline());
+  base.clear();
+  EXPECT_TRUE(small.is_inline());
+
+  // A plain vector takes the elements out of the inline buffer.
+  for (int i = 1; i <= 3; ++i) small.push_back(i);
+  CustomVector<int> plain(std::move(base));
+  EXPECT_EQ(Sum(plain), 6);
+  EXPECT_TRUE(small.empty());
+  base.swap(plain);
+  EXPECT_EQ(Sum(small), 6);
+  EXPECT_TRUE(plain.empty());
+}
+TEST(SmallVectorTest, SpillsToTheAllocator) {
+  ArenaResource arena;
+  SmallVector<int, 4, std::pmr::polymorphic_allocator<int>> vector(&arena);
+  for (int i = 0; i < 4; ++i) vector.push_back(i);
+  EXPECT_EQ(arena.used_bytes(), 0u);
+  vector.push_back(4);
+  EXPECT_GT(arena.used_bytes(), 0u);
+  SmallVector<int, 4, std::pmr::polymorphic_allocator<int>> other;
+  other = std::move(vector);
+  EXPECT_EQ(other.get_allocator().resource(),
+            std::pmr::get_default_resource());
+  EXPECT_EQ(other.size(), 5u);
+  EXPECT_EQ(other[4], 4);
+}
@@ -1,16 +1,119 @@
 #include <gtest/gtest.h>
 
+#include <string>
+#include <type_traits>
+#include <utility>
+
 #include "custom_vector.h"
 
+namespace {
+
+// Counts the objects alive and every constructor call; has no default
+// constructor, so CustomVector must never make objects it was not given.
+struct Tracked {
+  static int alive;
+  static int constructed;
+
+  explicit Tracked(int v) : value(v) {
+    ++alive;
+    ++constructed;
+  }
+  Tracked(const Tracked& other) : value(other.value) {
+    ++alive;
+    ++constructed;
+  }
+  Tracked(Tracked&& other) noexcept : value(other.value) {
+    other.value = -1;
+    ++alive;
+    ++constructed;
+  }
+  Tracked& operator=(const Tracked&) = default;
+  Tracked& operator=(Tracked&&) = default;
+  ~Tracked() { --alive; }
+
+  int value;
+};
+
+int Tracked::alive = 0;
+int Tracked::constructed = 0;
+
+// Owns a heap int, so it is not trivially copyable, but moving its bytes
+// elsewhere is a valid move: it opts in to bulk relocation below. Counts
+// the moves and destructions CustomVector still runs.
+struct Boxed {
+  static int moves;
+  static int destroyed;
+
+  explicit Boxed(int v) : value(new int(v)) {}
+  Boxed(Boxed&& other) noexcept : value(other.value) {
+    other.value = nullptr;
+    ++moves;
+  }
+  Boxed& operator=(Boxed&& other) noexcept {
+    std::swap(value, other.value);
+    ++moves;
+    return *this;
+  }
+  ~Boxed() {
+    delete value;
+    ++destroyed;
+  }
+
+  int* value;
+};
+
+int Boxed::moves = 0;
+int Boxed::destroyed = 0;
+
+std::string Values(const CustomVector<Boxed>& vec) {
+  std::string out;
+  for (std::size_t i = 0; i < vec.size(); ++i) {
+    out += std::to_string(*vec[i].value) + " ";
+  }
+  return out;
+}
+
+}  // namespace
+
+template <>
+struct IsTriviallyRelocatable<Boxed> : std::true_type {};
+
+namespace {
+
+// The capacities a vector passes through while n elements are pushed.
+template <typename Growth>
+std::string Capacities(int n) {
+  CustomVector<int, std::allocator<int>, Growth> vec;
+  std::string out;
+  for (int i = 0; i < n; ++i) {
+    std::size_t capacity = vec.capacity();
+    vec.push_back(i);
+    if (vec.capacity() != capacity) out += std::to_string(vec.capacity()) + " ";
+  }
+  return out;
+}
+
+std::string Values(const CustomVector<Tracked>& vec) {
+  std::string out;
+  for (std::size_t i = 0; i < vec.size(); ++i) {
+    out += std::to_string(vec[i].value) + " ";
+  }
+  return out;
+}
+
+}  // namespace
+
 TEST(CustomVectorTest, DefaultConstructor) {
   CustomVector<int> vec;
   EXPECT_EQ(0, vec.size());
 }
+
 TEST(CustomVectorTest, InitialCapacityConstructor) {
   CustomVector<int> vec(10);
   EXPECT_EQ(0, vec.size());
   EXPECT_GE(vec.capacity(), 10);
 }
+
 TEST(CustomVectorTest, CopyConstructor) {
   CustomVector<int> vec1(10);
   vec1.push_back(1);
@@ -18,6 +121,7 @@ TEST(CustomVectorTest, CopyConstructor) {
   EXPECT_EQ(vec1.size(), vec2.size());
   EXPECT_EQ(vec1[0], vec2[0]);
 }
+
 TEST(CustomVectorTest, MoveConstructor) {
   CustomVector<int> vec1(10);
   vec1.push_back(1);
@@ -25,6 +129,7 @@ TEST(CustomVectorTest, MoveConstructor) {
   EXPECT_EQ(1, vec2.size());
   EXPECT_EQ(1, vec2[0]);
 }
+
 TEST(CustomVectorTest, CopyAssignmentOperator) {
   CustomVector<int> vec1(10);
   vec1.push_back(1);
@@ -33,6 +138,7 @@ TEST(CustomVectorTest, CopyAssignmentOperator) {
   EXPECT_EQ(vec1.size(), vec2.size());
   EXPECT_EQ(vec1[0], vec2[0]);
 }
+
 TEST(CustomVectorTest, MoveAssignmentOperator) {
   CustomVector<int> vec1(10);
   vec1.push_back(1);
@@ -41,14 +147,193 @@ TEST(CustomVectorTest, MoveAssignmentOperator) {
   EXPECT_EQ(1, vec2.size());
   EXPECT_EQ(1, vec2[0]);
 }
+
 TEST(CustomVectorTest, AccessWithAt) {
   CustomVector<int> vec(10);
   vec.push_back(42);
   EXPECT_EQ(42, vec.at(0));
   EXPECT_THROW(vec.at(1), std::out_of_range);
 }
+
 TEST(CustomVectorTest, AccessWithOperator) {
   CustomVector<int> vec(10);
   vec.push_back(42);
   EXPECT_EQ(42, vec[0]);
-}
\ No newline at end of file
+}
+
+TEST(CustomVectorTest, SpareCapacityHoldsNoObjects) {
+  Tracked::constructed = 0;
+  {
+    CustomVector<Tracked> vec(1000);
+    vec.reserve(100000);
+    EXPECT_EQ(Tracked::constructed, 0);
+    vec.emplace_back(7);
+    vec.push_back(Tracked(8));
+    EXPECT_EQ(Tracked::alive, 2);
+    EXPECT_EQ(Values(vec), "7 8 ");
+  }
+  EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(CustomVectorTest, ModifiersDestroyWhatTheyRemove) {
+  {
+    CustomVector<Tracked> vec;
+    for (int i = 0; i < 5; ++i) vec.emplace_back(i);
+    vec.insert(0, Tracked(10));
+    vec.emplace(3, 11);
+    vec.emplace(vec.size(), 12);
+    vec.insert(vec.begin(), Tracked(13));
+    EXPECT_EQ(Values(vec), "13 10 0 1 11 2 3 4 12 ");
+    EXPECT_EQ(Tracked::alive, 9);
+    vec.erase(1);
+    vec.pop_back();
+    EXPECT_EQ(Values(vec), "13 0 1 11 2 3 4 ");
+    EXPECT_EQ(Tracked::alive, 7);
+    vec.resize(3, Tracked(0));
+    EXPECT_EQ(Tracked::alive, 3);
+    vec.resize(5, Tracked(9));
+    EXPECT_EQ(Values(vec), "13 0 1 9 9 ");
+    vec.shrink_to_fit();
+    EXPECT_EQ(vec.capacity(), 5u);
+    EXPECT_EQ(Values(vec), "13 0 1 9 9 ");
+    vec.assign(2, Tracked(4));
+    EXPECT_EQ(Values(vec), "4 4 ");
+    EXPECT_EQ(Tracked::alive, 2);
+    vec.clear();
+    EXPECT_EQ(Tracked::alive, 0);
+    vec.emplace_back(1);
+    EXPECT_EQ(Values(vec), "1 ");
+  }
+  EXPECT_EQ(Tracked::alive, 0);
+}
+// Arguments that refer into the vector stay valid while it grows or shifts.
+TEST(CustomVectorTest, ArgumentsMayAliasElements) {
+  CustomVector<std::string> vec;
+  vec.push_back("first");
+  for (int i = 0; i < 6; ++i) vec.push_back(vec[0]);
+  EXPECT_EQ(vec.size(), 7u);
+  EXPECT_EQ(vec[6], "first");
+  vec.push_back("last");
+  vec.insert(0, vec[7]);
+  EXPECT_EQ(vec[0], "last");
+  EXPECT_EQ(vec[8], "last");
+  vec.resize(20, vec[0]);
+  EXPECT_EQ(vec[19], "last");
+  vec.assign(3, vec[1]);
+  EXPECT_EQ(vec[2], "first");
+}
+
+TEST(CustomVectorTest, RelocatableTrait) {
+  struct Pod {
+    double values[8];
+  };
+  static_assert(IsTriviallyRelocatable<int>::value);
+  static_assert(IsTriviallyRelocatable<Pod>::value);
+  static_assert(IsTriviallyRelocatable<std::pair<int, Pod>>::value);
+  static_assert(IsTriviallyRelocatable<Boxed>::value);
+  static_assert(!IsTriviallyRelocatable<Tracked>::value);
+  static_assert(!IsTriviallyRelocatable<std::pair<int, Tracked>>::value);
+}
+// Growth, insert, erase and shrink_to_fit move relocatable elements as
+// bytes: the only moves are those of the elements being added.
+TEST(CustomVectorTest, RelocatableElementsMoveAsBytes) {
+  Boxed::moves = Boxed::destroyed = 0;
+  {
+    CustomVector<Boxed> vec;
+    // Each of the 8 growths builds its new element aside and moves it in.
+    for (int i = 0; i < 100; ++i) vec.emplace_back(i);
+    EXPECT_EQ(Boxed::moves, 8);
+    Boxed::moves = Boxed::destroyed = 0;
+    vec.emplace(0, -1);
+    vec.emplace(50, -2);
+    EXPECT_EQ(Boxed::moves, 2);
+    EXPECT_EQ(Boxed::destroyed, 2);
+    EXPECT_EQ(*vec[0].value, -1);
+    EXPECT_EQ(*vec[1].value, 0);
+    EXPECT_EQ(*vec[50].value, -2);
+    EXPECT_EQ(*vec[101].value, 99);
+
+    Boxed::moves = Boxed::destroyed = 0;
+    vec.erase(50);
+    vec.erase(0);
+    vec.erase(vec.size() - 1);
+    EXPECT_EQ(Boxed::moves, 0);
+    EXPECT_EQ(Boxed::destroyed, 3);
+    ASSERT_EQ(vec.size(), 99u);
+    for (int i = 0; i < 99; ++i) EXPECT_EQ(*vec[i].value, i);
+
+    vec.shrink_to_fit();
+    EXPECT_EQ(vec.capacity(), 99u);
+    EXPECT_EQ(Boxed::moves, 0);
+    EXPECT_EQ(*vec[98].value, 98);
+    Boxed::destroyed = 0;
+  }
+  EXPECT_EQ(Boxed::destroyed, 99);
+
+  CustomVector<Boxed> small;
+  small.emplace_back(1);
+  small.emplace_back(2);
+  small.emplace(1, 3);
+  small.emplace(0, 4);
+  EXPECT_EQ(Values(small), "4 1 3 2 ");
+}
+
+TEST(CustomVectorTest, RelocatableArgumentsMayAliasElements) {
+  CustomVector<std::pair<int, double>> vec;
+  vec.emplace_back(1, 1.5);
+  for (int i = 0; i < 9; ++i) vec.push_back(vec[0]);
+  vec.insert(0, vec[9]);
+  vec.push_back({2, 2.5});
+  vec.insert(5, vec[11]);
+  EXPECT_EQ(vec.size(), 13u);
+  EXPECT_EQ(vec[12].first, 2);
+  EXPECT_EQ(vec[5].second, 2.5);
+  EXPECT_EQ(vec[0].first, 1);
+  CustomVector<std::pair<int, double>> copy(vec);
+  EXPECT_EQ(copy[5].first, 2);
+}
+
+TEST(CustomVectorTest, GrowthPolicies) {
+  EXPECT_EQ(Capacities<DoublingGrowth>(20), "1 2 4 8 16 32 ");
+  EXPECT_EQ(Capacities<HalfAgainGrowth>(20), "1 2 3 4 6 9 13 19 28 ");
+  EXPECT_EQ(Capacities<ChunkGrowth<32>>(20), "8 16 24 ");
+  EXPECT_EQ(Capacities<SizeClassGrowth>(40), "4 8 12 20 32 48 ");
+  EXPECT_EQ(SizeClassGrowth::blockBytes(1), 16u);
+  EXPECT_EQ(SizeClassGrowth::blockBytes(33), 48u);
+  EXPECT_EQ(SizeClassGrowth::blockBytes(129), 160u);
+  EXPECT_EQ(SizeClassGrowth::blockBytes(3585), 4096u);
+  EXPECT_EQ(SizeClassGrowth::blockBytes(4097), 8192u);
+  EXPECT_EQ(SizeClassGrowth::next(4096, 4), 6144u);
+  EXPECT_EQ(SizeClassGrowth::next(1, 24), 2u);
+
+  // An empty policy fits in the padding after the allocator.
+  EXPECT_EQ(sizeof(CustomVector<int, std::allocator<int>, ChunkGrowth<>>),
+            sizeof(CustomVector<int>));
+}
+
+TEST(CustomVectorTest, GrowthStatsCountReallocations) {
+  CustomVector<Tracked, std::allocator<Tracked>, GrowthStats<>> vec;
+  for (int i = 0; i < 9; ++i) vec.emplace_back(i);
+  const GrowthStats<>& stats = vec.growth_policy();
+  EXPECT_EQ(stats.reallocations(), 5u);
+  EXPECT_EQ(stats.bytes_copied(), (1 + 2 + 4 + 8) * sizeof(Tracked));
+  EXPECT_EQ(stats.peak_slack_bytes(), 8 * sizeof(Tracked));
+  vec.shrink_to_fit();
+  vec.reserve(100);
+  EXPECT_EQ(stats.reallocations(), 7u);
+  EXPECT_EQ(stats.peak_slack_bytes(), 91 * sizeof(Tracked));
+
+  // The statistics stay with the vector object.
+  CustomVector<Tracked, std::allocator<Tracked>, GrowthStats<>> moved(
+      std::move(vec));
+  EXPECT_EQ(moved.growth_policy().reallocations(), 0u);
+  EXPECT_EQ(vec.growth_policy().reallocations(), 7u);
+
+  // realloc may grow an int buffer in place, which copies nothing; at
+  // worst 1.5x growth copies three times the final size.
+  CustomVector<int, std::allocator<int>, GrowthStats<HalfAgainGrowth>> ints;
+  for (int i = 0; i < 1000; ++i) ints.push_back(i);
+  EXPECT_GT(ints.growth_policy().reallocations(), 10u);
+  EXPECT_LE(ints.growth_policy().bytes_copied(), 3000 * sizeof(int));
+  EXPECT_EQ(ints[999], 999);
+}
@@ -13,3 +13,10 @@ target('s21_containers_test')
   add_packages('gtest')
 
   set_group('test')
+
+target('s21_containers_bench')
+  set_kind('binary')
+  add_files('bench/*.cpp')
+  add_includedirs('include')
+
+  set_group('bench')